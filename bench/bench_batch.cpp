@@ -0,0 +1,90 @@
+/**
+ * @file bench_batch.cpp
+ * @author Seiichi "Suikan" Horie
+ * @brief Micro benchmark of the BatchEvaluator.
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2026
+ *
+ * @details
+ * Evaluate millions of the independent items. First, by a new StackStrategy per item and
+ * Operation() on one thread. Then, by the BatchEvaluator with 1, 2, 4 ... threads up to
+ * the hardware threads. Print the throughput and the scaling against 1 thread.
+ */
+#include "rpnengine.hpp"
+#include <chrono>
+#include <cstdio>
+#include <thread>
+#include <vector>
+
+static const std::size_t kItemCount = 4 * 1024 * 1024;
+
+int main()
+{
+    using rpn_engine::Op;
+    typedef rpn_engine::BatchEvaluator<double> Batch;
+
+    // Short programs of the stack operations. Each item takes one of them.
+    const std::vector<std::vector<Op>> programs = {
+        {Op::add, Op::sqrt},
+        {Op::mul, Op::add, Op::sin},
+        {Op::swap, Op::div, Op::log, Op::mul},
+        {Op::square, Op::swap, Op::square, Op::add, Op::sqrt},
+        {Op::duplicate, Op::exp, Op::swap, Op::neg, Op::exp, Op::add},
+    };
+
+    std::vector<double> inputs(kItemCount * 3);
+    std::vector<Batch::Item> items(kItemCount);
+    rpn_engine::Xoshiro256 random(1);
+    for (std::size_t i = 0; i < kItemCount; i++)
+    {
+        for (int k = 0; k < 3; k++)
+            inputs[3 * i + k] = random.NextDouble() + 0.5;
+        const std::vector<Op> &program = programs[(i / 64) % programs.size()];
+        items[i] = Batch::Item{program.data(), program.size(), &inputs[3 * i], 3};
+    }
+    std::vector<double> results(kItemCount);
+
+    // Baseline : a stack per item on one thread.
+    auto start = std::chrono::steady_clock::now();
+    double checksum = 0;
+    for (std::size_t i = 0; i < kItemCount; i++)
+    {
+        rpn_engine::StackStrategy<double> engine(4);
+        for (unsigned int k = 3; k-- > 0;)
+            engine.Push(inputs[3 * i + k]);
+        for (std::size_t k = 0; k < items[i].length; k++)
+            engine.Operation(items[i].program[k]);
+        checksum += engine.Get(0);
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::printf("%-10s %8.2f Mitem/s (checksum %g)\n", "baseline", kItemCount / seconds * 1e-6, checksum);
+
+    unsigned int hardware = std::thread::hardware_concurrency();
+    if (hardware == 0)
+        hardware = 1;
+    double single = 0;
+    for (unsigned int threads = 1;; threads = threads * 2 < hardware ? threads * 2 : hardware)
+    {
+        rpn_engine::WorkStealingPool pool(threads);
+        Batch batch(pool);
+        batch.Evaluate(items.data(), kItemCount, results.data()); // warm up
+
+        start = std::chrono::steady_clock::now();
+        batch.Evaluate(items.data(), kItemCount, results.data());
+        seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        checksum = 0;
+        for (auto result : results)
+            checksum += result;
+        const double rate = kItemCount / seconds;
+        if (threads == 1)
+            single = rate;
+        std::printf("%3u thread %8.2f Mitem/s  speedup %6.2f  efficiency %5.1f%% (checksum %g)\n",
+                    threads, rate * 1e-6, rate / single, 100 * rate / single / threads, checksum);
+        if (threads == hardware)
+            break;
+    }
+    return 0;
+}
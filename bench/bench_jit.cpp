@@ -0,0 +1,80 @@
+/**
+ * @file bench_jit.cpp
+ * @author Seiichi "Suikan" Horie
+ * @brief Micro benchmark of the JitFunction.
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2026
+ *
+ * @details
+ * Evaluate the same program by the VirtualMachine, the JitFunction and the function
+ * generated by the AotCompiler. Then, print the time per evaluation and per operation.
+ */
+#include "rpnengine.hpp"
+#include "rpn_rational.hpp"
+#include <chrono>
+#include <climits>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+
+static const unsigned long kInterpreterCount = 200000;
+static const unsigned long kNativeCount = 20000000;
+
+// Run the function count times and print the result.
+template <class Function>
+static void Measure(const char *name, Function function, unsigned long count, std::size_t operations)
+{
+    double sum = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (unsigned long i = 0; i < count; i++)
+        sum += function(static_cast<double>(i & 1023) * 0.001, static_cast<double>((i >> 10) & 1023) * 0.002 + 1);
+    auto end = std::chrono::steady_clock::now();
+
+    double ns = std::chrono::duration<double, std::nano>(end - start).count() / count;
+    std::printf("%-12s %10.2f ns/eval %8.3f ns/op (checksum %g)\n", name, ns, ns / operations, sum);
+}
+
+int main()
+{
+    std::ifstream file(RPN_BENCH_PROGRAM);
+    std::stringstream text;
+    text << file.rdbuf();
+    std::vector<rpn_engine::Op> program;
+    unsigned int line;
+    if (!rpn_engine::ParseProgramText(text.str().c_str(), program, line))
+    {
+        std::fprintf(stderr, "%s:%u : unknown token\n", RPN_BENCH_PROGRAM, line);
+        return 1;
+    }
+
+    // Count the operations as the nodes of the graph excluding the inputs.
+    rpn_engine::ExpressionGraph graph(4);
+    graph.Build(program.data(), program.size());
+    std::size_t operations = graph.GetNodeCount() - graph.GetStackSize();
+
+    rpn_engine::StackStrategy<double> engine(4);
+    rpn_engine::VirtualMachine<double> vm(engine);
+    vm.Load(program.data(), program.size());
+    auto interpreter = [&](double x, double y)
+    {
+        engine.Clear();
+        engine.Push(y);
+        engine.Push(x);
+        vm.Reset();
+        vm.Run(ULONG_MAX);
+        return engine.Get(0);
+    };
+
+    rpn_engine::JitFunction jit;
+    jit.Compile(program.data(), program.size());
+    std::printf("%zu operations, JIT is %s, %zu byte code\n", operations, jit.IsNative() ? "native" : "fallback", jit.GetCodeSize());
+
+    Measure("interpreter", interpreter, kInterpreterCount, operations);
+    Measure("jit", [&](double x, double y)
+            { return jit(x, y); },
+            kNativeCount, operations);
+    Measure("aot", rpn_rational, kNativeCount, operations);
+    return 0;
+}
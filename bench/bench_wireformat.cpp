@@ -0,0 +1,65 @@
+/**
+ * @file bench_wireformat.cpp
+ * @author Seiichi "Suikan" Horie
+ * @brief Micro benchmark of the WireFormat.
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2026
+ *
+ * @details
+ * Encode and decode a keystroke log. Then, print the throughput by the size of the
+ * decoded opcodes and the size of the encoded bytes.
+ */
+#include "rpnengine.hpp"
+#include <chrono>
+#include <cstdio>
+#include <vector>
+
+static const std::size_t kLength = 16 * 1024 * 1024;
+static const int kRepeat = 10;
+
+// Decode the data kRepeat times and print the result.
+static void Measure(const char *name, const std::vector<rpn_engine::Op> &program)
+{
+    std::vector<uint8_t> data;
+    rpn_engine::WireFormat::Encode(program.data(), program.size(), data);
+
+    std::vector<rpn_engine::Op> decoded;
+    bool is_ok = true;
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < kRepeat; i++)
+        is_ok = rpn_engine::WireFormat::Decode(data.data(), data.size(), decoded) && is_ok;
+    auto end = std::chrono::steady_clock::now();
+
+    double seconds = std::chrono::duration<double>(end - start).count() / kRepeat;
+    std::printf("%-8s %6.2f bit/op  decode %7.2f GB/s of Op  %7.2f MB/s of wire  %s\n",
+                name,
+                8.0 * data.size() / program.size(),
+                program.size() * sizeof(rpn_engine::Op) / seconds * 1e-9,
+                data.size() / seconds * 1e-6,
+                is_ok && decoded == program ? "ok" : "MISMATCH");
+}
+
+int main()
+{
+    rpn_engine::Xoshiro256 random(1);
+    std::vector<rpn_engine::Op> program(kLength);
+
+    // Numbers and the arithmetic only.
+    for (auto &opcode : program)
+        opcode = static_cast<rpn_engine::Op>(static_cast<unsigned int>(rpn_engine::Op::num_0) + random.Next() % 10);
+    Measure("digits", program);
+
+    // Typical log. One of eight keys is a function.
+    for (auto &opcode : program)
+    {
+        uint64_t r = random.Next();
+        if (r % 8 == 0)
+            opcode = static_cast<rpn_engine::Op>((r >> 8) % (static_cast<unsigned int>(rpn_engine::Op::chs) + 1));
+        else
+            opcode = static_cast<rpn_engine::Op>(static_cast<unsigned int>(rpn_engine::Op::num_0) + (r >> 8) % 10);
+    }
+    Measure("mixed", program);
+    return 0;
+}
@@ -0,0 +1,142 @@
+#include "aotcompiler.hpp"
+#include <cassert>
+#include <cstdio>
+
+rpn_engine::AotCompiler::AotCompiler(unsigned int stack_size) : graph_(stack_size)
+{
+}
+
+bool rpn_engine::AotCompiler::Compile(const Op program[], std::size_t length)
+{
+    return graph_.Build(program, length);
+}
+
+std::size_t rpn_engine::AotCompiler::GetErrorPosition() const
+{
+    return graph_.GetErrorPosition();
+}
+
+const rpn_engine::ExpressionGraph &rpn_engine::AotCompiler::GetGraph() const
+{
+    return graph_;
+}
+
+const char *rpn_engine::AotCompiler::TypeName(ElementType type)
+{
+    return type == ElementType::real ? "double" : "std::complex<double>";
+}
+
+const char *rpn_engine::AotCompiler::KernelName(Op opcode)
+{
+    switch (opcode)
+    {
+    case Op::add:
+        return "Add";
+    case Op::sub:
+        return "Subtract";
+    case Op::mul:
+        return "Multiply";
+    case Op::div:
+        return "Divide";
+    case Op::power:
+        return "Power";
+    case Op::neg:
+        return "Negate";
+    case Op::inv:
+        return "Inverse";
+    case Op::sqrt:
+        return "Sqrt";
+    case Op::square:
+        return "Square";
+    case Op::exp:
+        return "Exp";
+    case Op::log:
+        return "Log";
+    case Op::log10:
+        return "Log10";
+    case Op::power10:
+        return "Power10";
+    case Op::sin:
+        return "Sin";
+    case Op::cos:
+        return "Cos";
+    case Op::tan:
+        return "Tan";
+    case Op::asin:
+        return "Asin";
+    case Op::acos:
+        return "Acos";
+    case Op::atan:
+        return "Atan";
+    default:
+        assert(false); // ExpressionGraph doesn't make the other operation.
+        return "";
+    }
+}
+
+std::string rpn_engine::AotCompiler::Signature(const std::string &name, ElementType type, bool is_x_used, bool is_y_used)
+{
+    std::string element = TypeName(type);
+    return element + " " + name + "(" + element + (is_x_used ? " x, " : ", ") + element + (is_y_used ? " y)" : ")");
+}
+
+std::string rpn_engine::AotCompiler::GenerateHeader(const std::string &name, ElementType type) const
+{
+    return "// Generated by rpn_engine::AotCompiler. Do not edit.\n"
+           "#pragma once\n"
+           "#include <complex>\n\n" +
+           Signature(name, type) + ";\n";
+}
+
+std::string rpn_engine::AotCompiler::GenerateSource(const std::string &name, ElementType type) const
+{
+    const std::string element = TypeName(type);
+    const uint32_t result = graph_.GetStackNode(0);
+    const std::vector<bool> live = graph_.GetLiveNodes(result);
+
+    std::string source = "// Generated by rpn_engine::AotCompiler. Do not edit.\n"
+                         "#include \"kernels.hpp\"\n\n" +
+                         Signature(name, type, live[0], live[1]) + "\n{\n";
+
+    // The nodes are in the order of the execution. Emit the live ones.
+    char buffer[64];
+    for (uint32_t i = 0; i < live.size(); i++)
+    {
+        if (!live[i])
+            continue;
+        const ExpressionGraph::Node &node = graph_.GetNode(i);
+        std::snprintf(buffer, sizeof(buffer), "v%u", i);
+        source += "    const " + element + " " + buffer + " = ";
+
+        switch (node.kind)
+        {
+        case ExpressionGraph::NodeKind::input:
+            // X and Y are given. The others are 0.
+            source += node.operand[0] == 0   ? "x"
+                      : node.operand[0] == 1 ? "y"
+                                             : element + "(0)";
+            break;
+        case ExpressionGraph::NodeKind::constant:
+            // 17 digits to reproduce the same double.
+            std::snprintf(buffer, sizeof(buffer), "%.17g", node.value);
+            source += element + "(" + buffer + ")";
+            break;
+        case ExpressionGraph::NodeKind::unary:
+            std::snprintf(buffer, sizeof(buffer), "(v%u)", node.operand[0]);
+            source += std::string("rpn_engine::kernel::") + KernelName(node.opcode) + buffer;
+            break;
+        case ExpressionGraph::NodeKind::binary:
+            std::snprintf(buffer, sizeof(buffer), "(v%u, v%u)", node.operand[0], node.operand[1]);
+            source += std::string("rpn_engine::kernel::") + KernelName(node.opcode) + buffer;
+            break;
+        case ExpressionGraph::NodeKind::recall:
+            assert(false); // Compile() doesn't allow the registers.
+            break;
+        }
+        source += ";\n";
+    }
+
+    std::snprintf(buffer, sizeof(buffer), "    return v%u;\n}\n", result);
+    source += buffer;
+    return source;
+}
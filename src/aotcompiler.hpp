@@ -0,0 +1,106 @@
+#pragma once
+/**
+ * @file aotcompiler.hpp
+ * @author Seiichi "Suikan" Horie
+ * @brief Ahead of time compiler from the Op program to the C++ source.
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#include "expressiongraph.hpp"
+#include <string>
+
+namespace rpn_engine
+{
+    /**
+     * @brief Translate a straight line program to a C++ function.
+     * @details
+     * The program is analyzed by the ExpressionGraph. Then, each needed node becomes
+     * a local constant of the generated function :
+     * @code
+     * double name(double x, double y)
+     * {
+     *     const double v0 = x;
+     *     const double v1 = y;
+     *     const double v4 = rpn_engine::kernel::Add(v1, v0);
+     *     return v4;
+     * }
+     * @endcode
+     * The function takes the X and Y of the stack before the program. The other registers
+     * are 0. It returns the X after the program. The operations call the functions
+     * in the kernels.hpp. So, the result is same as the StackStrategy bit by bit.
+     *
+     * The stack manipulations and unused values don't appear in the generated code.
+     * The unused parameter has no name to avoid the warning.
+     *
+     * The rpnc tool in the tool directory runs this compiler at the build time. See the
+     * rpn_compile_function() of the tool/rpncompile.cmake.
+     */
+    class AotCompiler
+    {
+    public:
+        /**
+         * @brief Element type of the generated function.
+         */
+        enum class ElementType
+        {
+            real,   ///< double
+            complex ///< std::complex<double>
+        };
+
+        /**
+         * @brief Construct a new compiler.
+         *
+         * @param stack_size Depth of the stack assumed by the program.
+         */
+        AotCompiler(unsigned int stack_size = 4);
+
+        /**
+         * @brief Analyze the program.
+         *
+         * @param program Array of the opcode.
+         * @param length Number of the opcode in the program.
+         * @return true The program can be compiled.
+         * @return false The program has the unsupported opcode. See GetErrorPosition().
+         */
+        bool Compile(const Op program[], std::size_t length);
+
+        /**
+         * @brief Position of the unsupported opcode found by the last Compile().
+         */
+        std::size_t GetErrorPosition() const;
+
+        /**
+         * @brief Analyzed program.
+         */
+        const ExpressionGraph &GetGraph() const;
+
+        /**
+         * @brief Generate the definition of the function.
+         *
+         * @param name Name of the function. Must be a C++ identifier.
+         * @param type Element type.
+         * @return C++ source text. It includes kernels.hpp.
+         */
+        std::string GenerateSource(const std::string &name, ElementType type) const;
+
+        /**
+         * @brief Generate the declaration of the function.
+         *
+         * @param name Name of the function. Must be a C++ identifier.
+         * @param type Element type.
+         * @return C++ header text.
+         */
+        std::string GenerateHeader(const std::string &name, ElementType type) const;
+
+    private:
+        ExpressionGraph graph_;
+
+        static const char *TypeName(ElementType type);
+        static const char *KernelName(Op opcode);
+        static std::string Signature(const std::string &name, ElementType type, bool is_x_used = true, bool is_y_used = true);
+    };
+}
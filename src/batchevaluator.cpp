@@ -0,0 +1,17 @@
+/**
+ * @file batchevaluator.cpp
+ * @author Seiichi "Suikan" Horie
+ * @brief Explicit instantiation of the BatchEvaluator class template.
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2026
+ *
+ * @details
+ * The batchevaluator.hpp declares these specializations as extern template.
+ * Thus, the member functions of these specializations are compiled only here.
+ */
+#include "batchevaluator.hpp"
+
+template class rpn_engine::BatchEvaluator<double>;
+template class rpn_engine::BatchEvaluator<std::complex<double>>;
@@ -0,0 +1,211 @@
+#pragma once
+/**
+ * @file batchevaluator.hpp
+ * @author Seiichi "Suikan" Horie
+ * @brief Parallel evaluation of many independent programs.
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#include "virtualmachine.hpp"
+#include "workstealingpool.hpp"
+#include <cassert>
+#include <complex>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <vector>
+
+namespace rpn_engine
+{
+    /**
+     * @brief Evaluate a batch of the independent pairs of a program and its inputs.
+     *
+     * @tparam Element Element type. double or std::complex<double>.
+     * @details
+     * Each item is evaluated from the stack filled by the inputs and zero, the registers
+     * cleared and the statistics cleared. The random number generator is seeded by the
+     * seed of SeedRandom() and the index of the item as the stream. Then, the program is run
+     * by the VirtualMachine. The X after the program is the result. So, the result of an item
+     * doesn't depend on the other items nor the worker.
+     *
+     * The items are divided into halves recursively on the WorkStealingPool until a range
+     * is smaller than kGrainSize. The idle workers steal the large ranges first.
+     *
+     * Each worker has its own stack machine and virtual machine. They are created by the
+     * constructor and reused for all items. The workers are allocated separately and padded
+     * so that they don't share a cache line. If the consecutive items have the same program
+     * array, the program is decoded only once in an Evaluate(). So, the caller can rewrite
+     * the program array between the Evaluate().
+     */
+    template <class Element>
+    class BatchEvaluator
+    {
+    public:
+        /**
+         * @brief A pair of the program and the inputs.
+         */
+        struct Item
+        {
+            const Op *program;         ///< Array of the opcode. Must be valid and not changed during Evaluate().
+            std::size_t length;        ///< Number of the opcode in the program.
+            const Element *inputs;     ///< Initial stack. inputs[0] is X. May be nullptr if input_count is 0.
+            unsigned int input_count;  ///< Number of the inputs. The stack below is zero.
+        };
+
+        /**
+         * @brief Max steps of the program of an item.
+         */
+        static const unsigned long kStepBudget = 1000000;
+
+        /**
+         * @brief Number of the items which a worker evaluates without dividing.
+         */
+        static const std::size_t kGrainSize = 256;
+
+        /**
+         * @brief Construct a new evaluator.
+         *
+         * @param pool Thread pool to evaluate the items.
+         * @param stack_size Depth of the stack.
+         */
+        BatchEvaluator(WorkStealingPool &pool, unsigned int stack_size = 4);
+
+        BatchEvaluator(const BatchEvaluator &) = delete;
+        BatchEvaluator &operator=(const BatchEvaluator &) = delete;
+
+        /**
+         * @brief Evaluate the items.
+         *
+         * @param items Array of the items.
+         * @param count Number of the items.
+         * @param results Array of count elements allocated by the caller. results[i] is the X
+         * after the program of items[i]. NaN if the program has error, doesn't finish within
+         * kStepBudget steps or overflows the return stack.
+         */
+        void Evaluate(const Item items[], std::size_t count, Element results[]);
+
+        /**
+         * @brief Set the seed of the random numbers of the items.
+         *
+         * @param seed Seed given to StackStrategy::SeedRandom() with the index of the item. The default is 0.
+         */
+        void SeedRandom(uint64_t seed);
+
+    private:
+        // Working area of a worker. The padding keeps the workers on the different cache lines.
+        struct Worker
+        {
+            char padding_front[64];
+            StackStrategy<Element> engine;
+            VirtualMachine<Element> vm;
+            const Op *program; // The program decoded in the vm.
+            std::size_t length;
+            bool is_cached; // The program is decoded in this Evaluate().
+            bool is_loaded;
+            char padding_back[64];
+
+            Worker(unsigned int stack_size) : engine(stack_size), vm(engine), program(nullptr), length(0), is_cached(false), is_loaded(false) {}
+        };
+
+        WorkStealingPool &pool_;
+        const unsigned int stack_size_;
+        uint64_t seed_;
+        std::vector<std::unique_ptr<Worker>> workers_;
+
+        /**
+         * @brief Evaluate the items. Divide the range until kGrainSize.
+         */
+        void EvaluateRange(unsigned int worker, const Item items[], std::size_t begin, std::size_t end, Element results[]);
+
+        /**
+         * @brief Evaluate an item.
+         */
+        Element EvaluateItem(Worker &worker, const Item &item, std::size_t index);
+    };
+}
+
+template <class Element>
+rpn_engine::BatchEvaluator<Element>::BatchEvaluator(WorkStealingPool &pool, unsigned int stack_size) : pool_(pool),
+                                                                                                        stack_size_(stack_size),
+                                                                                                        seed_(0)
+{
+    for (unsigned int i = 0; i < pool_.GetThreadCount(); i++)
+        workers_.emplace_back(new Worker(stack_size));
+}
+
+template <class Element>
+void rpn_engine::BatchEvaluator<Element>::Evaluate(const Item items[], std::size_t count, Element results[])
+{
+    if (count == 0)
+        return;
+    // The program array may be rewritten since the last call.
+    for (auto &worker : workers_)
+        worker->is_cached = false;
+    pool_.Run([this, items, count, results](unsigned int worker)
+              { EvaluateRange(worker, items, 0, count, results); });
+}
+
+template <class Element>
+void rpn_engine::BatchEvaluator<Element>::SeedRandom(uint64_t seed)
+{
+    seed_ = seed;
+}
+
+template <class Element>
+void rpn_engine::BatchEvaluator<Element>::EvaluateRange(unsigned int worker, const Item items[], std::size_t begin, std::size_t end, Element results[])
+{
+    // Leave the upper half to be stolen.
+    while (end - begin > kGrainSize)
+    {
+        const std::size_t middle = begin + (end - begin) / 2;
+        pool_.Spawn(worker, [this, items, middle, end, results](unsigned int w)
+                    { EvaluateRange(w, items, middle, end, results); });
+        end = middle;
+    }
+
+    Worker &own = *workers_[worker];
+    for (std::size_t i = begin; i < end; i++)
+        results[i] = EvaluateItem(own, items[i], i);
+}
+
+template <class Element>
+Element rpn_engine::BatchEvaluator<Element>::EvaluateItem(Worker &worker, const Item &item, std::size_t index)
+{
+    // Decode only if the program is changed.
+    if (!worker.is_cached || item.program != worker.program || item.length != worker.length)
+    {
+        worker.is_loaded = worker.vm.Load(item.program, item.length);
+        worker.program = item.program;
+        worker.length = item.length;
+        worker.is_cached = true;
+    }
+    if (!worker.is_loaded)
+        return Element(std::numeric_limits<double>::quiet_NaN());
+
+    // Push from the bottom.
+    assert(item.input_count <= stack_size_);
+    worker.engine.Clear();
+    for (unsigned int i = item.input_count; i-- > 0;)
+        worker.engine.Push(item.inputs[i]);
+    worker.engine.Operation(Op::sigma_clear);
+    worker.engine.ClearCoefficients();
+    worker.engine.SeedRandom(seed_, index);
+    for (unsigned int i = 0; i < kNumberOfVmRegisters; i++)
+        worker.vm.SetRegister(i, Element(0));
+    worker.vm.Reset();
+
+    if (worker.vm.Run(kStepBudget) != VirtualMachine<Element>::Result::completed)
+        return Element(std::numeric_limits<double>::quiet_NaN());
+    return worker.engine.Get(0);
+}
+
+#ifndef RPN_ENGINE_HEADER_ONLY
+// Compiled in batchevaluator.cpp
+extern template class rpn_engine::BatchEvaluator<double>;
+extern template class rpn_engine::BatchEvaluator<std::complex<double>>;
+#endif
@@ -0,0 +1,267 @@
+#include "batchfunction.hpp"
+#include <algorithm>
+#include <cassert>
+
+// Definition of the static const member used as a reference.
+const std::size_t rpn_engine::BatchFunction::kBlockSize;
+
+namespace
+{
+    // d[i] = f(x[i])
+    template <class Function>
+    void Map(Function f, const double *x, double *d, std::size_t count)
+    {
+        for (std::size_t i = 0; i < count; i++)
+            d[i] = f(x[i]);
+    }
+
+    // d[i] = f(y[i], x[i])
+    template <class Function>
+    void Map(Function f, const double *y, const double *x, double *d, std::size_t count)
+    {
+        for (std::size_t i = 0; i < count; i++)
+            d[i] = f(y[i], x[i]);
+    }
+
+    // The switch is out of the loop. So, each loop calls one kernel.
+    void ApplyColumn(rpn_engine::Op opcode, const double *y, const double *x, double *d, std::size_t count)
+    {
+        using namespace rpn_engine::kernel;
+        switch (opcode)
+        {
+        case rpn_engine::Op::add:
+            Map([](double a, double b)
+                { return Add(a, b); },
+                y, x, d, count);
+            break;
+        case rpn_engine::Op::sub:
+            Map([](double a, double b)
+                { return Subtract(a, b); },
+                y, x, d, count);
+            break;
+        case rpn_engine::Op::mul:
+            Map([](double a, double b)
+                { return Multiply(a, b); },
+                y, x, d, count);
+            break;
+        case rpn_engine::Op::div:
+            Map([](double a, double b)
+                { return Divide(a, b); },
+                y, x, d, count);
+            break;
+        case rpn_engine::Op::power:
+            Map([](double a, double b)
+                { return Power(a, b); },
+                y, x, d, count);
+            break;
+        case rpn_engine::Op::neg:
+            Map([](double a)
+                { return Negate(a); },
+                x, d, count);
+            break;
+        case rpn_engine::Op::inv:
+            Map([](double a)
+                { return Inverse(a); },
+                x, d, count);
+            break;
+        case rpn_engine::Op::sqrt:
+            Map([](double a)
+                { return Sqrt(a); },
+                x, d, count);
+            break;
+        case rpn_engine::Op::square:
+            Map([](double a)
+                { return Square(a); },
+                x, d, count);
+            break;
+        case rpn_engine::Op::exp:
+            Map([](double a)
+                { return Exp(a); },
+                x, d, count);
+            break;
+        case rpn_engine::Op::log:
+            Map([](double a)
+                { return Log(a); },
+                x, d, count);
+            break;
+        case rpn_engine::Op::log10:
+            Map([](double a)
+                { return Log10(a); },
+                x, d, count);
+            break;
+        case rpn_engine::Op::power10:
+            Map([](double a)
+                { return Power10(a); },
+                x, d, count);
+            break;
+        case rpn_engine::Op::sin:
+            Map([](double a)
+                { return Sin(a); },
+                x, d, count);
+            break;
+        case rpn_engine::Op::cos:
+            Map([](double a)
+                { return Cos(a); },
+                x, d, count);
+            break;
+        case rpn_engine::Op::tan:
+            Map([](double a)
+                { return Tan(a); },
+                x, d, count);
+            break;
+        case rpn_engine::Op::asin:
+            Map([](double a)
+                { return Asin(a); },
+                x, d, count);
+            break;
+        case rpn_engine::Op::acos:
+            Map([](double a)
+                { return Acos(a); },
+                x, d, count);
+            break;
+        case rpn_engine::Op::atan:
+            Map([](double a)
+                { return Atan(a); },
+                x, d, count);
+            break;
+        default:
+            assert(false); // ExpressionGraph doesn't make the other operation.
+        }
+    }
+}
+
+rpn_engine::BatchFunction::BatchFunction(unsigned int stack_size) : scalar_(stack_size),
+                                                                    graph_(stack_size),
+                                                                    is_vectorized_(false),
+                                                                    result_(0)
+{
+    for (unsigned int i = 0; i < kNumberOfVmRegisters; i++)
+        registers_[i] = 0;
+    Load(nullptr, 0);
+}
+
+bool rpn_engine::BatchFunction::Load(const Op program[], std::size_t length)
+{
+    is_vectorized_ = false;
+    steps_.clear();
+    if (!scalar_.Load(program, length))
+        return false;
+    if (!graph_.Build(program, length, true))
+        return true; // Run by the VirtualMachine.
+
+    // Only the nodes needed by X.
+    const uint32_t root = graph_.GetStackNode(0);
+    const std::vector<bool> live = graph_.GetLiveNodes(root);
+    std::vector<uint32_t> last_use(root + 1, 0);
+    for (uint32_t i = 0; i <= root; i++)
+    {
+        const ExpressionGraph::Node &node = graph_.GetNode(i);
+        if (live[i] && (node.kind == ExpressionGraph::NodeKind::unary || node.kind == ExpressionGraph::NodeKind::binary))
+            last_use[node.operand[0]] = i;
+        if (live[i] && node.kind == ExpressionGraph::NodeKind::binary)
+            last_use[node.operand[1]] = i;
+    }
+
+    // Assign the columns. The column of an operand is free after its last use.
+    std::vector<uint32_t> column_of(root + 1, 0);
+    std::vector<uint32_t> free_columns;
+    uint32_t columns = 0;
+    for (uint32_t i = 0; i <= root; i++)
+    {
+        if (!live[i])
+            continue;
+        const ExpressionGraph::Node &node = graph_.GetNode(i);
+        Step step = {node, 0, {0, 0}};
+        const unsigned int operand_count = node.kind == ExpressionGraph::NodeKind::binary  ? 2
+                                           : node.kind == ExpressionGraph::NodeKind::unary ? 1
+                                                                                           : 0;
+        for (unsigned int k = 0; k < operand_count; k++)
+        {
+            step.operand[k] = column_of[node.operand[k]];
+            if (last_use[node.operand[k]] == i && (k == 0 || node.operand[1] != node.operand[0]))
+                free_columns.push_back(step.operand[k]);
+        }
+        if (operand_count == 1)
+            step.operand[1] = step.operand[0];
+
+        if (free_columns.empty())
+            step.destination = columns++;
+        else
+        {
+            step.destination = free_columns.back();
+            free_columns.pop_back();
+        }
+        column_of[i] = step.destination;
+        steps_.push_back(step);
+    }
+    result_ = column_of[root];
+    columns_.assign(columns * kBlockSize, 0);
+    is_vectorized_ = true;
+    return true;
+}
+
+void rpn_engine::BatchFunction::SetRegister(unsigned int index, double value)
+{
+    assert(index < kNumberOfVmRegisters);
+    registers_[index] = value;
+    scalar_.SetRegister(index, value);
+}
+
+bool rpn_engine::BatchFunction::IsVectorized() const
+{
+    return is_vectorized_;
+}
+
+void rpn_engine::BatchFunction::Evaluate(const double x[], double y[], std::size_t count)
+{
+    const double *const inputs[] = {x};
+    Evaluate(inputs, 1, y, count);
+}
+
+void rpn_engine::BatchFunction::Evaluate(const double *const inputs[], unsigned int input_count, double y[], std::size_t count)
+{
+    assert(input_count <= graph_.GetStackSize());
+    if (!is_vectorized_)
+    {
+        lane_inputs_.resize(input_count);
+        for (std::size_t i = 0; i < count; i++)
+        {
+            for (unsigned int k = 0; k < input_count; k++)
+                lane_inputs_[k] = inputs[k][i];
+            y[i] = scalar_(lane_inputs_.data(), input_count);
+        }
+        return;
+    }
+    for (std::size_t i = 0; i < count; i += kBlockSize)
+        EvaluateBlock(inputs, input_count, i, y + i, std::min(kBlockSize, count - i));
+}
+
+void rpn_engine::BatchFunction::EvaluateBlock(const double *const inputs[], unsigned int input_count, std::size_t first, double y[], std::size_t count)
+{
+    for (auto &step : steps_)
+    {
+        double *d = &columns_[step.destination * kBlockSize];
+        const ExpressionGraph::Node &node = step.node;
+        switch (node.kind)
+        {
+        case ExpressionGraph::NodeKind::input:
+            // The arguments are pushed to the stack filled by zero.
+            if (node.operand[0] < input_count)
+                std::copy(inputs[node.operand[0]] + first, inputs[node.operand[0]] + first + count, d);
+            else
+                std::fill(d, d + count, 0.0);
+            break;
+        case ExpressionGraph::NodeKind::constant:
+            std::fill(d, d + count, node.value);
+            break;
+        case ExpressionGraph::NodeKind::recall:
+            std::fill(d, d + count, registers_[node.operand[0]]);
+            break;
+        default:
+            ApplyColumn(node.opcode, &columns_[step.operand[0] * kBlockSize], &columns_[step.operand[1] * kBlockSize], d, count);
+            break;
+        }
+    }
+    const double *result = &columns_[result_ * kBlockSize];
+    std::copy(result, result + count, y);
+}
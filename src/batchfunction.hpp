@@ -0,0 +1,122 @@
+#pragma once
+/**
+ * @file batchfunction.hpp
+ * @author Seiichi "Suikan" Horie
+ * @brief Evaluation of a program over many arguments at once.
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#include "expressiongraph.hpp"
+#include "realfunction.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace rpn_engine
+{
+    /**
+     * @brief Evaluate f(x) of a program for an array of x.
+     * @details
+     * The function is same as the RealFunction : x is pushed to the stack filled by zero,
+     * the registers are the parameters and X after the program is f(x). The function of
+     * several arguments takes a column for each stack position, like f(a, b, c) for the
+     * analytics on the columns.
+     *
+     * If the program is a straight line program, the arguments are processed as the
+     * lanes. Each node of the ExpressionGraph becomes a column of kBlockSize lanes and each
+     * operation is a loop over the lanes. So, the interpretation cost is paid once for
+     * a block, and the loop is simple enough to be vectorized by the compiler. The
+     * columns are reused after the last use of the node. Otherwise, the RealFunction
+     * is called for each argument.
+     *
+     * Both ways calculate by the same kernels. So, the results are same as RealFunction.
+     * An object is not thread safe. Each thread needs its own object.
+     */
+    class BatchFunction
+    {
+    public:
+        /**
+         * @brief Number of the lanes processed at once.
+         */
+        static const std::size_t kBlockSize = 1024;
+
+        /**
+         * @brief Construct a new function. The program is empty. So, f(x) = x.
+         *
+         * @param stack_size Depth of the stack.
+         */
+        BatchFunction(unsigned int stack_size = 4);
+
+        /**
+         * @brief Load the program.
+         *
+         * @param program Array of the opcode.
+         * @param length Number of the opcode in the program.
+         * @return true Loaded.
+         * @return false The program has error. See VirtualMachine::Load().
+         */
+        bool Load(const Op program[], std::size_t length);
+
+        /**
+         * @brief Set the register value given to each evaluation.
+         *
+         * @param index Register number. 0 .. kNumberOfVmRegisters-1.
+         * @param value Value of the register.
+         */
+        void SetRegister(unsigned int index, double value);
+
+        /**
+         * @brief Check whether the lanes are processed by the column loops.
+         *
+         * @return true The program is a straight line program.
+         * @return false The program is run by the VirtualMachine for each argument.
+         */
+        bool IsVectorized() const;
+
+        /**
+         * @brief Evaluate the function.
+         *
+         * @param x Array of the arguments.
+         * @param y Array to receive f(x).
+         * @param count Number of the arguments.
+         */
+        void Evaluate(const double x[], double y[], std::size_t count);
+
+        /**
+         * @brief Evaluate the function of several arguments.
+         *
+         * @param inputs Array of the argument columns. inputs[k][i] is the stack position k of the lane i. 0 is X.
+         * @param input_count Number of the columns. Up to the stack size. The stack below is zero.
+         * @param y Array to receive the X after the program of each lane.
+         * @param count Number of the lanes.
+         */
+        void Evaluate(const double *const inputs[], unsigned int input_count, double y[], std::size_t count);
+
+    private:
+        // An operation on the columns.
+        struct Step
+        {
+            ExpressionGraph::Node node;
+            uint32_t destination; // Column index.
+            uint32_t operand[2];  // Column index of Y and X. Unary uses operand[0].
+        };
+
+        RealFunction scalar_;
+        ExpressionGraph graph_;
+        std::vector<double> lane_inputs_; // Arguments of a lane for the scalar_.
+        double registers_[kNumberOfVmRegisters];
+        bool is_vectorized_;
+        std::vector<Step> steps_;
+        uint32_t result_; // Column of the X.
+        std::vector<double> columns_;
+
+        /**
+         * @brief Evaluate a block of the lanes by the columns.
+         */
+        void EvaluateBlock(const double *const inputs[], unsigned int input_count, std::size_t first, double y[], std::size_t count);
+    };
+}
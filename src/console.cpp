@@ -5,12 +5,18 @@
 #include <cstring>
 #include <cctype>
 #include <type_traits>
+#include <chrono>
+#include <climits>
 
 using rpn_engine::Op;
 
 static const int kFullMantissa = 9;
 static const int kUpperMostDigit = 7;
 
+// Definition of the static const member used as a reference.
+const int rpn_engine::Console::kDecimalPointNotDisplayed;
+const unsigned int rpn_engine::Console::kPlayTimeCheckInterval;
+
 rpn_engine::Console::Console(const char *initial_string) : engine_(StackStrategy<std::complex<double>>(kDepthOfStack)),
                                                            is_func_key_pressed_(false),
                                                            display_mode_(DisplayMode::fixed),
@@ -19,7 +25,15 @@ rpn_engine::Console::Console(const char *initial_string) : engine_(StackStrategy
                                                            mantissa_cursor_(1),
                                                            is_editing_float_(false),
                                                            is_hex_mode_(false),
-                                                           user_variable_(0)
+                                                           user_variable_(0),
+                                                           recording_program_(nullptr),
+                                                           is_rendering_deferred_(false),
+                                                           playing_program_(nullptr),
+                                                           suspended_program_(nullptr),
+                                                           play_position_(0),
+                                                           played_steps_(0),
+                                                           total_play_steps_(0),
+                                                           play_state_(PlayState::idle)
 {
     if (initial_string == nullptr)                                   // if the initial_string is null
         PostExecutionProcess();                                      // display 0.0000000 as initial string
@@ -65,6 +79,144 @@ int32_t rpn_engine::Console::GetDecimalPointPosition()
     return decimal_point_position_;
 }
 
+rpn_engine::Console::Snapshot rpn_engine::Console::TakeSnapshot()
+{
+    Snapshot snapshot(engine_.TakeSnapshot());
+
+    snapshot.is_func_key_pressed_ = is_func_key_pressed_;
+    snapshot.display_mode_ = display_mode_;
+    snapshot.is_editing_ = is_editing_;
+    snapshot.is_pushable_ = is_pushable_;
+    snapshot.mantissa_cursor_ = mantissa_cursor_;
+    snapshot.is_editing_float_ = is_editing_float_;
+    snapshot.is_hex_mode_ = is_hex_mode_;
+    std::memcpy(snapshot.text_buffer_, text_buffer_, sizeof(text_buffer_));
+    snapshot.decimal_point_position_ = decimal_point_position_;
+    std::memcpy(snapshot.mantissa_buffer_, mantissa_buffer_, sizeof(mantissa_buffer_));
+    std::memcpy(snapshot.exponent_buffer_, exponent_buffer_, sizeof(exponent_buffer_));
+    snapshot.user_variable_ = user_variable_;
+
+    return snapshot;
+}
+
+void rpn_engine::Console::RestoreSnapshot(const Snapshot &snapshot)
+{
+    engine_.RestoreSnapshot(snapshot.engine_);
+
+    is_func_key_pressed_ = snapshot.is_func_key_pressed_;
+    display_mode_ = snapshot.display_mode_;
+    is_editing_ = snapshot.is_editing_;
+    is_pushable_ = snapshot.is_pushable_;
+    mantissa_cursor_ = snapshot.mantissa_cursor_;
+    is_editing_float_ = snapshot.is_editing_float_;
+    is_hex_mode_ = snapshot.is_hex_mode_;
+    std::memcpy(text_buffer_, snapshot.text_buffer_, sizeof(text_buffer_));
+    decimal_point_position_ = snapshot.decimal_point_position_;
+    std::memcpy(mantissa_buffer_, snapshot.mantissa_buffer_, sizeof(mantissa_buffer_));
+    std::memcpy(exponent_buffer_, snapshot.exponent_buffer_, sizeof(exponent_buffer_));
+    user_variable_ = snapshot.user_variable_;
+}
+
+void rpn_engine::Console::StartRecording(ProgramMemory &program)
+{
+    recording_program_ = &program;
+}
+
+void rpn_engine::Console::StopRecording()
+{
+    recording_program_ = nullptr;
+}
+
+bool rpn_engine::Console::GetIsRecording()
+{
+    return recording_program_ != nullptr;
+}
+
+void rpn_engine::Console::Play(const ProgramMemory &program)
+{
+    StartPlay(program);
+    while (ResumePlay(UINT_MAX) == PlayState::running)
+        ;
+}
+
+void rpn_engine::Console::StartPlay(const ProgramMemory &program)
+{
+    playing_program_ = &program;
+    suspended_program_ = &program;
+    play_position_ = 0;
+    played_steps_ = 0;
+    total_play_steps_ = program.GetStepCount();
+    play_state_ = PlayState::running;
+}
+
+rpn_engine::Console::PlayState rpn_engine::Console::ResumePlay(unsigned int step_budget, double time_budget)
+{
+    if (play_state_ != PlayState::running)
+        return play_state_;
+
+    // At least one step runs.
+    if (step_budget == 0)
+        step_budget = 1;
+
+    // The time budget beyond the range of the clock is unlimited.
+    const double kMaxTimeBudget = std::chrono::duration<double>(std::chrono::steady_clock::duration::max()).count() / 2;
+    const bool is_timed = time_budget != 0 && time_budget < kMaxTimeBudget;
+    std::chrono::steady_clock::time_point deadline;
+    if (is_timed)
+        deadline = std::chrono::steady_clock::now() +
+                   std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(time_budget));
+
+    // The playback is not recorded. And the Input() from here is not a cancel.
+    ProgramMemory *recording_program = recording_program_;
+    recording_program_ = nullptr;
+    playing_program_ = nullptr;
+
+    is_rendering_deferred_ = true;
+    const unsigned int end = suspended_program_->GetNibbleCount();
+    for (unsigned int step = 0; step < step_budget && play_position_ < end; step++)
+    {
+        if (is_timed && step != 0 && step % kPlayTimeCheckInterval == 0 && std::chrono::steady_clock::now() > deadline)
+            break;
+        Input(suspended_program_->Fetch(play_position_));
+        played_steps_++;
+    }
+    is_rendering_deferred_ = false;
+
+    // The editing op renders the text_buffer_ by itself. Others need the rendering.
+    if (!is_editing_)
+        PostExecutionProcess();
+
+    recording_program_ = recording_program;
+    if (play_position_ < end)
+        playing_program_ = suspended_program_;
+    else
+    {
+        suspended_program_ = nullptr;
+        play_state_ = PlayState::completed;
+    }
+    return play_state_;
+}
+
+void rpn_engine::Console::CancelPlay()
+{
+    if (play_state_ != PlayState::running)
+        return;
+    playing_program_ = nullptr;
+    suspended_program_ = nullptr;
+    play_state_ = PlayState::cancelled;
+}
+
+rpn_engine::Console::PlayState rpn_engine::Console::GetPlayState()
+{
+    return play_state_;
+}
+
+void rpn_engine::Console::GetPlayProgress(unsigned int &played_steps, unsigned int &total_steps)
+{
+    played_steps = played_steps_;
+    total_steps = total_play_steps_;
+}
+
 void rpn_engine::Console::PreExecutionProcess()
 {
     StackElement value;
@@ -143,38 +295,78 @@ void rpn_engine::Console::PreExecutionProcess()
 
 void rpn_engine::Console::PostExecutionProcess()
 {
-    if (std::isnan(engine_.Get(0).real()) || std::isnan(engine_.Get(0).imag())) // NaN?
+    if (is_rendering_deferred_)
+        return;
+    Render(engine_.GetView()[0], text_buffer_, decimal_point_position_);
+}
+
+void rpn_engine::Console::Render(const StackElement &x, char text[], int32_t &decimal_point_position)
+{
+    // NaN and Inf appear only after the engine raised one of these flags.
+    // So, we can skip the inspection of the value in the most case.
+    const bool may_be_special = (engine_.GetStatus() & (kFpInvalid | kFpDivideByZero | kFpOverflow)) != 0;
+
+    if (may_be_special)
+        RenderText(x, display_mode_, is_hex_mode_, text, decimal_point_position);
+    else // Neither NaN nor Inf
+        RenderNumber(x.real(), display_mode_, is_hex_mode_, text, decimal_point_position);
+}
+
+void rpn_engine::Console::RenderText(const StackElement &x, DisplayMode mode, bool is_hex_mode, char text[], int32_t &decimal_point_position)
+{
+    if (std::isnan(x.real()) || std::isnan(x.imag())) // NaN?
     {
-        std::strcpy(text_buffer_, "      NaN");
-        decimal_point_position_ = kDecimalPointNotDisplayed;
+        std::strcpy(text, "      NaN");
+        decimal_point_position = kDecimalPointNotDisplayed;
     }
-    else if (std::isinf(engine_.Get(0).real()) || std::isinf(engine_.Get(0).imag())) // Inf?
+    else if (std::isinf(x.real()) || std::isinf(x.imag())) // Inf?
     {
-        std::strcpy(text_buffer_, "      INF");
-        decimal_point_position_ = kDecimalPointNotDisplayed;
+        std::strcpy(text, "      INF");
+        decimal_point_position = kDecimalPointNotDisplayed;
     }
     else // Neither NaN nor Inf
+        RenderNumber(x.real(), mode, is_hex_mode, text, decimal_point_position);
+}
+
+void rpn_engine::Console::RenderNumber(double value, DisplayMode mode, bool is_hex_mode, char text[], int32_t &decimal_point_position)
+{
+    // We display only real part.
+    if (is_hex_mode) // if hex mode
+        RenderHexMode(value, text, decimal_point_position);
+    else // decimal mode
     {
-        if (is_hex_mode_) // if hex mode
-            RenderHexMode();
-        else // decimal mode
+        switch (mode)
         {
-            switch (display_mode_)
-            {
-            case rpn_engine::DisplayMode::fixed:
-                RenderFixedMode();
-                break;
-            case rpn_engine::DisplayMode::scientific:
-                RenderScientificMode(false);
-                break;
-            case rpn_engine::DisplayMode::engineering:
-                RenderScientificMode(true);
-                break;
-            default:
-                assert(false); // program logic error
-            }
-        } // hex / decimal mode
-    }
+        case rpn_engine::DisplayMode::fixed:
+            RenderFixedMode(value, text, decimal_point_position);
+            break;
+        case rpn_engine::DisplayMode::scientific:
+            RenderScientificMode(value, text, decimal_point_position, false);
+            break;
+        case rpn_engine::DisplayMode::engineering:
+            RenderScientificMode(value, text, decimal_point_position, true);
+            break;
+        default:
+            assert(false); // program logic error
+        }
+    } // hex / decimal mode
+}
+
+void rpn_engine::Console::GetStackText(unsigned int count, char display_text[][kNumberOfDigits + 1], int32_t decimal_point_position[])
+{
+    assert(count >= 1);
+    assert(kDepthOfStack >= count);
+
+    StackView<StackElement> stack = engine_.GetView();
+
+    // X is same with the display.
+    GetText(display_text[0]);
+    decimal_point_position[0] = GetDecimalPointPosition();
+
+    // The edited number will be pushed on the stack top. Then, the stack top will be Y.
+    unsigned int offset = (is_editing_ && is_pushable_) ? 1 : 0;
+    for (unsigned int i = 1; i < count; i++)
+        Render(stack[i - offset], display_text[i], decimal_point_position[i]);
 }
 
 void rpn_engine::Console::HandleNonEditingOp(rpn_engine::Op opcode)
@@ -203,11 +395,16 @@ void rpn_engine::Console::HandleNonEditingOp(rpn_engine::Op opcode)
         break;
     case Op::clx:
         engine_.SetX(0.0);
-        is_pushable_ = false; // Only clx and enter makes NOT pushable
+        is_pushable_ = false; // Only clx, enter and sigma makes NOT pushable
         break;
     case Op::enter:
         engine_.Operation(Op::duplicate);
-        is_pushable_ = false; // Only clx and enter makes NOT pushable
+        is_pushable_ = false; // Only clx, enter and sigma makes NOT pushable
+        break;
+    case Op::sigma_plus:
+    case Op::sigma_minus:
+        engine_.Operation(opcode);
+        is_pushable_ = false; // The next number overwrites the number of samples.
         break;
     case Op::hex: // change to hex mode
         SetIsHexMode(true);
@@ -401,10 +598,21 @@ void rpn_engine::Console::HandleEditingOp(rpn_engine::Op opcode)
 
 void rpn_engine::Console::Input(Op opcode)
 {
+    if (playing_program_ != nullptr && Op::nop != opcode) // key during the playback?
+    {
+        CancelPlay(); // discard the key
+        return;
+    }
+
+    if (recording_program_ != nullptr && Op::nop != opcode) // is recording?
+        recording_program_->Append(opcode);                  // record the key. Ignore if full.
+
     if (Op::func == opcode)                          // F key pressed
         SetIsFuncKeyPressed(!GetIsFuncKeyPressed()); // invert the state
     else if (Op::nop == opcode)                      // is the opcode nop?
         ;                                            // do nothing
+    else if (opcode >= Op::label && Op::nop > opcode) // is the opcode for program?
+        ;                                             // do nothing. Only VirtualMachine handles it.
     else                                             // neither nop nor f key
     {
         if ((Op::num_0 > opcode) && (opcode >= Op::duplicate))
@@ -415,24 +623,22 @@ void rpn_engine::Console::Input(Op opcode)
     }
 }
 
-void rpn_engine::Console::RenderFixedMode()
+void rpn_engine::Console::RenderFixedMode(double value, char text[], int32_t &decimal_point_position)
 {
     //    const double kBoundaryOfScientific = 99999999.5; // 8 digits of 9 and rounding bias.
     const double kBoundaryOfScientific = 100000000; // 8 digits of 9 + one
-    // Get top of stack
-    StackElement x = engine_.Get(0);
-    // We display only real part.
-    auto value = x.real();
+    // keep the original value for the scientific mode.
+    double original_value = value;
 
     // record the sign of value.
     bool minus = value < 0.0;
     if (minus)
         value = -value;
 
-    if (value + 0.5 >= kBoundaryOfScientific) // if too large,
-        RenderScientificMode(false);          // display in the scientific format
-    else if (5e-8 > value && value != 0)      // if too small
-        RenderScientificMode(false);          // display in the scientific format
+    if (value + 0.5 >= kBoundaryOfScientific)                                      // if too large,
+        RenderScientificMode(original_value, text, decimal_point_position, false); // display in the scientific format
+    else if (5e-8 > value && value != 0)                                           // if too small
+        RenderScientificMode(original_value, text, decimal_point_position, false); // display in the scientific format
     else
     {
         int exponent = 7; // The display value in the text_buffer_[] is integer. So, we need exponent.
@@ -481,15 +687,15 @@ void rpn_engine::Console::RenderFixedMode()
         else
             assert(false); // program logic error
 
-        // text_buffer_[0] is space for sign
-        std::sprintf(&text_buffer_[1], "%08d", int_value);
+        // text[0] is space for sign
+        std::sprintf(&text[1], "%08d", int_value);
         // set sign or blank
-        text_buffer_[0] = minus ? '-' : ' ';
-        decimal_point_position_ = exponent;
+        text[0] = minus ? '-' : ' ';
+        decimal_point_position = exponent;
     }
 }
 
-void rpn_engine::Console::RenderScientificMode(bool engineering_mode)
+void rpn_engine::Console::RenderScientificMode(double value, char text[], int32_t &decimal_point_position, bool engineering_mode)
 {
     const int kBufferSize = 20;
     const int kExponentPos = 10;
@@ -499,11 +705,6 @@ void rpn_engine::Console::RenderScientificMode(bool engineering_mode)
     // temporally rendering area
     char buffer[kBufferSize];
 
-    // Get top of stack
-    StackElement x = engine_.Get(0);
-    // We display only real part.
-    auto value = x.real();
-
     // Convert to a text format as #.#######e#####
     std::snprintf(buffer, kBufferSize, kFormatSpec, value);
     // Check wether the format is OK.
@@ -512,27 +713,27 @@ void rpn_engine::Console::RenderScientificMode(bool engineering_mode)
     // Get a exponent part of #.#######e#####
     int exponent = std::atoi(&buffer[kExponentPos + 1]);
 
-    decimal_point_position_ = kUpperMostDigit; // right of the upper most digit
+    decimal_point_position = kUpperMostDigit; // right of the upper most digit
 
     if (exponent > 99) // if the number exceed the max display number
         if (value > 0)
-            std::strcpy(text_buffer_, "+99999+99"); // sign of max number
+            std::strcpy(text, "+99999+99"); // sign of max number
         else
-            std::strcpy(text_buffer_, "-99999+99"); // sign of max number
+            std::strcpy(text, "-99999+99"); // sign of max number
 
-    else if (-99 > exponent)                    // if the number is lower than the min display number
-        std::strcpy(text_buffer_, " 00000000"); // flash to zero
-    else                                        // the number is in the normal range
-    {                                           // copy the mantissa withtout decimal point
+    else if (-99 > exponent)            // if the number is lower than the min display number
+        std::strcpy(text, " 00000000"); // flash to zero
+    else                                // the number is in the normal range
+    {                                   // copy the mantissa withtout decimal point
         int i = 0;
         int j = 0;
-        text_buffer_[i++] = buffer[j++]; // Sign
-        text_buffer_[i++] = buffer[j++]; // upper most
-        j++;                             // skip decimal point
-        text_buffer_[i++] = buffer[j++]; // 2nd upper digit
-        text_buffer_[i++] = buffer[j++]; // 3rd upper digit
-        text_buffer_[i++] = buffer[j++]; // 4th upper digit
-        text_buffer_[i++] = buffer[j++]; // 5th upper digit
+        text[i++] = buffer[j++]; // Sign
+        text[i++] = buffer[j++]; // upper most
+        j++;                     // skip decimal point
+        text[i++] = buffer[j++]; // 2nd upper digit
+        text[i++] = buffer[j++]; // 3rd upper digit
+        text[i++] = buffer[j++]; // 4th upper digit
+        text[i++] = buffer[j++]; // 5th upper digit
 
         if (engineering_mode)
         {
@@ -549,24 +750,24 @@ void rpn_engine::Console::RenderScientificMode(bool engineering_mode)
                 exponent -= 3;        // this is required only when the old_exponent is not the integer multiple of 3
                 offset_exponent += 3; // adjust for the minus exponent
             }
-            decimal_point_position_ -= offset_exponent;
+            decimal_point_position -= offset_exponent;
         }
         // append exponent to mantissa
-        std::snprintf(&text_buffer_[i], 4, kDisplayFormatSpec, exponent);
+        std::snprintf(&text[i], 4, kDisplayFormatSpec, exponent);
     }
 }
 
-void rpn_engine::Console::RenderHexMode()
+void rpn_engine::Console::RenderHexMode(double value, char text[], int32_t &decimal_point_position)
 {
-    // get the stack top, take real part and round.
+    // round the given value.
     // Some implementation makes negative value to zero. To refuge it,
     // convet the double float to 64bit signed integer, then convert it
     // to 32bit signed integer.
     // We can get LSB 32bit precisely (hope so).
-    int32_t value = (int64_t)std::round(engine_.Get(0).real());
+    int32_t int_value = (int64_t)std::round(value);
 
-    unsigned int uivalue = value;                        // Copy the uint32_t data to unsigned integer.
-                                                         // This is required by "%X" format specifier
-    std::sprintf(text_buffer_, " %08X", uivalue);        // Display by 8 digit hex with leading zero
-    decimal_point_position_ = kDecimalPointNotDisplayed; // No decimal point
+    unsigned int uivalue = int_value;                   // Copy the uint32_t data to unsigned integer.
+                                                        // This is required by "%X" format specifier
+    std::sprintf(text, " %08X", uivalue);               // Display by 8 digit hex with leading zero
+    decimal_point_position = kDecimalPointNotDisplayed; // No decimal point
 }
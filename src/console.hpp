@@ -11,6 +11,7 @@
  */
 
 #include "stackstrategy.hpp"
+#include "programmemory.hpp"
 #include "cmath"
 #include "cstdio"
 
@@ -78,7 +79,44 @@ namespace rpn_engine
          * @brief Special value to identify the decimal point is not displayed
          *
          */
-        const int kDecimalPointNotDisplayed = 256;
+        static const int kDecimalPointNotDisplayed = 256;
+
+        /**
+         * @brief State of the program playback by StartPlay() and ResumePlay().
+         */
+        enum class PlayState
+        {
+            idle,      ///< No playback is started.
+            running,   ///< The playback is suspended. Call ResumePlay() to continue.
+            completed, ///< All steps are played.
+            cancelled  ///< Cancelled by CancelPlay() or a key.
+        };
+
+        /**
+         * @brief Saved state of the console.
+         * @details
+         * The snapshot holds the stack as StackStrategy::Snapshot, and the editing / display state
+         * as copy. So, taking and restoring a snapshot finish in constant time.
+         */
+        class Snapshot
+        {
+        private:
+            friend class Console;
+            Snapshot(const StackStrategy<StackElement>::Snapshot &engine) : engine_(engine) {}
+            StackStrategy<StackElement>::Snapshot engine_;
+            bool is_func_key_pressed_;
+            DisplayMode display_mode_;
+            bool is_editing_;
+            bool is_pushable_;
+            int mantissa_cursor_;
+            bool is_editing_float_;
+            bool is_hex_mode_;
+            char text_buffer_[kNumberOfDigits + 1];
+            int32_t decimal_point_position_;
+            char mantissa_buffer_[kNumberOfDigits + 1];
+            char exponent_buffer_[kNumberOfDigits + 1];
+            StackElement user_variable_;
+        };
         /**
          * @brief Construct a new Console object
          * @param initial_string A  string displayed at first. Ignored if nullptr.
@@ -162,6 +200,15 @@ namespace rpn_engine
          * @li logical_shift_right  : Pop X and Y, convert them to integer, do Y << X, then push the result.
          * @li logical_shift_left   : Pop X and Y, convert them to integer, do Y >> X, then push the result.
          * @li bit_not              : Pop X, convert it to integer, invert 1/0 for all bits, then push the result.
+         * @li sigma_plus           : Add (X, Y) to the statistics, then replace X by the number of samples. Set it non-pushable mode.
+         * @li sigma_minus          : Remove (X, Y) from the statistics, then replace X by the number of samples. Set it non-pushable mode.
+         * @li sigma_clear          : Clear the statistics.
+         * @li mean                 : Push mean of y, then push mean of x.
+         * @li standard_deviation   : Push sample standard deviation of y, then push the one of x.
+         * @li random               : Push uniform random number in [0, 1).
+         * @li polynomial           : Pop degree n, x and n+1 coefficients ( x^0 first ). Then push the value of polynomial.
+         * @li coefficient_store    : Pop index i, then store X to the coefficient register i.
+         * @li coefficient_polynomial : Pop degree n and x. Then push the value of polynomial by the coefficient registers 0 .. n.
          * @li change_display       : Change the display mode. Fixed -> Scientific -> Engineering -> Fixed.
          * @li enter                : In the editing mode, terminate it and push the value. And then, set pushable mode.
          * @li clx                  : Clear the X. And set it non-pushable mode.
@@ -171,6 +218,7 @@ namespace rpn_engine
          * @li sto                  : Store current X to the user variable.
          * @li rcl                  : Recall the user variable and push it.
          * @li func                 : Toggle Func mode.
+         * @li label .. x_le_y      : Program opcode for VirtualMachine. Ignored.
          * @li nop                  : Do nothing
          *
          * Editing op code :
@@ -223,6 +271,152 @@ namespace rpn_engine
          */
         int32_t GetDecimalPointPosition();
 
+        /**
+         * @brief Get the Text representation of several registers at once.
+         *
+         * @param count Number of registers to render. Must be 1 .. kDepthOfStack.
+         * @param display_text Caller owned buffers. display_text[i] receives the text of register i.
+         * @param decimal_point_position Caller owned array. decimal_point_position[i] receives the
+         * decimal point position of register i. Same format with GetDecimalPointPosition().
+         * @details
+         * The register 0 is X, the register 1 is Y, and so on. The text of X is same with GetText().
+         * The other registers are rendered by the current display mode.
+         *
+         * During the editing, the number on editing is X. Thus, the stack top is rendered
+         * as Y if the edited number will be pushed.
+         *
+         * The stack is accessed without copy. So, this is faster than calling GetText() for each register.
+         */
+        void GetStackText(unsigned int count, char display_text[][kNumberOfDigits + 1], int32_t decimal_point_position[]);
+
+        /**
+         * @brief Convert a value to the display text without the Console object.
+         *
+         * @param x Value to convert. Only the real part is displayed.
+         * @param mode Display format of the decimal mode.
+         * @param is_hex_mode Render in the hex mode.
+         * @param text Buffer to store the kNumberOfDigits characters with null termination.
+         * @param decimal_point_position Position of the decimal point. Same format with GetDecimalPointPosition().
+         * @details
+         * The text is same as GetText() of the Console in the given mode. NaN and Inf are always inspected.
+         * This function is thread safe.
+         */
+        static void RenderText(const StackElement &x, DisplayMode mode, bool is_hex_mode, char text[], int32_t &decimal_point_position);
+
+        /**
+         * @brief Save the current state of the console.
+         *
+         * @return Snapshot of the stack, user variable, display and editing state.
+         * @details
+         * The stack is shared with the snapshot until the next modification.
+         * Thus, a lot of snapshots can be kept with small memory.
+         */
+        Snapshot TakeSnapshot();
+
+        /**
+         * @brief Retrieve the state saved by TakeSnapshot()
+         *
+         * @param snapshot A snapshot to retrieve. It can be retrieved repeatedly.
+         * @details
+         * The display text is retrieved too.
+         */
+        void RestoreSnapshot(const Snapshot &snapshot);
+
+        /**
+         * @brief Start to record the input to the program memory.
+         *
+         * @param program Program memory to record. The opcodes given to Input() are appended.
+         * @details
+         * Op::nop is not recorded. If the program memory is full, the opcode is not recorded.
+         * The program memory must be valid until StopRecording().
+         */
+        void StartRecording(ProgramMemory &program);
+
+        /**
+         * @brief Stop recording.
+         */
+        void StopRecording();
+
+        /**
+         * @brief Get the recording state
+         *
+         * @return true The input is being recorded.
+         * @return false Not recording.
+         */
+        bool GetIsRecording();
+
+        /**
+         * @brief Run the program
+         *
+         * @param program Program to run.
+         * @details
+         * The opcodes in the program are given to Input() in order. The text rendering is
+         * deferred until the end of the program. So, the result is same as the Input() one by
+         * one, but faster.
+         *
+         * The program run is not recorded.
+         */
+        void Play(const ProgramMemory &program);
+
+        /**
+         * @brief Start the playback of the program in the time slices.
+         *
+         * @param program Program to run. Must be valid until the playback ends.
+         * @details
+         * No step runs by this function. Call ResumePlay() repeatedly from the UI loop until
+         * it returns other than PlayState::running. Between the calls, the UI can scan the keys
+         * and refresh the display.
+         *
+         * While the playback is running, Input() cancels it. The key is discarded.
+         * Op::nop doesn't cancel.
+         *
+         * The playback replays the keys of the ProgramMemory on the Console. The program ops
+         * are ignored as Input() does. So, a program with loops must run on the VirtualMachine,
+         * which is sliced by itself : VirtualMachine::Run() continues after
+         * Result::budget_exhausted, and VirtualMachine::Reset() cancels the program.
+         */
+        void StartPlay(const ProgramMemory &program);
+
+        /**
+         * @brief Run a slice of the playback.
+         *
+         * @param step_budget Max number of the steps in this slice. 0 is same as 1.
+         * @param time_budget Max time of this slice in second. 0 is unlimited. So is the time too long for the clock.
+         * @return State after this slice.
+         * @details
+         * At least one step runs if the playback is running. The time is inspected every
+         * kPlayTimeCheckInterval steps. The display text is rendered at the end of the slice.
+         * So, the display shows the progress of the calculation.
+         *
+         * The result of the whole playback is same as Play().
+         */
+        PlayState ResumePlay(unsigned int step_budget, double time_budget = 0);
+
+        /**
+         * @brief Cancel the playback.
+         * @details
+         * The stack keeps the state after the last played step.
+         */
+        void CancelPlay();
+
+        /**
+         * @brief Get the state of the playback.
+         */
+        PlayState GetPlayState();
+
+        /**
+         * @brief Get the progress of the playback.
+         *
+         * @param played_steps Number of the played steps.
+         * @param total_steps Number of the steps of the program.
+         */
+        void GetPlayProgress(unsigned int &played_steps, unsigned int &total_steps);
+
+        /**
+         * @brief Number of the steps between the inspections of the time budget in ResumePlay().
+         */
+        static const unsigned int kPlayTimeCheckInterval = 16;
+
     private:
         StackStrategy<StackElement> engine_;
         bool is_func_key_pressed_;
@@ -242,6 +436,21 @@ namespace rpn_engine
         char exponent_buffer_[kNumberOfDigits + 1];
         // User variable to store the data .
         StackElement user_variable_;
+        // Program memory to record the input. nullptr if not recording.
+        ProgramMemory *recording_program_;
+        // Skip the rendering in PostExecutionProcess(). Set during Play().
+        bool is_rendering_deferred_;
+        // Program on the playback. nullptr if not running or in ResumePlay().
+        const ProgramMemory *playing_program_;
+        // Suspended playback. Valid until the playback ends.
+        const ProgramMemory *suspended_program_;
+        // Nibble position of the next step of the playback.
+        unsigned int play_position_;
+        // Number of the played steps.
+        unsigned int played_steps_;
+        // Number of the steps of the program on the playback.
+        unsigned int total_play_steps_;
+        PlayState play_state_;
 
         /**
          * @brief Set the IsFuncKeyPressed state
@@ -276,9 +485,22 @@ namespace rpn_engine
          *
          * The text format follows  display_mode_. The position of decimal point
          * is stored to decimal_point_position_
+         *
+         * The rendering is skipped while is_rendering_deferred_ is true.
          */
         void PostExecutionProcess();
 
+        /**
+         * @brief Convert a value to the text presentation.
+         *
+         * @param x Value to convert.
+         * @param text Buffer to store the kNumberOfDigits characters with null termination.
+         * @param decimal_point_position Position of the decimal point of the text.
+         * @details
+         * The text format follows display_mode_ and is_hex_mode_.
+         */
+        void Render(const StackElement &x, char text[], int32_t &decimal_point_position);
+
         /**
          * @brief Handle opcode for "operation"
          *
@@ -295,28 +517,46 @@ namespace rpn_engine
         void HandleEditingOp(rpn_engine::Op opcode);
 
         /**
-         * @brief Convert the number of stack top to the text presentation in the fixed mode.
+         * @brief Convert the number to the text presentation in the fixed mode.
+         * @param value Number to convert.
+         * @param text Buffer to store the result.
+         * @param decimal_point_position Position of the decimal point of the result.
          * @details
-         * The result is stored in the text_buffer_ and decimal_point_position_.
          * If the number is bigger than or smaller than the one which
          * 8digit fixed number can represent, the number is rendered as
          * the scientific mode.
          */
-        void RenderFixedMode();
+        static void RenderFixedMode(double value, char text[], int32_t &decimal_point_position);
 
         /**
-         * @brief Convert the numver of the stack top to the text presentation in the scientific mode.
+         * @brief Convert the number to the text presentation in the scientific mode.
+         * @param value Number to convert.
+         * @param text Buffer to store the result.
+         * @param decimal_point_position Position of the decimal point of the result.
          * @param engineering_mode true : engineering mode, false : scientific mode.
          */
-        void RenderScientificMode(bool engineering_mode);
+        static void RenderScientificMode(double value, char text[], int32_t &decimal_point_position, bool engineering_mode);
 
         /**
-         * @brief Convert the number of stack top to the hex representation.
+         * @brief Convert the number to the hex representation.
+         * @param value Number to convert.
+         * @param text Buffer to store the result.
+         * @param decimal_point_position Position of the decimal point of the result.
          * @details
          * Before conversion, the value is rounded to integer .
          * The value is displayed as 32bit integer in hex format.
          *
          */
-        void RenderHexMode();
+        static void RenderHexMode(double value, char text[], int32_t &decimal_point_position);
+
+        /**
+         * @brief Convert a finite number to the text presentation.
+         * @param value Number to convert.
+         * @param mode Display format of the decimal mode.
+         * @param is_hex_mode Render in the hex mode.
+         * @param text Buffer to store the result.
+         * @param decimal_point_position Position of the decimal point of the result.
+         */
+        static void RenderNumber(double value, DisplayMode mode, bool is_hex_mode, char text[], int32_t &decimal_point_position);
     };
 }
\ No newline at end of file
@@ -0,0 +1,17 @@
+/**
+ * @file dataflowevaluator.cpp
+ * @author Seiichi "Suikan" Horie
+ * @brief Explicit instantiation of the DataflowEvaluator class template.
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2026
+ *
+ * @details
+ * The dataflowevaluator.hpp declares these specializations as extern template.
+ * Thus, the member functions of these specializations are compiled only here.
+ */
+#include "dataflowevaluator.hpp"
+
+template class rpn_engine::DataflowEvaluator<double>;
+template class rpn_engine::DataflowEvaluator<std::complex<double>>;
@@ -0,0 +1,340 @@
+#pragma once
+/**
+ * @file dataflowevaluator.hpp
+ * @author Seiichi "Suikan" Horie
+ * @brief Incremental evaluation of the straight line program.
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#include "expressiongraph.hpp"
+#include "virtualmachine.hpp"
+#include <cassert>
+#include <complex>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <queue>
+#include <vector>
+
+namespace rpn_engine
+{
+    /**
+     * @brief Spreadsheet like recalculation of a program.
+     *
+     * @tparam Element Element type. double or std::complex<double>.
+     * @details
+     * Load() lifts the program to the ExpressionGraph. The initial values of the stack
+     * and the registers are the sources of the graph. Each node keeps its value.
+     *
+     * SetInput() and SetRegister() change a source and mark the nodes which use it.
+     * Update() recalculates only the marked nodes in the order of the program. If the
+     * new value of a node is same as the old value bit by bit, the nodes which use it are not
+     * marked ( early cutoff ). So, the cost of Update() is proportional to the number
+     * of the affected nodes, not the length of the program.
+     *
+     * The nodes which don't reach the final stack or the registers are never calculated.
+     *
+     * The program must be a straight line program accepted by the ExpressionGraph with
+     * the registers. The values are calculated by the kernels as same as the
+     * VirtualMachine. But the floating point status is not recorded.
+     */
+    template <class Element>
+    class DataflowEvaluator
+    {
+    public:
+        /**
+         * @brief Construct a new evaluator.
+         *
+         * @param stack_size Depth of the stack.
+         */
+        DataflowEvaluator(unsigned int stack_size = 4);
+
+        /**
+         * @brief Analyze the program and calculate all nodes.
+         *
+         * @param program Array of the opcode.
+         * @param length Number of the opcode in the program.
+         * @return true Loaded.
+         * @return false The program is not supported. See GetErrorPosition(). The evaluator
+         * runs the empty program.
+         * @details
+         * The values given by SetInput() and SetRegister() are kept.
+         */
+        bool Load(const Op program[], std::size_t length);
+
+        /**
+         * @brief Position of the unsupported opcode found by the last Load().
+         */
+        std::size_t GetErrorPosition() const;
+
+        /**
+         * @brief Set the initial value of a stack position.
+         *
+         * @param position Stack position. 0 is X.
+         * @param value Value before the program.
+         */
+        void SetInput(unsigned int position, const Element &value);
+
+        /**
+         * @brief Set the initial value of a register.
+         *
+         * @param index Register number. 0 .. kNumberOfVmRegisters-1.
+         * @param value Value before the program.
+         */
+        void SetRegister(unsigned int index, const Element &value);
+
+        /**
+         * @brief Recalculate the nodes affected by the changed sources.
+         *
+         * @return Number of the recalculated nodes.
+         */
+        std::size_t Update();
+
+        /**
+         * @brief Get the stack after the program.
+         *
+         * @param position Stack position. 0 is X.
+         * @details
+         * Call Update() after changing the sources.
+         */
+        const Element &Get(unsigned int position) const;
+
+        /**
+         * @brief Get the register after the program.
+         *
+         * @param index Register number. 0 .. kNumberOfVmRegisters-1.
+         */
+        const Element &GetRegister(unsigned int index) const;
+
+        /**
+         * @brief The graph of the loaded program.
+         */
+        const ExpressionGraph &GetGraph() const;
+
+    private:
+        ExpressionGraph graph_;
+        std::vector<Element> inputs_;             // Initial stack.
+        std::vector<Element> register_inputs_;    // Initial registers.
+        std::vector<uint32_t> recall_nodes_;      // Recall node of each register, or kNoNode.
+        std::vector<Element> values_;             // Value of each node.
+        std::vector<bool> is_live_;               // The node reaches the stack or the registers.
+        std::vector<uint32_t> dependent_begin_;   // Dependents of the node i are dependents_[dependent_begin_[i] .. dependent_begin_[i+1]).
+        std::vector<uint32_t> dependents_;        // Live nodes which use the node.
+        std::vector<bool> is_queued_;             // The node is in the pending_.
+        std::priority_queue<uint32_t, std::vector<uint32_t>, std::greater<uint32_t>> pending_; // Smallest index first.
+
+        /**
+         * @brief Compare bit by bit. +0 and -0 are different, and the same NaN is same.
+         */
+        static bool IsSame(const Element &a, const Element &b);
+
+        /**
+         * @brief Change the value of a source node and mark its dependents.
+         */
+        void SetSource(uint32_t node, const Element &value);
+
+        /**
+         * @brief Mark the dependents of a node.
+         */
+        void Invalidate(uint32_t node);
+    };
+}
+
+template <class Element>
+rpn_engine::DataflowEvaluator<Element>::DataflowEvaluator(unsigned int stack_size) : graph_(stack_size),
+                                                                                      inputs_(stack_size, Element(0)),
+                                                                                      register_inputs_(kNumberOfVmRegisters, Element(0)),
+                                                                                      recall_nodes_(kNumberOfVmRegisters, ExpressionGraph::kNoNode)
+{
+    Load(nullptr, 0);
+}
+
+template <class Element>
+bool rpn_engine::DataflowEvaluator<Element>::Load(const Op program[], std::size_t length)
+{
+    // Run the empty program if failed.
+    const bool is_built = graph_.Build(program, length, true);
+    if (!is_built)
+        graph_.Build(nullptr, 0, true);
+
+    const std::size_t count = graph_.GetNodeCount();
+    const unsigned int stack_size = graph_.GetStackSize();
+
+    // Liveness from the final stack and registers. The operands have smaller index.
+    is_live_.assign(count, false);
+    for (unsigned int i = 0; i < stack_size; i++)
+        is_live_[graph_.GetStackNode(i)] = true;
+    for (unsigned int i = 0; i < kNumberOfVmRegisters; i++)
+        if (graph_.GetRegisterNode(i) != ExpressionGraph::kNoNode)
+            is_live_[graph_.GetRegisterNode(i)] = true;
+    for (std::size_t i = count; i-- > 0;)
+    {
+        const ExpressionGraph::Node &node = graph_.GetNode(i);
+        if (!is_live_[i])
+            continue;
+        if (node.kind == ExpressionGraph::NodeKind::unary || node.kind == ExpressionGraph::NodeKind::binary)
+            is_live_[node.operand[0]] = true;
+        if (node.kind == ExpressionGraph::NodeKind::binary)
+            is_live_[node.operand[1]] = true;
+    }
+
+    // Dependents of the live nodes in the compressed row form.
+    dependent_begin_.assign(count + 1, 0);
+    for (std::size_t i = 0; i < count; i++)
+    {
+        const ExpressionGraph::Node &node = graph_.GetNode(i);
+        if (!is_live_[i])
+            continue;
+        if (node.kind == ExpressionGraph::NodeKind::unary || node.kind == ExpressionGraph::NodeKind::binary)
+            dependent_begin_[node.operand[0] + 1]++;
+        if (node.kind == ExpressionGraph::NodeKind::binary && node.operand[1] != node.operand[0])
+            dependent_begin_[node.operand[1] + 1]++;
+    }
+    for (std::size_t i = 0; i < count; i++)
+        dependent_begin_[i + 1] += dependent_begin_[i];
+    dependents_.resize(dependent_begin_[count]);
+    std::vector<uint32_t> fill(dependent_begin_.begin(), dependent_begin_.end() - 1);
+    for (std::size_t i = 0; i < count; i++)
+    {
+        const ExpressionGraph::Node &node = graph_.GetNode(i);
+        if (!is_live_[i])
+            continue;
+        if (node.kind == ExpressionGraph::NodeKind::unary || node.kind == ExpressionGraph::NodeKind::binary)
+            dependents_[fill[node.operand[0]]++] = static_cast<uint32_t>(i);
+        if (node.kind == ExpressionGraph::NodeKind::binary && node.operand[1] != node.operand[0])
+            dependents_[fill[node.operand[1]]++] = static_cast<uint32_t>(i);
+    }
+
+    // Calculate all live nodes.
+    values_.assign(count, Element(0));
+    recall_nodes_.assign(kNumberOfVmRegisters, ExpressionGraph::kNoNode);
+    for (std::size_t i = 0; i < count; i++)
+    {
+        const ExpressionGraph::Node &node = graph_.GetNode(i);
+        if (node.kind == ExpressionGraph::NodeKind::input)
+            values_[i] = inputs_[node.operand[0]];
+        else if (node.kind == ExpressionGraph::NodeKind::recall)
+        {
+            recall_nodes_[node.operand[0]] = static_cast<uint32_t>(i);
+            values_[i] = register_inputs_[node.operand[0]];
+        }
+        else if (is_live_[i])
+        {
+            const Element &x = values_[node.kind == ExpressionGraph::NodeKind::binary ? node.operand[1] : node.operand[0]];
+            values_[i] = ExpressionGraph::Apply(node, values_[node.operand[0]], x);
+        }
+    }
+    is_queued_.assign(count, false);
+    pending_ = decltype(pending_)();
+    return is_built;
+}
+
+template <class Element>
+std::size_t rpn_engine::DataflowEvaluator<Element>::GetErrorPosition() const
+{
+    return graph_.GetErrorPosition();
+}
+
+template <class Element>
+void rpn_engine::DataflowEvaluator<Element>::SetInput(unsigned int position, const Element &value)
+{
+    assert(position < graph_.GetStackSize());
+    inputs_[position] = value;
+    SetSource(position, value); // The node i is the input of the stack position i.
+}
+
+template <class Element>
+void rpn_engine::DataflowEvaluator<Element>::SetRegister(unsigned int index, const Element &value)
+{
+    assert(index < kNumberOfVmRegisters);
+    register_inputs_[index] = value;
+    if (recall_nodes_[index] != ExpressionGraph::kNoNode)
+        SetSource(recall_nodes_[index], value);
+}
+
+template <class Element>
+bool rpn_engine::DataflowEvaluator<Element>::IsSame(const Element &a, const Element &b)
+{
+    return std::memcmp(&a, &b, sizeof(Element)) == 0;
+}
+
+template <class Element>
+void rpn_engine::DataflowEvaluator<Element>::SetSource(uint32_t node, const Element &value)
+{
+    if (IsSame(values_[node], value))
+        return;
+    values_[node] = value;
+    Invalidate(node);
+}
+
+template <class Element>
+void rpn_engine::DataflowEvaluator<Element>::Invalidate(uint32_t node)
+{
+    for (uint32_t i = dependent_begin_[node]; i < dependent_begin_[node + 1]; i++)
+    {
+        uint32_t dependent = dependents_[i];
+        if (!is_queued_[dependent])
+        {
+            is_queued_[dependent] = true;
+            pending_.push(dependent);
+        }
+    }
+}
+
+template <class Element>
+std::size_t rpn_engine::DataflowEvaluator<Element>::Update()
+{
+    // The dependents have larger index. So, a node is calculated after all its operands.
+    std::size_t count = 0;
+    while (!pending_.empty())
+    {
+        uint32_t index = pending_.top();
+        pending_.pop();
+        is_queued_[index] = false;
+
+        const ExpressionGraph::Node &node = graph_.GetNode(index);
+        const Element &x = values_[node.kind == ExpressionGraph::NodeKind::binary ? node.operand[1] : node.operand[0]];
+        const Element &y = values_[node.operand[0]];
+        Element value = ExpressionGraph::Apply(node, y, x);
+        count++;
+
+        if (!IsSame(value, values_[index])) // Early cutoff if same.
+        {
+            values_[index] = value;
+            Invalidate(index);
+        }
+    }
+    return count;
+}
+
+template <class Element>
+const Element &rpn_engine::DataflowEvaluator<Element>::Get(unsigned int position) const
+{
+    assert(position < graph_.GetStackSize());
+    return values_[graph_.GetStackNode(position)];
+}
+
+template <class Element>
+const Element &rpn_engine::DataflowEvaluator<Element>::GetRegister(unsigned int index) const
+{
+    assert(index < kNumberOfVmRegisters);
+    uint32_t node = graph_.GetRegisterNode(index);
+    return node == ExpressionGraph::kNoNode ? register_inputs_[index] : values_[node];
+}
+
+template <class Element>
+const rpn_engine::ExpressionGraph &rpn_engine::DataflowEvaluator<Element>::GetGraph() const
+{
+    return graph_;
+}
+
+#ifndef RPN_ENGINE_HEADER_ONLY
+// Compiled in dataflowevaluator.cpp
+extern template class rpn_engine::DataflowEvaluator<double>;
+extern template class rpn_engine::DataflowEvaluator<std::complex<double>>;
+#endif
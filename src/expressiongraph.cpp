@@ -0,0 +1,263 @@
+#include "expressiongraph.hpp"
+#include "opcode.hpp"
+#include "virtualmachine.hpp"
+#include <cassert>
+
+const uint32_t rpn_engine::ExpressionGraph::kNoNode;
+
+rpn_engine::ExpressionGraph::ExpressionGraph(unsigned int stack_size) : stack_size_(stack_size),
+                                                                        stack_(stack_size),
+                                                                        registers_(kNumberOfVmRegisters, kNoNode),
+                                                                        error_position_(0)
+{
+    assert(stack_size_ >= 2);
+    for (unsigned int i = 0; i < stack_size_; i++)
+        stack_[i] = AddNode(NodeKind::input, Op::nop, i, 0, 0);
+}
+
+uint32_t rpn_engine::ExpressionGraph::AddNode(NodeKind kind, Op opcode, uint32_t operand0, uint32_t operand1, double value)
+{
+    Node node = {kind, opcode, {operand0, operand1}, value};
+    nodes_.push_back(node);
+    return static_cast<uint32_t>(nodes_.size() - 1);
+}
+
+// Same as StackStrategy::Push(). The bottom is lost.
+void rpn_engine::ExpressionGraph::Push(uint32_t node)
+{
+    for (unsigned int i = stack_size_ - 1; i > 0; i--)
+        stack_[i] = stack_[i - 1];
+    stack_[0] = node;
+}
+
+// Same as StackStrategy::Pop(). The bottom is duplicated.
+uint32_t rpn_engine::ExpressionGraph::Pop()
+{
+    uint32_t top = stack_[0];
+    for (unsigned int i = 0; i < stack_size_ - 1; i++)
+        stack_[i] = stack_[i + 1];
+    return top;
+}
+
+bool rpn_engine::ExpressionGraph::Build(const Op program[], std::size_t length, bool allows_registers)
+{
+    // Start from the inputs.
+    nodes_.resize(stack_size_);
+    for (unsigned int i = 0; i < stack_size_; i++)
+        stack_[i] = i;
+    registers_.assign(kNumberOfVmRegisters, kNoNode);
+
+    bool is_pushable = true;
+    std::vector<Op> keys;
+
+    for (std::size_t i = 0; i < length; i++)
+    {
+        Op opcode = program[i];
+
+        // Number. Collect the keys as same as the VirtualMachine.
+        if ((opcode >= Op::num_0 && Op::num_9 >= opcode) || opcode == Op::period || opcode == Op::eex)
+        {
+            keys.clear();
+            std::size_t next = i;
+            for (; next < length; next++)
+            {
+                Op key = program[next];
+                if ((key >= Op::num_0 && Op::num_9 >= key) || key == Op::period || key == Op::eex || key == Op::chs)
+                    keys.push_back(key);
+                else if (key == Op::del)
+                {
+                    keys.pop_back();
+                    if (keys.empty())
+                    {
+                        next++;
+                        break;
+                    }
+                }
+                else
+                    break;
+            }
+            i = next - 1;
+
+            if (keys.empty()) // Deleted all. Same as clx.
+            {
+                stack_[0] = AddNode(NodeKind::constant, Op::clx, 0, 0, 0);
+                is_pushable = false;
+            }
+            else
+            {
+                uint32_t node = AddNode(NodeKind::constant, Op::num_0, 0, 0, ParseNumber(keys.data(), keys.size()));
+                if (is_pushable)
+                    Push(node);
+                else
+                    stack_[0] = node;
+                is_pushable = true;
+            }
+            continue;
+        }
+
+        switch (opcode)
+        {
+        case Op::duplicate:
+        {
+            uint32_t x = Pop();
+            Push(x);
+            Push(x);
+            break;
+        }
+        case Op::swap:
+        {
+            uint32_t x = Pop();
+            uint32_t y = Pop();
+            Push(x);
+            Push(y);
+            break;
+        }
+        case Op::rotate_pop:
+        {
+            uint32_t x = Pop();
+            stack_[stack_size_ - 1] = x;
+            break;
+        }
+        case Op::rotate_push:
+            Push(stack_[stack_size_ - 1]);
+            break;
+        case Op::add:
+        case Op::sub:
+        case Op::mul:
+        case Op::div:
+        case Op::power:
+        {
+            uint32_t x = Pop();
+            uint32_t y = Pop();
+            Push(AddNode(NodeKind::binary, opcode, y, x, 0));
+            break;
+        }
+        case Op::chs: // chs out of the number.
+            opcode = Op::neg;
+            // fall through
+        case Op::neg:
+        case Op::inv:
+        case Op::sqrt:
+        case Op::square:
+        case Op::exp:
+        case Op::log:
+        case Op::log10:
+        case Op::power10:
+        case Op::sin:
+        case Op::cos:
+        case Op::tan:
+        case Op::asin:
+        case Op::acos:
+        case Op::atan:
+        {
+            uint32_t x = Pop();
+            Push(AddNode(NodeKind::unary, opcode, x, 0, 0));
+            break;
+        }
+        case Op::pi:
+        {
+            if (!is_pushable)
+                Pop();
+            Push(AddNode(NodeKind::constant, Op::pi, 0, 0, rpn_engine::pi));
+            break;
+        }
+        case Op::enter:
+        {
+            uint32_t x = Pop();
+            Push(x);
+            Push(x);
+            is_pushable = false;
+            continue;
+        }
+        case Op::clx:
+        case Op::del: // del out of the number.
+            stack_[0] = AddNode(NodeKind::constant, Op::clx, 0, 0, 0);
+            is_pushable = false;
+            continue;
+        case Op::sto:
+        case Op::rcl:
+        {
+            int index = i + 1 < length ? DigitOf(program[i + 1]) : -1;
+            if (!allows_registers || index < 0)
+            {
+                error_position_ = i;
+                return false;
+            }
+            i++;
+            if (opcode == Op::sto)
+            {
+                registers_[index] = stack_[0];
+                continue; // Same as the VirtualMachine. Doesn't change the pushable state.
+            }
+            if (registers_[index] == kNoNode)
+                registers_[index] = AddNode(NodeKind::recall, Op::rcl, index, 0, 0);
+            Push(registers_[index]);
+            break;
+        }
+        case Op::change_display:
+        case Op::hex:
+        case Op::dec:
+        case Op::func:
+        case Op::nop:
+            continue; // Ignored. Same as the VirtualMachine.
+        default:
+            error_position_ = i;
+            return false;
+        }
+        is_pushable = true;
+    }
+    return true;
+}
+
+std::size_t rpn_engine::ExpressionGraph::GetErrorPosition() const
+{
+    return error_position_;
+}
+
+std::size_t rpn_engine::ExpressionGraph::GetNodeCount() const
+{
+    return nodes_.size();
+}
+
+const rpn_engine::ExpressionGraph::Node &rpn_engine::ExpressionGraph::GetNode(uint32_t index) const
+{
+    assert(index < nodes_.size());
+    return nodes_[index];
+}
+
+uint32_t rpn_engine::ExpressionGraph::GetStackNode(unsigned int position) const
+{
+    assert(position < stack_size_);
+    return stack_[position];
+}
+
+uint32_t rpn_engine::ExpressionGraph::GetRegisterNode(unsigned int index) const
+{
+    assert(index < kNumberOfVmRegisters);
+    return registers_[index];
+}
+
+unsigned int rpn_engine::ExpressionGraph::GetStackSize() const
+{
+    return stack_size_;
+}
+
+std::vector<bool> rpn_engine::ExpressionGraph::GetLiveNodes(uint32_t root) const
+{
+    assert(root < nodes_.size());
+    std::vector<bool> live(nodes_.size(), false);
+    live[root] = true;
+
+    // The operands have smaller index. So, one backward scan is enough.
+    for (uint32_t i = root + 1; i-- > 0;)
+    {
+        if (!live[i])
+            continue;
+        const Node &node = nodes_[i];
+        if (node.kind == NodeKind::unary || node.kind == NodeKind::binary)
+            live[node.operand[0]] = true;
+        if (node.kind == NodeKind::binary)
+            live[node.operand[1]] = true;
+    }
+    return live;
+}
@@ -0,0 +1,217 @@
+#pragma once
+/**
+ * @file expressiongraph.hpp
+ * @author Seiichi "Suikan" Horie
+ * @brief Stack effect analysis of the straight line program.
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#include "stackstrategy.hpp"
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace rpn_engine
+{
+    /**
+     * @brief Data flow graph of a straight line program.
+     * @details
+     * Build() runs the program on a symbolic stack. Each stack slot holds the index of
+     * the node which computed the value, instead of the value. Each operation creates a
+     * new node from the nodes of its operands. The stack manipulation like swap and
+     * duplicate doesn't create node. It only moves the indices. So, each node is a
+     * value to be kept in a local variable by a compiler.
+     *
+     * The keys are interpreted as same as the VirtualMachine. The number keys make one
+     * constant node. The enter and clx make the stack non-pushable.
+     *
+     * The nodes are stored in the order of the execution. Thus, the operands of a node
+     * always have smaller indices than the node. The first stack_size nodes are the inputs.
+     * The node i is the initial value of the stack position i.
+     *
+     * Only the opcodes which are the function of the stack are supported. The program
+     * with the complex, bitwise, statistics, random or program opcodes is rejected.
+     * The sto and rcl of the VirtualMachine are accepted if Build() allows the registers.
+     * The sto only binds the node of X to the register. The rcl of the register which
+     * is not stored yet creates a recall node as the initial value of the register.
+     */
+    class ExpressionGraph
+    {
+    public:
+        /**
+         * @brief Kind of the node.
+         */
+        enum class NodeKind : uint8_t
+        {
+            input,    ///< Initial value of the stack. operand[0] is the stack position.
+            constant, ///< Number or pi. The value is in value.
+            unary,    ///< opcode( operand[0] ).
+            binary,   ///< opcode( operand[0], operand[1] ). operand[0] is Y and operand[1] is X.
+            recall,   ///< Initial value of the register. operand[0] is the register number.
+        };
+
+        /**
+         * @brief Node of the graph.
+         */
+        struct Node
+        {
+            NodeKind kind;
+            Op opcode;
+            uint32_t operand[2];
+            double value;
+        };
+
+        /**
+         * @brief GetRegisterNode() value of the register which the program doesn't touch.
+         */
+        static const uint32_t kNoNode = UINT32_MAX;
+
+        /**
+         * @brief Construct an empty graph.
+         *
+         * @param stack_size Depth of the stack. Must be same as the StackStrategy to compare with.
+         */
+        ExpressionGraph(unsigned int stack_size = 4);
+
+        /**
+         * @brief Analyze the program.
+         *
+         * @param program Array of the opcode.
+         * @param length Number of the opcode in the program.
+         * @param allows_registers Accept sto and rcl with the digit operand.
+         * @return true The graph is built.
+         * @return false The program has unsupported opcode. See GetErrorPosition().
+         */
+        bool Build(const Op program[], std::size_t length, bool allows_registers = false);
+
+        /**
+         * @brief Position of the unsupported opcode found by the last Build().
+         */
+        std::size_t GetErrorPosition() const;
+
+        /**
+         * @brief Number of the nodes.
+         */
+        std::size_t GetNodeCount() const;
+
+        /**
+         * @brief Get the node.
+         *
+         * @param index Index of the node.
+         */
+        const Node &GetNode(uint32_t index) const;
+
+        /**
+         * @brief Get the node of a stack position after the program.
+         *
+         * @param position Stack position. 0 is X.
+         * @return Index of the node.
+         */
+        uint32_t GetStackNode(unsigned int position) const;
+
+        /**
+         * @brief Get the node of a register after the program.
+         *
+         * @param index Register number. 0 .. kNumberOfVmRegisters-1.
+         * @return Index of the node. kNoNode if the program doesn't touch the register.
+         */
+        uint32_t GetRegisterNode(unsigned int index) const;
+
+        /**
+         * @brief Depth of the stack.
+         */
+        unsigned int GetStackSize() const;
+
+        /**
+         * @brief Find the nodes needed to calculate a node.
+         *
+         * @param root Index of the node to calculate.
+         * @return live[i] is true if the node i is needed.
+         */
+        std::vector<bool> GetLiveNodes(uint32_t root) const;
+
+        /**
+         * @brief Calculate the value of an operation node.
+         *
+         * @tparam Element Type of the value.
+         * @param node A constant, unary or binary node.
+         * @param y Value of the operand[0] of the binary node.
+         * @param x Value of the operand[0] of the unary node, or the operand[1] of the binary node.
+         * @return Value of the node.
+         * @details
+         * The calculation is done by the functions in kernels.hpp. Thus, the result is same as
+         * the StackStrategy.
+         */
+        template <class Element>
+        static Element Apply(const Node &node, const Element &y, const Element &x);
+
+    private:
+        const unsigned int stack_size_;
+        std::vector<Node> nodes_;
+        std::vector<uint32_t> stack_;
+        std::vector<uint32_t> registers_;
+        std::size_t error_position_;
+
+        uint32_t AddNode(NodeKind kind, Op opcode, uint32_t operand0, uint32_t operand1, double value);
+        void Push(uint32_t node);
+        uint32_t Pop();
+    };
+}
+
+template <class Element>
+Element rpn_engine::ExpressionGraph::Apply(const Node &node, const Element &y, const Element &x)
+{
+    switch (node.opcode)
+    {
+    case Op::num_0:
+    case Op::clx:
+    case Op::pi:
+        return Element(node.value);
+    case Op::add:
+        return kernel::Add(y, x);
+    case Op::sub:
+        return kernel::Subtract(y, x);
+    case Op::mul:
+        return kernel::Multiply(y, x);
+    case Op::div:
+        return kernel::Divide(y, x);
+    case Op::power:
+        return kernel::Power(y, x);
+    case Op::neg:
+        return kernel::Negate(x);
+    case Op::inv:
+        return kernel::Inverse(x);
+    case Op::sqrt:
+        return kernel::Sqrt(x);
+    case Op::square:
+        return kernel::Square(x);
+    case Op::exp:
+        return kernel::Exp(x);
+    case Op::log:
+        return kernel::Log(x);
+    case Op::log10:
+        return kernel::Log10(x);
+    case Op::power10:
+        return kernel::Power10(x);
+    case Op::sin:
+        return kernel::Sin(x);
+    case Op::cos:
+        return kernel::Cos(x);
+    case Op::tan:
+        return kernel::Tan(x);
+    case Op::asin:
+        return kernel::Asin(x);
+    case Op::acos:
+        return kernel::Acos(x);
+    case Op::atan:
+        return kernel::Atan(x);
+    default:
+        assert(false); // Build() doesn't make the other operation.
+        return x;
+    }
+}
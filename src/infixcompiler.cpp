@@ -0,0 +1,476 @@
+#include "infixcompiler.hpp"
+#include "opcode.hpp"
+#include "programtext.hpp"
+#include "virtualmachine.hpp"
+#include <cassert>
+#include <cctype>
+#include <cmath>
+#include <complex>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+// Precedence of the operators. Higher binds tighter.
+static const int kAdditivePrecedence = 1;
+static const int kMultiplicativePrecedence = 2;
+static const int kUnaryPrecedence = 3;
+static const int kPowerPrecedence = 4;
+
+// Functions of the expression.
+static const struct
+{
+    const char *name;
+    rpn_engine::Op opcode;
+    int arity;
+} kFunctions[] = {
+    {"sin", rpn_engine::Op::sin, 1},
+    {"cos", rpn_engine::Op::cos, 1},
+    {"tan", rpn_engine::Op::tan, 1},
+    {"asin", rpn_engine::Op::asin, 1},
+    {"acos", rpn_engine::Op::acos, 1},
+    {"atan", rpn_engine::Op::atan, 1},
+    {"sqrt", rpn_engine::Op::sqrt, 1},
+    {"exp", rpn_engine::Op::exp, 1},
+    {"log", rpn_engine::Op::log, 1},
+    {"log10", rpn_engine::Op::log10, 1},
+    {"conj", rpn_engine::Op::conjugate, 1},
+    {"pow", rpn_engine::Op::power, 2},
+    {"complex", rpn_engine::Op::complex, 2},
+};
+
+// Calculate the operation by the same engine as the Console. Return false if it is not done at the compile time.
+static bool Fold(rpn_engine::Op opcode, double y, double x, double &result)
+{
+    // The Console calculates in complex. For example, its power and sqrt are different
+    // from the ones of double. So, the folding uses the same kernel.
+    rpn_engine::StackStrategy<std::complex<double>> engine(2);
+    engine.Push(y);
+    engine.Push(x);
+    engine.Operation(opcode);
+    const std::complex<double> value = engine.Get(0);
+    result = value.real();
+
+    // NaN, Inf and the complex result are kept as the operation.
+    std::vector<rpn_engine::Op> keys;
+    return value.imag() == 0 && std::isfinite(result) &&
+           (result == rpn_engine::pi || rpn_engine::InfixCompiler::ValueToKeys(result, keys));
+}
+
+rpn_engine::InfixCompiler::InfixCompiler(unsigned int stack_size) : stack_size_(stack_size),
+                                                                    variables_(kNumberOfVmRegisters),
+                                                                    text_(nullptr),
+                                                                    position_(0),
+                                                                    status_(Status::ok),
+                                                                    error_position_(0),
+                                                                    required_depth_(0),
+                                                                    is_number_last_(false)
+{
+}
+
+bool rpn_engine::InfixCompiler::DefineVariable(const std::string &name, unsigned int index)
+{
+    assert(index < kNumberOfVmRegisters);
+    if (!variables_[index].empty() || GetVariableRegister(name) >= 0)
+        return false;
+    variables_[index] = name;
+    return true;
+}
+
+int rpn_engine::InfixCompiler::GetVariableRegister(const std::string &name) const
+{
+    for (unsigned int i = 0; i < kNumberOfVmRegisters; i++)
+        if (variables_[i] == name)
+            return static_cast<int>(i);
+    return -1;
+}
+
+std::size_t rpn_engine::InfixCompiler::GetErrorPosition() const
+{
+    return error_position_;
+}
+
+unsigned int rpn_engine::InfixCompiler::GetRequiredDepth() const
+{
+    return required_depth_;
+}
+
+bool rpn_engine::InfixCompiler::ValueToKeys(double value, std::vector<Op> &keys)
+{
+    if (!std::isfinite(value))
+        return false;
+
+    // Try from the shortest mantissa. The 8 digits is the limit of the Console.
+    for (int precision = 0; precision < 8; precision++)
+    {
+        char text[32];
+        std::snprintf(text, sizeof(text), "%.*e", precision, std::fabs(value));
+
+        // text is "d.ddde+XX"
+        std::string digits(1, text[0]);
+        const char *p = text + 1;
+        if (*p == '.')
+            for (p++; std::isdigit(static_cast<unsigned char>(*p)); p++)
+                digits += *p;
+        int exponent = std::atoi(p + 1);
+        while (digits.size() > 1 && digits.back() == '0')
+            digits.pop_back();
+
+        std::vector<Op> candidate;
+        const int length = static_cast<int>(digits.size());
+        if (exponent >= 0 && exponent < 8 && length <= 8)
+        {
+            // ddd.dd
+            for (int i = 0; i < (length > exponent + 1 ? length : exponent + 1); i++)
+            {
+                if (i == exponent + 1)
+                    candidate.push_back(Op::period);
+                int digit = i < length ? digits[i] - '0' : 0;
+                candidate.push_back(static_cast<Op>(static_cast<unsigned int>(Op::num_0) + digit));
+            }
+            if (std::signbit(value))
+                candidate.push_back(Op::chs);
+        }
+        else if (exponent < 0 && length - exponent - 1 <= 8)
+        {
+            // .000ddd
+            candidate.push_back(Op::period);
+            for (int i = 0; i < -exponent - 1; i++)
+                candidate.push_back(Op::num_0);
+            for (int i = 0; i < length; i++)
+                candidate.push_back(static_cast<Op>(static_cast<unsigned int>(Op::num_0) + digits[i] - '0'));
+            if (std::signbit(value))
+                candidate.push_back(Op::chs);
+        }
+        else if (std::abs(exponent) <= 99)
+        {
+            // d.ddd eex XX
+            for (int i = 0; i < length; i++)
+            {
+                if (i == 1)
+                    candidate.push_back(Op::period);
+                candidate.push_back(static_cast<Op>(static_cast<unsigned int>(Op::num_0) + digits[i] - '0'));
+            }
+            if (std::signbit(value))
+                candidate.push_back(Op::chs);
+            candidate.push_back(Op::eex);
+            int magnitude = std::abs(exponent);
+            if (magnitude >= 10)
+                candidate.push_back(static_cast<Op>(static_cast<unsigned int>(Op::num_0) + magnitude / 10));
+            candidate.push_back(static_cast<Op>(static_cast<unsigned int>(Op::num_0) + magnitude % 10));
+            if (exponent < 0)
+                candidate.push_back(Op::chs);
+        }
+        else
+            return false;
+
+        if (ParseNumber(candidate.data(), candidate.size()) == value)
+        {
+            keys.insert(keys.end(), candidate.begin(), candidate.end());
+            return true;
+        }
+    }
+    return false;
+}
+
+void rpn_engine::InfixCompiler::SkipSpace()
+{
+    while (std::isspace(static_cast<unsigned char>(text_[position_])))
+        position_++;
+}
+
+int rpn_engine::InfixCompiler::Error(Status status, std::size_t position)
+{
+    // Keep the first error.
+    if (status_ == Status::ok)
+    {
+        status_ = status;
+        error_position_ = position;
+    }
+    return -1;
+}
+
+int rpn_engine::InfixCompiler::MakeNumber(double value, std::size_t position)
+{
+    Node node = {NodeKind::number, Op::nop, value, 0, {-1, -1}, position, 1};
+    nodes_.push_back(node);
+    return static_cast<int>(nodes_.size() - 1);
+}
+
+int rpn_engine::InfixCompiler::MakeUnary(Op opcode, int operand, std::size_t position)
+{
+    const Node &x = nodes_[operand];
+    double value;
+    if (x.kind == NodeKind::number && Fold(opcode, 0, x.value, value))
+        return MakeNumber(value, position);
+
+    Node node = {NodeKind::unary, opcode, 0, 0, {operand, -1}, position, x.depth};
+    nodes_.push_back(node);
+    return static_cast<int>(nodes_.size() - 1);
+}
+
+int rpn_engine::InfixCompiler::MakeBinary(Op opcode, int left, int right, std::size_t position)
+{
+    const Node &y = nodes_[left];
+    const Node &x = nodes_[right];
+    double value;
+    if (y.kind == NodeKind::number && x.kind == NodeKind::number && Fold(opcode, y.value, x.value, value))
+        return MakeNumber(value, position);
+
+    // Sethi-Ullman number. The deeper operand is calculated first.
+    unsigned int depth = y.depth == x.depth ? y.depth + 1 : (y.depth > x.depth ? y.depth : x.depth);
+    Node node = {NodeKind::binary, opcode, 0, 0, {left, right}, position, depth};
+    nodes_.push_back(node);
+    return static_cast<int>(nodes_.size() - 1);
+}
+
+int rpn_engine::InfixCompiler::ParseExpression(int min_precedence)
+{
+    int left = ParseUnary();
+
+    while (left >= 0)
+    {
+        SkipSpace();
+        const std::size_t position = position_;
+        Op opcode;
+        int precedence;
+        switch (text_[position_])
+        {
+        case '+':
+            opcode = Op::add;
+            precedence = kAdditivePrecedence;
+            break;
+        case '-':
+            opcode = Op::sub;
+            precedence = kAdditivePrecedence;
+            break;
+        case '*':
+            opcode = Op::mul;
+            precedence = kMultiplicativePrecedence;
+            break;
+        case '/':
+            opcode = Op::div;
+            precedence = kMultiplicativePrecedence;
+            break;
+        case '^':
+            opcode = Op::power;
+            precedence = kPowerPrecedence;
+            break;
+        default:
+            return left; // End of the expression.
+        }
+        if (precedence < min_precedence)
+            break;
+        position_++;
+
+        // The power is right associative. The others are left associative.
+        int right = ParseExpression(opcode == Op::power ? precedence : precedence + 1);
+        if (right < 0)
+            return -1;
+        left = MakeBinary(opcode, left, right, position);
+    }
+    return left;
+}
+
+int rpn_engine::InfixCompiler::ParseUnary()
+{
+    SkipSpace();
+    const std::size_t position = position_;
+    if (text_[position_] == '-')
+    {
+        position_++;
+        int operand = ParseExpression(kUnaryPrecedence);
+        return operand < 0 ? -1 : MakeUnary(Op::neg, operand, position);
+    }
+    if (text_[position_] == '+')
+    {
+        position_++;
+        return ParseExpression(kUnaryPrecedence);
+    }
+    return ParsePrimary();
+}
+
+int rpn_engine::InfixCompiler::ParsePrimary()
+{
+    SkipSpace();
+    const std::size_t start = position_;
+    const char c = text_[position_];
+
+    if (c == '(')
+    {
+        position_++;
+        int node = ParseExpression(kAdditivePrecedence);
+        SkipSpace();
+        if (node < 0)
+            return -1;
+        if (text_[position_] != ')')
+            return Error(Status::syntax_error, position_);
+        position_++;
+        return node;
+    }
+
+    if (std::isdigit(static_cast<unsigned char>(c)) || c == '.')
+    {
+        // digits [. digits] [e [+-] digits]
+        while (std::isdigit(static_cast<unsigned char>(text_[position_])) || text_[position_] == '.')
+            position_++;
+        if (text_[position_] == 'e' || text_[position_] == 'E')
+        {
+            position_++;
+            if (text_[position_] == '+' || text_[position_] == '-')
+                position_++;
+            while (std::isdigit(static_cast<unsigned char>(text_[position_])))
+                position_++;
+        }
+
+        // The value is what the keys give.
+        std::vector<Op> keys;
+        if (!NumberToKeys(std::string(text_ + start, text_ + position_), keys))
+            return Error(Status::syntax_error, start);
+        unsigned int digits = 0;
+        for (std::size_t i = 0; i < keys.size() && keys[i] != Op::eex; i++)
+            digits += DigitOf(keys[i]) >= 0;
+        if (digits > 8)
+            return Error(Status::number_not_enterable, start);
+        return MakeNumber(ParseNumber(keys.data(), keys.size()), start);
+    }
+
+    if (std::isalpha(static_cast<unsigned char>(c)) || c == '_')
+    {
+        while (std::isalnum(static_cast<unsigned char>(text_[position_])) || text_[position_] == '_')
+            position_++;
+        std::string name(text_ + start, text_ + position_);
+        SkipSpace();
+
+        if (text_[position_] == '(')
+        {
+            // Function call
+            position_++;
+            int arguments[2];
+            int count = 0;
+            SkipSpace();
+            if (text_[position_] != ')')
+                while (true)
+                {
+                    int argument = ParseExpression(kAdditivePrecedence);
+                    if (argument < 0)
+                        return -1;
+                    if (count < 2)
+                        arguments[count] = argument;
+                    count++;
+                    SkipSpace();
+                    if (text_[position_] != ',')
+                        break;
+                    position_++;
+                }
+            if (text_[position_] != ')')
+                return Error(Status::syntax_error, position_);
+            position_++;
+
+            for (auto &function : kFunctions)
+                if (name == function.name && count == function.arity)
+                    return count == 1 ? MakeUnary(function.opcode, arguments[0], start)
+                                      : MakeBinary(function.opcode, arguments[0], arguments[1], start);
+            return Error(Status::unknown_function, start);
+        }
+
+        if (name == "pi")
+            return MakeNumber(rpn_engine::pi, start);
+
+        // Variable. Assign a free register if new.
+        int index = GetVariableRegister(name);
+        if (index < 0)
+        {
+            for (unsigned int i = 0; i < kNumberOfVmRegisters && index < 0; i++)
+                if (variables_[i].empty())
+                    index = static_cast<int>(i);
+            if (index < 0)
+                return Error(Status::too_many_variables, start);
+            variables_[index] = name;
+        }
+        Node node = {NodeKind::variable, Op::rcl, 0, static_cast<unsigned int>(index), {-1, -1}, start, 1};
+        nodes_.push_back(node);
+        return static_cast<int>(nodes_.size() - 1);
+    }
+
+    return Error(Status::syntax_error, start);
+}
+
+bool rpn_engine::InfixCompiler::Emit(int index, std::vector<Op> &program)
+{
+    const Node &node = nodes_[index];
+    switch (node.kind)
+    {
+    case NodeKind::number:
+    {
+        std::vector<Op> keys;
+        if (ValueToKeys(node.value, keys))
+        {
+            if (is_number_last_) // Separate two numbers.
+                program.push_back(Op::enter);
+            program.insert(program.end(), keys.begin(), keys.end());
+            is_number_last_ = true;
+            return true;
+        }
+        if (node.value != rpn_engine::pi)
+        {
+            Error(Status::number_not_enterable, node.position);
+            return false;
+        }
+        program.push_back(Op::pi);
+        break;
+    }
+    case NodeKind::variable:
+        program.push_back(Op::rcl);
+        program.push_back(static_cast<Op>(static_cast<unsigned int>(Op::num_0) + node.index));
+        break;
+    case NodeKind::unary:
+        if (!Emit(node.operand[0], program))
+            return false;
+        program.push_back(node.opcode);
+        break;
+    case NodeKind::binary:
+        if (nodes_[node.operand[1]].depth > nodes_[node.operand[0]].depth)
+        {
+            // Calculate the deeper right operand first. Then, swap if needed.
+            if (!Emit(node.operand[1], program) || !Emit(node.operand[0], program))
+                return false;
+            if (node.opcode != Op::add && node.opcode != Op::mul)
+                program.push_back(Op::swap);
+        }
+        else if (!Emit(node.operand[0], program) || !Emit(node.operand[1], program))
+            return false;
+        program.push_back(node.opcode);
+        break;
+    }
+    is_number_last_ = false;
+    return true;
+}
+
+rpn_engine::InfixCompiler::Status rpn_engine::InfixCompiler::Compile(const char *expression, std::vector<Op> &program)
+{
+    nodes_.clear();
+    text_ = expression;
+    position_ = 0;
+    status_ = Status::ok;
+    error_position_ = 0;
+    required_depth_ = 0;
+    is_number_last_ = false;
+    const std::vector<std::string> variables = variables_;
+
+    int root = ParseExpression(kAdditivePrecedence);
+    SkipSpace();
+    if (root >= 0 && text_[position_] != '\0')
+        Error(Status::syntax_error, position_);
+
+    std::vector<Op> code;
+    if (status_ == Status::ok && Emit(root, code))
+    {
+        required_depth_ = nodes_[root].depth;
+        program.insert(program.end(), code.begin(), code.end());
+        if (required_depth_ > stack_size_)
+            status_ = Status::stack_overflow;
+    }
+    else
+        variables_ = variables; // Release the registers assigned by the failed expression.
+    return status_;
+}
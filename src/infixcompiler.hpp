@@ -0,0 +1,166 @@
+#pragma once
+/**
+ * @file infixcompiler.hpp
+ * @author Seiichi "Suikan" Horie
+ * @brief Compiler from the infix expression to the Op program.
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#include "stackstrategy.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace rpn_engine
+{
+    /**
+     * @brief Translate an infix expression to the keystroke program.
+     * @details
+     * The expression is parsed by the precedence climbing :
+     * @li Binary operators : + - * / and ^ ( power, right associative ).
+     * @li Unary minus. -x^2 is -(x^2).
+     * @li Numbers like 12, 0.5 and 6.02e23. pi is the constant.
+     * @li Functions : sin, cos, tan, asin, acos, atan, sqrt, exp, log ( natural ), log10,
+     * pow(y, x), conj(z) and complex(re, im).
+     * @li Variables : Other identifiers. Each variable is a register of the VirtualMachine
+     * and recalled by rcl. The register is given by DefineVariable() or assigned in the order of
+     * the appearance.
+     *
+     * The sub-expression of the numbers only is calculated at the compile time, if the result
+     * can be entered by the keys exactly. For example, 2*3 becomes 6 but 1/3 stays as 1 3 div.
+     * The calculation is done by StackStrategy<std::complex<double>> as the Console does. So,
+     * the folding doesn't change the result. The complex result ( like sqrt(-1) ) is not folded.
+     * Neither is 3^5, because the complex power doesn't give exactly 243.
+     *
+     * The operands are ordered by the Sethi-Ullman numbering. The operand which needs
+     * more stack is calculated first. The swap is inserted if the operator is not commutative.
+     * This order gives the minimum stack depth. If the depth is still more than the stack
+     * size, Compile() reports it. Because the stack machine loses the bottom at the push,
+     * the result of such program is wrong.
+     *
+     * The program without variables can be given to the Console::Input() too. The Console
+     * doesn't have the registers.
+     */
+    class InfixCompiler
+    {
+    public:
+        /**
+         * @brief Result of the compile.
+         */
+        enum class Status
+        {
+            ok,                   ///< Compiled.
+            syntax_error,         ///< Unexpected character or token.
+            unknown_function,     ///< The function name is not known, or wrong number of the arguments.
+            number_not_enterable, ///< The number has more than 8 digits or too large exponent.
+            too_many_variables,   ///< No more register for the variable.
+            stack_overflow,       ///< Compiled. But the program needs deeper stack. See GetRequiredDepth().
+        };
+
+        /**
+         * @brief Construct a new compiler.
+         *
+         * @param stack_size Depth of the stack to run the program.
+         */
+        InfixCompiler(unsigned int stack_size = 4);
+
+        /**
+         * @brief Bind a variable to the register.
+         *
+         * @param name Name of the variable.
+         * @param index Register number. 0 .. kNumberOfVmRegisters-1.
+         * @return true Bound.
+         * @return false The register is used by the other variable, or the name is already bound.
+         */
+        bool DefineVariable(const std::string &name, unsigned int index);
+
+        /**
+         * @brief Get the register of the variable.
+         *
+         * @param name Name of the variable.
+         * @return Register number. -1 if the variable is not defined.
+         */
+        int GetVariableRegister(const std::string &name) const;
+
+        /**
+         * @brief Compile an expression.
+         *
+         * @param expression Null terminated infix expression.
+         * @param program Generated program. The opcodes are appended.
+         * @return Result. The program is appended only if ok or stack_overflow.
+         * @details
+         * The variables found in the expression are kept for the next Compile(), only if the
+         * program is appended. Otherwise, their registers are released.
+         */
+        Status Compile(const char *expression, std::vector<Op> &program);
+
+        /**
+         * @brief Position of the error in the expression by the last Compile().
+         */
+        std::size_t GetErrorPosition() const;
+
+        /**
+         * @brief Stack depth needed by the program of the last Compile().
+         */
+        unsigned int GetRequiredDepth() const;
+
+        /**
+         * @brief Convert a value to the keys.
+         *
+         * @param value Value to convert.
+         * @param keys The keys are appended. Digits, period, eex and chs.
+         * @return true The keys give the exactly same value by the ParseNumber().
+         * @return false The value can't be entered exactly.
+         */
+        static bool ValueToKeys(double value, std::vector<Op> &keys);
+
+    private:
+        enum class NodeKind : uint8_t
+        {
+            number,
+            variable,
+            unary,
+            binary,
+        };
+
+        struct Node
+        {
+            NodeKind kind;
+            Op opcode;
+            double value;
+            unsigned int index;   // Register of the variable.
+            int operand[2];       // Index of the operand nodes.
+            std::size_t position; // Position in the expression.
+            unsigned int depth;   // Sethi-Ullman number. Stack depth to calculate this node.
+        };
+
+        const unsigned int stack_size_;
+        std::vector<std::string> variables_; // Name of the variable in each register.
+        std::vector<Node> nodes_;
+        const char *text_;
+        std::size_t position_;
+        Status status_;
+        std::size_t error_position_;
+        unsigned int required_depth_;
+        bool is_number_last_;
+
+        void SkipSpace();
+        /**
+         * @brief Record the first error.
+         * @return -1 as the invalid node.
+         */
+        int Error(Status status, std::size_t position);
+        int ParseExpression(int min_precedence);
+        int ParseUnary();
+        int ParsePrimary();
+        int MakeNumber(double value, std::size_t position);
+        int MakeUnary(Op opcode, int operand, std::size_t position);
+        int MakeBinary(Op opcode, int left, int right, std::size_t position);
+        bool Emit(int node, std::vector<Op> &program);
+    };
+}
@@ -0,0 +1,170 @@
+#include "integrator.hpp"
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+
+// Definition of the static const member used as a reference.
+const std::size_t rpn_engine::Integrator::kIntervalsPerTask;
+
+namespace
+{
+    // Nodes and weights of the 15 point Kronrod rule on [-1, 1]. The odd nodes are the 7 point Gauss rule.
+    // From QUADPACK qk15.
+    const double kKronrodNodes[8] = {
+        0.991455371120812639206854697526329, 0.949107912342758524526189684047851,
+        0.864864423359769072789712788640926, 0.741531185599394439863864773280788,
+        0.586087235467691130294144845693013, 0.405845151377397166906606412076961,
+        0.207784955007898467600689403773245, 0.000000000000000000000000000000000};
+    const double kKronrodWeights[8] = {
+        0.022935322010529224963732008058970, 0.063092092629978553290700663189204,
+        0.104790010322250183839876322541518, 0.140653259715525918745189590510238,
+        0.169004726639267902826583426598550, 0.190350578064785409913256402421014,
+        0.204432940075298892414161999234649, 0.209482141084727828012999174891714};
+    const double kGaussWeights[4] = {
+        0.129484966168869693270611432679082, 0.279705391489276667901467771423780,
+        0.381830050505118944950369775488975, 0.417959183673469387755102040816327};
+    const std::size_t kNodes = 15;
+}
+
+rpn_engine::Integrator::Integrator(WorkStealingPool &pool, unsigned int stack_size) : pool_(pool),
+                                                                                      absolute_tolerance_(1e-10),
+                                                                                      relative_tolerance_(1e-10),
+                                                                                      evaluation_budget_(0),
+                                                                                      evaluations_(0)
+{
+    for (unsigned int i = 0; i < pool_.GetThreadCount(); i++)
+        workers_.emplace_back(new Worker(stack_size));
+}
+
+bool rpn_engine::Integrator::Load(const Op program[], std::size_t length)
+{
+    bool is_loaded = true;
+    for (auto &worker : workers_)
+        is_loaded = worker->function.Load(program, length) && is_loaded;
+    return is_loaded;
+}
+
+void rpn_engine::Integrator::SetRegister(unsigned int index, double value)
+{
+    for (auto &worker : workers_)
+        worker->function.SetRegister(index, value);
+}
+
+void rpn_engine::Integrator::SetTolerance(double absolute, double relative)
+{
+    absolute_tolerance_ = absolute;
+    relative_tolerance_ = relative;
+}
+
+void rpn_engine::Integrator::SetEvaluationBudget(unsigned long evaluations)
+{
+    evaluation_budget_ = evaluations;
+}
+
+unsigned long rpn_engine::Integrator::GetEvaluationCount() const
+{
+    return evaluations_;
+}
+
+void rpn_engine::Integrator::GaussKronrod(Worker &worker, Interval intervals[], std::size_t count)
+{
+    // All nodes of the intervals are one batch.
+    worker.x.resize(count * kNodes);
+    worker.y.resize(count * kNodes);
+    for (std::size_t i = 0; i < count; i++)
+    {
+        const double center = (intervals[i].a + intervals[i].b) / 2;
+        const double half = (intervals[i].b - intervals[i].a) / 2;
+        double *x = &worker.x[i * kNodes];
+        x[0] = center;
+        for (int j = 0; j < 7; j++)
+        {
+            x[2 * j + 1] = center - half * kKronrodNodes[j];
+            x[2 * j + 2] = center + half * kKronrodNodes[j];
+        }
+    }
+    worker.function.Evaluate(worker.x.data(), worker.y.data(), count * kNodes);
+
+    for (std::size_t i = 0; i < count; i++)
+    {
+        const double half = (intervals[i].b - intervals[i].a) / 2;
+        const double *y = &worker.y[i * kNodes];
+        double kronrod = kKronrodWeights[7] * y[0];
+        double gauss = kGaussWeights[3] * y[0];
+        for (int j = 0; j < 7; j++)
+        {
+            const double sum = y[2 * j + 1] + y[2 * j + 2];
+            kronrod += kKronrodWeights[j] * sum;
+            if (j % 2 == 1)
+                gauss += kGaussWeights[j / 2] * sum;
+        }
+        intervals[i].result = kronrod * half;
+        intervals[i].error = std::fabs((kronrod - gauss) * half);
+    }
+}
+
+void rpn_engine::Integrator::Calculate(std::vector<Interval> &intervals)
+{
+    const std::size_t count = intervals.size();
+    evaluations_ += count * kNodes;
+    pool_.Run([&](unsigned int worker)
+              {
+                  for (std::size_t start = 0; start < count; start += kIntervalsPerTask)
+                      pool_.Spawn(worker, [&, start](unsigned int w)
+                                  { GaussKronrod(*workers_[w], &intervals[start], std::min(kIntervalsPerTask, count - start)); }); });
+}
+
+rpn_engine::Integrator::Status rpn_engine::Integrator::Integrate(double a, double b, double &result, double &error)
+{
+    evaluations_ = 0;
+    std::vector<Interval> intervals(1, Interval{a, b, 0, 0});
+    Calculate(intervals);
+
+    while (true)
+    {
+        // Sum in the order of x.
+        result = 0;
+        error = 0;
+        for (auto &interval : intervals)
+        {
+            result += interval.result;
+            error += interval.error;
+        }
+        if (!std::isfinite(result) || !std::isfinite(error))
+            return Status::not_finite;
+        const double tolerance = std::max(absolute_tolerance_, relative_tolerance_ * std::fabs(result));
+        if (error <= tolerance)
+            return Status::converged;
+
+        // Bisect the intervals which have more error than their share.
+        const double allowed = tolerance / std::fabs(b - a);
+        std::vector<Interval> next, children;
+        std::vector<bool> is_child;
+        for (auto &interval : intervals)
+        {
+            const double middle = (interval.a + interval.b) / 2;
+            if (interval.error > allowed * std::fabs(interval.b - interval.a) && middle != interval.a && middle != interval.b)
+            {
+                children.push_back(Interval{interval.a, middle, 0, 0});
+                children.push_back(Interval{middle, interval.b, 0, 0});
+                next.insert(next.end(), 2, interval);
+                is_child.insert(is_child.end(), 2, true);
+            }
+            else
+            {
+                next.push_back(interval);
+                is_child.push_back(false);
+            }
+        }
+        if (children.empty())
+            return Status::roundoff;
+        if (evaluation_budget_ != 0 && evaluations_ + children.size() * kNodes > evaluation_budget_)
+            return Status::evaluation_budget;
+
+        Calculate(children);
+        for (std::size_t i = 0, j = 0; i < next.size(); i++)
+            if (is_child[i])
+                next[i] = children[j++];
+        intervals.swap(next);
+    }
+}
@@ -0,0 +1,154 @@
+#pragma once
+/**
+ * @file integrator.hpp
+ * @author Seiichi "Suikan" Horie
+ * @brief Numerical integration of the program.
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#include "batchfunction.hpp"
+#include "workstealingpool.hpp"
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+namespace rpn_engine
+{
+    /**
+     * @brief Calculate the definite integral of f(x) given by a program.
+     * @details
+     * The integrand is the program evaluated by the BatchFunction. x is pushed to the
+     * stack filled by zero and X after the program is f(x). The registers are the
+     * parameters.
+     *
+     * Each interval is calculated by the 7 point Gauss and 15 point Kronrod rule.
+     * The Kronrod result is the integral and the difference from the Gauss result
+     * is the error estimation.
+     *
+     * The integration is adaptive in the rounds. In each round, the intervals whose
+     * error per width is larger than the allowed error per width are bisected. Then,
+     * all new intervals are calculated in parallel on the WorkStealingPool. A task
+     * takes several intervals and evaluates their 15 nodes as one batch of the
+     * BatchFunction. The rounds continue until the total error is within the tolerance.
+     *
+     * The intervals are summed in the order of x. So, the result doesn't depend on
+     * the number of the threads.
+     */
+    class Integrator
+    {
+    public:
+        /**
+         * @brief Result of the integration.
+         */
+        enum class Status
+        {
+            converged,         ///< The error estimation is within the tolerance.
+            evaluation_budget, ///< Stopped by the evaluation budget.
+            roundoff,          ///< The intervals can't be bisected any more.
+            not_finite,        ///< The integrand is not finite.
+        };
+
+        /**
+         * @brief Number of the intervals in a task.
+         */
+        static const std::size_t kIntervalsPerTask = 16;
+
+        /**
+         * @brief Construct a new integrator.
+         *
+         * @param pool Thread pool to evaluate the intervals.
+         * @param stack_size Depth of the stack.
+         */
+        Integrator(WorkStealingPool &pool, unsigned int stack_size = 4);
+
+        /**
+         * @brief Load the integrand.
+         *
+         * @param program Array of the opcode.
+         * @param length Number of the opcode in the program.
+         * @return true Loaded.
+         * @return false The program has error. See VirtualMachine::Load().
+         */
+        bool Load(const Op program[], std::size_t length);
+
+        /**
+         * @brief Set a parameter of the integrand.
+         *
+         * @param index Register number. 0 .. kNumberOfVmRegisters-1.
+         * @param value Value of the register.
+         */
+        void SetRegister(unsigned int index, double value);
+
+        /**
+         * @brief Set the tolerance.
+         *
+         * @param absolute Absolute tolerance. The default is 1e-10.
+         * @param relative Relative tolerance. The default is 1e-10.
+         * @details
+         * The integration converges if the error is less than max(absolute, relative * |result|).
+         */
+        void SetTolerance(double absolute, double relative);
+
+        /**
+         * @brief Set the max number of the evaluations of f in an Integrate().
+         *
+         * @param evaluations Number of the evaluations. 0 is no limit. The default is 0.
+         */
+        void SetEvaluationBudget(unsigned long evaluations);
+
+        /**
+         * @brief Calculate the integral from a to b.
+         *
+         * @param a Lower limit.
+         * @param b Upper limit.
+         * @param result The integral.
+         * @param error Estimated absolute error.
+         * @return Result. result and error are the best estimation even if not converged.
+         */
+        Status Integrate(double a, double b, double &result, double &error);
+
+        /**
+         * @brief Number of the evaluations of f in the last Integrate().
+         */
+        unsigned long GetEvaluationCount() const;
+
+    private:
+        struct Interval
+        {
+            double a;
+            double b;
+            double result;
+            double error;
+        };
+
+        // Working area of a worker.
+        struct Worker
+        {
+            BatchFunction function;
+            std::vector<double> x;
+            std::vector<double> y;
+            Worker(unsigned int stack_size) : function(stack_size) {}
+        };
+
+        WorkStealingPool &pool_;
+        std::vector<std::unique_ptr<Worker>> workers_;
+        double absolute_tolerance_;
+        double relative_tolerance_;
+        unsigned long evaluation_budget_;
+        unsigned long evaluations_;
+
+        /**
+         * @brief Calculate the intervals in parallel.
+         */
+        void Calculate(std::vector<Interval> &intervals);
+
+        /**
+         * @brief Calculate the intervals by the Gauss-Kronrod rule in a batch.
+         */
+        static void GaussKronrod(Worker &worker, Interval intervals[], std::size_t count);
+    };
+}
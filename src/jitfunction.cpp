@@ -0,0 +1,444 @@
+#include "jitfunction.hpp"
+#include "expressiongraph.hpp"
+#include <cassert>
+#include <climits>
+#include <cmath>
+#include <cstring>
+#include <vector>
+
+#ifdef RPN_ENGINE_JIT_AVAILABLE
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+rpn_engine::JitFunction::JitFunction() : native_(nullptr),
+                                         buffer_(nullptr),
+                                         buffer_size_(0),
+                                         code_size_(0),
+                                         engine_(4),
+                                         vm_(engine_),
+                                         is_loaded_(false)
+{
+}
+
+rpn_engine::JitFunction::~JitFunction()
+{
+    Release();
+}
+
+void rpn_engine::JitFunction::Release()
+{
+#ifdef RPN_ENGINE_JIT_AVAILABLE
+    if (buffer_ != nullptr)
+        munmap(buffer_, buffer_size_);
+#endif
+    native_ = nullptr;
+    buffer_ = nullptr;
+    buffer_size_ = 0;
+    code_size_ = 0;
+}
+
+bool rpn_engine::JitFunction::Compile(const Op program[], std::size_t length)
+{
+    Release();
+    is_loaded_ = vm_.Load(program, length);
+    if (!is_loaded_)
+        return false;
+
+    GenerateNative(program, length); // Use the VirtualMachine if it fails.
+    return true;
+}
+
+bool rpn_engine::JitFunction::IsNative() const
+{
+    return native_ != nullptr;
+}
+
+std::size_t rpn_engine::JitFunction::GetCodeSize() const
+{
+    return code_size_;
+}
+
+double rpn_engine::JitFunction::operator()(double x, double y) const
+{
+    if (native_ != nullptr)
+        return native_(x, y);
+
+    assert(is_loaded_);
+    engine_.Clear();
+    engine_.Push(y);
+    engine_.Push(x);
+    vm_.Reset();
+    vm_.Run(ULONG_MAX);
+    return engine_.Get(0);
+}
+
+#ifdef RPN_ENGINE_JIT_AVAILABLE
+
+// xmm0 and xmm1 are for the parameters and the return value. The nodes use xmm2 .. xmm15.
+static const int kFirstAllocatableRegister = 2;
+static const int kNumberOfRegisters = 16;
+
+// Each register has its save area at [rsp + 8 * register]. The extra 8 byte aligns rsp
+// to 16 byte at the call.
+static const int32_t kFrameSize = 8 * kNumberOfRegisters + 8;
+
+// Constant pool layout. The numbers in the program follow these.
+static const uint32_t kPoolSignMask = 0; // 16 byte for xorpd.
+static const uint32_t kPoolOne = 16;
+static const uint32_t kPoolTen = 24;
+static const uint32_t kPoolNumbers = 32;
+
+// SSE2 opcodes after 0x0F.
+static const uint8_t kMovsdLoad = 0x10;
+static const uint8_t kMovsdStore = 0x11;
+static const uint8_t kMovapd = 0x28;
+static const uint8_t kSqrtsd = 0x51;
+static const uint8_t kXorpd = 0x57;
+static const uint8_t kAddsd = 0x58;
+static const uint8_t kMulsd = 0x59;
+static const uint8_t kSubsd = 0x5C;
+static const uint8_t kDivsd = 0x5E;
+
+// Prefix of the scalar double and the packed double.
+static const uint8_t kScalarDouble = 0xF2;
+static const uint8_t kPackedDouble = 0x66;
+
+/**
+ * @brief Minimum x86-64 assembler for the JitFunction.
+ * @details
+ * The code is placed after the constant pool in the same buffer. So, the constants
+ * are addressed by the RIP relative addressing.
+ */
+class JitAssembler
+{
+public:
+    JitAssembler(uint32_t pool_size) : pool_size_(pool_size) {}
+
+    std::vector<uint8_t> code_;
+
+    // op xmm(reg), xmm(rm)
+    void RegisterRegister(uint8_t prefix, uint8_t opcode, int reg, int rm)
+    {
+        code_.push_back(prefix);
+        if (reg >= 8 || rm >= 8)
+            code_.push_back(static_cast<uint8_t>(0x40 | ((reg >> 3) << 2) | (rm >> 3))); // REX.R, REX.B
+        code_.push_back(0x0F);
+        code_.push_back(opcode);
+        code_.push_back(static_cast<uint8_t>(0xC0 | ((reg & 7) << 3) | (rm & 7)));
+    }
+
+    // movsd xmm(reg), [rsp + offset] or movsd [rsp + offset], xmm(reg)
+    void RegisterFrame(uint8_t opcode, int reg, int32_t offset)
+    {
+        code_.push_back(kScalarDouble);
+        if (reg >= 8)
+            code_.push_back(0x44); // REX.R
+        code_.push_back(0x0F);
+        code_.push_back(opcode);
+        code_.push_back(static_cast<uint8_t>(0x84 | ((reg & 7) << 3))); // [base + disp32]
+        code_.push_back(0x24);                                           // SIB : base = rsp
+        Dword(static_cast<uint32_t>(offset));
+    }
+
+    // op xmm(reg), [rip + pool]
+    void RegisterPool(uint8_t prefix, uint8_t opcode, int reg, uint32_t pool_offset)
+    {
+        code_.push_back(prefix);
+        if (reg >= 8)
+            code_.push_back(0x44); // REX.R
+        code_.push_back(0x0F);
+        code_.push_back(opcode);
+        code_.push_back(static_cast<uint8_t>(0x05 | ((reg & 7) << 3))); // [rip + disp32]
+        // The displacement is from the end of this instruction.
+        int64_t next = static_cast<int64_t>(pool_size_) + static_cast<int64_t>(code_.size()) + 4;
+        Dword(static_cast<uint32_t>(static_cast<int64_t>(pool_offset) - next));
+    }
+
+    // movapd copies the whole register. movsd between registers merges the upper half,
+    // thus it depends on the last value of the destination.
+    void Move(int destination, int source)
+    {
+        if (destination != source)
+            RegisterRegister(kPackedDouble, kMovapd, destination, source);
+    }
+
+    void AdjustStack(bool is_allocation, int32_t size)
+    {
+        code_.push_back(0x48); // REX.W
+        code_.push_back(0x81);
+        code_.push_back(is_allocation ? 0xEC : 0xC4); // sub rsp / add rsp
+        Dword(static_cast<uint32_t>(size));
+    }
+
+    void Call(const void *function)
+    {
+        uint64_t address;
+        std::memcpy(&address, &function, sizeof(address));
+        code_.push_back(0x48); // mov rax, imm64
+        code_.push_back(0xB8);
+        for (int i = 0; i < 8; i++)
+            code_.push_back(static_cast<uint8_t>(address >> (8 * i)));
+        code_.push_back(0xFF); // call rax
+        code_.push_back(0xD0);
+    }
+
+    void Return() { code_.push_back(0xC3); }
+
+private:
+    uint32_t pool_size_;
+
+    void Dword(uint32_t value)
+    {
+        for (int i = 0; i < 4; i++)
+            code_.push_back(static_cast<uint8_t>(value >> (8 * i)));
+    }
+};
+
+typedef double (*UnaryMathFunction)(double);
+typedef double (*BinaryMathFunction)(double, double);
+
+// The libm function which the kernels.hpp calls for the double.
+static UnaryMathFunction GetMathFunction(rpn_engine::Op opcode)
+{
+    switch (opcode)
+    {
+    case rpn_engine::Op::exp:
+        return static_cast<UnaryMathFunction>(std::exp);
+    case rpn_engine::Op::log:
+        return static_cast<UnaryMathFunction>(std::log);
+    case rpn_engine::Op::log10:
+        return static_cast<UnaryMathFunction>(std::log10);
+    case rpn_engine::Op::sin:
+        return static_cast<UnaryMathFunction>(std::sin);
+    case rpn_engine::Op::cos:
+        return static_cast<UnaryMathFunction>(std::cos);
+    case rpn_engine::Op::tan:
+        return static_cast<UnaryMathFunction>(std::tan);
+    case rpn_engine::Op::asin:
+        return static_cast<UnaryMathFunction>(std::asin);
+    case rpn_engine::Op::acos:
+        return static_cast<UnaryMathFunction>(std::acos);
+    case rpn_engine::Op::atan:
+        return static_cast<UnaryMathFunction>(std::atan);
+    default:
+        return nullptr;
+    }
+}
+
+bool rpn_engine::JitFunction::GenerateNative(const Op program[], std::size_t length)
+{
+    ExpressionGraph graph(4);
+    if (!graph.Build(program, length))
+        return false;
+
+    const uint32_t result = graph.GetStackNode(0);
+    const std::vector<bool> live = graph.GetLiveNodes(result);
+    const uint32_t node_count = static_cast<uint32_t>(live.size());
+
+    // Last user of each node. The register is freed there.
+    std::vector<uint32_t> last_use(node_count, 0);
+    std::vector<uint32_t> pool_offset(node_count, 0);
+    uint32_t pool_size = kPoolNumbers;
+    for (uint32_t i = 0; i < node_count; i++)
+    {
+        if (!live[i])
+            continue;
+        const ExpressionGraph::Node &node = graph.GetNode(i);
+        if (node.kind == ExpressionGraph::NodeKind::unary || node.kind == ExpressionGraph::NodeKind::binary)
+            last_use[node.operand[0]] = i;
+        if (node.kind == ExpressionGraph::NodeKind::binary)
+            last_use[node.operand[1]] = i;
+        if (node.kind == ExpressionGraph::NodeKind::constant)
+        {
+            pool_offset[i] = pool_size;
+            pool_size += 8;
+        }
+    }
+    last_use[result] = UINT32_MAX; // Returned.
+    pool_size = (pool_size + 15) & ~15u;
+
+    // The stack frame is needed only to save the registers at the call.
+    bool has_call = false;
+    for (uint32_t i = 0; i < node_count; i++)
+    {
+        const ExpressionGraph::Node &node = graph.GetNode(i);
+        if (live[i] && (GetMathFunction(node.opcode) != nullptr || node.opcode == Op::power || node.opcode == Op::power10))
+            has_call = true;
+    }
+
+    std::vector<int> location(node_count, -1); // Register of the node.
+    bool is_used[kNumberOfRegisters] = {};
+    JitAssembler a(pool_size);
+
+    if (has_call)
+        a.AdjustStack(true, kFrameSize);
+
+    for (uint32_t i = 0; i < node_count; i++)
+    {
+        if (!live[i])
+            continue;
+        const ExpressionGraph::Node &node = graph.GetNode(i);
+        const uint32_t first = node.operand[0];
+        const uint32_t second = node.operand[1];
+        const bool has_operand = node.kind == ExpressionGraph::NodeKind::unary || node.kind == ExpressionGraph::NodeKind::binary;
+        const bool is_first_dying = has_operand && last_use[first] == i;
+        const bool is_second_dying = node.kind == ExpressionGraph::NodeKind::binary && second != first && last_use[second] == i;
+        const int x = has_operand ? location[first] : -1;
+        const int y = node.kind == ExpressionGraph::NodeKind::binary ? location[second] : -1;
+        const UnaryMathFunction math = node.kind == ExpressionGraph::NodeKind::unary ? GetMathFunction(node.opcode) : nullptr;
+        const bool is_call = math != nullptr || node.opcode == Op::power || node.opcode == Op::power10;
+
+        // Free the first operand before the allocation, so that the result can overwrite it.
+        // The inverse loads 1.0 before reading the operand. So, it must not overwrite.
+        if (is_first_dying && node.opcode != Op::inv)
+            is_used[x] = false;
+        if (is_call && is_second_dying)
+            is_used[y] = false;
+
+        if (is_call)
+        {
+            // Save the live registers. All xmm registers are caller saved.
+            for (int r = kFirstAllocatableRegister; r < kNumberOfRegisters; r++)
+                if (is_used[r])
+                    a.RegisterFrame(kMovsdStore, r, 8 * r);
+
+            if (node.opcode == Op::power)
+            {
+                a.Move(0, x);
+                a.Move(1, y);
+                a.Call(reinterpret_cast<const void *>(static_cast<BinaryMathFunction>(std::pow)));
+            }
+            else if (node.opcode == Op::power10)
+            {
+                a.RegisterPool(kScalarDouble, kMovsdLoad, 0, kPoolTen);
+                a.Move(1, x);
+                a.Call(reinterpret_cast<const void *>(static_cast<BinaryMathFunction>(std::pow)));
+            }
+            else
+            {
+                a.Move(0, x);
+                a.Call(reinterpret_cast<const void *>(math));
+            }
+
+            for (int r = kFirstAllocatableRegister; r < kNumberOfRegisters; r++)
+                if (is_used[r])
+                    a.RegisterFrame(kMovsdLoad, r, 8 * r);
+        }
+
+        // Allocate the register of the result.
+        int d = kFirstAllocatableRegister;
+        while (d < kNumberOfRegisters && is_used[d])
+            d++;
+        if (d == kNumberOfRegisters) // Too many live values.
+            return false;
+        is_used[d] = true;
+        location[i] = d;
+
+        switch (node.kind)
+        {
+        case ExpressionGraph::NodeKind::input:
+            if (node.operand[0] < 2)
+                a.Move(d, static_cast<int>(node.operand[0])); // x in xmm0, y in xmm1
+            else
+                a.RegisterRegister(kPackedDouble, kXorpd, d, d); // The others are 0.
+            break;
+        case ExpressionGraph::NodeKind::constant:
+            a.RegisterPool(kScalarDouble, kMovsdLoad, d, pool_offset[i]);
+            break;
+        default:
+            if (is_call)
+                a.Move(d, 0);
+            else if (node.opcode == Op::inv)
+            {
+                a.RegisterPool(kScalarDouble, kMovsdLoad, d, kPoolOne);
+                a.RegisterRegister(kScalarDouble, kDivsd, d, x);
+            }
+            else if (node.opcode == Op::sqrt)
+                a.RegisterRegister(kScalarDouble, kSqrtsd, d, x);
+            else
+            {
+                // Two operand form : d = x, then d op= operand.
+                a.Move(d, x);
+                switch (node.opcode)
+                {
+                case Op::add:
+                    a.RegisterRegister(kScalarDouble, kAddsd, d, y);
+                    break;
+                case Op::sub:
+                    a.RegisterRegister(kScalarDouble, kSubsd, d, y);
+                    break;
+                case Op::mul:
+                    a.RegisterRegister(kScalarDouble, kMulsd, d, y);
+                    break;
+                case Op::div:
+                    a.RegisterRegister(kScalarDouble, kDivsd, d, y);
+                    break;
+                case Op::square:
+                    a.RegisterRegister(kScalarDouble, kMulsd, d, d);
+                    break;
+                case Op::neg:
+                    a.RegisterPool(kPackedDouble, kXorpd, d, kPoolSignMask);
+                    break;
+                default:
+                    assert(false); // ExpressionGraph doesn't make the other operation.
+                    return false;
+                }
+            }
+            break;
+        }
+
+        if (is_first_dying && node.opcode == Op::inv)
+            is_used[x] = false;
+        if (!is_call && is_second_dying)
+            is_used[y] = false;
+    }
+
+    a.Move(0, location[result]);
+    if (has_call)
+        a.AdjustStack(false, kFrameSize);
+    a.Return();
+
+    // Constant pool
+    std::vector<uint8_t> pool(pool_size, 0);
+    const uint64_t sign_mask = 0x8000000000000000ull;
+    const double one = 1.0;
+    const double ten = 10.0;
+    std::memcpy(&pool[kPoolSignMask], &sign_mask, sizeof(sign_mask));
+    std::memcpy(&pool[kPoolOne], &one, sizeof(one));
+    std::memcpy(&pool[kPoolTen], &ten, sizeof(ten));
+    for (uint32_t i = 0; i < node_count; i++)
+        if (live[i] && graph.GetNode(i).kind == ExpressionGraph::NodeKind::constant)
+            std::memcpy(&pool[pool_offset[i]], &graph.GetNode(i).value, sizeof(double));
+
+    // Write the code to a writable buffer, then make it executable.
+    const std::size_t page_size = static_cast<std::size_t>(sysconf(_SC_PAGESIZE));
+    const std::size_t size = pool_size + a.code_.size();
+    const std::size_t buffer_size = (size + page_size - 1) / page_size * page_size;
+    void *buffer = mmap(nullptr, buffer_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (buffer == MAP_FAILED)
+        return false;
+    uint8_t *bytes = static_cast<uint8_t *>(buffer);
+    std::memcpy(bytes, pool.data(), pool_size);
+    std::memcpy(bytes + pool_size, a.code_.data(), a.code_.size());
+    if (mprotect(buffer, buffer_size, PROT_READ | PROT_EXEC) != 0)
+    {
+        munmap(buffer, buffer_size);
+        return false;
+    }
+
+    buffer_ = buffer;
+    buffer_size_ = buffer_size;
+    code_size_ = size;
+    native_ = reinterpret_cast<NativeFunction>(bytes + pool_size);
+    return true;
+}
+
+#else // RPN_ENGINE_JIT_AVAILABLE
+
+bool rpn_engine::JitFunction::GenerateNative(const Op[], std::size_t)
+{
+    return false; // Not supported platform. Use the VirtualMachine.
+}
+
+#endif // RPN_ENGINE_JIT_AVAILABLE
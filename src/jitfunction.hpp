@@ -0,0 +1,117 @@
+#pragma once
+/**
+ * @file jitfunction.hpp
+ * @author Seiichi "Suikan" Horie
+ * @brief Just in time compiler of the Op program for double.
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#include "stackstrategy.hpp"
+#include "virtualmachine.hpp"
+#include <cstddef>
+
+#if defined(__x86_64__) && defined(__linux__)
+/**
+ * @brief Defined if the JitFunction can generate the native code on this platform.
+ * @details
+ * The generated code follows the System V AMD64 ABI.
+ */
+#define RPN_ENGINE_JIT_AVAILABLE
+#endif
+
+namespace rpn_engine
+{
+    /**
+     * @brief Op program compiled to the x86-64 machine code at run time.
+     * @details
+     * The program is analyzed by the ExpressionGraph. Each needed node is assigned to
+     * one of the xmm2 .. xmm15 registers. Then, the node is translated to the SSE2
+     * instructions :
+     * @li add, sub, mul, div, sqrt, square, neg and inv are inlined.
+     * @li The transcendental functions call the libm. The live registers are saved to the
+     * stack frame during the call.
+     * @li The numbers and pi are loaded from the constant pool at the top of the code buffer.
+     *
+     * The code is written to a buffer by mmap(), then the buffer is changed to read only
+     * and executable by mprotect(). The buffer is freed at the destruction.
+     *
+     * The result is same as the StackStrategy<double> bit by bit because the inlined
+     * instructions are IEEE 754 operations and the libm is same as the kernels.hpp.
+     *
+     * If the program is not a straight line program supported by the ExpressionGraph,
+     * or the platform is not x86-64 Linux, the function falls back to the VirtualMachine.
+     * Calling the native function is thread safe. Calling the fallback is not.
+     */
+    class JitFunction
+    {
+    public:
+        /**
+         * @brief Construct an empty function.
+         */
+        JitFunction();
+
+        /**
+         * @brief Free the code buffer.
+         */
+        ~JitFunction();
+
+        JitFunction(const JitFunction &) = delete;
+        JitFunction &operator=(const JitFunction &) = delete;
+
+        /**
+         * @brief Compile the program.
+         *
+         * @param program Array of the opcode.
+         * @param length Number of the opcode in the program.
+         * @return true The function is ready. It is native or interpreted.
+         * @return false The program can't be loaded by the VirtualMachine either.
+         */
+        bool Compile(const Op program[], std::size_t length);
+
+        /**
+         * @brief Check whether the function runs as the native code.
+         */
+        bool IsNative() const;
+
+        /**
+         * @brief Size of the generated code including the constant pool.
+         * @return Size in byte. 0 if the function is not native.
+         */
+        std::size_t GetCodeSize() const;
+
+        /**
+         * @brief Evaluate the function.
+         *
+         * @param x Initial X. The stack depth is 4.
+         * @param y Initial Y. The other registers are 0.
+         * @return X after the program.
+         */
+        double operator()(double x, double y) const;
+
+    private:
+        typedef double (*NativeFunction)(double x, double y);
+
+        NativeFunction native_;
+        void *buffer_;
+        std::size_t buffer_size_;
+        std::size_t code_size_;
+
+        // Fallback
+        mutable StackStrategy<double> engine_;
+        mutable VirtualMachine<double> vm_;
+        bool is_loaded_;
+
+        void Release();
+
+        /**
+         * @brief Generate the native code.
+         * @return true Success.
+         * @return false The program or the platform is not supported.
+         */
+        bool GenerateNative(const Op program[], std::size_t length);
+    };
+}
@@ -0,0 +1,154 @@
+#pragma once
+/**
+ * @file kernels.hpp
+ * @author Seiichi "Suikan" Horie
+ * @brief Arithmetic kernels of the stack machine.
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+#include <cmath>
+#include <complex>
+
+/**
+ * @brief Element wise calculation of the operations.
+ * @details
+ * StackStrategy pops the operands, calls these functions and pushes the result.
+ * The code generated by the AotCompiler calls the same functions. So, both give
+ * the same result bit by bit.
+ *
+ * The binary functions take the operands in the order of the stack : y is the second
+ * and x is the top. The standard math functions are found by the argument dependent
+ * lookup. So, the element types in the other namespaces can provide their own.
+ */
+namespace rpn_engine
+{
+    namespace kernel
+    {
+        /// @brief y + x
+        template <class T>
+        inline T Add(const T &y, const T &x) { return y + x; }
+
+        /// @brief y - x
+        template <class T>
+        inline T Subtract(const T &y, const T &x) { return y - x; }
+
+        /// @brief y * x
+        template <class T>
+        inline T Multiply(const T &y, const T &x) { return y * x; }
+
+        /// @brief y / x
+        template <class T>
+        inline T Divide(const T &y, const T &x) { return y / x; }
+
+        /// @brief -x
+        template <class T>
+        inline T Negate(const T &x) { return -x; }
+
+        /// @brief 1 / x
+        template <class T>
+        inline T Inverse(const T &x) { return 1.0 / x; }
+
+        /// @brief Square root of x
+        template <class T>
+        inline T Sqrt(const T &x)
+        {
+            using std::sqrt;
+            return sqrt(x);
+        }
+
+        /// @brief x * x
+        template <class T>
+        inline T Square(const T &x) { return x * x; }
+
+        /// @brief e^x
+        template <class T>
+        inline T Exp(const T &x)
+        {
+            using std::exp;
+            return exp(x);
+        }
+
+        /// @brief Natural logarithm of x
+        template <class T>
+        inline T Log(const T &x)
+        {
+            using std::log;
+            return log(x);
+        }
+
+        /// @brief Common logarithm of x
+        template <class T>
+        inline T Log10(const T &x)
+        {
+            using std::log10;
+            return log10(x);
+        }
+
+        /// @brief 10^x
+        template <class T>
+        inline T Power10(const T &x)
+        {
+            using std::pow;
+            return pow(10, x);
+        }
+
+        /// @brief y^x
+        template <class T>
+        inline T Power(const T &y, const T &x)
+        {
+            using std::pow;
+            return pow(y, x);
+        }
+
+        /// @brief sin x
+        template <class T>
+        inline T Sin(const T &x)
+        {
+            using std::sin;
+            return sin(x);
+        }
+
+        /// @brief cos x
+        template <class T>
+        inline T Cos(const T &x)
+        {
+            using std::cos;
+            return cos(x);
+        }
+
+        /// @brief tan x
+        template <class T>
+        inline T Tan(const T &x)
+        {
+            using std::tan;
+            return tan(x);
+        }
+
+        /// @brief asin x
+        template <class T>
+        inline T Asin(const T &x)
+        {
+            using std::asin;
+            return asin(x);
+        }
+
+        /// @brief acos x
+        template <class T>
+        inline T Acos(const T &x)
+        {
+            using std::acos;
+            return acos(x);
+        }
+
+        /// @brief atan x
+        template <class T>
+        inline T Atan(const T &x)
+        {
+            using std::atan;
+            return atan(x);
+        }
+    }
+}
@@ -0,0 +1,507 @@
+#include "matrixelement.hpp"
+#include "stackstrategy.hpp"
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <limits>
+
+using rpn_engine::MatrixElement;
+
+rpn_engine::MatrixElement::MatrixElement(double re, double im) : rows_(1), cols_(1)
+{
+    re_[0] = re;
+    im_[0] = im;
+}
+
+rpn_engine::MatrixElement::MatrixElement(const std::complex<double> &value) : rows_(1), cols_(1)
+{
+    re_[0] = value.real();
+    im_[0] = value.imag();
+}
+
+MatrixElement rpn_engine::MatrixElement::Vector(unsigned int size, const std::complex<double> values[])
+{
+    return Matrix(size, 1, values);
+}
+
+MatrixElement rpn_engine::MatrixElement::Vector(unsigned int size, const double values[])
+{
+    return Matrix(size, 1, values);
+}
+
+MatrixElement rpn_engine::MatrixElement::Matrix(unsigned int rows, unsigned int cols, const std::complex<double> values[])
+{
+    MatrixElement m;
+
+    m.Reshape(rows, cols);
+    for (unsigned int i = 0; i < m.Size(); i++)
+    {
+        m.re_[i] = values[i].real();
+        m.im_[i] = values[i].imag();
+    }
+    return m;
+}
+
+MatrixElement rpn_engine::MatrixElement::Matrix(unsigned int rows, unsigned int cols, const double values[])
+{
+    MatrixElement m;
+
+    m.Reshape(rows, cols);
+    for (unsigned int i = 0; i < m.Size(); i++)
+        m.re_[i] = values[i];
+    return m;
+}
+
+MatrixElement rpn_engine::MatrixElement::Identity(unsigned int size)
+{
+    MatrixElement m;
+
+    m.Reshape(size, size);
+    for (unsigned int i = 0; i < size; i++)
+        m.re_[i * size + i] = 1.0;
+    return m;
+}
+
+unsigned int rpn_engine::MatrixElement::Rows() const
+{
+    return rows_;
+}
+
+unsigned int rpn_engine::MatrixElement::Cols() const
+{
+    return cols_;
+}
+
+bool rpn_engine::MatrixElement::IsScalar() const
+{
+    return rows_ == 1 && cols_ == 1;
+}
+
+unsigned int rpn_engine::MatrixElement::Size() const
+{
+    return rows_ * cols_;
+}
+
+void rpn_engine::MatrixElement::Reshape(unsigned int rows, unsigned int cols)
+{
+    assert(kMaxMatrixDimension >= rows && rows >= 1);
+    assert(kMaxMatrixDimension >= cols && cols >= 1);
+
+    rows_ = rows;
+    cols_ = cols;
+    for (unsigned int i = 0; i < Size(); i++)
+    {
+        re_[i] = 0.0;
+        im_[i] = 0.0;
+    }
+}
+
+MatrixElement rpn_engine::MatrixElement::NaN()
+{
+    return MatrixElement(std::numeric_limits<double>::quiet_NaN(), std::numeric_limits<double>::quiet_NaN());
+}
+
+std::complex<double> rpn_engine::MatrixElement::Get(unsigned int row, unsigned int col) const
+{
+    assert(rows_ > row);
+    assert(cols_ > col);
+    return std::complex<double>(re_[row * cols_ + col], im_[row * cols_ + col]);
+}
+
+void rpn_engine::MatrixElement::Set(unsigned int row, unsigned int col, const std::complex<double> &value)
+{
+    assert(rows_ > row);
+    assert(cols_ > col);
+    re_[row * cols_ + col] = value.real();
+    im_[row * cols_ + col] = value.imag();
+}
+
+double rpn_engine::MatrixElement::real() const
+{
+    return IsScalar() ? re_[0] : std::numeric_limits<double>::quiet_NaN();
+}
+
+double rpn_engine::MatrixElement::imag() const
+{
+    return IsScalar() ? im_[0] : std::numeric_limits<double>::quiet_NaN();
+}
+
+void rpn_engine::MatrixElement::real(double value)
+{
+    if (IsScalar())
+        re_[0] = value;
+    else
+        *this = NaN();
+}
+
+void rpn_engine::MatrixElement::imag(double value)
+{
+    if (IsScalar())
+        im_[0] = value;
+    else
+        *this = NaN();
+}
+
+MatrixElement rpn_engine::operator+(const MatrixElement &y, const MatrixElement &x)
+{
+    MatrixElement r;
+
+    if (y.rows_ == x.rows_ && y.cols_ == x.cols_) // same shape
+    {
+        r.Reshape(y.rows_, y.cols_);
+        for (unsigned int i = 0; i < r.Size(); i++)
+        {
+            r.re_[i] = y.re_[i] + x.re_[i];
+            r.im_[i] = y.im_[i] + x.im_[i];
+        }
+    }
+    else if (x.IsScalar()) // add x to all elements of y
+    {
+        r.Reshape(y.rows_, y.cols_);
+        for (unsigned int i = 0; i < r.Size(); i++)
+        {
+            r.re_[i] = y.re_[i] + x.re_[0];
+            r.im_[i] = y.im_[i] + x.im_[0];
+        }
+    }
+    else if (y.IsScalar()) // add y to all elements of x
+    {
+        r.Reshape(x.rows_, x.cols_);
+        for (unsigned int i = 0; i < r.Size(); i++)
+        {
+            r.re_[i] = y.re_[0] + x.re_[i];
+            r.im_[i] = y.im_[0] + x.im_[i];
+        }
+    }
+    else
+        r = MatrixElement::NaN(); // shape mismatch
+
+    return r;
+}
+
+MatrixElement rpn_engine::operator-(const MatrixElement &x)
+{
+    MatrixElement r;
+
+    r.Reshape(x.rows_, x.cols_);
+    for (unsigned int i = 0; i < r.Size(); i++)
+    {
+        r.re_[i] = -x.re_[i];
+        r.im_[i] = -x.im_[i];
+    }
+    return r;
+}
+
+MatrixElement rpn_engine::operator-(const MatrixElement &y, const MatrixElement &x)
+{
+    return y + (-x);
+}
+
+MatrixElement rpn_engine::operator*(const MatrixElement &y, const MatrixElement &x)
+{
+    MatrixElement r;
+
+    if (y.IsScalar() && x.IsScalar()) // complex multiplication
+        r = MatrixElement(std::complex<double>(y.re_[0], y.im_[0]) * std::complex<double>(x.re_[0], x.im_[0]));
+    else if (y.IsScalar() || x.IsScalar()) // scalar multiplication
+    {
+        const MatrixElement &s = y.IsScalar() ? y : x;
+        const MatrixElement &m = y.IsScalar() ? x : y;
+        double s_re = s.re_[0];
+        double s_im = s.im_[0];
+
+        r.Reshape(m.rows_, m.cols_);
+        for (unsigned int i = 0; i < r.Size(); i++)
+        {
+            r.re_[i] = s_re * m.re_[i] - s_im * m.im_[i];
+            r.im_[i] = s_re * m.im_[i] + s_im * m.re_[i];
+        }
+    }
+    else if (y.cols_ == 1 && x.cols_ == 1 && y.rows_ == x.rows_) // dot product of vectors. Bilinear, not conjugated.
+    {
+        double re = 0.0;
+        double im = 0.0;
+
+        for (unsigned int i = 0; i < y.rows_; i++)
+        {
+            re += y.re_[i] * x.re_[i] - y.im_[i] * x.im_[i];
+            im += y.re_[i] * x.im_[i] + y.im_[i] * x.re_[i];
+        }
+        r = MatrixElement(re, im);
+    }
+    else if (y.cols_ == x.rows_) // matrix product. Including matrix - vector product.
+    {
+        unsigned int n = y.cols_;
+        unsigned int cols = x.cols_;
+
+        r.Reshape(y.rows_, x.cols_);
+        // i-k-j order to make the inner most loop contiguous.
+        for (unsigned int i = 0; i < y.rows_; i++)
+            for (unsigned int k = 0; k < n; k++)
+            {
+                double a_re = y.re_[i * n + k];
+                double a_im = y.im_[i * n + k];
+                for (unsigned int j = 0; j < cols; j++)
+                {
+                    r.re_[i * cols + j] += a_re * x.re_[k * cols + j] - a_im * x.im_[k * cols + j];
+                    r.im_[i * cols + j] += a_re * x.im_[k * cols + j] + a_im * x.re_[k * cols + j];
+                }
+            }
+    }
+    else
+        r = MatrixElement::NaN(); // shape mismatch
+
+    return r;
+}
+
+MatrixElement rpn_engine::operator/(const MatrixElement &y, const MatrixElement &x)
+{
+    MatrixElement r;
+
+    if (x.IsScalar()) // element wise division
+    {
+        std::complex<double> divisor(x.re_[0], x.im_[0]);
+
+        r.Reshape(y.rows_, y.cols_);
+        for (unsigned int i = 0; i < r.Size(); i++)
+        {
+            std::complex<double> q = std::complex<double>(y.re_[i], y.im_[i]) / divisor;
+            r.re_[i] = q.real();
+            r.im_[i] = q.imag();
+        }
+    }
+    else if (x.rows_ == x.cols_ && (y.IsScalar() || y.cols_ == x.rows_)) // Y * inv(X)
+        r = y * x.Inverse();
+    else
+        r = MatrixElement::NaN(); // shape mismatch
+
+    return r;
+}
+
+bool rpn_engine::operator==(const MatrixElement &y, const MatrixElement &x)
+{
+    if (y.rows_ != x.rows_ || y.cols_ != x.cols_)
+        return false;
+
+    for (unsigned int i = 0; i < y.Size(); i++)
+        if (y.re_[i] != x.re_[i] || y.im_[i] != x.im_[i])
+            return false;
+    return true;
+}
+
+MatrixElement rpn_engine::MatrixElement::Inverse() const
+{
+    if (IsScalar())
+        return MatrixElement(1.0 / std::complex<double>(re_[0], im_[0]));
+    if (rows_ != cols_)
+        return NaN();
+
+    const unsigned int n = rows_;
+    std::complex<double> lu[kMaxMatrixDimension][kMaxMatrixDimension];
+    unsigned int permutation[kMaxMatrixDimension];
+
+    // The pivot smaller than the rounding error of the elimination is regarded as zero.
+    // The tolerance is relative to the max row sum norm.
+    double norm = 0.0;
+    for (unsigned int i = 0; i < n; i++)
+    {
+        permutation[i] = i;
+        double row_sum = 0.0;
+        for (unsigned int j = 0; j < n; j++)
+        {
+            lu[i][j] = std::complex<double>(re_[i * n + j], im_[i * n + j]);
+            row_sum += std::abs(lu[i][j]);
+        }
+        norm = std::max(norm, row_sum);
+    }
+    const double tolerance = n * std::numeric_limits<double>::epsilon() * norm;
+
+    // LU decomposition with partial pivoting. L and U are stored in lu[][].
+    for (unsigned int k = 0; k < n; k++)
+    {
+        // search the pivot
+        unsigned int pivot = k;
+        for (unsigned int i = k + 1; i < n; i++)
+            if (std::abs(lu[i][k]) > std::abs(lu[pivot][k]))
+                pivot = i;
+
+        if (!(std::abs(lu[pivot][k]) > tolerance)) // singular or nearly singular matrix. NaN too.
+        {
+            MatrixElement r;
+            r.Reshape(n, n);
+            for (unsigned int i = 0; i < r.Size(); i++)
+                r.re_[i] = r.im_[i] = std::numeric_limits<double>::quiet_NaN();
+            return r;
+        }
+
+        if (pivot != k) // swap rows
+        {
+            for (unsigned int j = 0; j < n; j++)
+                std::swap(lu[k][j], lu[pivot][j]);
+            std::swap(permutation[k], permutation[pivot]);
+        }
+
+        for (unsigned int i = k + 1; i < n; i++)
+        {
+            lu[i][k] /= lu[k][k];
+            for (unsigned int j = k + 1; j < n; j++)
+                lu[i][j] -= lu[i][k] * lu[k][j];
+        }
+    }
+
+    // Solve L U x = P e for each column e of the identity matrix.
+    MatrixElement r;
+    r.Reshape(n, n);
+    for (unsigned int col = 0; col < n; col++)
+    {
+        std::complex<double> v[kMaxMatrixDimension];
+
+        // forward substitution
+        for (unsigned int i = 0; i < n; i++)
+        {
+            v[i] = (permutation[i] == col) ? 1.0 : 0.0;
+            for (unsigned int j = 0; j < i; j++)
+                v[i] -= lu[i][j] * v[j];
+        }
+        // backward substitution
+        for (unsigned int i = n; i-- > 0;)
+        {
+            for (unsigned int j = i + 1; j < n; j++)
+                v[i] -= lu[i][j] * v[j];
+            v[i] /= lu[i][i];
+        }
+        for (unsigned int i = 0; i < n; i++)
+        {
+            r.re_[i * n + col] = v[i].real();
+            r.im_[i * n + col] = v[i].imag();
+        }
+    }
+    return r;
+}
+
+MatrixElement rpn_engine::MatrixElement::Apply(std::complex<double> (*func)(const std::complex<double> &)) const
+{
+    MatrixElement r;
+
+    r.Reshape(rows_, cols_);
+    for (unsigned int i = 0; i < r.Size(); i++)
+    {
+        std::complex<double> v = func(std::complex<double>(re_[i], im_[i]));
+        r.re_[i] = v.real();
+        r.im_[i] = v.imag();
+    }
+    return r;
+}
+
+MatrixElement rpn_engine::MatrixElement::Apply(const MatrixElement &y, const MatrixElement &x,
+                                               std::complex<double> (*func)(const std::complex<double> &, const std::complex<double> &))
+{
+    MatrixElement r;
+
+    if (!(y.rows_ == x.rows_ && y.cols_ == x.cols_) && !x.IsScalar() && !y.IsScalar())
+        return NaN(); // shape mismatch
+
+    const MatrixElement &shape = y.IsScalar() ? x : y;
+    r.Reshape(shape.rows_, shape.cols_);
+    for (unsigned int i = 0; i < r.Size(); i++)
+    {
+        unsigned int iy = y.IsScalar() ? 0 : i;
+        unsigned int ix = x.IsScalar() ? 0 : i;
+        std::complex<double> v = func(std::complex<double>(y.re_[iy], y.im_[iy]),
+                                      std::complex<double>(x.re_[ix], x.im_[ix]));
+        r.re_[i] = v.real();
+        r.im_[i] = v.imag();
+    }
+    return r;
+}
+
+MatrixElement rpn_engine::sqrt(const MatrixElement &x)
+{
+    return x.Apply([](const std::complex<double> &v)
+                   { return std::sqrt(v); });
+}
+
+MatrixElement rpn_engine::exp(const MatrixElement &x)
+{
+    return x.Apply([](const std::complex<double> &v)
+                   { return std::exp(v); });
+}
+
+MatrixElement rpn_engine::log(const MatrixElement &x)
+{
+    return x.Apply([](const std::complex<double> &v)
+                   { return std::log(v); });
+}
+
+MatrixElement rpn_engine::log10(const MatrixElement &x)
+{
+    return x.Apply([](const std::complex<double> &v)
+                   { return std::log10(v); });
+}
+
+MatrixElement rpn_engine::pow(const MatrixElement &y, const MatrixElement &x)
+{
+    return MatrixElement::Apply(y, x, [](const std::complex<double> &a, const std::complex<double> &b)
+                                { return std::pow(a, b); });
+}
+
+MatrixElement rpn_engine::sin(const MatrixElement &x)
+{
+    return x.Apply([](const std::complex<double> &v)
+                   { return std::sin(v); });
+}
+
+MatrixElement rpn_engine::cos(const MatrixElement &x)
+{
+    return x.Apply([](const std::complex<double> &v)
+                   { return std::cos(v); });
+}
+
+MatrixElement rpn_engine::tan(const MatrixElement &x)
+{
+    return x.Apply([](const std::complex<double> &v)
+                   { return std::tan(v); });
+}
+
+MatrixElement rpn_engine::asin(const MatrixElement &x)
+{
+    return x.Apply([](const std::complex<double> &v)
+                   { return std::asin(v); });
+}
+
+MatrixElement rpn_engine::acos(const MatrixElement &x)
+{
+    return x.Apply([](const std::complex<double> &v)
+                   { return std::acos(v); });
+}
+
+MatrixElement rpn_engine::atan(const MatrixElement &x)
+{
+    return x.Apply([](const std::complex<double> &v)
+                   { return std::atan(v); });
+}
+
+MatrixElement rpn_engine::conj(const MatrixElement &x)
+{
+    return x.Apply([](const std::complex<double> &v)
+                   { return std::conj(v); });
+}
+
+double rpn_engine::abs(const MatrixElement &x)
+{
+    return std::abs(std::complex<double>(x.real(), x.imag()));
+}
+
+double rpn_engine::arg(const MatrixElement &x)
+{
+    return std::arg(std::complex<double>(x.real(), x.imag()));
+}
+
+uint32_t rpn_engine::ClassifyElement(const MatrixElement &x)
+{
+    uint32_t status = 0;
+    for (unsigned int i = 0; i < x.Rows(); i++)
+        for (unsigned int j = 0; j < x.Cols(); j++)
+            status |= ClassifyElement(x.Get(i, j));
+    return status;
+}
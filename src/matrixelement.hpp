@@ -0,0 +1,254 @@
+#pragma once
+/**
+ * @file matrixelement.hpp
+ * @author Seiichi "Suikan" Horie
+ * @brief Stack element which holds a scalar, a vector or a matrix.
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+#include <complex>
+#include <cstdint>
+
+namespace rpn_engine
+{
+    /**
+     * @brief Max number of rows and columns of MatrixElement.
+     *
+     */
+    const unsigned int kMaxMatrixDimension = 8;
+
+    /**
+     * @brief Complex scalar, vector or small dense matrix as stack element.
+     * @details
+     * This class can be given to the StackStrategy as Element type parameter.
+     * The shape of the value is given by the number of rows and columns :
+     * @li Scalar : 1 x 1. Both real and complex.
+     * @li Vector : N x 1 column vector. N is 1 .. kMaxMatrixDimension. The vector of 1 element is a scalar.
+     * @li Matrix : R x C. R and C are 1 .. kMaxMatrixDimension.
+     *
+     * The storage is embedded in the object. So, there is no dynamic allocation.
+     * The real part and imaginary part are stored in separated arrays. Thus, the
+     * kernels of the arithmetic operations are simple loops on double arrays
+     * which the compiler can vectorize.
+     *
+     * The arithmetic operations are :
+     * @li Y + X, Y - X : Element wise. If one of them is scalar, it is applied to all elements.
+     * @li Y * X : Scalar multiplication, matrix product ( matrix-vector product is included ),
+     * or dot product of two vectors. The dot product is the bilinear form sum(y[i] * x[i]) without
+     * the conjugate. Apply conj() to Y for the Hermitian inner product.
+     * @li Y / X : Y * inv(X) if X is a square matrix. Element wise division if X is scalar.
+     * @li -X : Element wise negation.
+     * @li 1 / X : Inverse matrix by LU decomposition with partial pivoting if X is a square matrix.
+     *
+     * The transcendental functions are applied element wise. The complex specific
+     * functions ( real(), imag(), abs(), arg() ) are valid only for scalars. They return NaN
+     * for vectors and matrices.
+     *
+     * If the shapes of the operands don't match, the result is a scalar NaN.
+     * If the matrix to invert is singular, all elements of the result are NaN. A pivot not larger
+     * than n * epsilon * ||X|| ( the max row sum norm ) is regarded as zero. So is the nearly
+     * singular matrix, because its inverse is dominated by the rounding error.
+     */
+    class MatrixElement
+    {
+    public:
+        /**
+         * @brief Construct a new scalar object
+         *
+         * @param re Real part.
+         * @param im Imaginary part.
+         */
+        MatrixElement(double re = 0, double im = 0);
+
+        /**
+         * @brief Construct a new scalar object from complex value.
+         *
+         * @param value Initial value.
+         */
+        MatrixElement(const std::complex<double> &value);
+
+        /**
+         * @brief Create a column vector
+         *
+         * @param size Number of elements. 1 .. kMaxMatrixDimension.
+         * @param values Initial values.
+         * @return Created vector.
+         */
+        static MatrixElement Vector(unsigned int size, const std::complex<double> values[]);
+
+        /**
+         * @brief Create a column vector from real values.
+         *
+         * @param size Number of elements. 1 .. kMaxMatrixDimension.
+         * @param values Initial values.
+         * @return Created vector.
+         */
+        static MatrixElement Vector(unsigned int size, const double values[]);
+
+        /**
+         * @brief Create a matrix
+         *
+         * @param rows Number of rows. 1 .. kMaxMatrixDimension.
+         * @param cols Number of columns. 1 .. kMaxMatrixDimension.
+         * @param values Initial values in row major order.
+         * @return Created matrix.
+         */
+        static MatrixElement Matrix(unsigned int rows, unsigned int cols, const std::complex<double> values[]);
+
+        /**
+         * @brief Create a matrix from real values
+         *
+         * @param rows Number of rows. 1 .. kMaxMatrixDimension.
+         * @param cols Number of columns. 1 .. kMaxMatrixDimension.
+         * @param values Initial values in row major order.
+         * @return Created matrix.
+         */
+        static MatrixElement Matrix(unsigned int rows, unsigned int cols, const double values[]);
+
+        /**
+         * @brief Create an identity matrix
+         *
+         * @param size Number of rows and columns. 1 .. kMaxMatrixDimension.
+         * @return Created matrix.
+         */
+        static MatrixElement Identity(unsigned int size);
+
+        /**
+         * @brief Number of rows
+         */
+        unsigned int Rows() const;
+
+        /**
+         * @brief Number of columns
+         */
+        unsigned int Cols() const;
+
+        /**
+         * @brief Is this object 1 x 1?
+         */
+        bool IsScalar() const;
+
+        /**
+         * @brief Get an element.
+         *
+         * @param row Row of the element.
+         * @param col Column of the element.
+         * @return Value of the element.
+         */
+        std::complex<double> Get(unsigned int row, unsigned int col = 0) const;
+
+        /**
+         * @brief Set an element.
+         *
+         * @param row Row of the element.
+         * @param col Column of the element.
+         * @param value Value to set.
+         */
+        void Set(unsigned int row, unsigned int col, const std::complex<double> &value);
+
+        /**
+         * @brief Real part of the scalar. NaN for vector and matrix.
+         */
+        double real() const;
+
+        /**
+         * @brief Imaginary part of the scalar. NaN for vector and matrix.
+         */
+        double imag() const;
+
+        /**
+         * @brief Set the real part of the scalar. Vector and matrix become NaN.
+         */
+        void real(double value);
+
+        /**
+         * @brief Set the imaginary part of the scalar. Vector and matrix become NaN.
+         */
+        void imag(double value);
+
+        friend MatrixElement operator+(const MatrixElement &y, const MatrixElement &x);
+        friend MatrixElement operator-(const MatrixElement &y, const MatrixElement &x);
+        friend MatrixElement operator*(const MatrixElement &y, const MatrixElement &x);
+        friend MatrixElement operator/(const MatrixElement &y, const MatrixElement &x);
+        friend MatrixElement operator-(const MatrixElement &x);
+        friend bool operator==(const MatrixElement &y, const MatrixElement &x);
+
+        /**
+         * @brief Apply a complex function to all elements.
+         *
+         * @param func Function to apply.
+         * @return Result of the same shape.
+         */
+        MatrixElement Apply(std::complex<double> (*func)(const std::complex<double> &)) const;
+
+        /**
+         * @brief Apply a binary complex function to all elements.
+         *
+         * @param y Left operand.
+         * @param x Right operand.
+         * @param func Function to apply. func(y, x) is calculated.
+         * @return Result. If one of the operand is scalar, it is applied to all elements.
+         */
+        static MatrixElement Apply(const MatrixElement &y, const MatrixElement &x,
+                                   std::complex<double> (*func)(const std::complex<double> &, const std::complex<double> &));
+
+        /**
+         * @brief Inverse matrix.
+         *
+         * @return 1/X for scalar. Inverse matrix by LU decomposition for square matrix.
+         * NaN for others.
+         */
+        MatrixElement Inverse() const;
+
+    private:
+        unsigned char rows_;
+        unsigned char cols_;
+        double re_[kMaxMatrixDimension * kMaxMatrixDimension];
+        double im_[kMaxMatrixDimension * kMaxMatrixDimension];
+
+        /**
+         * @brief Number of valid elements in re_ and im_.
+         */
+        unsigned int Size() const;
+
+        /**
+         * @brief Set the shape and fill all elements by zero.
+         */
+        void Reshape(unsigned int rows, unsigned int cols);
+
+        /**
+         * @brief Scalar NaN as the result of the invalid operation.
+         */
+        static MatrixElement NaN();
+    };
+
+    // Arithmetic operators. See MatrixElement for the rule of the shapes.
+    MatrixElement operator+(const MatrixElement &y, const MatrixElement &x);
+    MatrixElement operator-(const MatrixElement &y, const MatrixElement &x);
+    MatrixElement operator*(const MatrixElement &y, const MatrixElement &x);
+    MatrixElement operator/(const MatrixElement &y, const MatrixElement &x);
+    MatrixElement operator-(const MatrixElement &x);
+    bool operator==(const MatrixElement &y, const MatrixElement &x);
+
+    // Element wise functions. They are found by the StackStrategy through the argument dependent lookup.
+    MatrixElement sqrt(const MatrixElement &x);
+    MatrixElement exp(const MatrixElement &x);
+    MatrixElement log(const MatrixElement &x);
+    MatrixElement log10(const MatrixElement &x);
+    MatrixElement pow(const MatrixElement &y, const MatrixElement &x);
+    MatrixElement sin(const MatrixElement &x);
+    MatrixElement cos(const MatrixElement &x);
+    MatrixElement tan(const MatrixElement &x);
+    MatrixElement asin(const MatrixElement &x);
+    MatrixElement acos(const MatrixElement &x);
+    MatrixElement atan(const MatrixElement &x);
+    MatrixElement conj(const MatrixElement &x);
+    // Scalar only functions. NaN for vector and matrix.
+    double abs(const MatrixElement &x);
+    double arg(const MatrixElement &x);
+    // Bitwise OR of the floating point classification of all elements. See rpn_engine::FloatingPointStatus.
+    uint32_t ClassifyElement(const MatrixElement &x);
+}
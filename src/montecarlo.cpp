@@ -0,0 +1,95 @@
+#include "montecarlo.hpp"
+#include <atomic>
+#include <cassert>
+#include <thread>
+
+// Definition of the static const member used as a reference.
+const unsigned long rpn_engine::MonteCarlo::kChunkSize;
+
+rpn_engine::MonteCarlo::MonteCarlo(const Op program[], std::size_t length, unsigned int stack_size)
+    : program_(program, program + length),
+      stack_size_(stack_size),
+      status_(0)
+{
+    assert(stack_size_ >= 2);
+    for (auto opcode : program_)
+    {
+        // Only the stack machine operations are allowed.
+        assert(opcode != Op::clx);
+        assert(opcode != Op::enter);
+        assert(opcode != Op::change_display);
+        assert(Op::num_0 > opcode);
+        (void)opcode; // Supress the warning in case of NDEBUG
+    }
+}
+
+void rpn_engine::MonteCarlo::SetInitialStack(const double values[], unsigned int count)
+{
+    initial_stack_.assign(values, values + count);
+}
+
+rpn_engine::Statistics rpn_engine::MonteCarlo::Run(unsigned long long trials, uint64_t seed, unsigned int threads)
+{
+    if (threads == 0)
+        threads = std::thread::hardware_concurrency();
+    if (threads == 0) // in case the hardware_concurrency() is not computable.
+        threads = 1;
+
+    const unsigned long long chunks = (trials + kChunkSize - 1) / kChunkSize;
+    std::vector<Statistics> results(chunks);
+    std::vector<uint32_t> status(threads, 0);
+    std::atomic<unsigned long long> next_chunk(0);
+
+    // Each worker has its own stack machine and takes the chunks until all chunks are done.
+    auto worker = [&](unsigned int id)
+    {
+        StackStrategy<double> engine(stack_size_);
+        for (unsigned long long chunk = next_chunk++; chunk < chunks; chunk = next_chunk++)
+        {
+            unsigned long long remaining = trials - chunk * kChunkSize;
+            unsigned long count = remaining < kChunkSize ? remaining : kChunkSize;
+            RunChunk(engine, chunk, seed, count, results[chunk]);
+        }
+        status[id] = engine.GetStatus();
+    };
+
+    // The current thread works as the worker 0.
+    std::vector<std::thread> pool;
+    for (unsigned int id = 1; id < threads; id++)
+        pool.emplace_back(worker, id);
+    worker(0);
+    for (auto &thread : pool)
+        thread.join();
+
+    // Merge in the order of the chunk to make the result reproducible.
+    Statistics total;
+    for (auto &result : results)
+        total.Merge(result);
+    status_ = 0;
+    for (auto s : status)
+        status_ |= s;
+
+    return total;
+}
+
+uint32_t rpn_engine::MonteCarlo::GetStatus() const
+{
+    return status_;
+}
+
+void rpn_engine::MonteCarlo::RunChunk(StackStrategy<double> &engine, unsigned long long chunk, uint64_t seed, unsigned long count, Statistics &result)
+{
+    // Accumulate locally. The results of the adjacent chunks share the cache lines.
+    Statistics local;
+    engine.SeedRandom(seed, chunk);
+    for (unsigned long trial = 0; trial < count; trial++)
+    {
+        engine.Clear();
+        for (auto value : initial_stack_)
+            engine.Push(value);
+        for (auto opcode : program_)
+            engine.Operation(opcode);
+        local.Add(engine.Get(0), engine.Get(1));
+    }
+    result = local;
+}
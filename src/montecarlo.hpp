@@ -0,0 +1,98 @@
+#pragma once
+/**
+ * @file montecarlo.hpp
+ * @author Seiichi "Suikan" Horie
+ * @brief Parallel Monte Carlo driver of the stack machine.
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#include "stackstrategy.hpp"
+#include <vector>
+
+namespace rpn_engine
+{
+    /**
+     * @brief Run a program of Op many times and collect the statistics of the result.
+     * @details
+     * Each trial starts from the stack filled by zero. Then, the initial values are
+     * pushed and the program is executed. After the program, (X, Y) of the stack is
+     * added to the statistics. So, the mean and the standard deviation of X and the
+     * correlation between X and Y are obtained.
+     *
+     * The program can use Op::random to generate the random inputs.
+     *
+     * The trials are divided into the fixed size chunks. The worker threads take
+     * the chunks one by one. The random number generator is seeded by the seed and
+     * the chunk number for each chunk. The statistics of each chunk are merged in
+     * the order of the chunk number. Thus, the result doesn't depend on the
+     * number of threads and the scheduling. The work of the threads is independent
+     * until the final merge. So, the throughput scales with the number of cores.
+     *
+     * The program is executed by StackStrategy<double>.
+     */
+    class MonteCarlo
+    {
+    public:
+        /**
+         * @brief Number of the trials in a chunk.
+         */
+        static const unsigned long kChunkSize = 16384;
+
+        /**
+         * @brief Construct a new Monte Carlo object
+         *
+         * @param program Array of the opcode to run in each trial.
+         * @param length Number of the opcode in the program.
+         * @param stack_size Depth of the stack. Must be 2 or more.
+         * @details
+         * The program can contain the opcode which StackStrategy::Operation() accepts.
+         */
+        MonteCarlo(const Op program[], std::size_t length, unsigned int stack_size = 4);
+
+        /**
+         * @brief Set the values pushed before each trial.
+         *
+         * @param values Values to push. values[0] is pushed first.
+         * @param count Number of the values.
+         */
+        void SetInitialStack(const double values[], unsigned int count);
+
+        /**
+         * @brief Run the trials
+         *
+         * @param trials Number of the trials.
+         * @param seed Seed of the random numbers.
+         * @param threads Number of the worker threads. If 0, the number of the hardware threads is used.
+         * @return Statistics of (X, Y) at the end of the trials.
+         */
+        Statistics Run(unsigned long long trials, uint64_t seed, unsigned int threads = 0);
+
+        /**
+         * @brief Floating point status raised in the last Run().
+         *
+         * @return Bitwise OR of the status of all trials. See FloatingPointStatus.
+         */
+        uint32_t GetStatus() const;
+
+    private:
+        std::vector<Op> program_;
+        std::vector<double> initial_stack_;
+        const unsigned int stack_size_;
+        uint32_t status_;
+
+        /**
+         * @brief Run the trials of a chunk.
+         *
+         * @param engine Stack machine to run the program.
+         * @param chunk Chunk number. Used as the stream of the random number.
+         * @param seed Seed of the random numbers.
+         * @param count Number of the trials.
+         * @param result Statistics of the chunk.
+         */
+        void RunChunk(StackStrategy<double> &engine, unsigned long long chunk, uint64_t seed, unsigned long count, Statistics &result);
+    };
+}
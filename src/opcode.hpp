@@ -0,0 +1,168 @@
+#pragma once
+/**
+ * @file opcode.hpp
+ * @author Seiichi "Suikan" Horie
+ * @brief Helper functions of the Op.
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+#include "stackstrategy.hpp"
+#include <cmath>
+#include <cstddef>
+#include <cstdlib>
+#include <cstring>
+
+namespace rpn_engine
+{
+    /**
+     * @brief Number of the Op values.
+     */
+    const unsigned int kNumberOfOps = static_cast<unsigned int>(Op::chs) + 1;
+
+    /**
+     * @brief Get the name of the opcode.
+     *
+     * @param opcode Opcode.
+     * @return The identifier of the opcode in the Op. For example, "add" for Op::add.
+     */
+    const char *GetOpName(Op opcode);
+
+    /**
+     * @brief Find the opcode by name.
+     *
+     * @param name Name of the opcode. Same as GetOpName().
+     * @param opcode Found opcode.
+     * @return true The opcode is found.
+     * @return false No opcode has the name. The opcode is not changed.
+     */
+    bool FindOp(const char *name, Op &opcode);
+
+    /**
+     * @brief Get the digit of the opcode.
+     *
+     * @param opcode num_0 .. num_f.
+     * @return 0 .. 15. Or -1 if the opcode is not a digit.
+     */
+    int DigitOf(Op opcode);
+
+    /**
+     * @brief Convert the keys of a number to the value.
+     *
+     * @param keys Array of the num_0 .. num_9, period, eex and chs.
+     * @param count Number of the keys.
+     * @return Value of the number.
+     * @details
+     * The keys are interpreted as same as the Console editing. The mantissa is up to 8 digits
+     * and the exponent is the last 2 digits.
+     */
+    double ParseNumber(const Op keys[], std::size_t count);
+}
+
+// The definitions are inline to keep the header only mode of the VirtualMachine.
+
+inline const char *rpn_engine::GetOpName(Op opcode)
+{
+    static const char *const kNames[] = {
+        "duplicate", "swap", "rotate_pop", "rotate_push",
+        "add", "sub", "mul", "div", "neg", "inv", "sqrt", "square", "pi",
+        "exp", "log", "log10", "power10", "power",
+        "sin", "cos", "tan", "asin", "acos", "atan",
+        "complex", "decomplex", "conjugate", "to_polar", "to_cartesian", "swap_re_im",
+        "bit_add", "bit_sub", "bit_mul", "bit_div", "bit_neg", "bit_or", "bit_xor", "bit_and",
+        "logical_shift_right", "logical_shift_left", "bit_not",
+        "sigma_plus", "sigma_minus", "sigma_clear", "mean", "standard_deviation",
+        "random", "polynomial", "coefficient_store", "coefficient_polynomial",
+        "change_display", "enter", "clx", "undo", "hex", "dec", "sto", "rcl", "func",
+        "label", "go_to", "go_sub", "ret", "x_eq_y", "x_ne_y", "x_lt_y", "x_le_y",
+        "nop",
+        "num_0", "num_1", "num_2", "num_3", "num_4", "num_5", "num_6", "num_7",
+        "num_8", "num_9", "num_a", "num_b", "num_c", "num_d", "num_e", "num_f",
+        "period", "eex", "del", "chs"};
+    static_assert(sizeof(kNames) / sizeof(kNames[0]) == kNumberOfOps, "Name table must cover all Op");
+
+    unsigned int index = static_cast<unsigned int>(opcode);
+    assert(index < kNumberOfOps);
+    return kNames[index];
+}
+
+inline bool rpn_engine::FindOp(const char *name, Op &opcode)
+{
+    for (unsigned int i = 0; i < kNumberOfOps; i++)
+        if (std::strcmp(name, GetOpName(static_cast<Op>(i))) == 0)
+        {
+            opcode = static_cast<Op>(i);
+            return true;
+        }
+    return false;
+}
+
+inline int rpn_engine::DigitOf(Op opcode)
+{
+    if (opcode >= Op::num_0 && Op::num_f >= opcode)
+        return static_cast<int>(opcode) - static_cast<int>(Op::num_0);
+    else
+        return -1;
+}
+
+inline double rpn_engine::ParseNumber(const Op keys[], std::size_t count)
+{
+    // Same restriction with the Console : 8 digits mantissa and 2 digits exponent.
+    char mantissa[16] = "";
+    unsigned int length = 0;
+    unsigned int digits = 0;
+    bool has_period = false;
+    bool is_negative = false;
+    bool is_exponent = false;
+    bool is_exponent_negative = false;
+    int exponent = 0;
+
+    for (std::size_t i = 0; i < count; i++)
+    {
+        switch (keys[i])
+        {
+        case Op::period:
+            if (!is_exponent && !has_period)
+            {
+                if (digits == 0)
+                    mantissa[length++] = '0';
+                mantissa[length++] = '.';
+                has_period = true;
+            }
+            break;
+        case Op::eex:
+            if (!is_exponent)
+            {
+                if (digits == 0) // Same as Console, mantissa 0 is replaced by 1
+                {
+                    length = 0;
+                    mantissa[length++] = '1';
+                    digits = 1;
+                }
+                is_exponent = true;
+            }
+            break;
+        case Op::chs:
+            if (is_exponent)
+                is_exponent_negative = !is_exponent_negative;
+            else
+                is_negative = !is_negative;
+            break;
+        default: // num_0 .. num_9
+            if (is_exponent)
+                exponent = (exponent * 10 + DigitOf(keys[i])) % 100; // keep last 2 digits.
+            else if (digits < 8)
+            {
+                mantissa[length++] = static_cast<char>('0' + DigitOf(keys[i]));
+                digits++;
+            }
+            break;
+        }
+    }
+    mantissa[length] = '\0';
+
+    double value = std::strtod(mantissa, nullptr) * std::pow(10, is_exponent_negative ? -exponent : exponent);
+    return is_negative ? -value : value;
+}
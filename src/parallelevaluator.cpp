@@ -0,0 +1,17 @@
+/**
+ * @file parallelevaluator.cpp
+ * @author Seiichi "Suikan" Horie
+ * @brief Explicit instantiation of the ParallelEvaluator class template.
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2026
+ *
+ * @details
+ * The parallelevaluator.hpp declares these specializations as extern template.
+ * Thus, the member functions of these specializations are compiled only here.
+ */
+#include "parallelevaluator.hpp"
+
+template class rpn_engine::ParallelEvaluator<double>;
+template class rpn_engine::ParallelEvaluator<std::complex<double>>;
@@ -0,0 +1,365 @@
+#pragma once
+/**
+ * @file parallelevaluator.hpp
+ * @author Seiichi "Suikan" Horie
+ * @brief Task parallel evaluation of the straight line program.
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#include "expressiongraph.hpp"
+#include "workstealingpool.hpp"
+#include <atomic>
+#include <cassert>
+#include <complex>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <type_traits>
+#include <vector>
+
+namespace rpn_engine
+{
+    /**
+     * @brief Evaluate the independent sub-expressions of a program in parallel.
+     *
+     * @tparam Element Element type. double or std::complex<double>.
+     * @details
+     * Load() builds the ExpressionGraph of the program and divides the nodes into tasks.
+     * A node joins the task of its operand if that operand is the last node of the task
+     * and the other operand is not calculated by another task. Otherwise, the node starts
+     * a new task which waits for the tasks of its operands. Thus, a chain of operations is
+     * one task and the independent chains are different tasks.
+     *
+     * Run() takes the initial stack from the StackStrategy, runs the tasks on the
+     * WorkStealingPool and writes the final stack back. When a task is done, the tasks
+     * waiting for it become ready. A ready task estimated cheaper than the threshold runs
+     * on the same worker. The others are spawned to be stolen by the idle workers. If the
+     * whole program is cheaper than the threshold, the nodes are calculated serially
+     * without the pool.
+     *
+     * Each node is calculated by the kernels from the same operands as the serial
+     * execution. So, the final stack is same as StackStrategy::Operation() bit by bit,
+     * regardless of the scheduling. The floating point status is not recorded.
+     */
+    template <class Element>
+    class ParallelEvaluator
+    {
+    public:
+        /**
+         * @brief Construct a new evaluator.
+         *
+         * @param pool Thread pool to run the tasks.
+         * @param stack_size Depth of the stack. Must be same as the StackStrategy given to Run().
+         */
+        ParallelEvaluator(WorkStealingPool &pool, unsigned int stack_size = 4);
+
+        /**
+         * @brief Analyze the program and make the tasks.
+         *
+         * @param program Array of the opcode.
+         * @param length Number of the opcode in the program.
+         * @return true Loaded.
+         * @return false The program is not supported by the ExpressionGraph. See GetErrorPosition().
+         */
+        bool Load(const Op program[], std::size_t length);
+
+        /**
+         * @brief Position of the unsupported opcode found by the last Load().
+         */
+        std::size_t GetErrorPosition() const;
+
+        /**
+         * @brief Set the estimated cost to run a task in parallel.
+         *
+         * @param threshold Cost in the unit of an addition. The default is kDefaultThreshold.
+         */
+        void SetThreshold(double threshold);
+
+        /**
+         * @brief Number of the tasks made by the last Load().
+         */
+        std::size_t GetTaskCount() const;
+
+        /**
+         * @brief Estimated cost of the whole program in the unit of an addition.
+         */
+        double GetCost() const;
+
+        /**
+         * @brief Run the program on the stack.
+         *
+         * @param engine The stack. The initial stack is the input and the final stack is the output.
+         */
+        void Run(StackStrategy<Element> &engine);
+
+        /**
+         * @brief Default of the threshold.
+         * @details
+         * About 2 microseconds at an addition per nanosecond. A few times the cost to spawn
+         * and steal a task.
+         */
+        static constexpr double kDefaultThreshold = 2000;
+
+        /**
+         * @brief Estimated cost of an operation in the unit of an addition.
+         *
+         * @param opcode Opcode of the node.
+         */
+        static double EstimateCost(Op opcode);
+
+    private:
+        struct Task
+        {
+            std::vector<uint32_t> nodes;      // Nodes to calculate in order.
+            std::vector<uint32_t> successors; // Tasks waiting for this task.
+            unsigned int dependency_count;    // Number of the tasks to wait.
+            double cost;
+        };
+
+        WorkStealingPool &pool_;
+        ExpressionGraph graph_;
+        std::vector<Element> values_;
+        std::vector<Task> tasks_;
+        std::unique_ptr<std::atomic<unsigned int>[]> remaining_; // Not finished dependencies of each task.
+        std::vector<bool> is_live_;
+        double threshold_;
+        double cost_;
+
+        void Calculate(uint32_t node);
+
+        /**
+         * @brief Run a task and the cheap tasks which become ready.
+         */
+        void RunTask(uint32_t task, unsigned int worker);
+    };
+}
+
+template <class Element>
+constexpr double rpn_engine::ParallelEvaluator<Element>::kDefaultThreshold;
+
+template <class Element>
+rpn_engine::ParallelEvaluator<Element>::ParallelEvaluator(WorkStealingPool &pool, unsigned int stack_size) : pool_(pool),
+                                                                                                              graph_(stack_size),
+                                                                                                              threshold_(kDefaultThreshold),
+                                                                                                              cost_(0)
+{
+    Load(nullptr, 0);
+}
+
+template <class Element>
+double rpn_engine::ParallelEvaluator<Element>::EstimateCost(Op opcode)
+{
+    // The complex operation is several times heavier than the real one.
+    const double scale = std::is_scalar<Element>::value ? 1 : 4;
+
+    switch (opcode)
+    {
+    case Op::add:
+    case Op::sub:
+    case Op::neg:
+        return scale;
+    case Op::mul:
+    case Op::square:
+        return 2 * scale;
+    case Op::div:
+    case Op::inv:
+    case Op::sqrt:
+        return 8 * scale;
+    case Op::power:
+        return 80 * scale;
+    case Op::exp:
+    case Op::log:
+    case Op::log10:
+    case Op::power10:
+    case Op::sin:
+    case Op::cos:
+    case Op::tan:
+    case Op::asin:
+    case Op::acos:
+    case Op::atan:
+        return 40 * scale;
+    default:
+        return 0; // Constant and input.
+    }
+}
+
+template <class Element>
+bool rpn_engine::ParallelEvaluator<Element>::Load(const Op program[], std::size_t length)
+{
+    // Run the empty program if failed.
+    const bool is_built = graph_.Build(program, length);
+    if (!is_built)
+        graph_.Build(nullptr, 0);
+
+    const std::size_t count = graph_.GetNodeCount();
+    values_.assign(count, Element(0));
+
+    // Only the nodes reaching the final stack are calculated.
+    is_live_.assign(count, false);
+    for (unsigned int i = 0; i < graph_.GetStackSize(); i++)
+    {
+        std::vector<bool> live = graph_.GetLiveNodes(graph_.GetStackNode(i));
+        for (std::size_t j = 0; j < count; j++)
+            if (live[j])
+                is_live_[j] = true;
+    }
+
+    // Divide the calculation nodes to the tasks. The constants are calculated here.
+    const uint32_t kNoTask = UINT32_MAX;
+    std::vector<uint32_t> task_of(count, kNoTask);
+    tasks_.clear();
+    cost_ = 0;
+    for (uint32_t i = 0; i < count; i++)
+    {
+        const ExpressionGraph::Node &node = graph_.GetNode(i);
+        if (!is_live_[i] || node.kind == ExpressionGraph::NodeKind::input)
+            continue;
+        if (node.kind == ExpressionGraph::NodeKind::constant)
+        {
+            values_[i] = ExpressionGraph::Apply(node, values_[0], values_[0]);
+            continue;
+        }
+
+        // Tasks of the operands.
+        const unsigned int operand_count = node.kind == ExpressionGraph::NodeKind::binary ? 2 : 1;
+        uint32_t dependencies[2] = {kNoTask, kNoTask};
+        unsigned int dependency_count = 0;
+        bool extends_tail = false;
+        for (unsigned int k = 0; k < operand_count; k++)
+        {
+            uint32_t task = task_of[node.operand[k]];
+            if (task == kNoTask)
+                continue;
+            if (dependency_count == 0 || dependencies[0] != task)
+                dependencies[dependency_count++] = task;
+            if (tasks_[task].nodes.back() == node.operand[k])
+                extends_tail = true;
+        }
+
+        uint32_t task;
+        if (dependency_count == 1 && extends_tail)
+            task = dependencies[0]; // Continue the chain.
+        else
+        {
+            task = static_cast<uint32_t>(tasks_.size());
+            tasks_.push_back(Task{{}, {}, dependency_count, 0});
+            for (unsigned int k = 0; k < dependency_count; k++)
+                tasks_[dependencies[k]].successors.push_back(task);
+        }
+        tasks_[task].nodes.push_back(i);
+        task_of[i] = task;
+        const double cost = EstimateCost(node.opcode);
+        tasks_[task].cost += cost;
+        cost_ += cost;
+    }
+    remaining_.reset(new std::atomic<unsigned int>[tasks_.size()]);
+
+    return is_built;
+}
+
+template <class Element>
+std::size_t rpn_engine::ParallelEvaluator<Element>::GetErrorPosition() const
+{
+    return graph_.GetErrorPosition();
+}
+
+template <class Element>
+void rpn_engine::ParallelEvaluator<Element>::SetThreshold(double threshold)
+{
+    threshold_ = threshold;
+}
+
+template <class Element>
+std::size_t rpn_engine::ParallelEvaluator<Element>::GetTaskCount() const
+{
+    return tasks_.size();
+}
+
+template <class Element>
+double rpn_engine::ParallelEvaluator<Element>::GetCost() const
+{
+    return cost_;
+}
+
+template <class Element>
+void rpn_engine::ParallelEvaluator<Element>::Calculate(uint32_t index)
+{
+    const ExpressionGraph::Node &node = graph_.GetNode(index);
+    const Element &x = values_[node.kind == ExpressionGraph::NodeKind::binary ? node.operand[1] : node.operand[0]];
+    values_[index] = ExpressionGraph::Apply(node, values_[node.operand[0]], x);
+}
+
+template <class Element>
+void rpn_engine::ParallelEvaluator<Element>::RunTask(uint32_t task, unsigned int worker)
+{
+    // Continue on this worker while a ready task is found. The worklist instead of the
+    // recursion keeps the stack depth constant for the long fan out of the cheap tasks.
+    std::vector<uint32_t> ready(1, task);
+    while (!ready.empty())
+    {
+        task = ready.back();
+        ready.pop_back();
+        for (auto node : tasks_[task].nodes)
+            Calculate(node);
+
+        // The last finished dependency makes the successor ready.
+        bool is_continued = false;
+        for (auto successor : tasks_[task].successors)
+        {
+            if (remaining_[successor].fetch_sub(1, std::memory_order_acq_rel) != 1)
+                continue;
+            if (!is_continued || tasks_[successor].cost < threshold_)
+            {
+                // The first one or cheap. Run here rather than spawn.
+                ready.push_back(successor);
+                is_continued = true;
+            }
+            else
+                pool_.Spawn(worker, [this, successor](unsigned int w)
+                            { RunTask(successor, w); });
+        }
+    }
+}
+
+template <class Element>
+void rpn_engine::ParallelEvaluator<Element>::Run(StackStrategy<Element> &engine)
+{
+    const unsigned int stack_size = graph_.GetStackSize();
+    for (unsigned int i = 0; i < stack_size; i++)
+        values_[i] = engine.Get(i); // The node i is the input of the stack position i.
+
+    if (cost_ < threshold_ || pool_.GetThreadCount() == 1)
+    {
+        // Serially in the order of the program.
+        for (std::size_t i = stack_size; i < values_.size(); i++)
+            if (is_live_[i] && graph_.GetNode(static_cast<uint32_t>(i)).kind != ExpressionGraph::NodeKind::constant)
+                Calculate(static_cast<uint32_t>(i));
+    }
+    else
+    {
+        for (std::size_t i = 0; i < tasks_.size(); i++)
+            remaining_[i].store(tasks_[i].dependency_count, std::memory_order_relaxed);
+
+        // The tasks without dependency are the roots.
+        pool_.Run([this](unsigned int worker)
+                  {
+                      for (uint32_t i = 0; i < tasks_.size(); i++)
+                          if (tasks_[i].dependency_count == 0)
+                              pool_.Spawn(worker, [this, i](unsigned int w)
+                                          { RunTask(i, w); }); });
+    }
+
+    // Write back from the bottom.
+    for (unsigned int i = stack_size; i-- > 0;)
+        engine.Push(values_[graph_.GetStackNode(i)]);
+}
+
+#ifndef RPN_ENGINE_HEADER_ONLY
+// Compiled in parallelevaluator.cpp
+extern template class rpn_engine::ParallelEvaluator<double>;
+extern template class rpn_engine::ParallelEvaluator<std::complex<double>>;
+#endif
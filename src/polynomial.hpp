@@ -0,0 +1,164 @@
+#pragma once
+/**
+ * @file polynomial.hpp
+ * @author Seiichi "Suikan" Horie
+ * @brief Polynomial evaluation kernels.
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+#include <cmath>
+#include <cstddef>
+
+namespace rpn_engine
+{
+    /**
+     * @brief Number of the coefficients from which EvaluatePolynomial() uses the Estrin's scheme.
+     */
+    const std::size_t kEstrinThreshold = 9;
+
+    /**
+     * @brief Number of the coefficients evaluated together in the Estrin's scheme.
+     */
+    const std::size_t kEstrinBlockSize = 32;
+
+    /**
+     * @brief Calculate a * b + c
+     * @details
+     * Generic version. Used by the complex and other element types.
+     */
+    template <class T>
+    inline T MultiplyAdd(const T &a, const T &b, const T &c)
+    {
+        return a * b + c;
+    }
+
+    /**
+     * @brief Calculate a * b + c by the fused multiply add.
+     * @details
+     * Only one rounding happens.
+     */
+    inline double MultiplyAdd(double a, double b, double c)
+    {
+        return std::fma(a, b, c);
+    }
+
+    /**
+     * @brief Calculate a * b + c by the fused multiply add.
+     * @details
+     * Only one rounding happens.
+     */
+    inline float MultiplyAdd(float a, float b, float c)
+    {
+        return std::fma(a, b, c);
+    }
+
+    /**
+     * @brief Evaluate polynomial by the Horner's scheme.
+     *
+     * @tparam T Type of the coefficients and the variable.
+     * @param coefficients Coefficients in ascending order. coefficients[i] is for x^i.
+     * @param count Number of the coefficients. Must be 1 or more.
+     * @param x Variable.
+     * @return Value of the polynomial.
+     * @details
+     * The count - 1 multiply-add operations are done in a dependency chain.
+     */
+    template <class T>
+    T Horner(const T coefficients[], std::size_t count, const T &x)
+    {
+        T result = coefficients[count - 1];
+        for (std::size_t i = count - 1; i > 0; i--)
+            result = MultiplyAdd(result, x, coefficients[i - 1]);
+        return result;
+    }
+
+    /**
+     * @brief Evaluate polynomial by the Estrin's scheme.
+     *
+     * @tparam T Type of the coefficients and the variable.
+     * @param coefficients Coefficients in ascending order. coefficients[i] is for x^i.
+     * @param count Number of the coefficients. Must be 1 or more.
+     * @param x Variable.
+     * @return Value of the polynomial.
+     * @details
+     * The pairs of the terms are combined by x, then the pairs of pairs are
+     * combined by x^2, and so on. The multiply-add operations in each level don't
+     * depend on each other. Thus, the processor can execute them in parallel. The
+     * length of the dependency chain is log2(count).
+     *
+     * The coefficients are processed by blocks of the kEstrinBlockSize. The blocks
+     * are combined by the Horner's scheme with x^kEstrinBlockSize.
+     */
+    template <class T>
+    T Estrin(const T coefficients[], std::size_t count, const T &x)
+    {
+        T partial[kEstrinBlockSize / 2];
+
+        // x^kEstrinBlockSize to combine the blocks.
+        T block_power = x;
+        for (std::size_t size = 1; size < kEstrinBlockSize; size *= 2)
+            block_power = block_power * block_power;
+
+        // Start from the block of the highest order.
+        std::size_t first = (count - 1) / kEstrinBlockSize * kEstrinBlockSize;
+        T result = T(0); // Assigned by the highest block.
+        bool is_highest = true;
+        while (true)
+        {
+            const T *block = coefficients + first;
+            std::size_t size = count - first < kEstrinBlockSize ? count - first : kEstrinBlockSize;
+
+            // First level : combine the pairs of the coefficients by x.
+            std::size_t n = 0;
+            for (std::size_t i = 0; i + 1 < size; i += 2)
+                partial[n++] = MultiplyAdd(block[i + 1], x, block[i]);
+            if (size % 2 != 0)
+                partial[n++] = block[size - 1];
+
+            // Upper levels : combine the pairs of the partial results by x^2, x^4, ...
+            T power = x;
+            while (n > 1)
+            {
+                power = power * power;
+                std::size_t m = 0;
+                for (std::size_t i = 0; i + 1 < n; i += 2)
+                    partial[m++] = MultiplyAdd(partial[i + 1], power, partial[i]);
+                if (n % 2 != 0)
+                    partial[m++] = partial[n - 1];
+                n = m;
+            }
+
+            result = is_highest ? partial[0] : MultiplyAdd(result, block_power, partial[0]);
+            is_highest = false;
+
+            if (first == 0)
+                break;
+            first -= kEstrinBlockSize;
+        }
+        return result;
+    }
+
+    /**
+     * @brief Evaluate polynomial.
+     *
+     * @tparam T Type of the coefficients and the variable.
+     * @param coefficients Coefficients in ascending order. coefficients[i] is for x^i.
+     * @param count Number of the coefficients. Must be 1 or more.
+     * @param x Variable.
+     * @return Value of the polynomial.
+     * @details
+     * Horner's scheme is used for the low degree polynomial. The Estrin's scheme is used
+     * if count is kEstrinThreshold or more.
+     */
+    template <class T>
+    T EvaluatePolynomial(const T coefficients[], std::size_t count, const T &x)
+    {
+        if (count < kEstrinThreshold)
+            return Horner(coefficients, count, x);
+        else
+            return Estrin(coefficients, count, x);
+    }
+}
@@ -0,0 +1,107 @@
+#include "programmemory.hpp"
+#include <cassert>
+#include <type_traits>
+
+// The opcode must fit to the escaped 2 nibbles.
+static_assert(static_cast<std::underlying_type<rpn_engine::Op>::type>(rpn_engine::Op::chs) < 256, "Opcode exceeds 8bit");
+
+// Opcodes encoded in one nibble. The index is the code.
+static const rpn_engine::Op kShortCodes[] = {
+    rpn_engine::Op::num_0,
+    rpn_engine::Op::num_1,
+    rpn_engine::Op::num_2,
+    rpn_engine::Op::num_3,
+    rpn_engine::Op::num_4,
+    rpn_engine::Op::num_5,
+    rpn_engine::Op::num_6,
+    rpn_engine::Op::num_7,
+    rpn_engine::Op::num_8,
+    rpn_engine::Op::num_9,
+    rpn_engine::Op::period,
+    rpn_engine::Op::enter,
+    rpn_engine::Op::add,
+    rpn_engine::Op::sub,
+    rpn_engine::Op::mul,
+};
+
+static const unsigned int kNumberOfShortCodes = sizeof(kShortCodes) / sizeof(kShortCodes[0]);
+
+rpn_engine::ProgramMemory::ProgramMemory(unsigned int capacity) : memory_(new uint8_t[capacity]),
+                                                                  capacity_(capacity * 2),
+                                                                  nibble_count_(0),
+                                                                  step_count_(0)
+{
+    assert(memory_ != nullptr);
+}
+
+void rpn_engine::ProgramMemory::Clear()
+{
+    nibble_count_ = 0;
+    step_count_ = 0;
+}
+
+bool rpn_engine::ProgramMemory::Append(Op opcode)
+{
+    // Search the short code.
+    for (unsigned int code = 0; code < kNumberOfShortCodes; code++)
+        if (kShortCodes[code] == opcode)
+        {
+            if (nibble_count_ + 1 > capacity_)
+                return false;
+            PutNibble(nibble_count_++, code);
+            step_count_++;
+            return true;
+        }
+
+    // Not found. Escape and 2 nibbles.
+    if (nibble_count_ + 3 > capacity_)
+        return false;
+    unsigned int value = static_cast<std::underlying_type<Op>::type>(opcode);
+    PutNibble(nibble_count_++, kEscape);
+    PutNibble(nibble_count_++, value & 0xF);
+    PutNibble(nibble_count_++, value >> 4);
+    step_count_++;
+    return true;
+}
+
+rpn_engine::Op rpn_engine::ProgramMemory::Fetch(unsigned int &position) const
+{
+    assert(position < nibble_count_);
+
+    unsigned int code = GetNibble(position++);
+    if (code != kEscape)
+        return kShortCodes[code];
+
+    unsigned int value = GetNibble(position++);
+    value |= GetNibble(position++) << 4;
+    return static_cast<Op>(value);
+}
+
+unsigned int rpn_engine::ProgramMemory::GetStepCount() const
+{
+    return step_count_;
+}
+
+unsigned int rpn_engine::ProgramMemory::GetNibbleCount() const
+{
+    return nibble_count_;
+}
+
+unsigned int rpn_engine::ProgramMemory::GetCapacity() const
+{
+    return capacity_;
+}
+
+void rpn_engine::ProgramMemory::PutNibble(unsigned int position, unsigned int nibble)
+{
+    uint8_t &byte = memory_[position / 2];
+    if (position % 2 == 0)
+        byte = (byte & 0xF0) | nibble;
+    else
+        byte = (byte & 0x0F) | (nibble << 4);
+}
+
+unsigned int rpn_engine::ProgramMemory::GetNibble(unsigned int position) const
+{
+    return (memory_[position / 2] >> (4 * (position % 2))) & 0xF;
+}
@@ -0,0 +1,107 @@
+#pragma once
+/**
+ * @file programmemory.hpp
+ * @author Seiichi "Suikan" Horie
+ * @brief Keystroke program memory.
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#include "stackstrategy.hpp"
+#include <cstdint>
+#include <memory>
+
+namespace rpn_engine
+{
+    /**
+     * @brief Compact storage of the Op sequence.
+     * @details
+     * The opcodes are stored as a stream of 4bit nibbles. The frequently used keys
+     * take one nibble :
+     * @li 0x0 .. 0x9 : Op::num_0 .. Op::num_9
+     * @li 0xA : Op::period
+     * @li 0xB : Op::enter
+     * @li 0xC : Op::add
+     * @li 0xD : Op::sub
+     * @li 0xE : Op::mul
+     *
+     * The other opcodes take three nibbles : the escape nibble 0xF, then the lower and the upper
+     * nibble of the opcode value.
+     *
+     * The even nibble is stored in the lower 4bit of the byte and the odd nibble is stored in the upper 4bit.
+     * The memory is allocated at the construction. There is no allocation after that.
+     */
+    class ProgramMemory
+    {
+    public:
+        /**
+         * @brief Construct a new empty program memory.
+         *
+         * @param capacity Size of the memory in byte. A byte holds two nibbles.
+         */
+        ProgramMemory(unsigned int capacity);
+
+        /**
+         * @brief Remove all steps.
+         */
+        void Clear();
+
+        /**
+         * @brief Add an opcode at the end of the program.
+         *
+         * @param opcode Opcode to add.
+         * @return true The opcode is added.
+         * @return false The memory doesn't have space. The program is not changed.
+         */
+        bool Append(Op opcode);
+
+        /**
+         * @brief Decode an opcode.
+         *
+         * @param position Nibble position of the opcode. Updated to the position of the next opcode.
+         * @return Decoded opcode.
+         * @details
+         * The program is decoded from the position 0 until the position reaches GetNibbleCount().
+         */
+        Op Fetch(unsigned int &position) const;
+
+        /**
+         * @brief Number of the opcode in the program.
+         */
+        unsigned int GetStepCount() const;
+
+        /**
+         * @brief Number of the nibbles used by the program.
+         */
+        unsigned int GetNibbleCount() const;
+
+        /**
+         * @brief Capacity of the memory in nibble.
+         */
+        unsigned int GetCapacity() const;
+
+    private:
+        std::unique_ptr<uint8_t[]> memory_;
+        const unsigned int capacity_; // in nibble
+        unsigned int nibble_count_;
+        unsigned int step_count_;
+
+        /**
+         * @brief Nibble to escape the long opcode.
+         */
+        static const unsigned int kEscape = 0xF;
+
+        /**
+         * @brief Store a nibble at the position.
+         */
+        void PutNibble(unsigned int position, unsigned int nibble);
+
+        /**
+         * @brief Read a nibble at the position.
+         */
+        unsigned int GetNibble(unsigned int position) const;
+    };
+}
@@ -0,0 +1,126 @@
+#include "programtext.hpp"
+#include "opcode.hpp"
+#include <cctype>
+#include <string>
+
+bool rpn_engine::NumberToKeys(const std::string &token, std::vector<Op> &keys)
+{
+    std::size_t i = 0;
+    bool is_negative = false;
+    if (token[i] == '-' || token[i] == '+')
+        is_negative = token[i++] == '-';
+
+    // Mantissa
+    unsigned int digits = 0;
+    bool has_period = false;
+    for (; i < token.size(); i++)
+    {
+        char c = token[i];
+        if (std::isdigit(static_cast<unsigned char>(c)))
+        {
+            keys.push_back(static_cast<Op>(static_cast<unsigned int>(Op::num_0) + (c - '0')));
+            digits++;
+        }
+        else if (c == '.' && !has_period)
+        {
+            keys.push_back(Op::period);
+            has_period = true;
+        }
+        else
+            break;
+    }
+    if (digits == 0)
+        return false;
+    if (is_negative)
+        keys.push_back(Op::chs);
+
+    // Exponent
+    if (i < token.size() && (token[i] == 'e' || token[i] == 'E'))
+    {
+        keys.push_back(Op::eex);
+        i++;
+        bool is_exponent_negative = false;
+        if (i < token.size() && (token[i] == '-' || token[i] == '+'))
+            is_exponent_negative = token[i++] == '-';
+        if (i == token.size())
+            return false;
+        for (; i < token.size(); i++)
+        {
+            if (!std::isdigit(static_cast<unsigned char>(token[i])))
+                return false;
+            keys.push_back(static_cast<Op>(static_cast<unsigned int>(Op::num_0) + (token[i] - '0')));
+        }
+        if (is_exponent_negative)
+            keys.push_back(Op::chs);
+    }
+
+    return i == token.size();
+}
+
+bool rpn_engine::ParseProgramText(const char *text, std::vector<Op> &program, unsigned int &error_line)
+{
+    unsigned int line = 1;
+    bool is_last_number = false;
+    bool needs_operand = false;
+    const char *p = text;
+
+    while (*p != '\0')
+    {
+        // Skip white spaces and comments.
+        if (*p == '\n')
+        {
+            line++;
+            p++;
+            continue;
+        }
+        if (std::isspace(static_cast<unsigned char>(*p)))
+        {
+            p++;
+            continue;
+        }
+        if (*p == '#')
+        {
+            while (*p != '\0' && *p != '\n')
+                p++;
+            continue;
+        }
+
+        // Cut a token.
+        const char *start = p;
+        while (*p != '\0' && !std::isspace(static_cast<unsigned char>(*p)) && *p != '#')
+            p++;
+        std::string token(start, p);
+
+        Op opcode;
+        if (needs_operand && token.size() == 1 && std::isxdigit(static_cast<unsigned char>(token[0])))
+        {
+            // Digit operand of the label, go_to, go_sub, sto and rcl.
+            int digit = std::isdigit(static_cast<unsigned char>(token[0])) ? token[0] - '0' : std::tolower(token[0]) - 'a' + 10;
+            program.push_back(static_cast<Op>(static_cast<unsigned int>(Op::num_0) + digit));
+            is_last_number = false;
+            needs_operand = false;
+        }
+        else if (FindOp(token.c_str(), opcode))
+        {
+            program.push_back(opcode);
+            is_last_number = false;
+            needs_operand = opcode == Op::label || opcode == Op::go_to || opcode == Op::go_sub ||
+                            opcode == Op::sto || opcode == Op::rcl;
+        }
+        else
+        {
+            std::vector<Op> keys;
+            if (!NumberToKeys(token, keys))
+            {
+                error_line = line;
+                return false;
+            }
+            if (is_last_number) // Separate two numbers.
+                program.push_back(Op::enter);
+            program.insert(program.end(), keys.begin(), keys.end());
+            is_last_number = true;
+            needs_operand = false;
+        }
+    }
+    return true;
+}
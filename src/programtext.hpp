@@ -0,0 +1,49 @@
+#pragma once
+/**
+ * @file programtext.hpp
+ * @author Seiichi "Suikan" Horie
+ * @brief Text form of the keystroke program.
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#include "stackstrategy.hpp"
+#include <cstddef>
+#include <string>
+#include <vector>
+
+namespace rpn_engine
+{
+    /**
+     * @brief Convert the text to the Op sequence.
+     *
+     * @param text Null terminated program text.
+     * @param program Parsed program. The opcodes are appended.
+     * @param error_line The line number of the error. 1 origin. Not changed if no error.
+     * @return true The text is parsed.
+     * @return false The text has an unknown token.
+     * @details
+     * The text is a sequence of tokens separated by the white spaces. A line
+     * after '#' is a comment. The token is one of :
+     * @li Name of the opcode by GetOpName(). For example, "add" or "num_3".
+     * @li Decimal number like "12", "-0.5" or "6.02e23". It is converted to the
+     * digit keys, period, eex and chs. Only 8 digits of mantissa are taken as same as Console.
+     * @li 0 .. 9 or a .. f after label, go_to, go_sub, sto and rcl. It is the digit opcode of the operand.
+     *
+     * The enter is inserted between two numbers. Thus, "2 3 add" is same as "2 enter 3 add".
+     */
+    bool ParseProgramText(const char *text, std::vector<Op> &program, unsigned int &error_line);
+
+    /**
+     * @brief Convert a decimal number to the keys.
+     *
+     * @param token Decimal number like "12", "-0.5" or "6.02e23".
+     * @param keys The digit keys, period, eex and chs are appended.
+     * @return true Converted.
+     * @return false The token is not a number. The keys may be partially appended.
+     */
+    bool NumberToKeys(const std::string &token, std::vector<Op> &keys);
+}
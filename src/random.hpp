@@ -0,0 +1,116 @@
+#pragma once
+/**
+ * @file random.hpp
+ * @author Seiichi "Suikan" Horie
+ * @brief Pseudo random number generator for the stack machine.
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+#include <cstdint>
+
+namespace rpn_engine
+{
+    /**
+     * @brief xoshiro256** pseudo random number generator.
+     * @details
+     * The generator by D. Blackman and S. Vigna. The state is 256bit and the
+     * period is 2^256 - 1. Each number is generated by a few shifts, rotations
+     * and multiplications without branch.
+     *
+     * The state is initialized from a seed and a stream number by the SplitMix64.
+     * The different stream numbers give the independent sequences from the same seed.
+     * So, each thread or each chunk of the work can have its own reproducible stream.
+     */
+    class Xoshiro256
+    {
+    public:
+        /**
+         * @brief Construct a new generator
+         *
+         * @param seed Seed of the sequence.
+         * @param stream Stream number of the sequence.
+         */
+        Xoshiro256(uint64_t seed = 0, uint64_t stream = 0) { Seed(seed, stream); }
+
+        /**
+         * @brief Initialize the state.
+         *
+         * @param seed Seed of the sequence.
+         * @param stream Stream number of the sequence.
+         */
+        void Seed(uint64_t seed, uint64_t stream = 0);
+
+        /**
+         * @brief Generate 64bit random number.
+         */
+        uint64_t Next();
+
+        /**
+         * @brief Generate uniform random number in [0, 1).
+         * @details
+         * The upper 53bit of the Next() is used as the mantissa.
+         */
+        double NextDouble();
+
+    private:
+        uint64_t state_[4];
+
+        static uint64_t RotateLeft(uint64_t x, int k) { return (x << k) | (x >> (64 - k)); }
+
+        /**
+         * @brief SplitMix64 generator. Used to initialize the state.
+         *
+         * @param x State of the SplitMix64. Updated.
+         * @return Generated number.
+         */
+        static uint64_t SplitMix64(uint64_t &x);
+    };
+}
+
+// The definitions are inline to keep the header only mode of the StackStrategy.
+
+inline void rpn_engine::Xoshiro256::Seed(uint64_t seed, uint64_t stream)
+{
+    // Hash the seed and the stream to a key. Each word of the state is the SplitMix64 output
+    // from the key. So, the states of the streams are not related by a linear offset.
+    uint64_t s = seed;
+    uint64_t t = stream;
+    uint64_t key = SplitMix64(s) ^ RotateLeft(SplitMix64(t), 32);
+    for (int i = 0; i < 4; i++)
+        state_[i] = SplitMix64(key);
+    // The all zero state is not allowed.
+    if ((state_[0] | state_[1] | state_[2] | state_[3]) == 0)
+        state_[0] = 1;
+}
+
+inline uint64_t rpn_engine::Xoshiro256::Next()
+{
+    const uint64_t result = RotateLeft(state_[1] * 5, 7) * 9;
+    const uint64_t t = state_[1] << 17;
+
+    state_[2] ^= state_[0];
+    state_[3] ^= state_[1];
+    state_[1] ^= state_[2];
+    state_[0] ^= state_[3];
+    state_[2] ^= t;
+    state_[3] = RotateLeft(state_[3], 45);
+
+    return result;
+}
+
+inline double rpn_engine::Xoshiro256::NextDouble()
+{
+    // 2^-53
+    return static_cast<double>(Next() >> 11) * (1.0 / 9007199254740992.0);
+}
+
+inline uint64_t rpn_engine::Xoshiro256::SplitMix64(uint64_t &x)
+{
+    uint64_t z = (x += 0x9E3779B97F4A7C15ull);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+    return z ^ (z >> 31);
+}
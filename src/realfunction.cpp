@@ -0,0 +1,43 @@
+#include "realfunction.hpp"
+#include <cassert>
+#include <cmath>
+
+// Definition of the static const member used as a reference.
+const unsigned long rpn_engine::RealFunction::kStepBudget;
+
+rpn_engine::RealFunction::RealFunction(unsigned int stack_size) : engine_(stack_size),
+                                                                  vm_(engine_)
+{
+    for (unsigned int i = 0; i < kNumberOfVmRegisters; i++)
+        registers_[i] = 0;
+}
+
+bool rpn_engine::RealFunction::Load(const Op program[], std::size_t length)
+{
+    return vm_.Load(program, length);
+}
+
+void rpn_engine::RealFunction::SetRegister(unsigned int index, double value)
+{
+    assert(index < kNumberOfVmRegisters);
+    registers_[index] = value;
+}
+
+double rpn_engine::RealFunction::operator()(double x)
+{
+    return (*this)(&x, 1);
+}
+
+double rpn_engine::RealFunction::operator()(const double inputs[], unsigned int input_count)
+{
+    // Push from the bottom.
+    engine_.Clear();
+    for (unsigned int i = input_count; i-- > 0;)
+        engine_.Push(inputs[i]);
+    for (unsigned int i = 0; i < kNumberOfVmRegisters; i++)
+        vm_.SetRegister(i, registers_[i]);
+    vm_.Reset();
+    if (vm_.Run(kStepBudget) != VirtualMachine<double>::Result::completed)
+        return NAN;
+    return engine_.Get(0);
+}
@@ -0,0 +1,89 @@
+#pragma once
+/**
+ * @file realfunction.hpp
+ * @author Seiichi "Suikan" Horie
+ * @brief Program of the VirtualMachine as a real function.
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#include "virtualmachine.hpp"
+#include <cstddef>
+
+namespace rpn_engine
+{
+    /**
+     * @brief Evaluate a program as the function f(x).
+     * @details
+     * Each call starts from the stack filled by zero and the registers given by
+     * SetRegister(). Then, x is pushed and the program is run by the VirtualMachine.
+     * The X after the program is f(x). Thus, the result depends only on x and the
+     * registers. The registers are the parameters of the function.
+     *
+     * The program can have loops and subroutines. If the program doesn't finish within
+     * kStepBudget steps or overflows the return stack, the result is NaN.
+     *
+     * An object is not thread safe. Each thread needs its own object.
+     */
+    class RealFunction
+    {
+    public:
+        /**
+         * @brief Max steps of the program in a call.
+         */
+        static const unsigned long kStepBudget = 1000000;
+
+        /**
+         * @brief Construct a new function. The program is empty. So, f(x) = x.
+         *
+         * @param stack_size Depth of the stack.
+         */
+        RealFunction(unsigned int stack_size = 4);
+
+        RealFunction(const RealFunction &) = delete;
+        RealFunction &operator=(const RealFunction &) = delete;
+
+        /**
+         * @brief Load the program.
+         *
+         * @param program Array of the opcode.
+         * @param length Number of the opcode in the program.
+         * @return true Loaded.
+         * @return false The program has error. See VirtualMachine::Load().
+         */
+        bool Load(const Op program[], std::size_t length);
+
+        /**
+         * @brief Set the register value given to each call.
+         *
+         * @param index Register number. 0 .. kNumberOfVmRegisters-1.
+         * @param value Value of the register.
+         */
+        void SetRegister(unsigned int index, double value);
+
+        /**
+         * @brief Evaluate the function.
+         *
+         * @param x Argument.
+         * @return X after the program. NaN if the program didn't finish.
+         */
+        double operator()(double x);
+
+        /**
+         * @brief Evaluate the function of several arguments.
+         *
+         * @param inputs Initial stack. inputs[0] is X.
+         * @param input_count Number of the inputs. Up to the stack size. The stack below is zero.
+         * @return X after the program. NaN if the program didn't finish.
+         */
+        double operator()(const double inputs[], unsigned int input_count);
+
+    private:
+        StackStrategy<double> engine_;
+        VirtualMachine<double> vm_;
+        double registers_[kNumberOfVmRegisters];
+    };
+}
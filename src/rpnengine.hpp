@@ -15,3 +15,22 @@
 #include "segmentdecoder.hpp"
 #include "antichattering.hpp"
 #include "encodekey.hpp"
+#include "matrixelement.hpp"
+#include "montecarlo.hpp"
+#include "programmemory.hpp"
+#include "virtualmachine.hpp"
+#include "opcode.hpp"
+#include "programtext.hpp"
+#include "aotcompiler.hpp"
+#include "jitfunction.hpp"
+#include "infixcompiler.hpp"
+#include "dataflowevaluator.hpp"
+#include "workstealingpool.hpp"
+#include "parallelevaluator.hpp"
+#include "realfunction.hpp"
+#include "solver.hpp"
+#include "batchfunction.hpp"
+#include "integrator.hpp"
+#include "tablegenerator.hpp"
+#include "wireformat.hpp"
+#include "batchevaluator.hpp"
@@ -0,0 +1,217 @@
+#include "solver.hpp"
+#include <algorithm>
+#include <cassert>
+#include <cfloat>
+#include <cmath>
+
+rpn_engine::Solver::Solver(WorkStealingPool &pool, unsigned int stack_size) : pool_(pool),
+                                                                              tolerance_(1e-12),
+                                                                              evaluation_budget_(0),
+                                                                              time_budget_(0),
+                                                                              evaluations_(0),
+                                                                              stop_(static_cast<int>(Status::converged))
+{
+    for (unsigned int i = 0; i < pool_.GetThreadCount(); i++)
+        functions_.emplace_back(new RealFunction(stack_size));
+}
+
+bool rpn_engine::Solver::Load(const Op program[], std::size_t length)
+{
+    bool is_loaded = true;
+    for (auto &f : functions_)
+        is_loaded = f->Load(program, length) && is_loaded;
+    return is_loaded;
+}
+
+void rpn_engine::Solver::SetRegister(unsigned int index, double value)
+{
+    for (auto &f : functions_)
+        f->SetRegister(index, value);
+}
+
+void rpn_engine::Solver::SetTolerance(double tolerance)
+{
+    tolerance_ = tolerance;
+}
+
+void rpn_engine::Solver::SetEvaluationBudget(unsigned long evaluations)
+{
+    evaluation_budget_ = evaluations;
+}
+
+void rpn_engine::Solver::SetTimeBudget(double seconds)
+{
+    time_budget_ = seconds;
+}
+
+unsigned long rpn_engine::Solver::GetEvaluationCount() const
+{
+    return evaluations_;
+}
+
+void rpn_engine::Solver::Start()
+{
+    evaluations_ = 0;
+    stop_ = static_cast<int>(Status::converged);
+    deadline_ = std::chrono::steady_clock::now() +
+                std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(time_budget_));
+}
+
+bool rpn_engine::Solver::Evaluate(RealFunction &f, double x, double &y)
+{
+    if (stop_ != static_cast<int>(Status::converged))
+        return false;
+    if (time_budget_ != 0 && std::chrono::steady_clock::now() > deadline_)
+    {
+        stop_ = static_cast<int>(Status::time_budget);
+        return false;
+    }
+    // Take a slot of the budget atomically. The check and the increment in separate steps
+    // let the workers overrun the budget together.
+    const unsigned long taken = evaluations_.fetch_add(1);
+    if (evaluation_budget_ != 0 && taken >= evaluation_budget_)
+    {
+        evaluations_.fetch_sub(1); // Not evaluated.
+        stop_ = static_cast<int>(Status::evaluation_budget);
+        return false;
+    }
+    y = f(x);
+    return true;
+}
+
+// Brent, R. P. "Algorithms for Minimization without Derivatives", Chapter 4.
+rpn_engine::Solver::Status rpn_engine::Solver::Brent(RealFunction &f, double a, double b, double fa, double fb, double &root)
+{
+    // b is the best estimate. The root is between b and c. a is the previous b.
+    double c = a, fc = fa;
+    const double bound = std::min(std::fabs(fa), std::fabs(fb));
+
+    while (true)
+    {
+        const double previous_step = b - a;
+        if (std::fabs(fc) < std::fabs(fb))
+        {
+            a = b, b = c, c = a;
+            fa = fb, fb = fc, fc = fa;
+        }
+
+        const double tolerance = 2 * DBL_EPSILON * std::fabs(b) + tolerance_ / 2;
+        const double c_b = c - b;
+        double step = c_b / 2; // Bisection
+        if (std::fabs(step) <= tolerance || fb == 0)
+        {
+            root = b;
+            // The sign change of the discontinuity doesn't make |f| small.
+            return std::fabs(fb) <= bound ? Status::converged : Status::discontinuity;
+        }
+
+        // Interpolate if the last step reduced |f|.
+        if (std::fabs(previous_step) >= tolerance && std::fabs(fa) > std::fabs(fb))
+        {
+            double p, q;
+            const double s = fb / fa;
+            if (a == c) // Secant
+            {
+                p = c_b * s;
+                q = 1 - s;
+            }
+            else // Inverse quadratic interpolation
+            {
+                const double r = fb / fc;
+                q = fa / fc;
+                p = s * (c_b * q * (q - r) - (b - a) * (r - 1));
+                q = (q - 1) * (r - 1) * (s - 1);
+            }
+            if (p > 0)
+                q = -q;
+            else
+                p = -p;
+            // Take the interpolation only if it stays in the bracket and converges fast enough.
+            if (p < 0.75 * c_b * q - std::fabs(tolerance * q) / 2 && p < std::fabs(previous_step * q / 2))
+                step = p / q;
+        }
+        if (std::fabs(step) < tolerance)
+            step = step > 0 ? tolerance : -tolerance;
+
+        a = b, fa = fb;
+        b += step;
+        if (!Evaluate(f, b, fb))
+            return static_cast<Status>(stop_.load());
+        if ((fb > 0 && fc > 0) || (fb < 0 && fc < 0))
+            c = a, fc = fa;
+    }
+}
+
+rpn_engine::Solver::Status rpn_engine::Solver::Solve(double a, double b, double &root)
+{
+    Start();
+    RealFunction &f = *functions_[0];
+    double fa, fb;
+    if (!Evaluate(f, a, fa) || !Evaluate(f, b, fb))
+        return static_cast<Status>(stop_.load());
+    if (fa == 0 || fb == 0)
+    {
+        root = fa == 0 ? a : b;
+        return Status::converged;
+    }
+    if (!std::isfinite(fa) || !std::isfinite(fb) || (fa > 0) == (fb > 0))
+        return Status::no_sign_change;
+    return Brent(f, a, b, fa, fb, root);
+}
+
+rpn_engine::Solver::Status rpn_engine::Solver::SolveAll(double a, double b, unsigned int brackets, std::vector<double> &roots)
+{
+    assert(brackets > 0);
+    Start();
+
+    // Sample f at the ends of the brackets. A task evaluates a chunk of the samples.
+    const unsigned int kChunkSize = 64;
+    std::vector<double> x(brackets + 1), y(brackets + 1, NAN);
+    for (unsigned int i = 0; i < brackets; i++)
+        x[i] = a + (b - a) * i / brackets;
+    x[brackets] = b;
+    pool_.Run([&](unsigned int worker)
+              {
+                  for (unsigned int start = 0; start <= brackets; start += kChunkSize)
+                      pool_.Spawn(worker, [&, start](unsigned int w)
+                                  {
+                                      unsigned int end = std::min(start + kChunkSize, brackets + 1);
+                                      for (unsigned int i = start; i < end; i++)
+                                          if (!Evaluate(*functions_[w], x[i], y[i]))
+                                              return; }); });
+
+    // Search the brackets with the sign change.
+    std::vector<double> found(brackets, NAN);
+    std::vector<Status> status(brackets, Status::no_sign_change);
+    pool_.Run([&](unsigned int worker)
+              {
+                  for (unsigned int i = 0; i < brackets; i++)
+                  {
+                      if (!std::isfinite(y[i]) || !std::isfinite(y[i + 1]) || y[i] == 0 || y[i + 1] == 0 || (y[i] > 0) == (y[i + 1] > 0))
+                          continue;
+                      pool_.Spawn(worker, [&, i](unsigned int w)
+                                  { status[i] = Brent(*functions_[w], x[i], x[i + 1], y[i], y[i + 1], found[i]); });
+                  } });
+
+    // The exact zeros at the samples and the converged brackets are in order.
+    std::vector<double> candidates;
+    for (unsigned int i = 0; i <= brackets; i++)
+    {
+        if (y[i] == 0)
+            candidates.push_back(x[i]);
+        if (i < brackets && status[i] == Status::converged)
+            candidates.push_back(found[i]);
+    }
+    if (b < a)
+        std::reverse(candidates.begin(), candidates.end());
+    std::vector<double> distinct;
+    for (auto root : candidates)
+    {
+        const double distance = 4 * DBL_EPSILON * std::fabs(root) + tolerance_;
+        if (distinct.empty() || root - distinct.back() > distance)
+            distinct.push_back(root);
+    }
+    roots.insert(roots.end(), distinct.begin(), distinct.end());
+
+    return static_cast<Status>(stop_.load());
+}
@@ -0,0 +1,167 @@
+#pragma once
+/**
+ * @file solver.hpp
+ * @author Seiichi "Suikan" Horie
+ * @brief Root finding of the program.
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#include "realfunction.hpp"
+#include "workstealingpool.hpp"
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+namespace rpn_engine
+{
+    /**
+     * @brief Find x such that f(x) = 0 for the program f.
+     * @details
+     * The function is the program run by the RealFunction. x is pushed to the
+     * cleared stack and X after the program is f(x). The registers are the parameters.
+     *
+     * Solve() finds a root in a bracket [a, b] where f(a) and f(b) have different
+     * signs. It uses the Brent's method : the inverse quadratic interpolation or the
+     * secant step when it is safe, otherwise the bisection step. So, it converges as
+     * fast as the secant method for the smooth function, and never slower than the
+     * bisection.
+     *
+     * SolveAll() divides a range into many brackets and finds all roots. The samples
+     * of f and the brackets with the sign change are processed in parallel by the
+     * WorkStealingPool. The roots are sorted and the duplicates are removed. A sign
+     * change which doesn't converge to a small |f| like the pole of 1/x is not a root.
+     *
+     * The number of the evaluations and the time are limited by the budgets. When a
+     * budget is exhausted, all workers stop and the roots found so far are returned.
+     */
+    class Solver
+    {
+    public:
+        /**
+         * @brief Result of the search.
+         */
+        enum class Status
+        {
+            converged,         ///< Converged within the tolerance.
+            no_sign_change,    ///< f(a) and f(b) have the same sign or are not finite.
+            discontinuity,     ///< Converged to a sign change which is not a root.
+            evaluation_budget, ///< Stopped by the evaluation budget.
+            time_budget,       ///< Stopped by the time budget.
+        };
+
+        /**
+         * @brief Construct a new solver.
+         *
+         * @param pool Thread pool for SolveAll().
+         * @param stack_size Depth of the stack.
+         */
+        Solver(WorkStealingPool &pool, unsigned int stack_size = 4);
+
+        /**
+         * @brief Load the function.
+         *
+         * @param program Array of the opcode.
+         * @param length Number of the opcode in the program.
+         * @return true Loaded.
+         * @return false The program has error. See VirtualMachine::Load().
+         */
+        bool Load(const Op program[], std::size_t length);
+
+        /**
+         * @brief Set a parameter of the function.
+         *
+         * @param index Register number. 0 .. kNumberOfVmRegisters-1.
+         * @param value Value of the register.
+         */
+        void SetRegister(unsigned int index, double value);
+
+        /**
+         * @brief Set the absolute tolerance of x. The default is 1e-12.
+         * @details
+         * The relative tolerance of the double precision is added.
+         */
+        void SetTolerance(double tolerance);
+
+        /**
+         * @brief Set the max number of the evaluations of f in a Solve() or SolveAll().
+         *
+         * @param evaluations Number of the evaluations. 0 is no limit. The default is 0.
+         */
+        void SetEvaluationBudget(unsigned long evaluations);
+
+        /**
+         * @brief Set the max time of a Solve() or SolveAll().
+         *
+         * @param seconds Time in second. 0 is no limit. The default is 0.
+         */
+        void SetTimeBudget(double seconds);
+
+        /**
+         * @brief Find a root in a bracket.
+         *
+         * @param a An end of the bracket.
+         * @param b The other end of the bracket.
+         * @param root The root found.
+         * @return Result. The root is valid if converged.
+         * @details
+         * Run on the calling thread.
+         */
+        Status Solve(double a, double b, double &root);
+
+        /**
+         * @brief Find the roots in a range.
+         *
+         * @param a Start of the range.
+         * @param b End of the range.
+         * @param brackets Number of the brackets to divide the range into.
+         * @param roots The roots in ascending order are appended.
+         * @return converged if all brackets are processed. Otherwise, the reason of the stop.
+         * @details
+         * A bracket finds at most one root. So, the brackets should be narrower than
+         * the distance between the roots.
+         */
+        Status SolveAll(double a, double b, unsigned int brackets, std::vector<double> &roots);
+
+        /**
+         * @brief Number of the evaluations of f in the last Solve() or SolveAll().
+         */
+        unsigned long GetEvaluationCount() const;
+
+    private:
+        WorkStealingPool &pool_;
+        std::vector<std::unique_ptr<RealFunction>> functions_; // One for each worker.
+        double tolerance_;
+        unsigned long evaluation_budget_;
+        double time_budget_;
+        std::atomic<unsigned long> evaluations_;
+        std::atomic<int> stop_; // Status of the stop reason, or converged.
+        std::chrono::steady_clock::time_point deadline_;
+
+        /**
+         * @brief Start the budget of a search.
+         */
+        void Start();
+
+        /**
+         * @brief Evaluate f within the budget.
+         *
+         * @return true Evaluated.
+         * @return false A budget is exhausted.
+         */
+        bool Evaluate(RealFunction &f, double x, double &y);
+
+        /**
+         * @brief Brent's method.
+         *
+         * @param fa f(a)
+         * @param fb f(b). Must have the different sign from fa.
+         */
+        Status Brent(RealFunction &f, double a, double b, double fa, double fb, double &root);
+    };
+}
@@ -0,0 +1,19 @@
+/**
+ * @file stackstrategy.cpp
+ * @author Seiichi "Suikan" Horie
+ * @brief Explicit instantiation of the StackStrategy class template.
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2026
+ *
+ * @details
+ * The stackstrategy.hpp declares these specializations as extern template.
+ * Thus, the member functions of these specializations are compiled only here.
+ */
+#include "stackstrategy.hpp"
+
+template class rpn_engine::StackStrategy<int>;
+template class rpn_engine::StackStrategy<float>;
+template class rpn_engine::StackStrategy<double>;
+template class rpn_engine::StackStrategy<std::complex<double>>;
@@ -12,7 +12,14 @@
 #include <cassert>
 #include <cmath>
 #include <complex>
+#include <cstdint>
+#include <limits>
+#include <memory>
 #include <type_traits>
+#include "kernels.hpp"
+#include "polynomial.hpp"
+#include "random.hpp"
+#include "statistics.hpp"
 
 /**
  * @brief Engine implementation of RPN stack machine.
@@ -26,6 +33,13 @@ namespace rpn_engine
      */
     constexpr double pi = 3.141592653589793238462643383279502884L;
 
+    /**
+     * @brief Number of the coefficient registers of the StackStrategy.
+     * @details
+     * The registers are used by Op::coefficient_store and Op::coefficient_polynomial.
+     */
+    const unsigned int kNumberOfCoefficients = 16;
+
     /**
      * @brief enum class to specify the operation on stack
      *
@@ -78,6 +92,15 @@ namespace rpn_engine
         logical_shift_right, ///< Pop X, Y, do Y >> X, then push
         logical_shift_left,  ///< Pop X, Y, do Y << X, then push
         bit_not,             ///< Pop X,  do  ~X, then push
+        sigma_plus,          ///< Add (X, Y) to the statistics. Then, replace X by the number of samples.
+        sigma_minus,         ///< Remove (X, Y) from the statistics. Then, replace X by the number of samples.
+        sigma_clear,         ///< Clear the statistics.
+        mean,                ///< Push mean of y, then push mean of x.
+        standard_deviation,  ///< Push sample standard deviation of y, then push the one of x.
+        random,              ///< Push uniform random number in [0, 1)
+        polynomial,          ///< Pop degree n, x, a0, a1, ... an. Then push a0 + a1*x + ... + an*x^n. n + 3 must not exceed the stack size.
+        coefficient_store,   ///< Pop index i. Store Y to the coefficient register i. Y is left on the top.
+        coefficient_polynomial, ///< Pop degree n, x. Then push c0 + c1*x + ... + cn*x^n by the coefficient registers.
         change_display,      ///< Change the display mode ( fix, sci, end). Do not feed to Stack engine.
         enter,               ///< Delimiter between numbers.
         clx,                 ///< Clear X register. Do not feed to Stack engine.
@@ -87,6 +110,15 @@ namespace rpn_engine
         sto,                 ///< Store to a variable
         rcl,                 ///< Recall from a variable
         func,                ///< Pressing F key.
+        // Program opcode. Only for VirtualMachine. Console ignores them.
+        label,               ///< Label. Followed by a digit opcode as the label number.
+        go_to,               ///< Jump to the label. Followed by a digit opcode as the label number.
+        go_sub,              ///< Call the subroutine at the label. Followed by a digit opcode as the label number.
+        ret,                 ///< Return from the subroutine. End of program at the top level.
+        x_eq_y,              ///< Execute next step if X == Y. Otherwise, skip it.
+        x_ne_y,              ///< Execute next step if X != Y. Otherwise, skip it.
+        x_lt_y,              ///< Execute next step if X < Y. Otherwise, skip it.
+        x_le_y,              ///< Execute next step if X <= Y. Otherwise, skip it.
         nop,                 ///< Do nothing
                              // Editing op code.
         num_0,               ///< Constant for key input. Do not feed to Stack engine.
@@ -111,6 +143,107 @@ namespace rpn_engine
         chs,                 ///< negate the sign
     };
 
+    /**
+     * @brief Sticky floating point status flags of the StackStrategy.
+     *
+     * @details
+     * The flags are bitwise OR-ed. Once raised, a flag stays until StackStrategy::ClearStatus().
+     */
+    enum FloatingPointStatus : uint32_t
+    {
+        kFpInvalid = 1 << 0,        ///< NaN is created from non NaN operands.
+        kFpDivideByZero = 1 << 1,   ///< Division of by zero, or logarithm of zero.
+        kFpOverflow = 1 << 2,       ///< Infinity is created from finite operands.
+        kFpUnderflow = 1 << 3,      ///< Subnormal value is created from non subnormal operands.
+        kFpInexactBitwise = 1 << 4, ///< Fraction, imaginary part or upper bits are discarded by the bitwise operation.
+    };
+
+    /**
+     * @brief Classify the value for the floating point status.
+     *
+     * @param x Value to classify.
+     * @return kFpInvalid if NaN, kFpOverflow if infinity, kFpUnderflow if subnormal. Otherwise 0.
+     * @details
+     * The classification is done without branch. The other element types can
+     * provide their own overload in the rpn_engine namespace.
+     */
+    template <class T,
+              typename std::enable_if<std::is_arithmetic<T>::value, int>::type = 0>
+    inline uint32_t ClassifyElement(T x)
+    {
+        return kFpInvalid * std::isnan(x) |
+               kFpOverflow * std::isinf(x) |
+               kFpUnderflow * (std::fpclassify(x) == FP_SUBNORMAL);
+    }
+
+    /**
+     * @brief Classify the complex value for the floating point status.
+     *
+     * @param x Value to classify.
+     * @return Bitwise OR of the classification of the real part and imaginary part.
+     */
+    template <class T>
+    inline uint32_t ClassifyElement(const std::complex<T> &x)
+    {
+        return ClassifyElement(x.real()) | ClassifyElement(x.imag());
+    }
+
+    /**
+     * @brief Read only view of the stack contents.
+     *
+     * @tparam Element A type name as element of stack
+     * @details
+     * A light weight range over the live stack of StackStrategy. The view
+     * doesn't copy the elements. The element 0 is the stack top, and the
+     * element size()-1 is the stack bottom. That is the same order with
+     * the StackStrategy::Get().
+     *
+     * The view is valid until the next modification of the stack. The operator[]
+     * doesn't check the range.
+     */
+    template <class Element>
+    class StackView
+    {
+    public:
+        /**
+         * @brief Construct a new Stack View object
+         *
+         * @param data Pointer to the stack top.
+         * @param size Number of the elements in the stack.
+         */
+        StackView(const Element *data, unsigned int size) : data_(data), size_(size) {}
+
+        /**
+         * @brief Get the element at specified position
+         *
+         * @param position The distance from the stack top. Must be smaller than size().
+         * @return Reference to the element.
+         */
+        const Element &operator[](unsigned int position) const { return data_[position]; }
+
+        /**
+         * @brief Number of the elements in the view
+         */
+        unsigned int size() const { return size_; }
+
+        /**
+         * @brief Iterator to the stack top.
+         */
+        const Element *begin() const { return data_; }
+
+        /**
+         * @brief Iterator to the next of the stack bottom.
+         */
+        const Element *end() const { return data_ + size_; }
+
+    private:
+        const Element *const data_;
+        const unsigned int size_;
+    };
+
+    template <class Element>
+    class VirtualMachine;
+
     /**
      * @brief A generic stack.
      *
@@ -134,11 +267,59 @@ namespace rpn_engine
      * @li ToPolar
      * @li ToCartesian
      * @li SwapReIm
+     *
+     * The mathematical functions are called without namespace qualification, after
+     * the using declaration of the std namespace. Thus, a user defined Element type
+     * can provide its own sqrt(), exp(), ... in its namespace.
+     *
+     * The stack and the undo buffer are copy-on-write storage. The TakeSnapshot() and
+     * the RestoreSnapshot() share the storage with the snapshot. The storage is copied
+     * at the first modification after sharing. So, both functions finish in
+     * constant time regardless of the stack size.
      */
     template <class Element>
     class StackStrategy
     {
+        // VirtualMachine saves the stack to the undo buffer once per Run().
+        template <class E>
+        friend class VirtualMachine;
+
     public:
+        /**
+         * @brief Saved state of the stack.
+         * @details
+         * The state of the stack and the undo buffer at TakeSnapshot(). The snapshot
+         * shares the storage with the stack until one of them is modified. Thus,
+         * copying a snapshot is also cheap. The snapshots are not modified by the stack.
+         */
+        class Snapshot
+        {
+        public:
+            /**
+             * @brief Get the value of the saved stack at specified position
+             *
+             * @param position The distance from the stack top.
+             * @return Element at the specified position.
+             */
+            const Element &Get(unsigned int position) const
+            {
+                assert(stack_size_ > position);
+                return storage_.get()[position];
+            }
+
+        private:
+            friend class StackStrategy;
+            Snapshot(const std::shared_ptr<Element> &storage, unsigned int stack_size,
+                     uint32_t status, unsigned long operation_count, unsigned long first_status_index)
+                : storage_(storage), stack_size_(stack_size),
+                  status_(status), operation_count_(operation_count), first_status_index_(first_status_index) {}
+            std::shared_ptr<Element> storage_;
+            unsigned int stack_size_;
+            uint32_t status_;
+            unsigned long operation_count_;
+            unsigned long first_status_index_;
+        };
+
         /**
          * @brief Construct a new Stack Strategy object
          *
@@ -147,6 +328,15 @@ namespace rpn_engine
          * In the cae of stack_size == 0, assertion failed.
          */
         StackStrategy(unsigned int stack_size);
+
+        /**
+         * @brief Construct a copy of the stack.
+         *
+         * @param other Stack to copy.
+         * @details
+         * The storage is shared with other until one of them is modified.
+         */
+        StackStrategy(const StackStrategy &other);
         // Surpress the default constructor.
         StackStrategy() = delete;
         ~StackStrategy();
@@ -168,6 +358,24 @@ namespace rpn_engine
          */
         Element Get(unsigned int position);
 
+        /**
+         * @brief Get the read only view of the stack.
+         *
+         * @return The view from the stack top to the stack bottom.
+         * @details
+         * No element is copied. The view is valid until the next modification of the stack.
+         */
+        StackView<Element> GetView() const;
+
+        /**
+         * @brief Get the read only view of the undo buffer.
+         *
+         * @return The view of the stack state which Undo() will retrieve.
+         * @details
+         * No element is copied. The view is valid until the next modification of the stack.
+         */
+        StackView<Element> GetUndoView() const;
+
         /**
          * @brief Overwrite stack top
          * @param e Value to overwrite the stack top
@@ -202,16 +410,192 @@ namespace rpn_engine
          */
         void Undo();
 
+        /**
+         * @brief Fill the stack by zero.
+         * @details
+         * The undo buffer, the statistics and the floating point status are not affected.
+         */
+        void Clear();
+
+        /**
+         * @brief Save the current state of the stack.
+         *
+         * @return Snapshot of the stack and undo buffer.
+         * @details
+         * No element is copied at this point.
+         */
+        Snapshot TakeSnapshot() const;
+
+        /**
+         * @brief Retrieve the stack state saved by TakeSnapshot()
+         *
+         * @param snapshot A snapshot taken from the stack with same size.
+         * @details
+         * Both the stack and the undo buffer are retrieved. The snapshot can be
+         * retrieved repeatedly. No element is copied at this point.
+         *
+         * The floating point status is retrieved, too.
+         */
+        void RestoreSnapshot(const Snapshot &snapshot);
+
+        /**
+         * @brief Get the sticky floating point status.
+         *
+         * @return Bitwise OR of the FloatingPointStatus raised since the last ClearStatus().
+         * @details
+         * The status is updated by Operation() without any check by the caller. So, a batch
+         * of operations can be run without inspecting the stack, and then the status can be
+         * queried once.
+         *
+         * The status is not affected by Undo().
+         */
+        uint32_t GetStatus() const;
+
+        /**
+         * @brief Clear the floating point status and the operation count.
+         */
+        void ClearStatus();
+
+        /**
+         * @brief Number of the Operation() calls since the last ClearStatus().
+         */
+        unsigned long GetOperationCount() const;
+
+        /**
+         * @brief Index of the first operation which raised the status.
+         *
+         * @return Zero based index of the Operation() call since the last ClearStatus().
+         * The return value is valid only when GetStatus() is not zero.
+         */
+        unsigned long GetFirstStatusIndex() const;
+
+        /**
+         * @brief Get the statistics accumulator.
+         *
+         * @return The accumulator updated by Op::sigma_plus, Op::sigma_minus and Accumulate().
+         * @details
+         * The accumulator is not affected by Undo() and RestoreSnapshot().
+         */
+        const Statistics &GetStatistics() const;
+
+        /**
+         * @brief Add the array of samples to the statistics.
+         *
+         * @param x Array of the x samples.
+         * @param count Number of the samples.
+         * @details
+         * y is regarded as 0. The stack is not affected.
+         */
+        void Accumulate(const double x[], std::size_t count);
+
+        /**
+         * @brief Add the arrays of (x, y) samples to the statistics.
+         *
+         * @param x Array of the x samples.
+         * @param y Array of the y samples.
+         * @param count Number of the samples.
+         * @details
+         * The stack is not affected.
+         */
+        void Accumulate(const double x[], const double y[], std::size_t count);
+
+        /**
+         * @brief Initialize the random number generator for Op::random.
+         *
+         * @param seed Seed of the sequence.
+         * @param stream Stream number. The engines with different stream number generate
+         * the independent sequences from the same seed.
+         */
+        void SeedRandom(uint64_t seed, uint64_t stream = 0);
+
+        /**
+         * @brief Evaluate polynomial by the coefficients in the register range.
+         *
+         * @param coefficients Coefficients in ascending order. coefficients[i] is for x^i.
+         * @param count Number of the coefficients. Must be 1 or more.
+         * @details
+         * Pop X, then push the value of the polynomial at X. The coefficients are not
+         * limited by the stack size. Undo buffer is affected.
+         */
+        void Polynomial(const Element coefficients[], unsigned int count);
+
+        /**
+         * @brief Get the coefficient register.
+         *
+         * @param index Index of the register. Must be less than kNumberOfCoefficients.
+         * @return The value stored by Op::coefficient_store or SetCoefficient().
+         */
+        Element GetCoefficient(unsigned int index) const;
+
+        /**
+         * @brief Set the coefficient register.
+         *
+         * @param index Index of the register. Must be less than kNumberOfCoefficients.
+         * @param value Coefficient of x^index for Op::coefficient_polynomial.
+         */
+        void SetCoefficient(unsigned int index, const Element &value);
+
+        /**
+         * @brief Clear all the coefficient registers to 0.
+         * @details
+         * The coefficient registers are not affected by Clear(), Undo() and RestoreSnapshot().
+         */
+        void ClearCoefficients();
+
     private:
         const unsigned int stack_size_;
+        /**
+         * @brief The storage of the stack and undo buffer.
+         * @details
+         * The first stack_size_ elements are stack. The next stack_size_ elements are undo buffer.
+         * The storage may be shared with the snapshots.
+         */
+        std::shared_ptr<Element> storage_;
         /**
          * @brief The entity of stack.
          * @details
          * The stack_[0] is the stack top. Index is allowed from 0 to stack_size_-1.
          */
-        Element *const stack_;
-        Element *const undo_buffer_;
+        Element *stack_;
+        Element *undo_buffer_;
         bool undo_saving_enabled_;
+        Statistics statistics_;
+        Xoshiro256 random_;
+        Element coefficients_[kNumberOfCoefficients];
+        uint32_t status_;                  // Sticky floating point status.
+        uint32_t kernel_status_;           // Status raised by the kernel of the current operation.
+        unsigned long operation_count_;    // Number of operations since the last ClearStatus().
+        unsigned long first_status_index_; // Index of the operation which raised the status first.
+
+        /**
+         * @brief Classify the result of the operation and update the status.
+         *
+         * @param operand_status Classification of the operands before the operation.
+         * @details
+         * Only the special values which are newly created by the operation raise the flags.
+         * The values just propagated from the operands don't.
+         */
+        void UpdateStatus(uint32_t operand_status);
+
+        /**
+         * @brief Check whether the operation creates a value.
+         *
+         * @param opcode Operation.
+         * @return false The stack manipulation. It only moves or restores the values.
+         */
+        static bool CreatesValue(Op opcode);
+
+        /**
+         * @brief Make the storage exclusive before modification.
+         * @details
+         * If the storage is shared with the snapshots, copy it to the new storage.
+         */
+        void DetachStorage();
+
+        /**
+         * @brief Update stack_ and undo_buffer_ by storage_.
+         */
+        void AttachStorage(const std::shared_ptr<Element> &storage);
 
         /**
          * @brief Disabling to save the stack by RAII
@@ -335,6 +719,45 @@ namespace rpn_engine
          */
         void Pi();
 
+        /**
+         * @brief Push random number
+         * @details
+         * Push uniform random number in [0, 1) to the stack.
+         */
+        void Random();
+
+        /**
+         * @brief Evaluate polynomial by the coefficients on the stack.
+         * @details
+         * Pop degree n from X, variable x from Y, then pop n+1 coefficients.
+         * The coefficient of x^0 is at Z, and the coefficient of x^n is the deepest.
+         * Then, push the value of the polynomial. The stack is shifted only once.
+         *
+         * If n is not an integer or n + 3 exceeds the stack size, n and x are popped and NaN is pushed.
+         * So, the degree is 0 or 1 on the 4 level stack of the Console. Use the deeper stack,
+         * CoefficientPolynomial() or Polynomial(coefficients, count) for the higher degree.
+         */
+        void Polynomial();
+
+        /**
+         * @brief Store Y to the coefficient register.
+         * @details
+         * Pop index i from X, then store the new X to the coefficient register i.
+         * If i is not an integer in [0, kNumberOfCoefficients), i is popped and X is replaced by NaN.
+         */
+        void CoefficientStore();
+
+        /**
+         * @brief Evaluate polynomial by the coefficient registers.
+         * @details
+         * Pop degree n from X, variable x from Y. Then, push the value of the polynomial
+         * by the coefficient registers 0 .. n. Unlike Polynomial(), the degree is not limited
+         * by the stack size.
+         *
+         * If n is not an integer or n + 1 exceeds kNumberOfCoefficients, n and x are popped and NaN is pushed.
+         */
+        void CoefficientPolynomial();
+
         /********************************** TRANSCENDENTAL OPERATION *****************************/
 
         /**
@@ -493,7 +916,8 @@ namespace rpn_engine
             auto x = this->Pop();
 
             // push real, push imag
-            this->Push(std::conj(x));
+            using std::conj;
+            this->Push(conj(x));
         }
 
         template <class E = Element,
@@ -526,7 +950,9 @@ namespace rpn_engine
             auto x = this->Pop();
 
             // push in polar notation
-            this->Push(Element(std::abs(x), std::arg(x)));
+            using std::abs;
+            using std::arg;
+            this->Push(Element(abs(x), arg(x)));
         }
 
         template <class E = Element,
@@ -559,7 +985,8 @@ namespace rpn_engine
             auto x = this->Pop();
 
             // push in cartesian nortation : abs * exp( i * arg )
-            this->Push(x.real() * std::exp(Element(0, 1) * x.imag()));
+            using std::exp;
+            this->Push(x.real() * exp(Element(0, 1) * x.imag()));
         }
 
         template <class E = Element,
@@ -701,6 +1128,88 @@ namespace rpn_engine
 
         void BitNot();
 
+        /********************************** STATISTICS OPERATION *****************************/
+
+        /**
+         * @brief Add (X, Y) to the statistics and replace X by the number of samples.
+         * @details
+         * The real parts are used. Undo buffer is affected.
+         */
+        void SigmaPlus();
+
+        /**
+         * @brief Remove (X, Y) from the statistics and replace X by the number of samples.
+         * @details
+         * The real parts are used. Undo buffer is affected.
+         */
+        void SigmaMinus();
+
+        /**
+         * @brief Clear the statistics.
+         * @details
+         * The stack is not affected.
+         */
+        void SigmaClear();
+
+        /**
+         * @brief Push mean of y and then push mean of x.
+         * @details
+         * Undo buffer is affected.
+         */
+        void Mean();
+
+        /**
+         * @brief Push sample standard deviation of y and then push the one of x.
+         * @details
+         * Undo buffer is affected.
+         */
+        void StandardDeviation();
+
+        /**
+         * @fn double ToDouble(Element x)
+         * @brief Convert parameter to double
+         *
+         * @param x Value to convert.
+         * @return double Real part of the x.
+         */
+        template <class E = Element,
+                  typename std::enable_if<!std::is_scalar<E>::value, int>::type = 0>
+        // Implementation when the template is specialized by std::complex<> type.
+        double ToDouble(Element x)
+        {
+            return x.real();
+        }
+
+        template <class E = Element,
+                  typename std::enable_if<std::is_scalar<E>::value, int>::type = 0>
+        // Implementation when the template is specialized by scarlar type.
+        double ToDouble(Element x)
+        {
+            return static_cast<double>(x);
+        }
+
+        /**
+         * @fn Element NotANumber()
+         * @brief Quiet NaN of the Element type.
+         *
+         * @return NaN. In case of the integer type, 0.
+         */
+        template <class E = Element,
+                  typename std::enable_if<!std::is_scalar<E>::value, int>::type = 0>
+        // Implementation when the template is specialized by std::complex<> type.
+        Element NotANumber()
+        {
+            return Element(std::numeric_limits<double>::quiet_NaN());
+        }
+
+        template <class E = Element,
+                  typename std::enable_if<std::is_scalar<E>::value, int>::type = 0>
+        // Implementation when the template is specialized by scarlar type.
+        Element NotANumber()
+        {
+            return std::numeric_limits<Element>::quiet_NaN();
+        }
+
         /**
          * @fn int32_t To64bitValue(Element x)
          * @brief Convert parameter to int32_t
@@ -722,6 +1231,11 @@ namespace rpn_engine
         // Implementation when the template is specialized by std::complex<> type.
         int64_t To64bitValue(Element x)
         {
+            // Discarding the fraction, the imaginary part or the upper bits is inexact.
+            // NaN and infinity are also inexact.
+            double value = x.real();
+            kernel_status_ |= kFpInexactBitwise * !(value == std::trunc(value) && std::fabs(value) < 4294967296.0 && x.imag() == 0);
+
             // The double value is truncated to 64bit integer. Then,
             // 32bit LSB is extracted.
             int64_t intermediate_value = x.real();
@@ -738,6 +1252,11 @@ namespace rpn_engine
         // Implementation when the template is specialized by scarlar type.
         int64_t To64bitValue(Element x)
         {
+            // Discarding the fraction or the upper bits is inexact.
+            // NaN and infinity are also inexact.
+            double value = static_cast<double>(x);
+            kernel_status_ |= kFpInexactBitwise * !(value == std::trunc(value) && std::fabs(value) < 4294967296.0);
+
             // The double value is truncated to 64bit integer. Then,
             // 32bit LSB is extracted.
             int64_t intermediate_value = x;
@@ -762,12 +1281,15 @@ namespace rpn_engine
 // constructor
 template <class Element>
 rpn_engine::StackStrategy<Element>::StackStrategy(unsigned int stack_size) : stack_size_(stack_size),
-                                                                             stack_(new Element[stack_size_]),
-                                                                             undo_buffer_(new Element[stack_size_]),
-                                                                             undo_saving_enabled_(true)
+                                                                             undo_saving_enabled_(true),
+                                                                             status_(0),
+                                                                             kernel_status_(0),
+                                                                             operation_count_(0),
+                                                                             first_status_index_(0)
 {
     assert(stack_size_ >= 2);
-    // allocate stack
+    // allocate stack and undo buffer
+    AttachStorage(std::shared_ptr<Element>(new Element[2 * stack_size_], std::default_delete<Element[]>()));
     assert(stack_ != nullptr);
 
     // initialize stack
@@ -776,15 +1298,122 @@ rpn_engine::StackStrategy<Element>::StackStrategy(unsigned int stack_size) : sta
     // initialize undo buffer
     for (unsigned int i = 0; i < stack_size_; i++)
         undo_buffer_[i] = 0;
+    ClearCoefficients();
+}
+
+template <class Element>
+rpn_engine::StackStrategy<Element>::StackStrategy(const StackStrategy &other) : stack_size_(other.stack_size_),
+                                                                               undo_saving_enabled_(other.undo_saving_enabled_),
+                                                                               statistics_(other.statistics_),
+                                                                               random_(other.random_),
+                                                                               status_(other.status_),
+                                                                               kernel_status_(other.kernel_status_),
+                                                                               operation_count_(other.operation_count_),
+                                                                               first_status_index_(other.first_status_index_)
+{
+    AttachStorage(other.storage_);
+    for (unsigned int i = 0; i < kNumberOfCoefficients; i++)
+        coefficients_[i] = other.coefficients_[i];
 }
 
 template <class Element>
 rpn_engine::StackStrategy<Element>::~StackStrategy()
 {
-    if (stack_ != nullptr)
-        delete[] stack_;
-    if (undo_buffer_ != nullptr)
-        delete[] undo_buffer_;
+    // storage_ is released automatically.
+}
+
+template <class Element>
+void rpn_engine::StackStrategy<Element>::AttachStorage(const std::shared_ptr<Element> &storage)
+{
+    storage_ = storage;
+    stack_ = storage_.get();
+    undo_buffer_ = stack_ + stack_size_;
+}
+
+template <class Element>
+void rpn_engine::StackStrategy<Element>::DetachStorage()
+{
+    // The source object and the snapshots are never written here. So, the copies
+    // in the other threads don't race with this check.
+    if (storage_.use_count() > 1) // Is the storage shared with snapshots or copies?
+    {
+        std::shared_ptr<Element> copy(new Element[2 * stack_size_], std::default_delete<Element[]>());
+        for (unsigned int i = 0; i < 2 * stack_size_; i++)
+            copy.get()[i] = storage_.get()[i];
+        AttachStorage(copy);
+    }
+}
+
+template <class Element>
+typename rpn_engine::StackStrategy<Element>::Snapshot rpn_engine::StackStrategy<Element>::TakeSnapshot() const
+{
+    return Snapshot(storage_, stack_size_, status_, operation_count_, first_status_index_);
+}
+
+template <class Element>
+void rpn_engine::StackStrategy<Element>::RestoreSnapshot(const Snapshot &snapshot)
+{
+    assert(snapshot.stack_size_ == stack_size_);
+    AttachStorage(snapshot.storage_);
+    status_ = snapshot.status_;
+    operation_count_ = snapshot.operation_count_;
+    first_status_index_ = snapshot.first_status_index_;
+}
+
+template <class Element>
+uint32_t rpn_engine::StackStrategy<Element>::GetStatus() const
+{
+    return status_;
+}
+
+template <class Element>
+void rpn_engine::StackStrategy<Element>::ClearStatus()
+{
+    status_ = 0;
+    operation_count_ = 0;
+    first_status_index_ = 0;
+}
+
+template <class Element>
+unsigned long rpn_engine::StackStrategy<Element>::GetOperationCount() const
+{
+    return operation_count_;
+}
+
+template <class Element>
+unsigned long rpn_engine::StackStrategy<Element>::GetFirstStatusIndex() const
+{
+    return first_status_index_;
+}
+
+template <class Element>
+bool rpn_engine::StackStrategy<Element>::CreatesValue(Op opcode)
+{
+    switch (opcode)
+    {
+    case Op::duplicate:
+    case Op::swap:
+    case Op::rotate_pop:
+    case Op::rotate_push:
+    case Op::undo:
+    case Op::sigma_clear:
+        return false;
+    default:
+        return true;
+    }
+}
+
+template <class Element>
+void rpn_engine::StackStrategy<Element>::UpdateStatus(uint32_t operand_status)
+{
+    // Special values newly created by this operation.
+    uint32_t raised = (ClassifyElement(stack_[0]) & ~operand_status) | kernel_status_;
+    // Infinity by the division by zero is not an overflow.
+    raised &= ~(kFpOverflow * ((kernel_status_ & kFpDivideByZero) != 0));
+
+    // Remember the first operation which raised the status.
+    first_status_index_ = (status_ == 0 && raised != 0) ? operation_count_ : first_status_index_;
+    status_ |= raised;
 }
 
 template <class Element>
@@ -794,6 +1423,18 @@ Element rpn_engine::StackStrategy<Element>::Get(unsigned int postion)
     return stack_[postion];
 }
 
+template <class Element>
+rpn_engine::StackView<Element> rpn_engine::StackStrategy<Element>::GetView() const
+{
+    return StackView<Element>(stack_, stack_size_);
+}
+
+template <class Element>
+rpn_engine::StackView<Element> rpn_engine::StackStrategy<Element>::GetUndoView() const
+{
+    return StackView<Element>(undo_buffer_, stack_size_);
+}
+
 template <class Element>
 void rpn_engine::StackStrategy<Element>::SetX(const Element &e)
 {
@@ -801,6 +1442,7 @@ void rpn_engine::StackStrategy<Element>::SetX(const Element &e)
     SaveToUndoBuffer();
     DisableUndoSaving disable_undo(this); // Disabling by RAII
 
+    DetachStorage();
     stack_[0] = e;
 }
 
@@ -811,6 +1453,7 @@ void rpn_engine::StackStrategy<Element>::Push(const Element &e)
     SaveToUndoBuffer();
     DisableUndoSaving disable_undo(this); // Disabling by RAII
 
+    DetachStorage();
     // copy stack[0..stack_size-2] to stack[1..stack_size_-1]
     for (unsigned int i = stack_size_ - 1; i > 0; i--)
         stack_[i] = stack_[i - 1];
@@ -826,6 +1469,7 @@ Element rpn_engine::StackStrategy<Element>::Pop()
     SaveToUndoBuffer();
     DisableUndoSaving disable_undo(this); // Disabling by RAII
 
+    DetachStorage();
     // preserve the last top value.
     Element last_top = stack_[0];
 
@@ -888,6 +1532,7 @@ void rpn_engine::StackStrategy<Element>::SaveToUndoBuffer()
 {
     if (undo_saving_enabled_)
     {
+        DetachStorage();
         // Store Stack state to the undo buffer.
         for (unsigned int i = 0; i < stack_size_; i++)
             undo_buffer_[i] = stack_[i];
@@ -913,11 +1558,20 @@ rpn_engine::StackStrategy<Element>::DisableUndoSaving::~DisableUndoSaving()
 template <class Element>
 void rpn_engine::StackStrategy<Element>::Undo()
 {
+    DetachStorage();
     // Retrieve the last stack state
     for (unsigned int i = 0; i < stack_size_; i++)
         stack_[i] = undo_buffer_[i];
 }
 
+template <class Element>
+void rpn_engine::StackStrategy<Element>::Clear()
+{
+    DetachStorage();
+    for (unsigned int i = 0; i < stack_size_; i++)
+        stack_[i] = 0;
+}
+
 template <class Element>
 void rpn_engine::StackStrategy<Element>::Add()
 {
@@ -929,7 +1583,7 @@ void rpn_engine::StackStrategy<Element>::Add()
     Element x = Pop();
     Element y = Pop();
     // do the operation
-    Push(y + x);
+    Push(kernel::Add(y, x));
 }
 
 template <class Element>
@@ -943,7 +1597,7 @@ void rpn_engine::StackStrategy<Element>::Subtract()
     Element x = Pop();
     Element y = Pop();
     // do the operation
-    Push(y - x);
+    Push(kernel::Subtract(y, x));
 }
 
 template <class Element>
@@ -957,7 +1611,7 @@ void rpn_engine::StackStrategy<Element>::Multiply()
     Element x = Pop();
     Element y = Pop();
     // do the operation
-    Push(y * x);
+    Push(kernel::Multiply(y, x));
 }
 
 template <class Element>
@@ -971,7 +1625,8 @@ void rpn_engine::StackStrategy<Element>::Divide()
     Element x = Pop();
     Element y = Pop();
     // do the operation
-    Push(y / x);
+    kernel_status_ |= kFpDivideByZero * (x == Element(0));
+    Push(kernel::Divide(y, x));
 }
 
 template <class Element>
@@ -984,7 +1639,7 @@ void rpn_engine::StackStrategy<Element>::Negate()
     // Get parameters
     Element x = Pop();
     // do the operation
-    Push(-x);
+    Push(kernel::Negate(x));
 }
 
 template <class Element>
@@ -997,7 +1652,8 @@ void rpn_engine::StackStrategy<Element>::Inverse()
     // Get parameters
     Element x = Pop();
     // do the operation
-    Push(1.0 / x);
+    kernel_status_ |= kFpDivideByZero * (x == Element(0));
+    Push(kernel::Inverse(x));
 }
 
 template <class Element>
@@ -1010,7 +1666,7 @@ void rpn_engine::StackStrategy<Element>::Sqrt()
     // Get parameters
     Element x = Pop();
     // do the operation
-    Push(std::sqrt(x));
+    Push(kernel::Sqrt(x));
 }
 
 template <class Element>
@@ -1023,7 +1679,7 @@ void rpn_engine::StackStrategy<Element>::Square()
     // Get parameters
     Element x = Pop();
     // do the operation
-    Push(x * x);
+    Push(kernel::Square(x));
 }
 
 template <class Element>
@@ -1037,6 +1693,17 @@ void rpn_engine::StackStrategy<Element>::Pi()
     Push(rpn_engine::pi);
 }
 
+template <class Element>
+void rpn_engine::StackStrategy<Element>::Random()
+{
+    // Save stack state before mathematical operation
+    SaveToUndoBuffer();
+    DisableUndoSaving disable_undo(this); // Disabling by RAII
+
+    // do the operation
+    Push(random_.NextDouble());
+}
+
 template <class Element>
 void rpn_engine::StackStrategy<Element>::Exp()
 {
@@ -1047,7 +1714,7 @@ void rpn_engine::StackStrategy<Element>::Exp()
     // Get parameters
     Element x = Pop();
     // do the operation
-    Push(std::exp(x));
+    Push(kernel::Exp(x));
 }
 
 template <class Element>
@@ -1060,7 +1727,8 @@ void rpn_engine::StackStrategy<Element>::Log()
     // Get parameters
     Element x = Pop();
     // do the operation
-    Push(std::log(x));
+    kernel_status_ |= kFpDivideByZero * (x == Element(0));
+    Push(kernel::Log(x));
 }
 
 template <class Element>
@@ -1073,7 +1741,8 @@ void rpn_engine::StackStrategy<Element>::Log10()
     // Get parameters
     Element x = Pop();
     // do the operation
-    Push(std::log10(x));
+    kernel_status_ |= kFpDivideByZero * (x == Element(0));
+    Push(kernel::Log10(x));
 }
 
 template <class Element>
@@ -1086,7 +1755,7 @@ void rpn_engine::StackStrategy<Element>::Power10()
     // Get parameters
     Element x = Pop();
     // do the operation
-    Push(std::pow(10, x));
+    Push(kernel::Power10(x));
 }
 
 template <class Element>
@@ -1100,7 +1769,7 @@ void rpn_engine::StackStrategy<Element>::Power()
     Element x = Pop();
     Element y = Pop();
     // do the operation
-    Push(std::pow(y, x));
+    Push(kernel::Power(y, x));
 }
 
 template <class Element>
@@ -1113,7 +1782,7 @@ void rpn_engine::StackStrategy<Element>::Sin()
     // Get parameters
     Element x = Pop();
     // do the operation
-    Push(std::sin(x));
+    Push(kernel::Sin(x));
 }
 
 template <class Element>
@@ -1126,7 +1795,7 @@ void rpn_engine::StackStrategy<Element>::Cos()
     // Get parameters
     Element x = Pop();
     // do the operation
-    Push(std::cos(x));
+    Push(kernel::Cos(x));
 }
 
 template <class Element>
@@ -1139,7 +1808,7 @@ void rpn_engine::StackStrategy<Element>::Tan()
     // Get parameters
     Element x = Pop();
     // do the operation
-    Push(std::tan(x));
+    Push(kernel::Tan(x));
 }
 
 template <class Element>
@@ -1152,7 +1821,7 @@ void rpn_engine::StackStrategy<Element>::Asin()
     // Get parameters
     Element x = Pop();
     // do the operation
-    Push(std::asin(x));
+    Push(kernel::Asin(x));
 }
 
 template <class Element>
@@ -1165,7 +1834,7 @@ void rpn_engine::StackStrategy<Element>::Acos()
     // Get parameters
     Element x = Pop();
     // do the operation
-    Push(std::acos(x));
+    Push(kernel::Acos(x));
 }
 
 template <class Element>
@@ -1178,7 +1847,7 @@ void rpn_engine::StackStrategy<Element>::Atan()
     // Get parameters
     Element x = Pop();
     // do the operation
-    Push(std::atan(x));
+    Push(kernel::Atan(x));
 }
 
 template <class Element>
@@ -1374,6 +2043,182 @@ void rpn_engine::StackStrategy<Element>::BitNot()
     Push(ToElementValue(r));
 }
 
+template <class Element>
+void rpn_engine::StackStrategy<Element>::SigmaPlus()
+{
+    // Save stack state before mathematical operation
+    SaveToUndoBuffer();
+    DisableUndoSaving disable_undo(this); // Disabling by RAII
+
+    // Add (x, y) and then show the number of samples.
+    statistics_.Add(ToDouble(stack_[0]), ToDouble(stack_[1]));
+    SetX(static_cast<double>(statistics_.Count()));
+}
+
+template <class Element>
+void rpn_engine::StackStrategy<Element>::SigmaMinus()
+{
+    // Save stack state before mathematical operation
+    SaveToUndoBuffer();
+    DisableUndoSaving disable_undo(this); // Disabling by RAII
+
+    // Remove (x, y) and then show the number of samples.
+    statistics_.Remove(ToDouble(stack_[0]), ToDouble(stack_[1]));
+    SetX(static_cast<double>(statistics_.Count()));
+}
+
+template <class Element>
+void rpn_engine::StackStrategy<Element>::SigmaClear()
+{
+    statistics_.Clear();
+}
+
+template <class Element>
+void rpn_engine::StackStrategy<Element>::Mean()
+{
+    // Save stack state before mathematical operation
+    SaveToUndoBuffer();
+    DisableUndoSaving disable_undo(this); // Disabling by RAII
+
+    // mean of x is on the top.
+    Push(statistics_.MeanY());
+    Push(statistics_.MeanX());
+}
+
+template <class Element>
+void rpn_engine::StackStrategy<Element>::StandardDeviation()
+{
+    // Save stack state before mathematical operation
+    SaveToUndoBuffer();
+    DisableUndoSaving disable_undo(this); // Disabling by RAII
+
+    // standard deviation of x is on the top.
+    Push(statistics_.StandardDeviationY());
+    Push(statistics_.StandardDeviationX());
+}
+
+template <class Element>
+const rpn_engine::Statistics &rpn_engine::StackStrategy<Element>::GetStatistics() const
+{
+    return statistics_;
+}
+
+template <class Element>
+void rpn_engine::StackStrategy<Element>::Accumulate(const double x[], std::size_t count)
+{
+    statistics_.Accumulate(x, count);
+}
+
+template <class Element>
+void rpn_engine::StackStrategy<Element>::Accumulate(const double x[], const double y[], std::size_t count)
+{
+    statistics_.Accumulate(x, y, count);
+}
+
+template <class Element>
+void rpn_engine::StackStrategy<Element>::Polynomial(const Element coefficients[], unsigned int count)
+{
+    assert(count > 0);
+
+    // Save stack state before mathematical operation
+    SaveToUndoBuffer();
+    DisableUndoSaving disable_undo(this); // Disabling by RAII
+
+    // Get parameters
+    Element x = Pop();
+    // do the operation
+    Push(rpn_engine::EvaluatePolynomial(coefficients, count, x));
+}
+
+template <class Element>
+void rpn_engine::StackStrategy<Element>::Polynomial()
+{
+    // Save stack state before mathematical operation
+    SaveToUndoBuffer();
+    DisableUndoSaving disable_undo(this); // Disabling by RAII
+
+    double degree = ToDouble(stack_[0]);
+    if (!(degree >= 0 && degree == std::trunc(degree) && degree + 3 <= stack_size_)) // NaN is also invalid.
+    {
+        Pop();
+        Pop();
+        Push(NotANumber());
+        return;
+    }
+
+    // The coefficients are stack_[2] .. stack_[n+2] in ascending order.
+    unsigned int count = static_cast<unsigned int>(degree) + 1;
+    Element result = rpn_engine::EvaluatePolynomial(stack_ + 2, count, stack_[1]);
+
+    // Remove n, x and the coefficients, then put the result on the top.
+    DetachStorage();
+    unsigned int removed = count + 2;
+    stack_[0] = result;
+    for (unsigned int i = 1; i < stack_size_; i++)
+        // The stack bottom is duplicated.
+        stack_[i] = stack_[i + removed - 1 < stack_size_ ? i + removed - 1 : stack_size_ - 1];
+}
+
+template <class Element>
+void rpn_engine::StackStrategy<Element>::CoefficientStore()
+{
+    // Save stack state before mathematical operation
+    SaveToUndoBuffer();
+    DisableUndoSaving disable_undo(this); // Disabling by RAII
+
+    double index = ToDouble(Pop());
+    if (!(index >= 0 && index == std::trunc(index) && index < kNumberOfCoefficients)) // NaN is also invalid.
+    {
+        SetX(NotANumber());
+        return;
+    }
+    coefficients_[static_cast<unsigned int>(index)] = stack_[0];
+}
+
+template <class Element>
+void rpn_engine::StackStrategy<Element>::CoefficientPolynomial()
+{
+    // Save stack state before mathematical operation
+    SaveToUndoBuffer();
+    DisableUndoSaving disable_undo(this); // Disabling by RAII
+
+    double degree = ToDouble(Pop());
+    Element x = Pop();
+    if (!(degree >= 0 && degree == std::trunc(degree) && degree < kNumberOfCoefficients)) // NaN is also invalid.
+    {
+        Push(NotANumber());
+        return;
+    }
+    Push(rpn_engine::EvaluatePolynomial(coefficients_, static_cast<unsigned int>(degree) + 1, x));
+}
+
+template <class Element>
+Element rpn_engine::StackStrategy<Element>::GetCoefficient(unsigned int index) const
+{
+    assert(index < kNumberOfCoefficients);
+    return coefficients_[index];
+}
+
+template <class Element>
+void rpn_engine::StackStrategy<Element>::SetCoefficient(unsigned int index, const Element &value)
+{
+    assert(index < kNumberOfCoefficients);
+    coefficients_[index] = value;
+}
+
+template <class Element>
+void rpn_engine::StackStrategy<Element>::ClearCoefficients()
+{
+    for (unsigned int i = 0; i < kNumberOfCoefficients; i++)
+        coefficients_[i] = 0;
+}
+
+template <class Element>
+void rpn_engine::StackStrategy<Element>::SeedRandom(uint64_t seed, uint64_t stream)
+{
+    random_.Seed(seed, stream);
+}
+
 template <class Element>
 void rpn_engine::StackStrategy<Element>::Operation(Op opcode)
 {
@@ -1383,6 +2228,10 @@ void rpn_engine::StackStrategy<Element>::Operation(Op opcode)
     assert(opcode != Op::change_display);
     assert(Op::num_0 > opcode);
 
+    // Classify the operands to detect the special values created by this operation.
+    uint32_t operand_status = ClassifyElement(stack_[0]) | ClassifyElement(stack_[1]);
+    kernel_status_ = 0;
+
     switch (opcode)
     {
     case Op::duplicate:
@@ -1508,10 +2357,54 @@ void rpn_engine::StackStrategy<Element>::Operation(Op opcode)
     case Op::bit_not:
         BitNot();
         break;
+    case Op::sigma_plus:
+        SigmaPlus();
+        break;
+    case Op::sigma_minus:
+        SigmaMinus();
+        break;
+    case Op::sigma_clear:
+        SigmaClear();
+        break;
+    case Op::mean:
+        Mean();
+        break;
+    case Op::standard_deviation:
+        StandardDeviation();
+        break;
+    case Op::random:
+        Random();
+        break;
+    case Op::polynomial:
+        Polynomial();
+        break;
+    case Op::coefficient_store:
+        CoefficientStore();
+        break;
+    case Op::coefficient_polynomial:
+        CoefficientPolynomial();
+        break;
     case Op::undo:
         Undo();
         break;
     default: // in case of wrong op code.
         assert(false);
     }
-}
\ No newline at end of file
+
+    // Stack manipulation doesn't create any value.
+    if (CreatesValue(opcode))
+        UpdateStatus(operand_status);
+    operation_count_++;
+}
+
+#ifndef RPN_ENGINE_HEADER_ONLY
+// The common specializations are explicitly instantiated in stackstrategy.cpp.
+// Suppress the implicit instantiation in each translation unit to save the
+// build time and the duplicated code. Define RPN_ENGINE_HEADER_ONLY to
+// use this file without linking stackstrategy.cpp.
+// The other element types are instantiated implicitly in any case.
+extern template class rpn_engine::StackStrategy<int>;
+extern template class rpn_engine::StackStrategy<float>;
+extern template class rpn_engine::StackStrategy<double>;
+extern template class rpn_engine::StackStrategy<std::complex<double>>;
+#endif
@@ -0,0 +1,441 @@
+#pragma once
+/**
+ * @file statistics.hpp
+ * @author Seiichi "Suikan" Horie
+ * @brief Statistics accumulator for the stack machine.
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+
+namespace rpn_engine
+{
+    /**
+     * @brief Compensated summation.
+     * @details
+     * Kahan-Babuska ( Neumaier ) summation. The rounding error of each addition is
+     * accumulated separately and added at the end.
+     *
+     * Do not compile with -ffast-math or similar options. They remove the compensation.
+     */
+    class KahanSum
+    {
+    public:
+        KahanSum() : sum_(0.0), compensation_(0.0) {}
+
+        /**
+         * @brief Add a value
+         *
+         * @param value Value to add.
+         */
+        void Add(double value)
+        {
+            double t = sum_ + value;
+            if (std::fabs(sum_) >= std::fabs(value))
+                compensation_ += (sum_ - t) + value; // lower bits of value are lost
+            else
+                compensation_ += (value - t) + sum_; // lower bits of sum_ are lost
+            sum_ = t;
+        }
+
+        /**
+         * @brief Add a compensated sum
+         *
+         * @param other Sum to add.
+         */
+        void Add(const KahanSum &other)
+        {
+            Add(other.sum_);
+            compensation_ += other.compensation_;
+        }
+
+        /**
+         * @brief Get the compensated sum.
+         */
+        double Get() const { return sum_ + compensation_; }
+
+    private:
+        double sum_;
+        double compensation_;
+    };
+
+    /**
+     * @brief Statistics accumulator of the (x, y) samples.
+     * @details
+     * The mean, variance and co-variance are updated by the Welford's algorithm.
+     * The sums of the x, y, x^2, y^2 and xy are accumulated by compensated summation.
+     * These are the classic statistics registers of the calculators.
+     *
+     * The samples can be removed by Remove(). It is the reverse operation of the Add().
+     *
+     * The Accumulate() ingests an array of the samples by blocks. Each block is
+     * summarized by the multiple accumulation lanes, and then merged to the accumulator
+     * by Merge(). The lanes don't depend on each other. So, the compiler can vectorize
+     * the loop.
+     */
+    class Statistics
+    {
+    public:
+        Statistics() { Clear(); }
+
+        /**
+         * @brief Clear all samples.
+         */
+        void Clear();
+
+        /**
+         * @brief Add a sample.
+         *
+         * @param x Sample value of x.
+         * @param y Sample value of y.
+         */
+        void Add(double x, double y = 0.0);
+
+        /**
+         * @brief Remove a sample which was added before.
+         *
+         * @param x Sample value of x.
+         * @param y Sample value of y.
+         * @details
+         * If there is no sample, nothing happens.
+         */
+        void Remove(double x, double y = 0.0);
+
+        /**
+         * @brief Add the array of x samples.
+         *
+         * @param x Array of the samples.
+         * @param count Number of the samples.
+         * @details
+         * y is regarded as 0 for all samples.
+         */
+        void Accumulate(const double x[], std::size_t count);
+
+        /**
+         * @brief Add the arrays of x and y samples.
+         *
+         * @param x Array of the x samples.
+         * @param y Array of the y samples.
+         * @param count Number of the samples.
+         */
+        void Accumulate(const double x[], const double y[], std::size_t count);
+
+        /**
+         * @brief Merge the samples of other accumulator.
+         *
+         * @param other Accumulator to merge.
+         * @details
+         * The result is same as adding all samples of other to this accumulator.
+         */
+        void Merge(const Statistics &other);
+
+        /**
+         * @brief Number of the samples.
+         */
+        int64_t Count() const { return count_; }
+
+        /**
+         * @brief Mean of x. NaN if there is no sample.
+         */
+        double MeanX() const { return count_ > 0 ? mean_x_ : std::numeric_limits<double>::quiet_NaN(); }
+
+        /**
+         * @brief Mean of y. NaN if there is no sample.
+         */
+        double MeanY() const { return count_ > 0 ? mean_y_ : std::numeric_limits<double>::quiet_NaN(); }
+
+        /**
+         * @brief Sample variance of x. NaN if there is less than 2 samples.
+         */
+        double VarianceX() const { return count_ > 1 ? m2_x_ / (count_ - 1) : std::numeric_limits<double>::quiet_NaN(); }
+
+        /**
+         * @brief Sample variance of y. NaN if there is less than 2 samples.
+         */
+        double VarianceY() const { return count_ > 1 ? m2_y_ / (count_ - 1) : std::numeric_limits<double>::quiet_NaN(); }
+
+        /**
+         * @brief Sample standard deviation of x. NaN if there is less than 2 samples.
+         */
+        double StandardDeviationX() const { return std::sqrt(VarianceX()); }
+
+        /**
+         * @brief Sample standard deviation of y. NaN if there is less than 2 samples.
+         */
+        double StandardDeviationY() const { return std::sqrt(VarianceY()); }
+
+        /**
+         * @brief Slope of the linear regression y = a x + b.
+         */
+        double Slope() const { return count_ > 1 ? c_xy_ / m2_x_ : std::numeric_limits<double>::quiet_NaN(); }
+
+        /**
+         * @brief Intercept of the linear regression y = a x + b.
+         */
+        double Intercept() const { return MeanY() - Slope() * MeanX(); }
+
+        /**
+         * @brief Correlation coefficient of x and y.
+         */
+        double Correlation() const { return count_ > 1 ? c_xy_ / std::sqrt(m2_x_ * m2_y_) : std::numeric_limits<double>::quiet_NaN(); }
+
+        /**
+         * @brief Sum of x.
+         */
+        double SumX() const { return sum_x_.Get(); }
+
+        /**
+         * @brief Sum of y.
+         */
+        double SumY() const { return sum_y_.Get(); }
+
+        /**
+         * @brief Sum of x^2.
+         */
+        double SumX2() const { return sum_x2_.Get(); }
+
+        /**
+         * @brief Sum of y^2.
+         */
+        double SumY2() const { return sum_y2_.Get(); }
+
+        /**
+         * @brief Sum of x*y.
+         */
+        double SumXY() const { return sum_xy_.Get(); }
+
+    private:
+        int64_t count_;
+        // Welford's accumulator
+        double mean_x_;
+        double mean_y_;
+        double m2_x_; // sum of (x - mean_x)^2
+        double m2_y_; // sum of (y - mean_y)^2
+        double c_xy_; // sum of (x - mean_x)(y - mean_y)
+        // Statistic registers
+        KahanSum sum_x_;
+        KahanSum sum_y_;
+        KahanSum sum_x2_;
+        KahanSum sum_y2_;
+        KahanSum sum_xy_;
+
+        /**
+         * @brief Summarize a block of samples and merge it.
+         *
+         * @param x Array of the x samples.
+         * @param y Array of the y samples. nullptr means all zero.
+         * @param count Number of the samples. Must not exceed kBlockSize.
+         */
+        void AccumulateBlock(const double x[], const double y[], std::size_t count);
+
+        /**
+         * @brief Number of the samples in a block of Accumulate().
+         */
+        static const std::size_t kBlockSize = 256;
+
+        /**
+         * @brief Number of independent accumulation lanes in a block.
+         */
+        static const std::size_t kLanes = 4;
+    };
+}
+
+// The definitions are inline to keep the header only mode of the StackStrategy.
+
+inline void rpn_engine::Statistics::Clear()
+{
+    count_ = 0;
+    mean_x_ = 0.0;
+    mean_y_ = 0.0;
+    m2_x_ = 0.0;
+    m2_y_ = 0.0;
+    c_xy_ = 0.0;
+    sum_x_ = KahanSum();
+    sum_y_ = KahanSum();
+    sum_x2_ = KahanSum();
+    sum_y2_ = KahanSum();
+    sum_xy_ = KahanSum();
+}
+
+inline void rpn_engine::Statistics::Add(double x, double y)
+{
+    count_++;
+    double dx = x - mean_x_;
+    double dy = y - mean_y_;
+    mean_x_ += dx / count_;
+    mean_y_ += dy / count_;
+    m2_x_ += dx * (x - mean_x_);
+    m2_y_ += dy * (y - mean_y_);
+    c_xy_ += dx * (y - mean_y_);
+
+    sum_x_.Add(x);
+    sum_y_.Add(y);
+    sum_x2_.Add(x * x);
+    sum_y2_.Add(y * y);
+    sum_xy_.Add(x * y);
+}
+
+inline void rpn_engine::Statistics::Remove(double x, double y)
+{
+    if (count_ == 0)
+        return;
+    if (count_ == 1) // removing last sample.
+    {
+        Clear();
+        return;
+    }
+
+    // Reverse of the Add()
+    count_--;
+    double mean_x_with = mean_x_;
+    double mean_y_with = mean_y_;
+    mean_x_ -= (x - mean_x_) / count_;
+    mean_y_ -= (y - mean_y_) / count_;
+    m2_x_ -= (x - mean_x_) * (x - mean_x_with);
+    m2_y_ -= (y - mean_y_) * (y - mean_y_with);
+    c_xy_ -= (x - mean_x_) * (y - mean_y_with);
+
+    sum_x_.Add(-x);
+    sum_y_.Add(-y);
+    sum_x2_.Add(-x * x);
+    sum_y2_.Add(-y * y);
+    sum_xy_.Add(-x * y);
+}
+
+inline void rpn_engine::Statistics::Merge(const Statistics &other)
+{
+    if (other.count_ == 0)
+        return;
+    if (count_ == 0)
+    {
+        *this = other;
+        return;
+    }
+
+    // Chan's parallel algorithm.
+    double n_a = static_cast<double>(count_);
+    double n_b = static_cast<double>(other.count_);
+    double n = n_a + n_b;
+    double dx = other.mean_x_ - mean_x_;
+    double dy = other.mean_y_ - mean_y_;
+
+    mean_x_ += dx * n_b / n;
+    mean_y_ += dy * n_b / n;
+    m2_x_ += other.m2_x_ + dx * dx * n_a * n_b / n;
+    m2_y_ += other.m2_y_ + dy * dy * n_a * n_b / n;
+    c_xy_ += other.c_xy_ + dx * dy * n_a * n_b / n;
+    count_ += other.count_;
+
+    sum_x_.Add(other.sum_x_);
+    sum_y_.Add(other.sum_y_);
+    sum_x2_.Add(other.sum_x2_);
+    sum_y2_.Add(other.sum_y2_);
+    sum_xy_.Add(other.sum_xy_);
+}
+
+inline void rpn_engine::Statistics::Accumulate(const double x[], std::size_t count)
+{
+    for (std::size_t i = 0; i < count; i += kBlockSize)
+    {
+        std::size_t n = count - i;
+        if (n > kBlockSize)
+            n = kBlockSize;
+        AccumulateBlock(&x[i], nullptr, n);
+    }
+}
+
+inline void rpn_engine::Statistics::Accumulate(const double x[], const double y[], std::size_t count)
+{
+    for (std::size_t i = 0; i < count; i += kBlockSize)
+    {
+        std::size_t n = count - i;
+        if (n > kBlockSize)
+            n = kBlockSize;
+        AccumulateBlock(&x[i], &y[i], n);
+    }
+}
+
+inline void rpn_engine::Statistics::AccumulateBlock(const double x[], const double y[], std::size_t count)
+{
+    // Lane accumulators. The lane j handles the samples i where i % kLanes == j.
+    double s_x[kLanes] = {}, c_x[kLanes] = {};
+    double s_y[kLanes] = {}, c_y[kLanes] = {};
+    std::size_t body = count - count % kLanes;
+
+    // First pass : Compensated sum of x and y to get the block mean.
+    for (std::size_t i = 0; i < body; i += kLanes)
+        for (std::size_t j = 0; j < kLanes; j++)
+        {
+            // Kahan summation. Each lane is independent.
+            double v = x[i + j] - c_x[j];
+            double t = s_x[j] + v;
+            c_x[j] = (t - s_x[j]) - v;
+            s_x[j] = t;
+        }
+    if (y != nullptr)
+        for (std::size_t i = 0; i < body; i += kLanes)
+            for (std::size_t j = 0; j < kLanes; j++)
+            {
+                double v = y[i + j] - c_y[j];
+                double t = s_y[j] + v;
+                c_y[j] = (t - s_y[j]) - v;
+                s_y[j] = t;
+            }
+
+    Statistics block;
+    for (std::size_t j = 0; j < kLanes; j++)
+    {
+        block.sum_x_.Add(s_x[j]);
+        block.sum_x_.Add(-c_x[j]);
+        block.sum_y_.Add(s_y[j]);
+        block.sum_y_.Add(-c_y[j]);
+    }
+    for (std::size_t i = body; i < count; i++) // remainder
+    {
+        block.sum_x_.Add(x[i]);
+        block.sum_y_.Add(y != nullptr ? y[i] : 0.0);
+    }
+    block.count_ = count;
+    block.mean_x_ = block.sum_x_.Get() / count;
+    block.mean_y_ = block.sum_y_.Get() / count;
+
+    // Second pass : Moments around the block mean and the sums of products.
+    // The block is still in the cache.
+    double m2_x[kLanes] = {}, m2_y[kLanes] = {}, c_xy[kLanes] = {};
+    double x2[kLanes] = {}, y2[kLanes] = {}, xy[kLanes] = {};
+    for (std::size_t i = 0; i < count; i += kLanes)
+    {
+        // The last iteration handles the remainder by the lower lanes.
+        std::size_t lanes = (count - i) < kLanes ? (count - i) : static_cast<std::size_t>(kLanes);
+        for (std::size_t j = 0; j < lanes; j++)
+        {
+            double vx = x[i + j];
+            double vy = (y != nullptr) ? y[i + j] : 0.0;
+            double dx = vx - block.mean_x_;
+            double dy = vy - block.mean_y_;
+            m2_x[j] += dx * dx;
+            m2_y[j] += dy * dy;
+            c_xy[j] += dx * dy;
+            x2[j] += vx * vx;
+            y2[j] += vy * vy;
+            xy[j] += vx * vy;
+        }
+    }
+    for (std::size_t j = 0; j < kLanes; j++)
+    {
+        block.m2_x_ += m2_x[j];
+        block.m2_y_ += m2_y[j];
+        block.c_xy_ += c_xy[j];
+        block.sum_x2_.Add(x2[j]);
+        block.sum_y2_.Add(y2[j]);
+        block.sum_xy_.Add(xy[j]);
+    }
+
+    Merge(block);
+}
@@ -0,0 +1,128 @@
+#include "tablegenerator.hpp"
+#include <algorithm>
+#include <cassert>
+
+// Definition of the static const member used as a reference.
+const std::size_t rpn_engine::TableGenerator::kChunkSize;
+
+rpn_engine::TableGenerator::TableGenerator(WorkStealingPool &pool, unsigned int stack_size) : pool_(pool),
+                                                                                              is_display_enabled_(false),
+                                                                                              display_mode_(DisplayMode::fixed),
+                                                                                              is_hex_mode_(false)
+{
+    for (unsigned int i = 0; i < pool_.GetThreadCount(); i++)
+        workers_.emplace_back(new Worker(stack_size));
+}
+
+bool rpn_engine::TableGenerator::Load(const Op program[], std::size_t length)
+{
+    bool is_loaded = true;
+    for (auto &worker : workers_)
+        is_loaded = worker->function.Load(program, length) && is_loaded;
+    return is_loaded;
+}
+
+void rpn_engine::TableGenerator::SetRegister(unsigned int index, double value)
+{
+    for (auto &worker : workers_)
+        worker->function.SetRegister(index, value);
+}
+
+void rpn_engine::TableGenerator::SetDisplay(bool is_enabled, DisplayMode mode, bool is_hex_mode)
+{
+    is_display_enabled_ = is_enabled;
+    display_mode_ = mode;
+    is_hex_mode_ = is_hex_mode;
+}
+
+void rpn_engine::TableGenerator::Generate(double start, double stop, std::size_t count, const Sink &sink)
+{
+    // The last x is exactly stop. A single row is start.
+    Generate([=](std::size_t i)
+             { return count == 1 ? start : i + 1 == count ? stop : start + (stop - start) * i / (count - 1); },
+             count, sink);
+}
+
+void rpn_engine::TableGenerator::Generate(const double x[], std::size_t count, const Sink &sink)
+{
+    Generate([x](std::size_t i)
+             { return x[i]; },
+             count, sink);
+}
+
+void rpn_engine::TableGenerator::Evaluate(Worker &worker, const std::function<double(std::size_t)> &x_of, std::size_t first, Row rows[], std::size_t count)
+{
+    worker.x.resize(count);
+    worker.y.resize(count);
+    for (std::size_t i = 0; i < count; i++)
+        worker.x[i] = x_of(first + i);
+    worker.function.Evaluate(worker.x.data(), worker.y.data(), count);
+
+    for (std::size_t i = 0; i < count; i++)
+    {
+        rows[i].x = worker.x[i];
+        rows[i].y = worker.y[i];
+        if (is_display_enabled_)
+            Console::RenderText(worker.y[i], display_mode_, is_hex_mode_, rows[i].text, rows[i].decimal_point_position);
+        else
+        {
+            rows[i].text[0] = '\0';
+            rows[i].decimal_point_position = Console::kDecimalPointNotDisplayed;
+        }
+    }
+}
+
+void rpn_engine::TableGenerator::Generate(const std::function<double(std::size_t)> &x_of, std::size_t count, const Sink &sink)
+{
+    // Enough chunks in a wave to keep all workers busy.
+    const std::size_t wave_rows = kChunkSize * pool_.GetThreadCount() * 4;
+    std::vector<Row> waves[2] = {std::vector<Row>(std::min(wave_rows, count)), std::vector<Row>(std::min(wave_rows, count))};
+
+    // Rows of the previous wave to give to the sink.
+    std::size_t previous_count = 0;
+    for (std::size_t first = 0, wave = 0; first < count; first += wave_rows, wave++)
+    {
+        std::vector<Row> &rows = waves[wave % 2];
+        const std::vector<Row> &previous = waves[(wave + 1) % 2];
+        const std::size_t wave_count = std::min(wave_rows, count - first);
+
+        pool_.Run([&](unsigned int worker)
+                  {
+                      for (std::size_t start = 0; start < wave_count; start += kChunkSize)
+                          pool_.Spawn(worker, [&, start](unsigned int w)
+                                      { Evaluate(*workers_[w], x_of, first + start, &rows[start], std::min(kChunkSize, wave_count - start)); });
+
+                      // The previous wave is written while the workers evaluate this wave.
+                      for (std::size_t start = 0; start < previous_count; start += kChunkSize)
+                          sink(&previous[start], std::min(kChunkSize, previous_count - start)); });
+        previous_count = wave_count;
+
+        // The last wave.
+        if (first + wave_count >= count)
+            for (std::size_t start = 0; start < wave_count; start += kChunkSize)
+                sink(&rows[start], std::min(kChunkSize, wave_count - start));
+    }
+}
+
+rpn_engine::TableGenerator::Sink rpn_engine::TableGenerator::MakeFileSink(std::FILE *file)
+{
+    return [file](const Row rows[], std::size_t count)
+    {
+        for (std::size_t i = 0; i < count; i++)
+        {
+            std::fprintf(file, "%.17g,%.17g", rows[i].x, rows[i].y);
+            if (rows[i].text[0] != '\0')
+            {
+                // Insert the decimal point. The position is counted from the right most digit.
+                std::fputc(',', file);
+                for (int j = 0; j < kNumberOfDigits; j++)
+                {
+                    std::fputc(rows[i].text[j], file);
+                    if (kNumberOfDigits - 1 - j == rows[i].decimal_point_position)
+                        std::fputc('.', file);
+                }
+            }
+            std::fputc('\n', file);
+        }
+    };
+}
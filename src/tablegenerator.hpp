@@ -0,0 +1,159 @@
+#pragma once
+/**
+ * @file tablegenerator.hpp
+ * @author Seiichi "Suikan" Horie
+ * @brief Function table of the program.
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#include "batchfunction.hpp"
+#include "console.hpp"
+#include "workstealingpool.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <functional>
+#include <memory>
+#include <vector>
+
+namespace rpn_engine
+{
+    /**
+     * @brief Tabulate f(x) of a program over many x.
+     * @details
+     * The function is the program evaluated by the BatchFunction. x is pushed to the
+     * stack filled by zero and X after the program is f(x). The registers are the
+     * parameters.
+     *
+     * The x are divided into the chunks of kChunkSize. The chunks are evaluated in
+     * parallel on the WorkStealingPool. Each chunk is one batch of the BatchFunction.
+     *
+     * The rows are given to the sink in the order of x, one chunk at a time. The chunks
+     * are processed in the waves of a fixed number of chunks. While a wave is evaluated,
+     * the previous wave is given to the sink on the calling thread. So, the memory is
+     * bounded by two waves regardless of the number of the rows.
+     *
+     * Optionally, each row has the text which the Console displays for f(x).
+     */
+    class TableGenerator
+    {
+    public:
+        /**
+         * @brief Number of the rows in a chunk.
+         */
+        static const std::size_t kChunkSize = 4096;
+
+        /**
+         * @brief A row of the table.
+         */
+        struct Row
+        {
+            double x;
+            double y;                       ///< f(x)
+            int32_t decimal_point_position; ///< Position of the decimal point of the text. See Console::GetDecimalPointPosition().
+            char text[kNumberOfDigits + 1]; ///< Display text of y. Empty if the display is not enabled.
+        };
+
+        /**
+         * @brief Receiver of the rows.
+         * @details
+         * The parameters are the rows and the number of the rows. Called on the thread calling Generate().
+         */
+        typedef std::function<void(const Row[], std::size_t)> Sink;
+
+        /**
+         * @brief Construct a new table generator.
+         *
+         * @param pool Thread pool to evaluate the chunks.
+         * @param stack_size Depth of the stack.
+         */
+        TableGenerator(WorkStealingPool &pool, unsigned int stack_size = 4);
+
+        /**
+         * @brief Load the function.
+         *
+         * @param program Array of the opcode.
+         * @param length Number of the opcode in the program.
+         * @return true Loaded.
+         * @return false The program has error. See VirtualMachine::Load().
+         */
+        bool Load(const Op program[], std::size_t length);
+
+        /**
+         * @brief Set a parameter of the function.
+         *
+         * @param index Register number. 0 .. kNumberOfVmRegisters-1.
+         * @param value Value of the register.
+         */
+        void SetRegister(unsigned int index, double value);
+
+        /**
+         * @brief Enable the display text of the rows.
+         *
+         * @param is_enabled Render the text if true.
+         * @param mode Display format.
+         * @param is_hex_mode Render in the hex mode.
+         */
+        void SetDisplay(bool is_enabled, DisplayMode mode = DisplayMode::fixed, bool is_hex_mode = false);
+
+        /**
+         * @brief Tabulate over a range.
+         *
+         * @param start The first x.
+         * @param stop The last x.
+         * @param count Number of the rows. x are evenly spaced from start to stop.
+         * @param sink Receiver of the rows.
+         */
+        void Generate(double start, double stop, std::size_t count, const Sink &sink);
+
+        /**
+         * @brief Tabulate over a list.
+         *
+         * @param x Array of x.
+         * @param count Number of x.
+         * @param sink Receiver of the rows.
+         */
+        void Generate(const double x[], std::size_t count, const Sink &sink);
+
+        /**
+         * @brief Make a sink writing the rows to a file as CSV.
+         *
+         * @param file Output file. Must be valid while the sink is used.
+         * @return The sink.
+         * @details
+         * Each line is "x,y" in 17 digits. If the display is enabled, the text with the
+         * decimal point is appended as the third column.
+         */
+        static Sink MakeFileSink(std::FILE *file);
+
+    private:
+        // Working area of a worker.
+        struct Worker
+        {
+            BatchFunction function;
+            std::vector<double> x;
+            std::vector<double> y;
+            Worker(unsigned int stack_size) : function(stack_size) {}
+        };
+
+        WorkStealingPool &pool_;
+        std::vector<std::unique_ptr<Worker>> workers_;
+        bool is_display_enabled_;
+        DisplayMode display_mode_;
+        bool is_hex_mode_;
+
+        /**
+         * @brief Tabulate x given by a function of the row index.
+         */
+        void Generate(const std::function<double(std::size_t)> &x_of, std::size_t count, const Sink &sink);
+
+        /**
+         * @brief Evaluate a chunk.
+         */
+        void Evaluate(Worker &worker, const std::function<double(std::size_t)> &x_of, std::size_t first, Row rows[], std::size_t count);
+    };
+}
@@ -0,0 +1,17 @@
+/**
+ * @file virtualmachine.cpp
+ * @author Seiichi "Suikan" Horie
+ * @brief Explicit instantiation of the VirtualMachine class template.
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2026
+ *
+ * @details
+ * The virtualmachine.hpp declares these specializations as extern template.
+ * Thus, the member functions of these specializations are compiled only here.
+ */
+#include "virtualmachine.hpp"
+
+template class rpn_engine::VirtualMachine<double>;
+template class rpn_engine::VirtualMachine<std::complex<double>>;
@@ -0,0 +1,799 @@
+#pragma once
+/**
+ * @file virtualmachine.hpp
+ * @author Seiichi "Suikan" Horie
+ * @brief Programmable virtual machine on the stack machine.
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#include "stackstrategy.hpp"
+#include "opcode.hpp"
+#include "programmemory.hpp"
+#include <cassert>
+#include <cstdint>
+#include <vector>
+#ifdef RPN_ENGINE_PROFILE
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <map>
+#include <string>
+#endif
+
+namespace rpn_engine
+{
+    /**
+     * @brief Number of the labels and registers of the VirtualMachine.
+     * @details
+     * The label and register are specified by the following digit opcode ( num_0 .. num_f ).
+     */
+    const unsigned int kNumberOfVmRegisters = 16;
+
+    /**
+     * @brief Max nesting level of the subroutine call of the VirtualMachine.
+     */
+    const unsigned int kVmReturnStackDepth = 16;
+
+    /**
+     * @brief Keystroke programmable machine on the StackStrategy.
+     *
+     * @tparam Element Element type of the StackStrategy.
+     * @details
+     * The program is a sequence of Op as the keys of the Console. It is decoded once by Load().
+     * The decoding removes the labels, resolves the jump targets and converts the digit
+     * entry keys to a literal value. Then, Run() executes the decoded program by a simple
+     * dispatch loop.
+     *
+     * The key sequences are interpreted as same as Console :
+     * @li Number : The sequence of num_0 .. num_9, period, eex and chs is a number.
+     *  del removes the last key of the number.
+     * @li enter, clx, sigma_plus and sigma_minus make the stack non-pushable. The next number overwrites X.
+     * @li chs out of the number is neg. del out of the number is clx.
+     * @li change_display, hex, dec, func and nop are ignored. The number is always decimal.
+     * @li The other calculation opcodes are passed to the StackStrategy::Operation().
+     *
+     * The program opcodes are :
+     * @li label n : Mark the position n. n is a digit opcode.
+     * @li go_to n : Jump to the label n.
+     * @li go_sub n : Call the subroutine at label n.
+     * @li ret : Return from the subroutine. At the top level, stop the program.
+     * @li x_eq_y, x_ne_y, x_lt_y, x_le_y : Compare X and Y. If false, skip the next step.
+     *  Less than is compared by the real part.
+     * @li sto n : Store X to the register n.
+     * @li rcl n : Push the register n.
+     *
+     * Run() executes until the end of the program or the given budget of the steps.
+     * The machine keeps the program counter. So, the next Run() continues the program.
+     * The UI loop can run a long program in the slices this way, and cancel it by Reset().
+     * The stack is saved to the undo buffer only at the beginning of Run(). Thus, the
+     * StackStrategy::Undo() after Run() retrieves the stack before Run(). Op::undo in
+     * the program does the same.
+     *
+     * If RPN_ENGINE_PROFILE is defined, Run() counts the execution and accumulates the time
+     * of each step. The time of a step is from its start to the start of the next step by
+     * std::chrono::steady_clock. So, it includes the dispatch and the cost of the clock.
+     * Without the macro, the profile functions and the counters don't exist.
+     */
+    template <class Element>
+    class VirtualMachine
+    {
+    public:
+        /**
+         * @brief Reason why Run() stopped.
+         */
+        enum class Result
+        {
+            completed,            ///< End of the program, or ret at the top level.
+            budget_exhausted,     ///< Executed the given number of the steps. Can continue by Run().
+            return_stack_overflow ///< Too deep subroutine call. The machine is reset.
+        };
+
+        /**
+         * @brief Construct a new virtual machine
+         *
+         * @param engine Stack machine to run the program. Must be valid while this object is used.
+         */
+        VirtualMachine(StackStrategy<Element> &engine);
+
+        /**
+         * @brief Decode the program
+         *
+         * @param program Array of the opcode.
+         * @param length Number of the opcode in the program.
+         * @return true The program is loaded.
+         * @return false The program has error. Missing operand, undefined label, duplicated label
+         * or hex digit in the number. The machine has empty program.
+         * @details
+         * The machine is reset after loading.
+         */
+        bool Load(const Op program[], std::size_t length);
+
+        /**
+         * @brief Decode the program in the program memory.
+         *
+         * @param program The program memory.
+         * @return true The program is loaded.
+         * @return false The program has error.
+         */
+        bool Load(const ProgramMemory &program);
+
+        /**
+         * @brief Move the program counter to the top of the program.
+         * @details
+         * The return stack is cleared and the stack becomes pushable.
+         * The registers and the stack are not changed.
+         */
+        void Reset();
+
+        /**
+         * @brief Run the program
+         *
+         * @param budget Max number of the steps to execute.
+         * @return Reason of the stop.
+         */
+        Result Run(unsigned long budget);
+
+        /**
+         * @brief Number of the steps executed by the last Run().
+         */
+        unsigned long GetExecutedCount() const;
+
+        /**
+         * @brief Number of the steps of the decoded program.
+         * @details
+         * A number is one step.
+         */
+        std::size_t GetProgramSize() const;
+
+        /**
+         * @brief Get the register value.
+         *
+         * @param index Register number. 0 .. kNumberOfVmRegisters-1.
+         */
+        const Element &GetRegister(unsigned int index) const;
+
+        /**
+         * @brief Set the register value.
+         *
+         * @param index Register number. 0 .. kNumberOfVmRegisters-1.
+         * @param value Value to set.
+         */
+        void SetRegister(unsigned int index, const Element &value);
+
+#ifdef RPN_ENGINE_PROFILE
+        /**
+         * @brief Execution record of a step.
+         */
+        struct ProfileCounter
+        {
+            unsigned long count;                      ///< Number of the execution.
+            std::chrono::steady_clock::duration time; ///< Accumulated time.
+        };
+
+        /**
+         * @brief Get the execution record of the steps.
+         * @details
+         * The index is the step of the decoded program. Accumulated over Run() until
+         * ClearProfile() or Load().
+         */
+        const std::vector<ProfileCounter> &GetProfile() const;
+
+        /**
+         * @brief Clear the execution record.
+         */
+        void ClearProfile();
+
+        /**
+         * @brief Get the range of the loaded program decoded to a step.
+         *
+         * @param step Index of the step.
+         * @param begin Position of the first opcode of the step in the program given to Load().
+         * @param end Position next to the last opcode of the step.
+         */
+        void GetStepRange(std::size_t step, std::size_t &begin, std::size_t &end) const;
+
+        /**
+         * @brief Write the flat profile by the opcode.
+         *
+         * @param file Output file.
+         * @details
+         * The record of the steps is summed by the opcode. The number is shown as "number".
+         * The lines are sorted by the time.
+         */
+        void WriteFlatProfile(std::FILE *file) const;
+
+        /**
+         * @brief Write the program with the execution record of each step.
+         *
+         * @param file Output file.
+         * @param program The program given to Load().
+         * @param length Number of the opcode in the program.
+         * @details
+         * The opcodes which don't generate a step, like label, are shown without the record.
+         */
+        void WriteAnnotatedListing(std::FILE *file, const Op program[], std::size_t length) const;
+#endif
+
+    private:
+        // Kind of the decoded step.
+        enum class Kind : uint8_t
+        {
+            operation,              // Pass opcode to the engine.
+            replacing_operation,    // Pop if non-pushable, then pass opcode to the engine.
+            nonpushable_operation,  // Pass opcode to the engine, then make it non-pushable.
+            literal,                // Push or overwrite X by the literals_[operand].
+            enter,                  // Duplicate X and make it non-pushable.
+            clx,                    // Clear X and make it non-pushable.
+            store,                  // Store X to the register.
+            recall,                 // Push the register.
+            go_to,                  // Jump to operand.
+            go_sub,                 // Call operand.
+            ret,                    // Return.
+            test,                   // Skip next step if the condition is false.
+        };
+
+        // Decoded step.
+        struct Instruction
+        {
+            Kind kind;
+            Op opcode;
+            uint32_t operand; // Register number, literal index or jump target.
+        };
+
+        static const uint32_t kUndefinedLabel = UINT32_MAX;
+
+        StackStrategy<Element> &engine_;
+        std::vector<Instruction> code_;
+        std::vector<Element> literals_;
+        Element registers_[kNumberOfVmRegisters];
+        uint32_t return_stack_[kVmReturnStackDepth];
+        unsigned int return_stack_pointer_;
+        uint32_t program_counter_;
+        bool is_pushable_;
+        unsigned long executed_count_;
+#ifdef RPN_ENGINE_PROFILE
+        std::vector<ProfileCounter> profile_;                  // Record of each step.
+        std::vector<std::size_t> step_begin_;                  // Position of the first opcode of each step.
+        std::vector<std::size_t> step_end_;                    // Position next to the last opcode of each step.
+        uint32_t profiled_step_;                               // Step being timed, or kNoStep.
+        std::chrono::steady_clock::time_point profile_start_; // Start of the profiled_step_.
+        static const uint32_t kNoStep = UINT32_MAX;
+
+        /**
+         * @brief Close the timing of the previous step and start the step.
+         */
+        void ProfileStep(uint32_t step);
+
+        /**
+         * @brief Close the timing of the last step of Run().
+         */
+        void ProfileEnd();
+
+        /**
+         * @brief Name of the step in the flat profile.
+         */
+        const char *GetStepName(std::size_t step) const;
+#endif
+
+        /**
+         * @brief Compare X and Y.
+         */
+        bool Test(Op opcode);
+
+        template <class E = Element,
+                  typename std::enable_if<!std::is_scalar<E>::value, int>::type = 0>
+        // Implementation when the template is specialized by std::complex<> type.
+        static double RealPart(const Element &x)
+        {
+            return x.real();
+        }
+
+        template <class E = Element,
+                  typename std::enable_if<std::is_scalar<E>::value, int>::type = 0>
+        // Implementation when the template is specialized by scarlar type.
+        static double RealPart(const Element &x)
+        {
+            return static_cast<double>(x);
+        }
+    };
+}
+
+template <class Element>
+rpn_engine::VirtualMachine<Element>::VirtualMachine(StackStrategy<Element> &engine) : engine_(engine),
+                                                                                     return_stack_pointer_(0),
+                                                                                     program_counter_(0),
+                                                                                     is_pushable_(true),
+                                                                                     executed_count_(0)
+{
+#ifdef RPN_ENGINE_PROFILE
+    profiled_step_ = kNoStep;
+#endif
+    for (unsigned int i = 0; i < kNumberOfVmRegisters; i++)
+        registers_[i] = 0;
+}
+
+template <class Element>
+bool rpn_engine::VirtualMachine<Element>::Load(const Op program[], std::size_t length)
+{
+    uint32_t label_address[kNumberOfVmRegisters];
+    for (unsigned int i = 0; i < kNumberOfVmRegisters; i++)
+        label_address[i] = kUndefinedLabel;
+
+    code_.clear();
+    literals_.clear();
+    Reset();
+#ifdef RPN_ENGINE_PROFILE
+    step_begin_.clear();
+    step_end_.clear();
+#endif
+
+    // First pass : decode and record the label address. The jump operand is the label number.
+    std::vector<Op> keys;
+    bool is_valid = true;
+    for (std::size_t i = 0; i < length && is_valid; i++)
+    {
+#ifdef RPN_ENGINE_PROFILE
+        const std::size_t begin = i;
+#endif
+        Op opcode = program[i];
+        Instruction instruction = {Kind::operation, opcode, 0};
+
+        // Start of number. Collect the keys until the end of the number.
+        if ((opcode >= Op::num_0 && Op::num_9 >= opcode) || opcode == Op::period || opcode == Op::eex)
+        {
+            keys.clear();
+            std::size_t next = i;
+            for (; next < length; next++)
+            {
+                Op key = program[next];
+                if ((key >= Op::num_0 && Op::num_9 >= key) || key == Op::period || key == Op::eex || key == Op::chs)
+                    keys.push_back(key);
+                else if (key == Op::del)
+                {
+                    keys.pop_back();
+                    if (keys.empty()) // Deleted all. Same as clx.
+                    {
+                        next++;
+                        break;
+                    }
+                }
+                else
+                {
+                    if (DigitOf(key) >= 0) // hex digit is not allowed.
+                        is_valid = false;
+                    break;
+                }
+            }
+#ifdef RPN_ENGINE_PROFILE
+            step_begin_.push_back(begin);
+            step_end_.push_back(next);
+#endif
+            i = next - 1; // Process the key after the number in the next iteration.
+
+            if (keys.empty())
+                instruction.kind = Kind::clx;
+            else
+            {
+                instruction.kind = Kind::literal;
+                instruction.operand = static_cast<uint32_t>(literals_.size());
+                literals_.push_back(ParseNumber(keys.data(), keys.size()));
+            }
+            code_.push_back(instruction);
+            continue;
+        }
+
+        switch (opcode)
+        {
+        case Op::label:
+        case Op::go_to:
+        case Op::go_sub:
+        case Op::sto:
+        case Op::rcl:
+        {
+            // These opcode need a digit operand.
+            int operand = (i + 1 < length) ? DigitOf(program[i + 1]) : -1;
+            if (operand < 0)
+            {
+                is_valid = false;
+                break;
+            }
+            i++;
+            instruction.operand = operand;
+            if (opcode == Op::label)
+            {
+                if (label_address[operand] != kUndefinedLabel) // duplicated
+                    is_valid = false;
+                label_address[operand] = static_cast<uint32_t>(code_.size());
+                continue; // label doesn't generate code.
+            }
+            instruction.kind = opcode == Op::go_to    ? Kind::go_to
+                               : opcode == Op::go_sub ? Kind::go_sub
+                               : opcode == Op::sto    ? Kind::store
+                                                      : Kind::recall;
+            break;
+        }
+        case Op::ret:
+            instruction.kind = Kind::ret;
+            break;
+        case Op::x_eq_y:
+        case Op::x_ne_y:
+        case Op::x_lt_y:
+        case Op::x_le_y:
+            instruction.kind = Kind::test;
+            break;
+        case Op::enter:
+            instruction.kind = Kind::enter;
+            break;
+        case Op::clx:
+        case Op::del:
+            instruction.kind = Kind::clx;
+            break;
+        case Op::chs:
+            instruction.opcode = Op::neg;
+            break;
+        case Op::pi:
+            instruction.kind = Kind::replacing_operation;
+            break;
+        case Op::sigma_plus:
+        case Op::sigma_minus:
+            instruction.kind = Kind::nonpushable_operation;
+            break;
+        case Op::change_display:
+        case Op::hex:
+        case Op::dec:
+        case Op::func:
+        case Op::nop:
+            continue; // Ignored.
+        default:
+            if (DigitOf(opcode) >= 0) // hex digit out of operand.
+                is_valid = false;
+            break;
+        }
+        if (is_valid)
+        {
+#ifdef RPN_ENGINE_PROFILE
+            step_begin_.push_back(begin);
+            step_end_.push_back(i + 1); // i is at the operand if any.
+#endif
+            code_.push_back(instruction);
+        }
+    }
+
+    // Second pass : resolve the jump target.
+    for (auto &instruction : code_)
+        if (instruction.kind == Kind::go_to || instruction.kind == Kind::go_sub)
+        {
+            instruction.operand = label_address[instruction.operand];
+            if (instruction.operand == kUndefinedLabel)
+                is_valid = false;
+        }
+
+    if (!is_valid)
+    {
+        code_.clear();
+        literals_.clear();
+#ifdef RPN_ENGINE_PROFILE
+        step_begin_.clear();
+        step_end_.clear();
+#endif
+    }
+#ifdef RPN_ENGINE_PROFILE
+    ClearProfile();
+#endif
+    return is_valid;
+}
+
+template <class Element>
+bool rpn_engine::VirtualMachine<Element>::Load(const ProgramMemory &program)
+{
+    std::vector<Op> opcodes;
+    opcodes.reserve(program.GetStepCount());
+
+    unsigned int position = 0;
+    while (position < program.GetNibbleCount())
+        opcodes.push_back(program.Fetch(position));
+
+    return Load(opcodes.data(), opcodes.size());
+}
+
+template <class Element>
+void rpn_engine::VirtualMachine<Element>::Reset()
+{
+    program_counter_ = 0;
+    return_stack_pointer_ = 0;
+    is_pushable_ = true;
+}
+
+template <class Element>
+bool rpn_engine::VirtualMachine<Element>::Test(Op opcode)
+{
+    StackView<Element> stack = engine_.GetView();
+
+    switch (opcode)
+    {
+    case Op::x_eq_y:
+        return stack[0] == stack[1];
+    case Op::x_ne_y:
+        return !(stack[0] == stack[1]);
+    case Op::x_lt_y:
+        return RealPart(stack[0]) < RealPart(stack[1]);
+    default: // Op::x_le_y
+        return RealPart(stack[0]) <= RealPart(stack[1]);
+    }
+}
+
+template <class Element>
+typename rpn_engine::VirtualMachine<Element>::Result rpn_engine::VirtualMachine<Element>::Run(unsigned long budget)
+{
+    const Instruction *code = code_.data();
+    const uint32_t size = static_cast<uint32_t>(code_.size());
+    unsigned long executed = 0;
+    Result result = Result::completed;
+
+    // The whole run is one step for the undo. Saving for each step is disabled.
+    engine_.SaveToUndoBuffer();
+    typename StackStrategy<Element>::DisableUndoSaving disable_undo(&engine_);
+
+    while (true)
+    {
+        if (program_counter_ >= size) // End of program
+            break;
+        if (executed >= budget)
+        {
+            result = Result::budget_exhausted;
+            break;
+        }
+
+#ifdef RPN_ENGINE_PROFILE
+        ProfileStep(program_counter_);
+#endif
+        const Instruction &instruction = code[program_counter_++];
+        executed++;
+
+        switch (instruction.kind)
+        {
+        case Kind::operation:
+            engine_.Operation(instruction.opcode);
+            is_pushable_ = true;
+            break;
+        case Kind::replacing_operation:
+            if (!is_pushable_)
+                engine_.Pop();
+            engine_.Operation(instruction.opcode);
+            is_pushable_ = true;
+            break;
+        case Kind::nonpushable_operation:
+            engine_.Operation(instruction.opcode);
+            is_pushable_ = false;
+            break;
+        case Kind::literal:
+            if (is_pushable_)
+                engine_.Push(literals_[instruction.operand]);
+            else
+                engine_.SetX(literals_[instruction.operand]);
+            is_pushable_ = true;
+            break;
+        case Kind::enter:
+            engine_.Operation(Op::duplicate);
+            is_pushable_ = false;
+            break;
+        case Kind::clx:
+            engine_.SetX(0);
+            is_pushable_ = false;
+            break;
+        case Kind::store:
+            registers_[instruction.operand] = engine_.Get(0);
+            break;
+        case Kind::recall:
+            engine_.Push(registers_[instruction.operand]);
+            is_pushable_ = true;
+            break;
+        case Kind::go_to:
+            program_counter_ = instruction.operand;
+            break;
+        case Kind::go_sub:
+            if (return_stack_pointer_ >= kVmReturnStackDepth)
+            {
+#ifdef RPN_ENGINE_PROFILE
+                ProfileEnd();
+#endif
+                Reset();
+                executed_count_ = executed;
+                return Result::return_stack_overflow;
+            }
+            return_stack_[return_stack_pointer_++] = program_counter_;
+            program_counter_ = instruction.operand;
+            break;
+        case Kind::ret:
+            if (return_stack_pointer_ == 0) // top level
+                program_counter_ = size;    // end of program
+            else
+                program_counter_ = return_stack_[--return_stack_pointer_];
+            break;
+        case Kind::test:
+            if (!Test(instruction.opcode))
+                program_counter_++; // skip next step
+            break;
+        }
+    }
+
+#ifdef RPN_ENGINE_PROFILE
+    ProfileEnd();
+#endif
+    executed_count_ = executed;
+    return result;
+}
+
+template <class Element>
+unsigned long rpn_engine::VirtualMachine<Element>::GetExecutedCount() const
+{
+    return executed_count_;
+}
+
+template <class Element>
+std::size_t rpn_engine::VirtualMachine<Element>::GetProgramSize() const
+{
+    return code_.size();
+}
+
+template <class Element>
+const Element &rpn_engine::VirtualMachine<Element>::GetRegister(unsigned int index) const
+{
+    assert(kNumberOfVmRegisters > index);
+    return registers_[index];
+}
+
+template <class Element>
+void rpn_engine::VirtualMachine<Element>::SetRegister(unsigned int index, const Element &value)
+{
+    assert(kNumberOfVmRegisters > index);
+    registers_[index] = value;
+}
+
+#ifdef RPN_ENGINE_PROFILE
+template <class Element>
+void rpn_engine::VirtualMachine<Element>::ProfileStep(uint32_t step)
+{
+    const std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+    if (profiled_step_ != kNoStep)
+        profile_[profiled_step_].time += now - profile_start_;
+    profile_[step].count++;
+    profiled_step_ = step;
+    profile_start_ = now;
+}
+
+template <class Element>
+void rpn_engine::VirtualMachine<Element>::ProfileEnd()
+{
+    if (profiled_step_ != kNoStep)
+        profile_[profiled_step_].time += std::chrono::steady_clock::now() - profile_start_;
+    profiled_step_ = kNoStep;
+}
+
+template <class Element>
+const std::vector<typename rpn_engine::VirtualMachine<Element>::ProfileCounter> &rpn_engine::VirtualMachine<Element>::GetProfile() const
+{
+    return profile_;
+}
+
+template <class Element>
+void rpn_engine::VirtualMachine<Element>::ClearProfile()
+{
+    profile_.assign(code_.size(), ProfileCounter{0, std::chrono::steady_clock::duration::zero()});
+}
+
+template <class Element>
+void rpn_engine::VirtualMachine<Element>::GetStepRange(std::size_t step, std::size_t &begin, std::size_t &end) const
+{
+    assert(step < code_.size());
+    begin = step_begin_[step];
+    end = step_end_[step];
+}
+
+template <class Element>
+const char *rpn_engine::VirtualMachine<Element>::GetStepName(std::size_t step) const
+{
+    const Instruction &instruction = code_[step];
+    switch (instruction.kind)
+    {
+    case Kind::literal:
+        return "number";
+    case Kind::enter:
+        return GetOpName(Op::enter);
+    case Kind::clx:
+        return GetOpName(Op::clx);
+    case Kind::store:
+        return GetOpName(Op::sto);
+    case Kind::recall:
+        return GetOpName(Op::rcl);
+    case Kind::go_to:
+        return GetOpName(Op::go_to);
+    case Kind::go_sub:
+        return GetOpName(Op::go_sub);
+    case Kind::ret:
+        return GetOpName(Op::ret);
+    default:
+        return GetOpName(instruction.opcode);
+    }
+}
+
+template <class Element>
+void rpn_engine::VirtualMachine<Element>::WriteFlatProfile(std::FILE *file) const
+{
+    // Sum by the name.
+    std::map<std::string, ProfileCounter> sums;
+    std::chrono::steady_clock::duration total = std::chrono::steady_clock::duration::zero();
+    for (std::size_t step = 0; step < profile_.size(); step++)
+    {
+        ProfileCounter &sum = sums.insert(std::make_pair(std::string(GetStepName(step)), ProfileCounter{0, std::chrono::steady_clock::duration::zero()})).first->second;
+        sum.count += profile_[step].count;
+        sum.time += profile_[step].time;
+        total += profile_[step].time;
+    }
+
+    std::vector<std::pair<std::string, ProfileCounter>> lines(sums.begin(), sums.end());
+    std::stable_sort(lines.begin(), lines.end(), [](const std::pair<std::string, ProfileCounter> &a, const std::pair<std::string, ProfileCounter> &b)
+                     { return a.second.time > b.second.time; });
+
+    const double total_ns = std::chrono::duration<double, std::nano>(total).count();
+    std::fprintf(file, "  %%time         ns       count    ns/call  opcode\n");
+    for (auto &line : lines)
+    {
+        const double ns = std::chrono::duration<double, std::nano>(line.second.time).count();
+        std::fprintf(file, "%7.2f %10.0f %11lu %10.2f  %s\n",
+                     total_ns > 0 ? 100 * ns / total_ns : 0.0,
+                     ns,
+                     line.second.count,
+                     line.second.count > 0 ? ns / line.second.count : 0.0,
+                     line.first.c_str());
+    }
+}
+
+template <class Element>
+void rpn_engine::VirtualMachine<Element>::WriteAnnotatedListing(std::FILE *file, const Op program[], std::size_t length) const
+{
+    std::chrono::steady_clock::duration total = std::chrono::steady_clock::duration::zero();
+    for (auto &counter : profile_)
+        total += counter.time;
+    const double total_ns = std::chrono::duration<double, std::nano>(total).count();
+
+    auto write_opcodes = [&](std::size_t begin, std::size_t end)
+    {
+        for (std::size_t i = begin; i < end && i < length; i++)
+            std::fprintf(file, " %s", GetOpName(program[i]));
+        std::fprintf(file, "\n");
+    };
+
+    std::fprintf(file, "  step  %%time         ns       count  program\n");
+    std::size_t position = 0;
+    for (std::size_t step = 0; step < code_.size(); step++)
+    {
+        // The opcodes without a step, like label.
+        if (position < step_begin_[step])
+        {
+            std::fprintf(file, "%6s %6s %10s %11s ", "", "", "", "");
+            write_opcodes(position, step_begin_[step]);
+        }
+
+        const double ns = std::chrono::duration<double, std::nano>(profile_[step].time).count();
+        std::fprintf(file, "%6zu %6.2f %10.0f %11lu ", step, total_ns > 0 ? 100 * ns / total_ns : 0.0, ns, profile_[step].count);
+        write_opcodes(step_begin_[step], step_end_[step]);
+        position = step_end_[step];
+    }
+    if (position < length)
+    {
+        std::fprintf(file, "%6s %6s %10s %11s ", "", "", "", "");
+        write_opcodes(position, length);
+    }
+}
+#endif
+
+#ifndef RPN_ENGINE_HEADER_ONLY
+// Compiled in virtualmachine.cpp
+extern template class rpn_engine::VirtualMachine<double>;
+extern template class rpn_engine::VirtualMachine<std::complex<double>>;
+#endif
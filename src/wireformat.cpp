@@ -0,0 +1,331 @@
+#include "wireformat.hpp"
+#include "opcode.hpp"
+#include <algorithm>
+#include <cassert>
+
+// Definition of the static const member used as a reference.
+const uint8_t rpn_engine::WireFormat::kVersion;
+
+// Opcode of each wire code. The index is the code. Append-only : the code of an existing
+// opcode must not change, even if the Op enum is reordered. The new opcode goes to the end.
+static const rpn_engine::Op kWireCodes[] = {
+    rpn_engine::Op::duplicate, rpn_engine::Op::swap, rpn_engine::Op::rotate_pop, rpn_engine::Op::rotate_push,
+    rpn_engine::Op::add, rpn_engine::Op::sub, rpn_engine::Op::mul, rpn_engine::Op::div, rpn_engine::Op::neg,
+    rpn_engine::Op::inv, rpn_engine::Op::sqrt, rpn_engine::Op::square, rpn_engine::Op::pi,
+    rpn_engine::Op::exp, rpn_engine::Op::log, rpn_engine::Op::log10, rpn_engine::Op::power10, rpn_engine::Op::power,
+    rpn_engine::Op::sin, rpn_engine::Op::cos, rpn_engine::Op::tan, rpn_engine::Op::asin, rpn_engine::Op::acos, rpn_engine::Op::atan,
+    rpn_engine::Op::complex, rpn_engine::Op::decomplex, rpn_engine::Op::conjugate, rpn_engine::Op::to_polar,
+    rpn_engine::Op::to_cartesian, rpn_engine::Op::swap_re_im,
+    rpn_engine::Op::bit_add, rpn_engine::Op::bit_sub, rpn_engine::Op::bit_mul, rpn_engine::Op::bit_div,
+    rpn_engine::Op::bit_neg, rpn_engine::Op::bit_or, rpn_engine::Op::bit_xor, rpn_engine::Op::bit_and,
+    rpn_engine::Op::logical_shift_right, rpn_engine::Op::logical_shift_left, rpn_engine::Op::bit_not,
+    rpn_engine::Op::sigma_plus, rpn_engine::Op::sigma_minus, rpn_engine::Op::sigma_clear, rpn_engine::Op::mean,
+    rpn_engine::Op::standard_deviation,
+    rpn_engine::Op::random, rpn_engine::Op::polynomial,
+    rpn_engine::Op::change_display, rpn_engine::Op::enter, rpn_engine::Op::clx, rpn_engine::Op::undo,
+    rpn_engine::Op::hex, rpn_engine::Op::dec, rpn_engine::Op::sto, rpn_engine::Op::rcl, rpn_engine::Op::func,
+    rpn_engine::Op::label, rpn_engine::Op::go_to, rpn_engine::Op::go_sub, rpn_engine::Op::ret,
+    rpn_engine::Op::x_eq_y, rpn_engine::Op::x_ne_y, rpn_engine::Op::x_lt_y, rpn_engine::Op::x_le_y,
+    rpn_engine::Op::nop,
+    rpn_engine::Op::num_0, rpn_engine::Op::num_1, rpn_engine::Op::num_2, rpn_engine::Op::num_3,
+    rpn_engine::Op::num_4, rpn_engine::Op::num_5, rpn_engine::Op::num_6, rpn_engine::Op::num_7,
+    rpn_engine::Op::num_8, rpn_engine::Op::num_9, rpn_engine::Op::num_a, rpn_engine::Op::num_b,
+    rpn_engine::Op::num_c, rpn_engine::Op::num_d, rpn_engine::Op::num_e, rpn_engine::Op::num_f,
+    rpn_engine::Op::period, rpn_engine::Op::eex, rpn_engine::Op::del, rpn_engine::Op::chs,
+    // Appended for the coefficient registers.
+    rpn_engine::Op::coefficient_store, rpn_engine::Op::coefficient_polynomial};
+
+static const unsigned int kNumberOfWireCodes = sizeof(kWireCodes) / sizeof(kWireCodes[0]);
+static_assert(kNumberOfWireCodes == rpn_engine::kNumberOfOps, "Wire table must cover all Op");
+// The code must fit to the escaped 8bit, and must not collide with the repetition.
+static_assert(kNumberOfWireCodes <= 255, "Wire code exceeds 8bit");
+
+// Opcodes encoded in one nibble. The index is the code. Same as the ProgramMemory.
+// The last entry is the escape. It is read by the fast path but never counted.
+static const rpn_engine::Op kShortCodes[16] = {
+    rpn_engine::Op::num_0,
+    rpn_engine::Op::num_1,
+    rpn_engine::Op::num_2,
+    rpn_engine::Op::num_3,
+    rpn_engine::Op::num_4,
+    rpn_engine::Op::num_5,
+    rpn_engine::Op::num_6,
+    rpn_engine::Op::num_7,
+    rpn_engine::Op::num_8,
+    rpn_engine::Op::num_9,
+    rpn_engine::Op::period,
+    rpn_engine::Op::enter,
+    rpn_engine::Op::add,
+    rpn_engine::Op::sub,
+    rpn_engine::Op::mul,
+    rpn_engine::Op::nop, // Escape.
+};
+
+static const unsigned int kEscape = 0xF;
+static const unsigned int kRepeat = 0xFF;
+
+namespace
+{
+    // Append the nibbles to the byte array.
+    class NibbleWriter
+    {
+    public:
+        NibbleWriter(std::vector<uint8_t> &data) : data_(data), is_odd_(false) {}
+
+        void Put(unsigned int nibble)
+        {
+            if (is_odd_)
+                data_.back() |= static_cast<uint8_t>(nibble << 4);
+            else
+                data_.push_back(static_cast<uint8_t>(nibble));
+            is_odd_ = !is_odd_;
+        }
+
+    private:
+        std::vector<uint8_t> &data_;
+        bool is_odd_;
+    };
+
+    // Wire code of the opcode. The inverse of kWireCodes.
+    unsigned int WireCodeOf(rpn_engine::Op opcode)
+    {
+        struct Table
+        {
+            uint8_t codes[rpn_engine::kNumberOfOps];
+            Table()
+            {
+                for (unsigned int code = 0; code < kNumberOfWireCodes; code++)
+                    codes[static_cast<unsigned int>(kWireCodes[code])] = static_cast<uint8_t>(code);
+            }
+        };
+        static const Table table;
+        return table.codes[static_cast<unsigned int>(opcode)];
+    }
+
+    // Short code of the opcode, or kEscape.
+    unsigned int ShortCodeOf(rpn_engine::Op opcode)
+    {
+        for (unsigned int code = 0; code < kEscape; code++)
+            if (kShortCodes[code] == opcode)
+                return code;
+        return kEscape;
+    }
+
+    // Number of the nibbles of the varint.
+    unsigned int VarintNibbles(std::size_t value)
+    {
+        unsigned int count = 1;
+        for (value >>= 3; value != 0; value >>= 3)
+            count++;
+        return count;
+    }
+
+    unsigned int NibbleAt(const uint8_t bytes[], std::size_t position)
+    {
+        return (bytes[position / 2] >> (4 * (position % 2))) & 0xF;
+    }
+
+    // Number of the nibbles from the LSB before the first 0xF. 16 if no 0xF.
+    std::size_t LeadingShortCodes(uint64_t word)
+    {
+        // Bit 4i is set if the nibble i is 0xF.
+        const uint64_t escapes = word & (word >> 1) & (word >> 2) & (word >> 3) & UINT64_C(0x1111111111111111);
+        // Ones below the first escape. Count them without branch.
+        uint64_t below = (escapes & (0 - escapes)) - 1;
+        below = below - ((below >> 1) & UINT64_C(0x5555555555555555));
+        below = (below & UINT64_C(0x3333333333333333)) + ((below >> 2) & UINT64_C(0x3333333333333333));
+        below = (below + (below >> 4)) & UINT64_C(0x0F0F0F0F0F0F0F0F);
+        return static_cast<std::size_t>((below * UINT64_C(0x0101010101010101)) >> 56) / 4;
+    }
+}
+
+void rpn_engine::WireFormat::Encode(const Op program[], std::size_t length, std::vector<uint8_t> &data)
+{
+    data.clear();
+
+    // Header.
+    data.push_back(kVersion);
+    std::size_t count = length;
+    do
+    {
+        data.push_back(static_cast<uint8_t>((count & 0x7F) | (count > 0x7F ? 0x80 : 0)));
+        count >>= 7;
+    } while (count != 0);
+
+    NibbleWriter writer(data);
+    std::size_t i = 0;
+    while (i < length)
+    {
+        const Op opcode = program[i];
+        const unsigned int code = ShortCodeOf(opcode);
+        if (code != kEscape)
+            writer.Put(code);
+        else
+        {
+            unsigned int value = WireCodeOf(opcode);
+            writer.Put(kEscape);
+            writer.Put(value & 0xF);
+            writer.Put(value >> 4);
+        }
+
+        // Same opcodes following.
+        std::size_t run = 1;
+        while (i + run < length && program[i + run] == opcode)
+            run++;
+        const std::size_t repeat = run - 1;
+        const std::size_t plain_nibbles = repeat * (code != kEscape ? 1 : 3);
+        if (repeat > 0 && 3 + VarintNibbles(repeat) < plain_nibbles)
+        {
+            writer.Put(kEscape);
+            writer.Put(kRepeat & 0xF);
+            writer.Put(kRepeat >> 4);
+            std::size_t value = repeat;
+            do
+            {
+                writer.Put((value & 0x7) | (value > 0x7 ? 0x8 : 0));
+                value >>= 3;
+            } while (value != 0);
+            i += run;
+        }
+        else
+            i++;
+    }
+}
+
+bool rpn_engine::WireFormat::Decode(const uint8_t data[], std::size_t size, std::vector<Op> &program)
+{
+    // Header. The unknown version may have the unknown nibble coding.
+    if (size == 0 || data[0] != kVersion)
+    {
+        program.clear();
+        return false;
+    }
+    std::size_t count = 0;
+    std::size_t header = 1;
+    for (unsigned int shift = 0;; shift += 7)
+    {
+        if (header >= size || shift >= sizeof(std::size_t) * 8)
+        {
+            program.clear();
+            return false;
+        }
+        const uint8_t byte = data[header++];
+        count |= static_cast<std::size_t>(byte & 0x7F) << shift;
+        if ((byte & 0x80) == 0)
+            break;
+    }
+    const uint8_t *body = data + header;
+    const std::size_t nibble_count = (size - header) * 2;
+
+    // Each opcode needs at least a nibble, except the repetition. So, the broken count
+    // doesn't allocate more than the data. The reused buffer is not initialized again.
+    program.resize(std::min(count, nibble_count));
+    Op *out = program.data();
+    std::size_t produced = 0;
+    std::size_t position = 0; // in nibble
+    bool is_broken = false;
+
+    while (produced < count && !is_broken)
+    {
+        // Fast path : The nibbles in 8 bytes before the first escape are converted by
+        // the table. All 16 entries are written to avoid the branch. Only the valid ones
+        // are counted. The program may be shorter than the count after a repetition.
+        if (position + 16 <= nibble_count && produced + 16 <= program.size())
+        {
+            const uint8_t *bytes = body + position / 2;
+            uint64_t word = 0;
+            for (unsigned int k = 0; k < 8; k++)
+                word |= static_cast<uint64_t>(bytes[k]) << (8 * k);
+            word >>= 4 * (position % 2); // The top nibble becomes 0. Not an escape.
+            for (unsigned int k = 0; k < 16; k++)
+                out[produced + k] = kShortCodes[(word >> (4 * k)) & 0xF];
+
+            const std::size_t available = 16 - position % 2;
+            const std::size_t valid = std::min(available, LeadingShortCodes(word));
+            produced += valid;
+            position += valid;
+            if (valid == available)
+                continue;
+            // The escape is handled below.
+        }
+
+        // An escaped opcode.
+        if (position + 3 <= nibble_count && NibbleAt(body, position) == kEscape)
+        {
+            const unsigned int value = NibbleAt(body, position + 1) | (NibbleAt(body, position + 2) << 4);
+            if (value < kNumberOfWireCodes)
+            {
+                out[produced++] = kWireCodes[value];
+                position += 3;
+                continue;
+            }
+        }
+
+        // Slow path : a nibble.
+        auto get = [&]() -> unsigned int
+        {
+            if (position >= nibble_count)
+            {
+                is_broken = true;
+                return 0;
+            }
+            unsigned int nibble = NibbleAt(body, position);
+            position++;
+            return nibble;
+        };
+
+        unsigned int code = get();
+        if (code != kEscape)
+        {
+            if (!is_broken)
+                out[produced++] = kShortCodes[code];
+            continue;
+        }
+        unsigned int value = get();
+        value |= get() << 4;
+        if (is_broken)
+            break;
+        if (value == kRepeat)
+        {
+            std::size_t repeat = 0;
+            for (unsigned int shift = 0;; shift += 3)
+            {
+                unsigned int nibble = get();
+                if (is_broken || shift >= sizeof(std::size_t) * 8)
+                {
+                    is_broken = true;
+                    break;
+                }
+                repeat |= static_cast<std::size_t>(nibble & 0x7) << shift;
+                if ((nibble & 0x8) == 0)
+                    break;
+            }
+            if (is_broken || produced == 0 || repeat == 0 || repeat > count - produced)
+            {
+                is_broken = true;
+                break;
+            }
+            const std::size_t needed = std::min(count, produced + repeat + (nibble_count - position));
+            if (program.size() < needed)
+            {
+                program.resize(needed);
+                out = program.data();
+            }
+            std::fill(out + produced, out + produced + repeat, out[produced - 1]);
+            produced += repeat;
+        }
+        else if (value >= kNumberOfWireCodes)
+            is_broken = true;
+        else
+            out[produced++] = kWireCodes[value];
+    }
+
+    // All bytes are used. The padding nibble is zero.
+    if (is_broken || (position + 1) / 2 != size - header ||
+        (position % 2 == 1 && (body[position / 2] >> 4) != 0))
+    {
+        program.clear();
+        return false;
+    }
+    return true;
+}
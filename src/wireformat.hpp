@@ -0,0 +1,75 @@
+#pragma once
+/**
+ * @file wireformat.hpp
+ * @author Seiichi "Suikan" Horie
+ * @brief Compact binary format of the Op sequence.
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#include "stackstrategy.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace rpn_engine
+{
+    /**
+     * @brief Serialize the Op sequence to bytes and back.
+     * @details
+     * The format is a version byte, a varint of the number of the opcodes and a stream of
+     * 4bit nibbles. The varint has 7bit of the value in each byte from the lower bits. The
+     * MSB of the byte is set if more byte follows.
+     *
+     * The nibbles are coded as same as the ProgramMemory :
+     * @li 0x0 .. 0xE : The frequently used opcodes. Digits, period, enter, add, sub and mul.
+     * @li 0xF : Escape. The next two nibbles are the 8bit value. Lower nibble first.
+     *
+     * The 8bit value is the wire code of the opcode, except 0xFF. The wire code is given by
+     * the append-only table. So, the reordering of the Op enum doesn't change the encoded
+     * data, and a new opcode gets a new code. 0xFF repeats the previous opcode. The number
+     * of the repetition follows as a varint of nibbles. Each nibble has 3bit of the value
+     * from the lower bits and the bit 3 is set if more nibble follows. The encoder uses the
+     * repetition only if it is shorter.
+     *
+     * The even nibble is stored in the lower 4bit of the byte. If the number of the nibbles
+     * is odd, the last upper 4bit is zero.
+     *
+     * Decode() converts 8 bytes at once to 16 opcodes by a table without branch. Then, the
+     * opcodes before the first escape are taken. The escape is decoded one by one.
+     */
+    class WireFormat
+    {
+    public:
+        /**
+         * @brief Version of the format at the top of the data.
+         * @details
+         * Decode() rejects the other versions.
+         */
+        static const uint8_t kVersion = 1;
+
+        /**
+         * @brief Encode the opcodes.
+         *
+         * @param program Array of the opcode.
+         * @param length Number of the opcode in the program.
+         * @param data Encoded bytes. The previous content is discarded.
+         */
+        static void Encode(const Op program[], std::size_t length, std::vector<uint8_t> &data);
+
+        /**
+         * @brief Decode the opcodes.
+         *
+         * @param data Encoded bytes.
+         * @param size Number of the bytes.
+         * @param program Decoded opcodes. The previous content is discarded.
+         * @return true Decoded.
+         * @return false The data is broken. Unknown version, truncated, unknown opcode, extra
+         * bytes or repetition without the previous opcode. The program is empty.
+         */
+        static bool Decode(const uint8_t data[], std::size_t size, std::vector<Op> &program);
+    };
+}
@@ -0,0 +1,108 @@
+#include "workstealingpool.hpp"
+#include <cassert>
+
+rpn_engine::WorkStealingPool::WorkStealingPool(unsigned int threads) : pending_(0),
+                                                                      generation_(0),
+                                                                      is_stopping_(false)
+{
+    if (threads == 0)
+        threads = std::thread::hardware_concurrency();
+    if (threads == 0) // in case the hardware_concurrency() is not computable.
+        threads = 1;
+
+    for (unsigned int id = 0; id < threads; id++)
+        workers_.emplace_back(new Worker);
+    // The caller of Run() works as the worker 0.
+    for (unsigned int id = 1; id < threads; id++)
+        threads_.emplace_back(&WorkStealingPool::Work, this, id);
+}
+
+rpn_engine::WorkStealingPool::~WorkStealingPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        is_stopping_ = true;
+    }
+    start_.notify_all();
+    for (auto &thread : threads_)
+        thread.join();
+}
+
+unsigned int rpn_engine::WorkStealingPool::GetThreadCount() const
+{
+    return static_cast<unsigned int>(workers_.size());
+}
+
+void rpn_engine::WorkStealingPool::Run(const Task &root)
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        pending_ = 1;
+        generation_++;
+    }
+    start_.notify_all();
+
+    root(0);
+    pending_--;
+    while (pending_ > 0)
+        if (!RunOne(0))
+            std::this_thread::yield();
+}
+
+void rpn_engine::WorkStealingPool::Spawn(unsigned int worker, Task task)
+{
+    assert(worker < workers_.size());
+    pending_++;
+    std::lock_guard<std::mutex> lock(workers_[worker]->mutex);
+    workers_[worker]->tasks.push_back(std::move(task));
+}
+
+bool rpn_engine::WorkStealingPool::RunOne(unsigned int worker)
+{
+    Task task;
+    const unsigned int count = static_cast<unsigned int>(workers_.size());
+
+    // The newest task of the own deque first. Then, the oldest task of the others.
+    for (unsigned int i = 0; i < count && !task; i++)
+    {
+        Worker &victim = *workers_[(worker + i) % count];
+        std::lock_guard<std::mutex> lock(victim.mutex);
+        if (victim.tasks.empty())
+            continue;
+        if (i == 0)
+        {
+            task = std::move(victim.tasks.back());
+            victim.tasks.pop_back();
+        }
+        else
+        {
+            task = std::move(victim.tasks.front());
+            victim.tasks.pop_front();
+        }
+    }
+    if (!task)
+        return false;
+
+    task(worker);
+    pending_--;
+    return true;
+}
+
+void rpn_engine::WorkStealingPool::Work(unsigned int worker)
+{
+    unsigned long generation = 0;
+    while (true)
+    {
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            start_.wait(lock, [&]
+                        { return is_stopping_ || generation_ != generation; });
+            if (is_stopping_)
+                return;
+            generation = generation_;
+        }
+        while (pending_ > 0)
+            if (!RunOne(worker))
+                std::this_thread::yield();
+    }
+}
@@ -0,0 +1,111 @@
+#pragma once
+/**
+ * @file workstealingpool.hpp
+ * @author Seiichi "Suikan" Horie
+ * @brief Thread pool with the work stealing scheduler.
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2026
+ *
+ */
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace rpn_engine
+{
+    /**
+     * @brief Thread pool which runs the tasks spawned by the tasks.
+     * @details
+     * Each worker has its own deque of the tasks. A task spawned by a worker is pushed
+     * to the deque of that worker. The worker takes the newest task from its own deque.
+     * If its deque is empty, it steals the oldest task from the other workers. Thus,
+     * the workers don't touch the same end of a deque while there are enough tasks.
+     *
+     * The worker threads are created by the constructor and wait for Run(). The thread
+     * calling Run() works as the worker 0. Run() returns when all tasks spawned in the
+     * Run() are done. Run() must not be called from a task.
+     */
+    class WorkStealingPool
+    {
+    public:
+        /**
+         * @brief Task to run. The parameter is the id of the worker running the task.
+         */
+        typedef std::function<void(unsigned int)> Task;
+
+        /**
+         * @brief Construct a new pool.
+         *
+         * @param threads Number of the workers including the caller of Run(). If 0, the number of the hardware threads is used.
+         */
+        WorkStealingPool(unsigned int threads = 0);
+
+        /**
+         * @brief Stop and join the worker threads.
+         */
+        ~WorkStealingPool();
+
+        WorkStealingPool(const WorkStealingPool &) = delete;
+        WorkStealingPool &operator=(const WorkStealingPool &) = delete;
+
+        /**
+         * @brief Number of the workers including the caller of Run().
+         */
+        unsigned int GetThreadCount() const;
+
+        /**
+         * @brief Run a task and the tasks spawned by it.
+         *
+         * @param root The first task. It runs on the calling thread as worker 0.
+         */
+        void Run(const Task &root);
+
+        /**
+         * @brief Add a task to the deque of a worker.
+         *
+         * @param worker Id of the worker calling this function.
+         * @param task Task to run.
+         * @details
+         * Call from the task running in Run().
+         */
+        void Spawn(unsigned int worker, Task task);
+
+    private:
+        // The padding keeps the deques of the workers on the different cache lines.
+        struct Worker
+        {
+            std::mutex mutex;
+            std::deque<Task> tasks;
+            char padding[64];
+        };
+
+        std::vector<std::unique_ptr<Worker>> workers_;
+        std::vector<std::thread> threads_;
+        std::atomic<unsigned long> pending_; // Spawned but not finished.
+        std::mutex mutex_;
+        std::condition_variable start_;
+        unsigned long generation_; // Incremented by each Run().
+        bool is_stopping_;
+
+        /**
+         * @brief Run one task from the own deque or the other deque.
+         *
+         * @return true A task was run.
+         * @return false No task was found.
+         */
+        bool RunOne(unsigned int worker);
+
+        /**
+         * @brief Body of the worker thread.
+         */
+        void Work(unsigned int worker);
+    };
+}
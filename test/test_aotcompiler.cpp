@@ -0,0 +1,205 @@
+// Test cases for the rpn_engine::AotCompiler class and the generated functions
+
+#include "gtest/gtest.h"
+#include "rpnengine.hpp"
+#include "rpn_hypot.hpp"
+#include "rpn_quadratic.hpp"
+#include "rpn_stack.hpp"
+#include "rpn_transcendental.hpp"
+#include "rpn_complex_quadratic.hpp"
+#include "rpn_complex_transcendental.hpp"
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <sstream>
+#include <string>
+
+using rpn_engine::Op;
+typedef rpn_engine::ExpressionGraph::NodeKind NodeKind;
+
+// Load the program text used by the rpn_compile_function() of the test/CMakeLists.txt
+static std::vector<Op> LoadProgram(const char *name)
+{
+    std::ifstream file(std::string(RPN_TEST_PROGRAM_DIR) + "/" + name);
+    std::stringstream text;
+    text << file.rdbuf();
+
+    std::vector<Op> program;
+    unsigned int line = 0;
+    EXPECT_TRUE(rpn_engine::ParseProgramText(text.str().c_str(), program, line)) << name << ":" << line;
+    return program;
+}
+
+// Run the program by the interpreter with X = x, Y = y and the other registers 0.
+template <class Element>
+static Element Interpret(const std::vector<Op> &program, Element x, Element y)
+{
+    rpn_engine::StackStrategy<Element> s(4);
+    rpn_engine::VirtualMachine<Element> vm(s);
+    s.Push(y);
+    s.Push(x);
+    EXPECT_TRUE(vm.Load(program.data(), program.size()));
+    vm.Run(1000);
+    return s.Get(0);
+}
+
+// Bit exact comparison. NaN is equal to NaN.
+static void ExpectSame(double expected, double actual, double x, double y)
+{
+    if (std::isnan(expected))
+        EXPECT_TRUE(std::isnan(actual)) << "x=" << x << " y=" << y;
+    else
+        EXPECT_EQ(expected, actual) << "x=" << x << " y=" << y;
+}
+
+static const double kSamples[] = {0, 1, -1, 0.5, -0.25, 3, -7.5, 1e-3, 123.456, -1e10};
+
+TEST(AotCompilerTest, ParseText)
+{
+    std::vector<Op> program;
+    unsigned int line = 0;
+
+    ASSERT_TRUE(rpn_engine::ParseProgramText("# comment\n2 -3.5e-2 add sto a\n rcl 1", program, line));
+    const Op expected[] = {Op::num_2, Op::enter, Op::num_3, Op::period, Op::num_5, Op::chs, Op::eex,
+                           Op::num_2, Op::chs, Op::add, Op::sto, Op::num_a, Op::rcl, Op::num_1};
+    ASSERT_EQ(program.size(), sizeof(expected) / sizeof(expected[0]));
+    for (std::size_t i = 0; i < program.size(); i++)
+        EXPECT_EQ(program[i], expected[i]) << i;
+
+    EXPECT_FALSE(rpn_engine::ParseProgramText("add\n\nfoo", program, line));
+    EXPECT_EQ(line, 3u);
+    EXPECT_FALSE(rpn_engine::ParseProgramText("1e", program, line));
+    EXPECT_EQ(line, 1u);
+}
+
+TEST(AotCompilerTest, OpName)
+{
+    for (unsigned int i = 0; i < rpn_engine::kNumberOfOps; i++)
+    {
+        Op opcode = Op::nop;
+        ASSERT_TRUE(rpn_engine::FindOp(rpn_engine::GetOpName(static_cast<Op>(i)), opcode));
+        EXPECT_EQ(opcode, static_cast<Op>(i));
+    }
+    EXPECT_STREQ(rpn_engine::GetOpName(Op::log10), "log10");
+    Op opcode = Op::nop;
+    EXPECT_FALSE(rpn_engine::FindOp("log2", opcode));
+    EXPECT_EQ(opcode, Op::nop);
+}
+
+TEST(AotCompilerTest, Graph)
+{
+    rpn_engine::ExpressionGraph graph(4);
+
+    // swap and duplicate don't make node. The bottom is duplicated by pop.
+    const Op program[] = {Op::swap, Op::duplicate, Op::mul, Op::add, Op::add, Op::num_2, Op::sin};
+    ASSERT_TRUE(graph.Build(program, sizeof(program) / sizeof(program[0])));
+    EXPECT_EQ(graph.GetNodeCount(), 4u + 5u);
+
+    // z + (y*y + x), then sin(2). T is lost by duplicate.
+    const rpn_engine::ExpressionGraph::Node &sin = graph.GetNode(graph.GetStackNode(0));
+    EXPECT_EQ(sin.kind, NodeKind::unary);
+    EXPECT_EQ(sin.opcode, Op::sin);
+    EXPECT_EQ(graph.GetNode(sin.operand[0]).kind, NodeKind::constant);
+    EXPECT_EQ(graph.GetNode(sin.operand[0]).value, 2);
+
+    const rpn_engine::ExpressionGraph::Node &add = graph.GetNode(graph.GetStackNode(1));
+    EXPECT_EQ(add.opcode, Op::add);
+    EXPECT_EQ(graph.GetNode(add.operand[1]).opcode, Op::add);
+    EXPECT_EQ(graph.GetNode(add.operand[0]).kind, NodeKind::input);
+    EXPECT_EQ(graph.GetNode(add.operand[0]).operand[0], 2u); // Z
+
+    // Z and T are the copy of the bottom
+    EXPECT_EQ(graph.GetStackNode(2), 2u);
+    EXPECT_EQ(graph.GetStackNode(3), 2u);
+
+    // Only sin(2) is needed for X.
+    std::vector<bool> live = graph.GetLiveNodes(graph.GetStackNode(0));
+    EXPECT_EQ(std::count(live.begin(), live.end(), true), 2);
+}
+
+TEST(AotCompilerTest, Unsupported)
+{
+    rpn_engine::AotCompiler compiler;
+
+    const Op program[] = {Op::num_1, Op::add, Op::random, Op::mul};
+    EXPECT_FALSE(compiler.Compile(program, sizeof(program) / sizeof(program[0])));
+    EXPECT_EQ(compiler.GetErrorPosition(), 2u);
+
+    const Op labeled[] = {Op::label, Op::num_1, Op::add};
+    EXPECT_FALSE(compiler.Compile(labeled, sizeof(labeled) / sizeof(labeled[0])));
+    EXPECT_EQ(compiler.GetErrorPosition(), 0u);
+}
+
+TEST(AotCompilerTest, Source)
+{
+    rpn_engine::AotCompiler compiler;
+
+    // The dead value 3 and stack manipulations don't appear.
+    const Op program[] = {Op::num_3, Op::rotate_pop, Op::swap, Op::add};
+    ASSERT_TRUE(compiler.Compile(program, sizeof(program) / sizeof(program[0])));
+    std::string source = compiler.GenerateSource("f", rpn_engine::AotCompiler::ElementType::real);
+
+    EXPECT_NE(source.find("#include \"kernels.hpp\""), std::string::npos);
+    EXPECT_NE(source.find("double f(double x, double y)"), std::string::npos);
+    EXPECT_NE(source.find("rpn_engine::kernel::Add(v0, v1)"), std::string::npos);
+    EXPECT_EQ(source.find("(3)"), std::string::npos);
+
+    // Unused parameter has no name.
+    const Op constant[] = {Op::num_3, Op::neg};
+    ASSERT_TRUE(compiler.Compile(constant, sizeof(constant) / sizeof(constant[0])));
+    source = compiler.GenerateSource("f", rpn_engine::AotCompiler::ElementType::real);
+    EXPECT_NE(source.find("double f(double, double)"), std::string::npos);
+
+    std::string header = compiler.GenerateHeader("g", rpn_engine::AotCompiler::ElementType::complex);
+    EXPECT_NE(header.find("std::complex<double> g(std::complex<double> x, std::complex<double> y);"), std::string::npos);
+}
+
+TEST(AotCompilerTest, DifferentialReal)
+{
+    const struct
+    {
+        const char *file;
+        double (*function)(double, double);
+    } programs[] = {
+        {"hypot.rpn", rpn_hypot},
+        {"quadratic.rpn", rpn_quadratic},
+        {"stack.rpn", rpn_stack},
+        {"transcendental.rpn", rpn_transcendental},
+    };
+
+    for (auto &program : programs)
+    {
+        SCOPED_TRACE(program.file);
+        std::vector<Op> keys = LoadProgram(program.file);
+        for (double x : kSamples)
+            for (double y : kSamples)
+                ExpectSame(Interpret(keys, x, y), program.function(x, y), x, y);
+    }
+}
+
+TEST(AotCompilerTest, DifferentialComplex)
+{
+    typedef std::complex<double> Complex;
+    const struct
+    {
+        const char *file;
+        Complex (*function)(Complex, Complex);
+    } programs[] = {
+        {"quadratic.rpn", rpn_complex_quadratic},
+        {"transcendental.rpn", rpn_complex_transcendental},
+    };
+
+    for (auto &program : programs)
+    {
+        SCOPED_TRACE(program.file);
+        std::vector<Op> keys = LoadProgram(program.file);
+        for (double x : kSamples)
+            for (double y : kSamples)
+            {
+                Complex expected = Interpret(keys, Complex(x, y), Complex(y, -x));
+                Complex actual = program.function(Complex(x, y), Complex(y, -x));
+                ExpectSame(expected.real(), actual.real(), x, y);
+                ExpectSame(expected.imag(), actual.imag(), x, y);
+            }
+    }
+}
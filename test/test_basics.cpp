@@ -3,6 +3,8 @@
 #include "gtest/gtest.h"
 #include "rpnengine.hpp"
 #include <stdexcept>
+#include <thread>
+#include <vector>
 
 using rpn_engine::Op;
 typedef rpn_engine::StackStrategy<int> IntStack;
@@ -527,3 +529,139 @@ TEST(BasicStackTest, RotatePush)
 
     delete s;
 }
+
+TEST(BasicStackTest, View)
+{
+    IntStack *s;
+    s = new IntStack(4);
+    s->Push(1);
+    s->Push(2);
+    s->Push(3);
+    s->Push(4);
+    s->Operation(rpn_engine::Op::add);
+
+    auto view = s->GetView();
+    EXPECT_EQ(view.size(), 4u);
+    EXPECT_EQ(view[0], 7); // check the stack top
+    EXPECT_EQ(view[1], 2); // check the stack 2nd.
+    EXPECT_EQ(view[2], 1); // check the stack 3rd.
+    EXPECT_EQ(view[3], 1); // check the stack 4th.
+
+    // Range access from the stack top to the stack bottom.
+    int sum = 0;
+    for (auto e : view)
+        sum += e;
+    EXPECT_EQ(sum, 11);
+
+    // Undo buffer keeps the stack before the add.
+    auto undo_view = s->GetUndoView();
+    EXPECT_EQ(undo_view.size(), 4u);
+    EXPECT_EQ(undo_view[0], 4); // check the stack top
+    EXPECT_EQ(undo_view[1], 3); // check the stack 2nd.
+    EXPECT_EQ(undo_view[2], 2); // check the stack 3rd.
+    EXPECT_EQ(undo_view[3], 1); // check the stack 4th.
+
+    delete s;
+}
+
+TEST(BasicStackTest, Snapshot)
+{
+    IntStack *s;
+    s = new IntStack(4);
+    s->Push(1);
+    s->Push(2);
+    s->Push(3);
+    s->Push(4);
+
+    auto snapshot = s->TakeSnapshot();
+    // The snapshot shares the storage with the stack.
+    EXPECT_EQ(&snapshot.Get(0), s->GetView().begin());
+
+    s->Operation(rpn_engine::Op::add);
+    s->Operation(rpn_engine::Op::mul);
+    EXPECT_EQ(s->Get(0), 14); // check the stack top
+
+    // The modification doesn't affect to the snapshot.
+    EXPECT_EQ(snapshot.Get(0), 4); // check the stack top
+    EXPECT_EQ(snapshot.Get(1), 3); // check the stack 2nd.
+    EXPECT_EQ(snapshot.Get(2), 2); // check the stack 3rd.
+    EXPECT_EQ(snapshot.Get(3), 1); // check the stack 4th.
+
+    // Branch from the snapshot.
+    s->RestoreSnapshot(snapshot);
+    EXPECT_EQ(s->GetView().begin(), &snapshot.Get(0));
+    s->Operation(rpn_engine::Op::sub);
+    EXPECT_EQ(s->Get(0), -1); // check the stack top
+    EXPECT_EQ(s->Get(1), 2);  // check the stack 2nd.
+
+    // Undo buffer is retrieved too.
+    s->RestoreSnapshot(snapshot);
+    s->Undo();
+    EXPECT_EQ(s->Get(0), 3); // check the stack top
+    EXPECT_EQ(s->Get(1), 2); // check the stack 2nd.
+    EXPECT_EQ(s->Get(2), 1); // check the stack 3rd.
+    EXPECT_EQ(s->Get(3), 0); // check the stack 4th.
+
+    // The snapshot is still unchanged.
+    EXPECT_EQ(snapshot.Get(0), 4); // check the stack top
+
+    delete s;
+}
+
+// Testing the copy of the stack. The copy shares the storage until the modification.
+TEST(BasicStackTest, Copy)
+{
+    IntStack s(4);
+
+    s.Push(1);
+    s.Push(2);
+
+    IntStack t(s);
+    EXPECT_EQ(t.Get(0), 2); // check the stack top
+    EXPECT_EQ(t.Get(1), 1); // check the stack 2nd.
+
+    // Modification of the copy doesn't change the original
+    t.Push(3);
+    EXPECT_EQ(t.Get(0), 3);
+    EXPECT_EQ(s.Get(0), 2);
+
+    // and vice versa.
+    IntStack u(s);
+    s.Operation(rpn_engine::Op::add);
+    EXPECT_EQ(s.Get(0), 3);
+    EXPECT_EQ(u.Get(0), 2);
+    EXPECT_EQ(u.Get(1), 1);
+}
+
+// The copy constructor doesn't write to the source. So, the threads can copy the shared engine.
+TEST(BasicStackTest, ConcurrentCopy)
+{
+    IntStack s(4);
+    s.Push(1);
+    s.Push(2);
+    const IntStack &source = s;
+
+    std::vector<int> results(4);
+    auto copy_and_add = [&source, &results](int i)
+    {
+        int sum = 0;
+        for (int k = 0; k < 1000; k++)
+        {
+            IntStack t(source);
+            t.Push(i);
+            t.Operation(rpn_engine::Op::add);
+            sum += t.Get(0);
+        }
+        results[i] = sum;
+    };
+    std::vector<std::thread> threads;
+    for (int i = 0; i < 4; i++)
+        threads.emplace_back(copy_and_add, i);
+    for (auto &thread : threads)
+        thread.join();
+
+    for (int i = 0; i < 4; i++)
+        EXPECT_EQ(results[i], 1000 * (2 + i));
+    EXPECT_EQ(s.Get(0), 2);
+    EXPECT_EQ(s.Get(1), 1);
+}
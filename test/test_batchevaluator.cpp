@@ -0,0 +1,135 @@
+// Test cases for the rpn_engine::BatchEvaluator class
+
+#include "gtest/gtest.h"
+#include "rpnengine.hpp"
+#include "testhelper.hpp"
+#include <cmath>
+#include <complex>
+#include <string>
+#include <vector>
+
+using rpn_engine::Op;
+typedef rpn_engine::BatchEvaluator<double> DoubleBatch;
+
+// Evaluate an item by the VirtualMachine alone.
+static double Reference(const std::vector<Op> &program, const double inputs[], unsigned int input_count)
+{
+    rpn_engine::StackStrategy<double> engine(4);
+    rpn_engine::VirtualMachine<double> vm(engine);
+    if (!vm.Load(program.data(), program.size()))
+        return NAN;
+    for (unsigned int i = input_count; i-- > 0;)
+        engine.Push(inputs[i]);
+    if (vm.Run(DoubleBatch::kStepBudget) != rpn_engine::VirtualMachine<double>::Result::completed)
+        return NAN;
+    return engine.Get(0);
+}
+
+TEST(BatchEvaluatorTest, Evaluate)
+{
+    const std::vector<std::vector<Op>> programs = {
+        Parse("add sqrt"),
+        Parse("swap div 3 power"),
+        Parse("rcl 0 add sto 0 rcl 0 mul"), // The registers start from zero in each item.
+        Parse("sigma_plus mean"),            // The statistics too.
+        Parse("go_to 1"),                    // Error.
+        Parse(""),
+    };
+    const std::vector<Op> endless = Parse("label 1 go_to 1"); // Never finishes.
+    const std::size_t count = 10000;
+    std::vector<double> inputs(count * 3);
+    std::vector<DoubleBatch::Item> items(count);
+    for (std::size_t i = 0; i < count; i++)
+    {
+        inputs[3 * i] = static_cast<double>(i % 97) / 7;
+        inputs[3 * i + 1] = static_cast<double>(i % 13) - 4;
+        inputs[3 * i + 2] = 1;
+        // Runs of the same program and the changes of the program.
+        const std::vector<Op> &program = i % 2000 == 1999 ? endless : programs[(i / 5) % programs.size()];
+        items[i] = DoubleBatch::Item{program.data(), program.size(), &inputs[3 * i], static_cast<unsigned int>(i % 4)};
+    }
+
+    for (unsigned int threads = 1; threads <= 4; threads++)
+    {
+        rpn_engine::WorkStealingPool pool(threads);
+        DoubleBatch batch(pool);
+        std::vector<double> results(count, -1);
+        batch.Evaluate(items.data(), count, results.data());
+        for (std::size_t i = 0; i < count; i++)
+        {
+            const std::vector<Op> &program = i % 2000 == 1999 ? endless : programs[(i / 5) % programs.size()];
+            ASSERT_TRUE(IsSame(results[i], Reference(program, &inputs[3 * i], i % 4))) << i;
+        }
+
+        // Again with the reused workers.
+        std::vector<double> again(count, -1);
+        batch.Evaluate(items.data(), count, again.data());
+        for (std::size_t i = 0; i < count; i++)
+            ASSERT_TRUE(IsSame(again[i], results[i])) << i;
+    }
+}
+
+TEST(BatchEvaluatorTest, Complex)
+{
+    typedef std::complex<double> Complex;
+    rpn_engine::WorkStealingPool pool(2);
+    rpn_engine::BatchEvaluator<Complex> batch(pool);
+
+    std::vector<Op> program = Parse("sqrt");
+    const Complex inputs[] = {Complex(-4, 0), Complex(0, 2)};
+    const rpn_engine::BatchEvaluator<Complex>::Item items[] = {
+        {program.data(), program.size(), &inputs[0], 1},
+        {program.data(), program.size(), &inputs[1], 1},
+    };
+    Complex results[2];
+    batch.Evaluate(items, 2, results);
+    EXPECT_EQ(results[0], Complex(0, 2));
+    EXPECT_NEAR(results[1].real(), 1, 1e-15);
+    EXPECT_NEAR(results[1].imag(), 1, 1e-15);
+
+    // Nothing to do.
+    batch.Evaluate(items, 0, results);
+}
+
+// The program array rewritten between the Evaluate() is decoded again.
+TEST(BatchEvaluatorTest, ReusedProgram)
+{
+    rpn_engine::WorkStealingPool pool(2);
+    rpn_engine::BatchEvaluator<double> batch(pool);
+
+    std::vector<Op> program = Parse("add");
+    const double inputs[] = {2, 3};
+    const rpn_engine::BatchEvaluator<double>::Item item = {program.data(), program.size(), inputs, 2};
+    double result;
+    batch.Evaluate(&item, 1, &result);
+    EXPECT_EQ(result, 5);
+
+    program[0] = Op::mul;
+    batch.Evaluate(&item, 1, &result);
+    EXPECT_EQ(result, 6);
+}
+
+// The random numbers depend on the seed and the index of the item only.
+TEST(BatchEvaluatorTest, Random)
+{
+    const std::vector<Op> program = Parse("random");
+    std::vector<rpn_engine::BatchEvaluator<double>::Item> items(1000, {program.data(), program.size(), nullptr, 0});
+    std::vector<double> first(items.size()), second(items.size()), single_thread(items.size());
+
+    rpn_engine::WorkStealingPool pool(4);
+    rpn_engine::BatchEvaluator<double> batch(pool);
+    batch.Evaluate(items.data(), items.size(), first.data());
+    batch.Evaluate(items.data(), items.size(), second.data());
+    EXPECT_EQ(first, second);
+    EXPECT_NE(first[0], first[1]);
+
+    // Same on the evaluator of a thread.
+    rpn_engine::WorkStealingPool single(1);
+    rpn_engine::BatchEvaluator<double> other(single);
+    other.Evaluate(items.data(), items.size(), single_thread.data());
+    EXPECT_EQ(first, single_thread);
+
+    batch.SeedRandom(1);
+    batch.Evaluate(items.data(), items.size(), second.data());
+    EXPECT_NE(first, second);
+}
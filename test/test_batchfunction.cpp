@@ -0,0 +1,102 @@
+// Test cases for the rpn_engine::BatchFunction class
+
+#include "gtest/gtest.h"
+#include "rpnengine.hpp"
+#include "testhelper.hpp"
+#include <cmath>
+#include <string>
+#include <vector>
+
+using rpn_engine::Op;
+
+// Compare the batch with the RealFunction.
+TEST(BatchFunctionTest, Evaluate)
+{
+    const char *programs[] = {
+        "",
+        "square rcl 0 mul sin 2 add",
+        "duplicate sqrt swap 3 power div pi add log",
+        "swap",                                     // The stack below x is zero.
+        "1 2 3 4 add add add",                      // x is lost.
+        "sto 1 rcl 1 rcl 1 mul rcl 0 rotate_pop", // Registers.
+        "enter 5 chs sub atan 1 enter 2 clx add",   // enter and clx.
+        "duplicate 0 x_lt_y neg",                   // Not straight line.
+    };
+    std::vector<double> x(1000), expected(1000), y(1000);
+    for (std::size_t i = 0; i < x.size(); i++)
+        x[i] = (static_cast<double>(i) - 500) / 37;
+
+    for (auto text : programs)
+    {
+        std::vector<Op> program = Parse(text);
+        rpn_engine::BatchFunction batch;
+        rpn_engine::RealFunction scalar;
+        ASSERT_TRUE(batch.Load(program.data(), program.size())) << text;
+        ASSERT_TRUE(scalar.Load(program.data(), program.size())) << text;
+        batch.SetRegister(0, 1.5);
+        scalar.SetRegister(0, 1.5);
+        EXPECT_EQ(batch.IsVectorized(), std::string(text).find("x_lt_y") == std::string::npos) << text;
+
+        batch.Evaluate(x.data(), y.data(), x.size());
+        for (std::size_t i = 0; i < x.size(); i++)
+            EXPECT_TRUE(IsSame(y[i], scalar(x[i]))) << text << " at " << x[i];
+    }
+
+    rpn_engine::BatchFunction batch;
+    std::vector<Op> program = Parse("label 1");
+    EXPECT_TRUE(batch.Load(program.data(), program.size()));
+    program = Parse("go_to 1");
+    EXPECT_FALSE(batch.Load(program.data(), program.size()));
+}
+
+// f(a, b, c) of the columns.
+TEST(BatchFunctionTest, Columns)
+{
+    const char *programs[] = {
+        "mul add",                    // c * b + a
+        "rotate_pop sub swap div",    // (a - c) / b
+        "sqrt rcl 2 power add sin",   // sin(b + sqrt(c)^r2) on top of a
+        "duplicate 0 x_lt_y neg mul", // Not straight line.
+    };
+    const std::size_t count = 3 * rpn_engine::BatchFunction::kBlockSize + 17;
+    std::vector<double> a(count), b(count), c(count), y(count);
+    for (std::size_t i = 0; i < count; i++)
+    {
+        a[i] = static_cast<double>(i % 101) / 9 - 5;
+        b[i] = static_cast<double>(i % 7) - 3;
+        c[i] = static_cast<double>(i) / 100;
+    }
+    // Stack position 0 is X.
+    const double *const columns[] = {c.data(), b.data(), a.data()};
+
+    for (auto text : programs)
+    {
+        std::vector<Op> program = Parse(text);
+        rpn_engine::BatchFunction batch;
+        rpn_engine::RealFunction scalar;
+        ASSERT_TRUE(batch.Load(program.data(), program.size())) << text;
+        ASSERT_TRUE(scalar.Load(program.data(), program.size())) << text;
+        batch.SetRegister(2, 0.5);
+        scalar.SetRegister(2, 0.5);
+
+        for (unsigned int input_count = 0; input_count <= 3; input_count++)
+        {
+            batch.Evaluate(columns, input_count, y.data(), count);
+            for (std::size_t i = 0; i < count; i++)
+            {
+                const double inputs[] = {c[i], b[i], a[i]};
+                ASSERT_TRUE(IsSame(y[i], scalar(inputs, input_count))) << text << " at " << i;
+            }
+        }
+    }
+
+    // A column is same as f(x).
+    std::vector<Op> program = Parse("mul add");
+    rpn_engine::BatchFunction batch;
+    rpn_engine::RealFunction scalar;
+    ASSERT_TRUE(batch.Load(program.data(), program.size()));
+    ASSERT_TRUE(scalar.Load(program.data(), program.size()));
+    batch.Evaluate(c.data(), y.data(), count);
+    for (std::size_t i = 0; i < count; i++)
+        EXPECT_EQ(y[i], scalar(c[i]));
+}
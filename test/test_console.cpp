@@ -221,3 +221,81 @@ TEST(Console, DelSwap)
     EXPECT_STREQ(display_text, " 00000000");
     EXPECT_EQ(decimal_point, 7);
 }
+
+TEST(Console, GetStackText)
+{
+    rpn_engine::Console c;
+    char display_text[rpn_engine::kDepthOfStack][rpn_engine::kNumberOfDigits + 1];
+    int32_t decimal_point[rpn_engine::kDepthOfStack];
+
+    c.Input(Op::num_1);
+    c.Input(Op::enter);
+    c.Input(Op::num_2);
+    c.Input(Op::enter);
+    c.Input(Op::num_3);
+    c.Input(Op::add);
+
+    c.GetStackText(rpn_engine::kDepthOfStack, display_text, decimal_point);
+    EXPECT_STREQ(display_text[0], " 50000000");
+    EXPECT_EQ(decimal_point[0], 7);
+    EXPECT_STREQ(display_text[1], " 10000000");
+    EXPECT_EQ(decimal_point[1], 7);
+    EXPECT_STREQ(display_text[2], " 00000000");
+    EXPECT_EQ(decimal_point[2], 7);
+    EXPECT_STREQ(display_text[3], " 00000000");
+    EXPECT_EQ(decimal_point[3], 7);
+
+    // During the editing, the stack top is rendered as Y.
+    c.Input(Op::num_4);
+    c.GetStackText(2, display_text, decimal_point);
+    EXPECT_STREQ(display_text[0], " 4       ");
+    EXPECT_EQ(decimal_point[0], c.kDecimalPointNotDisplayed);
+    EXPECT_STREQ(display_text[1], " 50000000");
+    EXPECT_EQ(decimal_point[1], 7);
+
+    // After enter, the edited number overwrites the stack top.
+    c.Input(Op::enter);
+    c.Input(Op::num_6);
+    c.GetStackText(2, display_text, decimal_point);
+    EXPECT_STREQ(display_text[0], " 6       ");
+    EXPECT_STREQ(display_text[1], " 40000000");
+
+    // Other registers follow the display mode.
+    c.Input(Op::hex);
+    c.GetStackText(3, display_text, decimal_point);
+    EXPECT_STREQ(display_text[0], " 00000006");
+    EXPECT_STREQ(display_text[1], " 00000004");
+    EXPECT_EQ(decimal_point[1], c.kDecimalPointNotDisplayed);
+    EXPECT_STREQ(display_text[2], " 00000005");
+}
+
+TEST(Console, Snapshot)
+{
+    rpn_engine::Console c;
+    char display_text[12];
+
+    c.Input(Op::num_2);
+    c.Input(Op::enter);
+    c.Input(Op::num_3);
+    auto snapshot = c.TakeSnapshot(); // Snapshot during editing
+
+    c.Input(Op::mul);
+    c.GetText(display_text);
+    EXPECT_STREQ(display_text, " 60000000");
+
+    // Branch from the snapshot.
+    c.RestoreSnapshot(snapshot);
+    c.GetText(display_text);
+    EXPECT_STREQ(display_text, " 3       ");
+    c.Input(Op::num_1);
+    c.Input(Op::add);
+    c.GetText(display_text);
+    EXPECT_STREQ(display_text, " 33000000");
+    EXPECT_EQ(c.GetDecimalPointPosition(), 6);
+
+    // Another branch from the same snapshot.
+    c.RestoreSnapshot(snapshot);
+    c.Input(Op::sub);
+    c.GetText(display_text);
+    EXPECT_STREQ(display_text, "-10000000");
+}
@@ -0,0 +1,174 @@
+// Test cases for the rpn_engine::DataflowEvaluator class template
+
+#include "gtest/gtest.h"
+#include "rpnengine.hpp"
+#include "testhelper.hpp"
+#include <cmath>
+#include <complex>
+#include <string>
+#include <vector>
+
+using rpn_engine::Op;
+typedef std::complex<double> Complex;
+
+static std::string Repeat(const std::string &text, int count)
+{
+    std::string result;
+    for (int i = 0; i < count; i++)
+        result += text;
+    return result;
+}
+
+// Compare with the VirtualMachine after each change of the sources.
+TEST(DataflowEvaluatorTest, Differential)
+{
+    const std::vector<Op> program = Parse("rcl 0 rcl 1 add sto 2 square swap sin mul rcl 2 add "
+                                          "rotate_pop 3 chs power sto 3 rcl 1 sqrt duplicate rotate_push div");
+    rpn_engine::DataflowEvaluator<Complex> evaluator;
+    ASSERT_TRUE(evaluator.Load(program.data(), program.size()));
+
+    Complex inputs[4] = {0, 0, 0, 0};
+    Complex registers[2] = {0, 0};
+    rpn_engine::Xoshiro256 random(1);
+    for (int trial = 0; trial < 100; trial++)
+    {
+        // Change a source.
+        Complex value(random.NextDouble() * 4 - 2, trial % 3 == 0 ? random.NextDouble() : 0);
+        unsigned int target = trial % 6;
+        if (target < 4)
+        {
+            inputs[target] = value;
+            evaluator.SetInput(target, value);
+        }
+        else
+        {
+            registers[target - 4] = value;
+            evaluator.SetRegister(target - 4, value);
+        }
+        evaluator.Update();
+
+        // Run from the beginning.
+        rpn_engine::StackStrategy<Complex> s(4);
+        rpn_engine::VirtualMachine<Complex> vm(s);
+        ASSERT_TRUE(vm.Load(program.data(), program.size()));
+        for (unsigned int i = 4; i-- > 0;)
+            s.Push(inputs[i]);
+        vm.SetRegister(0, registers[0]);
+        vm.SetRegister(1, registers[1]);
+        vm.Run(1000);
+
+        for (unsigned int i = 0; i < 4; i++)
+            EXPECT_TRUE(IsSame(evaluator.Get(i), s.Get(i))) << "trial " << trial << " position " << i;
+        for (unsigned int i = 0; i < rpn_engine::kNumberOfVmRegisters; i++)
+            EXPECT_TRUE(IsSame(evaluator.GetRegister(i), vm.GetRegister(i))) << "trial " << trial << " register " << i;
+    }
+}
+
+// Only the affected nodes are recalculated.
+TEST(DataflowEvaluatorTest, Incremental)
+{
+    // Two independent chains of 100 operations.
+    const std::vector<Op> program = Parse(Repeat("neg ", 100) + "swap " + Repeat("1 add ", 100) + "add");
+    rpn_engine::DataflowEvaluator<double> evaluator;
+    ASSERT_TRUE(evaluator.Load(program.data(), program.size()));
+
+    EXPECT_EQ(evaluator.Update(), 0u);
+    evaluator.SetInput(1, 0.5);
+    EXPECT_EQ(evaluator.Update(), 101u);
+    evaluator.SetInput(0, 0.25);
+    EXPECT_EQ(evaluator.Update(), 101u);
+    evaluator.SetInput(0, 0.25); // Not changed.
+    EXPECT_EQ(evaluator.Update(), 0u);
+
+    // Two changes are merged.
+    evaluator.SetInput(0, 1);
+    evaluator.SetInput(1, 2);
+    EXPECT_EQ(evaluator.Update(), 201u);
+
+    EXPECT_EQ(evaluator.Get(0), 1 + 102);
+
+    // Z and T are not used.
+    evaluator.SetInput(2, 3);
+    EXPECT_EQ(evaluator.Update(), 0u);
+    EXPECT_EQ(evaluator.Get(1), 3);
+}
+
+// The change stops at the node which gives the same value.
+TEST(DataflowEvaluatorTest, EarlyCutoff)
+{
+    const std::vector<Op> program = Parse("square " + Repeat("sin ", 50) + "rcl 5 mul");
+    rpn_engine::DataflowEvaluator<double> evaluator;
+    ASSERT_TRUE(evaluator.Load(program.data(), program.size()));
+
+    evaluator.SetInput(0, 2);
+    evaluator.SetRegister(5, 3);
+    EXPECT_EQ(evaluator.Update(), 52u);
+    double expected = evaluator.Get(0);
+
+    evaluator.SetInput(0, -2); // square gives same value.
+    EXPECT_EQ(evaluator.Update(), 1u);
+    EXPECT_EQ(evaluator.Get(0), expected);
+
+    evaluator.SetRegister(5, 6);
+    EXPECT_EQ(evaluator.Update(), 1u);
+    EXPECT_EQ(evaluator.Get(0), expected * 2);
+
+    // The register not used by the program.
+    evaluator.SetRegister(7, 1);
+    EXPECT_EQ(evaluator.Update(), 0u);
+    EXPECT_EQ(evaluator.GetRegister(7), 1);
+}
+
+// The early cutoff compares the bits. The sign of zero changes the result of inv.
+TEST(DataflowEvaluatorTest, SignedZero)
+{
+    const std::vector<Op> program = Parse("inv");
+    rpn_engine::DataflowEvaluator<double> evaluator;
+    ASSERT_TRUE(evaluator.Load(program.data(), program.size()));
+
+    evaluator.SetInput(0, 0.0);
+    evaluator.Update();
+    EXPECT_EQ(evaluator.Get(0), HUGE_VAL);
+
+    evaluator.SetInput(0, -0.0);
+    EXPECT_EQ(evaluator.Update(), 1u);
+    EXPECT_EQ(evaluator.Get(0), -HUGE_VAL);
+
+    // Same NaN doesn't recalculate.
+    evaluator.SetInput(0, NAN);
+    EXPECT_EQ(evaluator.Update(), 1u);
+    evaluator.SetInput(0, NAN);
+    EXPECT_EQ(evaluator.Update(), 0u);
+}
+
+TEST(DataflowEvaluatorTest, Load)
+{
+    rpn_engine::DataflowEvaluator<double> evaluator;
+    evaluator.SetInput(0, 5);
+    evaluator.SetRegister(1, 7);
+
+    // The sources are kept.
+    std::vector<Op> program = Parse("rcl 1 add");
+    ASSERT_TRUE(evaluator.Load(program.data(), program.size()));
+    EXPECT_EQ(evaluator.Get(0), 12);
+
+    // Jump is not supported.
+    program = Parse("label 1 rcl 1 go_to 1");
+    EXPECT_FALSE(evaluator.Load(program.data(), program.size()));
+    EXPECT_EQ(evaluator.GetErrorPosition(), 0u);
+    EXPECT_EQ(evaluator.Get(0), 5);
+
+    // Register operand is needed.
+    program = Parse("2 sto");
+    EXPECT_FALSE(evaluator.Load(program.data(), program.size()));
+    EXPECT_EQ(evaluator.GetErrorPosition(), 1u);
+
+    // The ExpressionGraph rejects the registers by default.
+    rpn_engine::ExpressionGraph graph;
+    program = Parse("rcl 1");
+    EXPECT_FALSE(graph.Build(program.data(), program.size()));
+    EXPECT_TRUE(graph.Build(program.data(), program.size(), true));
+    EXPECT_EQ(graph.GetNode(graph.GetStackNode(0)).kind, rpn_engine::ExpressionGraph::NodeKind::recall);
+    EXPECT_EQ(graph.GetRegisterNode(1), graph.GetStackNode(0));
+    EXPECT_EQ(graph.GetRegisterNode(2), rpn_engine::ExpressionGraph::kNoNode);
+}
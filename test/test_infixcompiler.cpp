@@ -0,0 +1,211 @@
+// Test cases for the rpn_engine::InfixCompiler class
+
+#include "gtest/gtest.h"
+#include "rpnengine.hpp"
+#include <cmath>
+#include <complex>
+#include <vector>
+
+using rpn_engine::Op;
+typedef rpn_engine::InfixCompiler::Status Status;
+typedef std::complex<double> Complex;
+
+// Run the program with the registers.
+static Complex RunProgram(const std::vector<Op> &program, const Complex registers[], unsigned int count)
+{
+    rpn_engine::StackStrategy<Complex> s(4);
+    rpn_engine::VirtualMachine<Complex> vm(s);
+    EXPECT_TRUE(vm.Load(program.data(), program.size()));
+    for (unsigned int i = 0; i < count; i++)
+        vm.SetRegister(i, registers[i]);
+    vm.Run(10000);
+    return s.Get(0);
+}
+
+static void ExpectProgram(const std::vector<Op> &program, const std::vector<Op> &expected)
+{
+    ASSERT_EQ(program.size(), expected.size());
+    for (std::size_t i = 0; i < program.size(); i++)
+        EXPECT_EQ(program[i], expected[i]) << rpn_engine::GetOpName(program[i]) << " at " << i;
+}
+
+TEST(InfixCompilerTest, Evaluate)
+{
+    rpn_engine::InfixCompiler compiler;
+    ASSERT_TRUE(compiler.DefineVariable("x", 0));
+    ASSERT_TRUE(compiler.DefineVariable("y", 1));
+    const Complex registers[] = {Complex(1.5), Complex(-2)};
+    const double x = 1.5, y = -2;
+
+    const struct
+    {
+        const char *expression;
+        double expected;
+    } cases[] = {
+        {"x*x + 3*y", x * x + 3 * y},
+        {"x - y - 1", x - y - 1},
+        {"x / y / 4", x / y / 4},
+        {"2^3^2", 512},
+        {"-x^2", -(x * x)},
+        {"2*-x", -2 * x},
+        {"sqrt(x*x + y*y)", std::sqrt(x * x + y * y)},
+        {"pow(x, 2) + sin(y) * cos(x) - atan(y/x)", std::pow(x, 2) + std::sin(y) * std::cos(x) - std::atan(y / x)},
+        {"exp(log(x)) + log10(1000) * tan(pi/4)", x + 3},
+        {"conj(x) + ((x))", 2 * x},
+        {"1/3 + 2", 1.0 / 3 + 2},
+    };
+
+    for (auto &c : cases)
+    {
+        std::vector<Op> program;
+        ASSERT_EQ(compiler.Compile(c.expression, program), Status::ok) << c.expression;
+        Complex result = RunProgram(program, registers, 2);
+        EXPECT_NEAR(result.real(), c.expected, 1e-12) << c.expression;
+        EXPECT_NEAR(result.imag(), 0, 1e-12) << c.expression;
+    }
+}
+
+TEST(InfixCompilerTest, Complex)
+{
+    rpn_engine::InfixCompiler compiler;
+    std::vector<Op> program;
+
+    // sqrt(-4) is not folded because it is complex.
+    ASSERT_EQ(compiler.Compile("sqrt(-4)", program), Status::ok);
+    ExpectProgram(program, {Op::num_4, Op::chs, Op::sqrt});
+    Complex result = RunProgram(program, nullptr, 0);
+    EXPECT_NEAR(result.real(), 0, 1e-12);
+    EXPECT_NEAR(result.imag(), 2, 1e-12);
+
+    program.clear();
+    ASSERT_EQ(compiler.Compile("conj(complex(1, z)) * 2", program), Status::ok);
+    const Complex registers[] = {Complex(3)};
+    result = RunProgram(program, registers, 1);
+    EXPECT_NEAR(result.real(), 2, 1e-12);
+    EXPECT_NEAR(result.imag(), -6, 1e-12);
+}
+
+TEST(InfixCompilerTest, Folding)
+{
+    rpn_engine::InfixCompiler compiler;
+    std::vector<Op> program;
+
+    ASSERT_EQ(compiler.Compile("2*3 + x", program), Status::ok);
+    ExpectProgram(program, {Op::num_6, Op::rcl, Op::num_0, Op::add});
+
+    // 1/3 can't be entered by keys. The enter separates the numbers.
+    program.clear();
+    ASSERT_EQ(compiler.Compile("1/3", program), Status::ok);
+    ExpectProgram(program, {Op::num_1, Op::enter, Op::num_3, Op::div});
+
+    program.clear();
+    ASSERT_EQ(compiler.Compile("(1.5e3 - 250) * -2 / 1e-3", program), Status::ok);
+    ExpectProgram(program, {Op::num_2, Op::num_5, Op::num_0, Op::num_0, Op::num_0, Op::num_0, Op::num_0, Op::chs});
+
+    program.clear();
+    ASSERT_EQ(compiler.Compile("pi", program), Status::ok);
+    ExpectProgram(program, {Op::pi});
+
+    // The complex power of the Console doesn't give the exact integer. The folding must not
+    // hide the difference.
+    const char *const powers[] = {"(0-2)^3", "3^5", "7^2", "10^-2"};
+    for (auto expression : powers)
+    {
+        program.clear();
+        ASSERT_EQ(compiler.Compile(expression, program), Status::ok) << expression;
+        EXPECT_EQ(program.back(), Op::power) << expression;
+    }
+    ExpectProgram(program, {Op::num_1, Op::num_0, Op::enter, Op::num_2, Op::chs, Op::power});
+
+    // Exact in complex too.
+    program.clear();
+    ASSERT_EQ(compiler.Compile("2^10", program), Status::ok);
+    ExpectProgram(program, {Op::num_1, Op::num_0, Op::num_2, Op::num_4});
+}
+
+TEST(InfixCompilerTest, StackDepth)
+{
+    rpn_engine::InfixCompiler compiler;
+    std::vector<Op> program;
+
+    // The deeper operand first, then swap.
+    ASSERT_EQ(compiler.Compile("1 - x*y", program), Status::ok);
+    ExpectProgram(program, {Op::rcl, Op::num_0, Op::rcl, Op::num_1, Op::mul, Op::num_1, Op::swap, Op::sub});
+    EXPECT_EQ(compiler.GetRequiredDepth(), 2u);
+
+    // The left to right order needs 4 levels. The optimal order needs 2.
+    program.clear();
+    ASSERT_EQ(compiler.Compile("x + (y + (x + y*x))", program), Status::ok);
+    EXPECT_EQ(compiler.GetRequiredDepth(), 2u);
+
+    // 8 leaves in a balanced tree needs 4.
+    program.clear();
+    ASSERT_EQ(compiler.Compile("((a-b)/(c-d)) - ((e-f)/(g-h))", program), Status::ok);
+    EXPECT_EQ(compiler.GetRequiredDepth(), 4u);
+    const Complex registers[] = {1, 2, 3, 5, 8, 13, 21, 34, 55, 89};
+    // a..h are the registers 2..9
+    EXPECT_NEAR(RunProgram(program, registers, 10).real(), (3.0 - 5) / (8 - 13) - (21.0 - 34) / (55 - 89), 1e-12);
+
+    // 16 leaves needs 5. The program is generated but reported.
+    rpn_engine::InfixCompiler compiler16;
+    program.clear();
+    EXPECT_EQ(compiler16.Compile("((a-b)/(c-d) - (e-f)/(g-h)) * ((i-j)/(k-l) - (m-n)/(o-p))", program), Status::stack_overflow);
+    EXPECT_EQ(compiler16.GetRequiredDepth(), 5u);
+    EXPECT_FALSE(program.empty());
+}
+
+TEST(InfixCompilerTest, Error)
+{
+    rpn_engine::InfixCompiler compiler;
+    std::vector<Op> program;
+
+    EXPECT_EQ(compiler.Compile("sin(", program), Status::syntax_error);
+    EXPECT_EQ(compiler.GetErrorPosition(), 4u);
+    EXPECT_EQ(compiler.Compile("2 3", program), Status::syntax_error);
+    EXPECT_EQ(compiler.GetErrorPosition(), 2u);
+    EXPECT_EQ(compiler.Compile("(1 + 2", program), Status::syntax_error);
+    EXPECT_EQ(compiler.Compile("1 + * 2", program), Status::syntax_error);
+    EXPECT_EQ(compiler.GetErrorPosition(), 4u);
+    EXPECT_EQ(compiler.Compile("foo(1)", program), Status::unknown_function);
+    EXPECT_EQ(compiler.Compile("pow(1)", program), Status::unknown_function);
+    EXPECT_EQ(compiler.Compile("x + 1.23456789", program), Status::number_not_enterable);
+    EXPECT_EQ(compiler.GetErrorPosition(), 4u);
+    EXPECT_TRUE(program.empty());
+
+    // The failed compile doesn't keep the registers of its variables.
+    EXPECT_EQ(compiler.GetVariableRegister("x"), -1);
+    EXPECT_EQ(compiler.Compile("a + b +", program), Status::syntax_error);
+    EXPECT_EQ(compiler.GetVariableRegister("a"), -1);
+    EXPECT_EQ(compiler.Compile("c", program), Status::ok);
+    EXPECT_EQ(compiler.GetVariableRegister("c"), 0);
+    program.clear();
+
+    // 16 registers are available.
+    rpn_engine::InfixCompiler compiler16;
+    EXPECT_EQ(compiler16.Compile("a+b+c+d+e+f+g+h+i+j+k+l+m+n+o+p", program), Status::ok);
+    EXPECT_EQ(compiler16.GetVariableRegister("p"), 15);
+    EXPECT_EQ(compiler16.Compile("q", program), Status::too_many_variables);
+    EXPECT_FALSE(compiler16.DefineVariable("r", 3));
+}
+
+TEST(InfixCompilerTest, ValueToKeys)
+{
+    const double values[] = {0, 1, -1, 42, 0.5, -0.00125, 12345678, 6.02e23, 1e99, 1e-99, 0.1, 123.456};
+    for (double value : values)
+    {
+        std::vector<Op> keys;
+        ASSERT_TRUE(rpn_engine::InfixCompiler::ValueToKeys(value, keys)) << value;
+        EXPECT_EQ(rpn_engine::ParseNumber(keys.data(), keys.size()), value);
+    }
+
+    std::vector<Op> keys;
+    EXPECT_FALSE(rpn_engine::InfixCompiler::ValueToKeys(1.0 / 3, keys));
+    EXPECT_FALSE(rpn_engine::InfixCompiler::ValueToKeys(123456789, keys));
+    EXPECT_FALSE(rpn_engine::InfixCompiler::ValueToKeys(1e100, keys));
+    EXPECT_FALSE(rpn_engine::InfixCompiler::ValueToKeys(NAN, keys));
+    EXPECT_TRUE(keys.empty());
+
+    // Short form
+    ASSERT_TRUE(rpn_engine::InfixCompiler::ValueToKeys(250, keys));
+    ExpectProgram(keys, {Op::num_2, Op::num_5, Op::num_0});
+}
@@ -0,0 +1,82 @@
+// Test cases for the rpn_engine::Integrator class
+
+#include "gtest/gtest.h"
+#include "rpnengine.hpp"
+#include "testhelper.hpp"
+#include <cmath>
+#include <string>
+#include <vector>
+
+using rpn_engine::Op;
+typedef rpn_engine::Integrator::Status Status;
+
+TEST(IntegratorTest, Integrate)
+{
+    rpn_engine::WorkStealingPool pool(2);
+    rpn_engine::Integrator integrator(pool);
+    double result, error;
+
+    std::vector<Op> program = Parse("sin");
+    ASSERT_TRUE(integrator.Load(program.data(), program.size()));
+    EXPECT_EQ(integrator.Integrate(0, rpn_engine::pi, result, error), Status::converged);
+    EXPECT_NEAR(result, 2, 1e-12);
+    EXPECT_LE(error, 1e-10);
+    EXPECT_EQ(integrator.GetEvaluationCount(), 15u); // Smooth enough for one interval.
+
+    // Reversed
+    EXPECT_EQ(integrator.Integrate(rpn_engine::pi, 0, result, error), Status::converged);
+    EXPECT_NEAR(result, -2, 1e-12);
+
+    // The singular derivative at 0 needs the adaptive bisection.
+    program = Parse("sqrt");
+    ASSERT_TRUE(integrator.Load(program.data(), program.size()));
+    EXPECT_EQ(integrator.Integrate(0, 1, result, error), Status::converged);
+    EXPECT_NEAR(result, 2.0 / 3, 1e-10);
+    EXPECT_GT(integrator.GetEvaluationCount(), 15u);
+
+    // Parameter in the register
+    program = Parse("rcl 0 power");
+    ASSERT_TRUE(integrator.Load(program.data(), program.size()));
+    integrator.SetRegister(0, 3);
+    EXPECT_EQ(integrator.Integrate(0, 2, result, error), Status::converged);
+    EXPECT_NEAR(result, 4, 1e-12);
+
+    // Not straight line : |x| by the conditional skip.
+    program = Parse("0 x_le_y go_to 1 swap neg swap label 1 rotate_pop");
+    ASSERT_TRUE(integrator.Load(program.data(), program.size()));
+    EXPECT_EQ(integrator.Integrate(-1, 3, result, error), Status::converged);
+    EXPECT_NEAR(result, 5, 1e-10);
+
+    // 1/x at x = 0.
+    program = Parse("inv");
+    ASSERT_TRUE(integrator.Load(program.data(), program.size()));
+    EXPECT_EQ(integrator.Integrate(-1, 1, result, error), Status::not_finite);
+
+    // Budget
+    program = Parse("sqrt");
+    ASSERT_TRUE(integrator.Load(program.data(), program.size()));
+    integrator.SetEvaluationBudget(100);
+    EXPECT_EQ(integrator.Integrate(0, 1, result, error), Status::evaluation_budget);
+    EXPECT_LE(integrator.GetEvaluationCount(), 100u);
+    EXPECT_NEAR(result, 2.0 / 3, 1e-3);
+}
+
+// The result doesn't depend on the number of the threads.
+TEST(IntegratorTest, Threads)
+{
+    std::vector<Op> program = Parse("duplicate 10 mul sin square swap sqrt mul");
+    double expected = 0;
+    for (unsigned int threads = 1; threads <= 4; threads++)
+    {
+        rpn_engine::WorkStealingPool pool(threads);
+        rpn_engine::Integrator integrator(pool);
+        integrator.SetTolerance(1e-13, 1e-13);
+        ASSERT_TRUE(integrator.Load(program.data(), program.size()));
+        double result, error;
+        EXPECT_EQ(integrator.Integrate(0, 10, result, error), Status::converged);
+        if (threads == 1)
+            expected = result;
+        EXPECT_EQ(result, expected);
+        EXPECT_NEAR(result, 10.6133730111, 1e-8);
+    }
+}
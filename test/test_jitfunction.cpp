@@ -0,0 +1,116 @@
+// Test cases for the rpn_engine::JitFunction class
+
+#include "gtest/gtest.h"
+#include "rpnengine.hpp"
+#include "testhelper.hpp"
+#include <cmath>
+#include <vector>
+
+using rpn_engine::Op;
+
+// Run the program by the interpreter with X = x, Y = y and the other registers 0.
+static double Interpret(const std::vector<Op> &program, double x, double y)
+{
+    rpn_engine::StackStrategy<double> s(4);
+    rpn_engine::VirtualMachine<double> vm(s);
+    s.Push(y);
+    s.Push(x);
+    EXPECT_TRUE(vm.Load(program.data(), program.size()));
+    vm.Run(100000);
+    return s.Get(0);
+}
+
+static const double kSamples[] = {0, 1, -1, 0.5, -0.25, 3, -7.5, 1e-3, 123.456, -1e10};
+
+// Compare the function with the interpreter bit by bit.
+static void ExpectSameAsInterpreter(const char *text, bool is_native)
+{
+    SCOPED_TRACE(text);
+    std::vector<Op> program = Parse(text);
+    rpn_engine::JitFunction f;
+    ASSERT_TRUE(f.Compile(program.data(), program.size()));
+#ifdef RPN_ENGINE_JIT_AVAILABLE
+    EXPECT_EQ(f.IsNative(), is_native);
+#else
+    (void)is_native;
+    EXPECT_FALSE(f.IsNative());
+#endif
+
+    for (double x : kSamples)
+        for (double y : kSamples)
+        {
+            double expected = Interpret(program, x, y);
+            double actual = f(x, y);
+            if (std::isnan(expected))
+                EXPECT_TRUE(std::isnan(actual)) << "x=" << x << " y=" << y;
+            else
+                EXPECT_EQ(expected, actual) << "x=" << x << " y=" << y;
+        }
+}
+
+TEST(JitFunctionTest, Arithmetic)
+{
+    ExpectSameAsInterpreter("add", true);
+    ExpectSameAsInterpreter("sub", true);
+    ExpectSameAsInterpreter("swap sub", true);
+    ExpectSameAsInterpreter("mul 2.5 div", true);
+    ExpectSameAsInterpreter("div inv neg", true);
+    ExpectSameAsInterpreter("square swap square add sqrt", true);
+    ExpectSameAsInterpreter("duplicate mul duplicate add", true);
+    ExpectSameAsInterpreter("chs pi add 1e-3 mul", true);
+}
+
+TEST(JitFunctionTest, Stack)
+{
+    ExpectSameAsInterpreter("", true);
+    ExpectSameAsInterpreter("swap", true);
+    ExpectSameAsInterpreter("rotate_pop", true);
+    ExpectSameAsInterpreter("rotate_push", true);
+    ExpectSameAsInterpreter("enter 3 mul pi add rotate_pop rotate_push swap", true);
+    ExpectSameAsInterpreter("1.5 2.5e-1 enter 1 del 7 add mul clx 42 rotate_push rotate_pop add", true);
+    // All four registers are live across the operations.
+    ExpectSameAsInterpreter("1 2 rotate_pop rotate_pop add rotate_push mul rotate_push div add", true);
+}
+
+TEST(JitFunctionTest, Transcendental)
+{
+    ExpectSameAsInterpreter("sin swap cos div atan exp log", true);
+    ExpectSameAsInterpreter("power", true);
+    ExpectSameAsInterpreter("duplicate power", true);
+    ExpectSameAsInterpreter("power10 log10 swap asin acos tan add", true);
+    // Live values across the call are saved.
+    ExpectSameAsInterpreter("1 2 3 sin add mul exp swap sqrt rotate_push cos add add", true);
+    ExpectSameAsInterpreter("duplicate sin swap duplicate cos swap 2 power add add sub", true);
+}
+
+TEST(JitFunctionTest, Fallback)
+{
+    // Loop is not a straight line program. The interpreter runs it.
+    ExpectSameAsInterpreter("sto 0 0 sto 1 10 sto 2 "
+                            "label 1 rcl 1 rcl 0 add sto 1 rcl 2 1 sub sto 2 0 x_lt_y go_to 1 "
+                            "rcl 1",
+                            false);
+    ExpectSameAsInterpreter("1 swap bit_add", false);
+
+    // Undefined label can't be evaluated.
+    std::vector<Op> program = Parse("go_to 3");
+    rpn_engine::JitFunction f;
+    EXPECT_FALSE(f.Compile(program.data(), program.size()));
+    EXPECT_FALSE(f.IsNative());
+    EXPECT_EQ(f.GetCodeSize(), 0u);
+}
+
+TEST(JitFunctionTest, Recompile)
+{
+    rpn_engine::JitFunction f;
+    std::vector<Op> program = Parse("add");
+    ASSERT_TRUE(f.Compile(program.data(), program.size()));
+    EXPECT_EQ(f(2, 3), 5);
+
+    program = Parse("sub");
+    ASSERT_TRUE(f.Compile(program.data(), program.size()));
+    EXPECT_EQ(f(2, 3), 1);
+#ifdef RPN_ENGINE_JIT_AVAILABLE
+    EXPECT_GT(f.GetCodeSize(), 0u);
+#endif
+}
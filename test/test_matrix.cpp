@@ -0,0 +1,218 @@
+// Test cases for the rpn_engine::MatrixElement as the element of rpn_engine::StackStrategy
+
+#include "gtest/gtest.h"
+#include "rpnengine.hpp"
+#include <cmath>
+#include <complex>
+
+using rpn_engine::MatrixElement;
+using rpn_engine::Op;
+typedef rpn_engine::StackStrategy<MatrixElement> MatrixStack;
+
+TEST(MatrixTest, Add)
+{
+    MatrixStack s(4);
+    const double a[] = {1, 2, 3};
+    const double b[] = {10, 20, 30};
+
+    s.Push(MatrixElement::Vector(3, a));
+    s.Push(MatrixElement::Vector(3, b));
+    s.Operation(Op::add);
+
+    auto x = s.Get(0);
+    EXPECT_EQ(x.Rows(), 3u);
+    EXPECT_EQ(x.Cols(), 1u);
+    EXPECT_DOUBLE_EQ(x.Get(0).real(), 11);
+    EXPECT_DOUBLE_EQ(x.Get(1).real(), 22);
+    EXPECT_DOUBLE_EQ(x.Get(2).real(), 33);
+
+    // Scalar is added to all elements.
+    s.Push(std::complex<double>(1, 1));
+    s.Operation(Op::sub);
+    x = s.Get(0);
+    EXPECT_EQ(x.Rows(), 3u);
+    EXPECT_EQ(x.Get(0), std::complex<double>(10, -1));
+    EXPECT_EQ(x.Get(2), std::complex<double>(32, -1));
+
+    s.Operation(Op::neg);
+    EXPECT_EQ(s.Get(0).Get(1), std::complex<double>(-21, 1));
+}
+
+TEST(MatrixTest, MatrixVectorProduct)
+{
+    MatrixStack s(4);
+    // Rotation by 90 degree around z axis.
+    const double rz[] = {0, -1, 0,
+                         1, 0, 0,
+                         0, 0, 1};
+    const double v[] = {1, 2, 3};
+
+    s.Push(MatrixElement::Matrix(3, 3, rz));
+    s.Push(MatrixElement::Vector(3, v));
+    s.Operation(Op::mul);
+
+    auto x = s.Get(0);
+    EXPECT_EQ(x.Rows(), 3u);
+    EXPECT_EQ(x.Cols(), 1u);
+    EXPECT_DOUBLE_EQ(x.Get(0).real(), -2);
+    EXPECT_DOUBLE_EQ(x.Get(1).real(), 1);
+    EXPECT_DOUBLE_EQ(x.Get(2).real(), 3);
+
+    // Dot product of two vectors.
+    s.Push(MatrixElement::Vector(3, v));
+    s.Operation(Op::mul);
+    x = s.Get(0);
+    EXPECT_TRUE(x.IsScalar());
+    EXPECT_DOUBLE_EQ(x.real(), 9);
+
+    // The complex dot product is bilinear. Not conjugated.
+    const std::complex<double> c[] = {std::complex<double>(0, 1), std::complex<double>(1, 1)};
+    s.Push(MatrixElement::Vector(2, c));
+    s.Push(MatrixElement::Vector(2, c));
+    s.Operation(Op::mul);
+    x = s.Get(0);
+    EXPECT_DOUBLE_EQ(x.real(), -1);
+    EXPECT_DOUBLE_EQ(x.imag(), 2);
+}
+
+TEST(MatrixTest, Inverse)
+{
+    MatrixStack s(4);
+    const double a[] = {2, 1, 1,
+                        1, 3, 2,
+                        1, 0, 0};
+    auto m = MatrixElement::Matrix(3, 3, a);
+
+    s.Push(m);
+    s.Operation(Op::inv);
+    s.Push(m);
+    s.Operation(Op::mul);
+
+    // inv(A) * A = I
+    auto x = s.Get(0);
+    for (unsigned int i = 0; i < 3; i++)
+        for (unsigned int j = 0; j < 3; j++)
+        {
+            EXPECT_NEAR(x.Get(i, j).real(), i == j ? 1.0 : 0.0, 1e-14);
+            EXPECT_NEAR(x.Get(i, j).imag(), 0.0, 1e-14);
+        }
+}
+
+TEST(MatrixTest, Solve)
+{
+    MatrixStack s(4);
+    const std::complex<double> a[] = {std::complex<double>(1, 1), 2,
+                                      3, std::complex<double>(0, -1)};
+    const std::complex<double> b[] = {std::complex<double>(4, 2), std::complex<double>(3, 1)};
+
+    // Solve A x = b as inv(A) * b.
+    s.Push(MatrixElement::Matrix(2, 2, a));
+    s.Operation(Op::inv);
+    s.Push(MatrixElement::Vector(2, b));
+    s.Operation(Op::mul);
+    auto x = s.Get(0);
+
+    // The expected solution is (1+i, 2).
+    EXPECT_NEAR(x.Get(0).real(), 1.0, 1e-14);
+    EXPECT_NEAR(x.Get(0).imag(), 1.0, 1e-14);
+    EXPECT_NEAR(x.Get(1).real(), 2.0, 1e-14);
+    EXPECT_NEAR(x.Get(1).imag(), 0.0, 1e-14);
+}
+
+TEST(MatrixTest, Divide)
+{
+    MatrixStack s(4);
+    const double a[] = {4, 0,
+                        0, 2};
+    const double v[] = {8, 8};
+
+    // Y / X = Y * inv(X) for row vector Y.
+    s.Push(MatrixElement::Matrix(1, 2, v));
+    s.Push(MatrixElement::Matrix(2, 2, a));
+    s.Operation(Op::div);
+    auto x = s.Get(0);
+    EXPECT_EQ(x.Rows(), 1u);
+    EXPECT_EQ(x.Cols(), 2u);
+    EXPECT_DOUBLE_EQ(x.Get(0, 0).real(), 2);
+    EXPECT_DOUBLE_EQ(x.Get(0, 1).real(), 4);
+
+    // Element wise division by scalar.
+    s.Push(2);
+    s.Operation(Op::div);
+    x = s.Get(0);
+    EXPECT_DOUBLE_EQ(x.Get(0, 0).real(), 1);
+    EXPECT_DOUBLE_EQ(x.Get(0, 1).real(), 2);
+}
+
+TEST(MatrixTest, InvalidShape)
+{
+    MatrixStack s(4);
+    const double a[] = {1, 2};
+    const double b[] = {1, 2, 3};
+    const double singular[] = {1, 2,
+                               2, 4};
+
+    // Shape mismatch
+    s.Push(MatrixElement::Vector(2, a));
+    s.Push(MatrixElement::Vector(3, b));
+    s.Operation(Op::add);
+    EXPECT_TRUE(s.Get(0).IsScalar());
+    EXPECT_TRUE(std::isnan(s.Get(0).real()));
+
+    // Singular matrix
+    s.Push(MatrixElement::Matrix(2, 2, singular));
+    s.Operation(Op::inv);
+    EXPECT_EQ(s.Get(0).Rows(), 2u);
+    EXPECT_TRUE(std::isnan(s.Get(0).Get(1, 1).real()));
+
+    // Nearly singular. The pivot is lost in the rounding error.
+    const double nearly_singular[] = {1, 2,
+                                      1, 2 + 4e-16};
+    s.Push(MatrixElement::Matrix(2, 2, nearly_singular));
+    s.Operation(Op::inv);
+    EXPECT_TRUE(std::isnan(s.Get(0).Get(0, 0).real()));
+
+    // The tolerance is relative. The small but regular matrix is inverted.
+    const double small[] = {2e-200, 0,
+                            0, 4e-200};
+    s.Push(MatrixElement::Matrix(2, 2, small));
+    s.Operation(Op::inv);
+    EXPECT_DOUBLE_EQ(s.Get(0).Get(0, 0).real(), 0.5e200);
+    EXPECT_DOUBLE_EQ(s.Get(0).Get(1, 1).real(), 0.25e200);
+
+    // Complex specific operation on vector.
+    s.Push(MatrixElement::Vector(2, a));
+    s.Operation(Op::to_polar);
+    EXPECT_TRUE(std::isnan(s.Get(0).real()));
+}
+
+TEST(MatrixTest, Scalar)
+{
+    MatrixStack s(4);
+
+    // Scalar works as complex number.
+    s.Push(-4);
+    s.Operation(Op::sqrt);
+    EXPECT_DOUBLE_EQ(s.Get(0).real(), 0);
+    EXPECT_DOUBLE_EQ(s.Get(0).imag(), 2);
+
+    s.Push(3);
+    s.Operation(Op::complex);
+    EXPECT_DOUBLE_EQ(s.Get(0).real(), 0);
+    EXPECT_DOUBLE_EQ(s.Get(0).imag(), 3);
+
+    s.Operation(Op::to_polar);
+    EXPECT_DOUBLE_EQ(s.Get(0).real(), 3);
+    EXPECT_DOUBLE_EQ(s.Get(0).imag(), rpn_engine::pi / 2);
+
+    s.Operation(Op::pi);
+    s.Operation(Op::cos);
+    EXPECT_DOUBLE_EQ(s.Get(0).real(), -1);
+
+    // Transcendental function is element wise.
+    const double v[] = {0, 1};
+    s.Push(MatrixElement::Vector(2, v));
+    s.Operation(Op::exp);
+    EXPECT_DOUBLE_EQ(s.Get(0).Get(0).real(), 1);
+    EXPECT_DOUBLE_EQ(s.Get(0).Get(1).real(), std::exp(1.0));
+}
@@ -0,0 +1,99 @@
+// Test cases for the random operation and the rpn_engine::MonteCarlo class
+
+#include "gtest/gtest.h"
+#include "rpnengine.hpp"
+#include <cmath>
+
+using rpn_engine::Op;
+typedef rpn_engine::StackStrategy<double> DoubleStack;
+
+TEST(RandomTest, Xoshiro256)
+{
+    rpn_engine::Xoshiro256 a(1), b(1), c(1, 1);
+
+    // Same seed and stream gives the same sequence.
+    for (int i = 0; i < 100; i++)
+        EXPECT_EQ(a.Next(), b.Next());
+
+    // Different stream gives the different sequence.
+    int same = 0;
+    for (int i = 0; i < 100; i++)
+        same += a.Next() == c.Next();
+    EXPECT_EQ(same, 0);
+
+    // Range of the double
+    for (int i = 0; i < 10000; i++)
+    {
+        double r = a.NextDouble();
+        EXPECT_GE(r, 0.0);
+        EXPECT_LT(r, 1.0);
+    }
+}
+
+TEST(RandomTest, Operation)
+{
+    DoubleStack s(4), t(4);
+
+    s.SeedRandom(42);
+    t.SeedRandom(42);
+    s.Operation(Op::random);
+    t.Operation(Op::random);
+    EXPECT_EQ(s.Get(0), t.Get(0));
+    EXPECT_GE(s.Get(0), 0.0);
+    EXPECT_LT(s.Get(0), 1.0);
+
+    // Pushed as a new value
+    s.Operation(Op::random);
+    EXPECT_NE(s.Get(0), s.Get(1));
+
+    // Clear the stack
+    s.Clear();
+    EXPECT_EQ(s.Get(0), 0);
+    EXPECT_EQ(s.Get(1), 0);
+}
+
+TEST(MonteCarloTest, Uniform)
+{
+    // Sum of two uniform random numbers : mean 1, variance 1/6
+    const Op program[] = {Op::random, Op::random, Op::add};
+    rpn_engine::MonteCarlo mc(program, 3);
+
+    auto result = mc.Run(100000, 1, 2);
+    EXPECT_EQ(result.Count(), 100000u);
+    EXPECT_NEAR(result.MeanX(), 1.0, 0.01);
+    EXPECT_NEAR(result.VarianceX(), 1.0 / 6, 0.01);
+    EXPECT_EQ(mc.GetStatus(), 0u);
+}
+
+TEST(MonteCarloTest, Reproducible)
+{
+    // 10 + 2 * random
+    const Op program[] = {Op::random, Op::mul, Op::add};
+    const double initial[] = {10, 2};
+    rpn_engine::MonteCarlo mc(program, 3);
+    mc.SetInitialStack(initial, 2);
+
+    // The result doesn't depend on the number of threads.
+    auto single = mc.Run(50000, 7, 1);
+    auto multi = mc.Run(50000, 7, 4);
+    EXPECT_EQ(single.Count(), multi.Count());
+    EXPECT_EQ(single.MeanX(), multi.MeanX());
+    EXPECT_EQ(single.VarianceX(), multi.VarianceX());
+    EXPECT_NEAR(single.MeanX(), 11.0, 0.02);
+
+    // Different seed gives different result.
+    auto other = mc.Run(50000, 8, 4);
+    EXPECT_NE(single.MeanX(), other.MeanX());
+}
+
+TEST(MonteCarloTest, Status)
+{
+    // log(random - 0.5) is NaN in half of the trials.
+    const Op program[] = {Op::random, Op::sub, Op::log};
+    const double initial[] = {0.5};
+    rpn_engine::MonteCarlo mc(program, 3);
+    mc.SetInitialStack(initial, 1);
+
+    mc.Run(1000, 3);
+    EXPECT_NE(mc.GetStatus() & rpn_engine::kFpInvalid, 0u);
+}
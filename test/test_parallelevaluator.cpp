@@ -0,0 +1,123 @@
+// Test cases for the rpn_engine::ParallelEvaluator class template
+
+#include "gtest/gtest.h"
+#include "rpnengine.hpp"
+#include "testhelper.hpp"
+#include <cmath>
+#include <complex>
+#include <string>
+#include <vector>
+
+using rpn_engine::Op;
+typedef std::complex<double> Complex;
+
+// Run the program serially and in parallel. Then compare the stacks.
+template <class Element>
+static void ExpectSameAsSerial(rpn_engine::ParallelEvaluator<Element> &evaluator, const std::vector<Op> &program, const Element inputs[4])
+{
+    rpn_engine::StackStrategy<Element> serial(4), parallel(4);
+    for (unsigned int i = 4; i-- > 0;)
+    {
+        serial.Push(inputs[i]);
+        parallel.Push(inputs[i]);
+    }
+    rpn_engine::VirtualMachine<Element> vm(serial);
+    ASSERT_TRUE(vm.Load(program.data(), program.size()));
+    vm.Run(100000);
+
+    evaluator.Run(parallel);
+    for (unsigned int i = 0; i < 4; i++)
+        EXPECT_TRUE(IsSame(parallel.Get(i), serial.Get(i))) << "position " << i;
+}
+
+// Two independent power chains multiplied.
+TEST(ParallelEvaluatorTest, TwoChains)
+{
+    std::string chain;
+    for (int i = 0; i < 30; i++)
+        chain += "1.01 power 0.3 add sqrt ";
+    const std::vector<Op> program = Parse(chain + "swap " + chain + "mul");
+    const Complex inputs[4] = {Complex(1.5, 0.5), Complex(-0.5, 2), Complex(3), Complex(4)};
+
+    rpn_engine::WorkStealingPool pool(4);
+    rpn_engine::ParallelEvaluator<Complex> evaluator(pool);
+    ASSERT_TRUE(evaluator.Load(program.data(), program.size()));
+    EXPECT_EQ(evaluator.GetTaskCount(), 3u);
+    EXPECT_EQ(evaluator.GetCost(), 2 * 30 * (80 + 1 + 8) * 4 + 2 * 4);
+
+    // Parallel and serial.
+    for (double threshold : {0.0, 1e9})
+    {
+        evaluator.SetThreshold(threshold);
+        for (int repeat = 0; repeat < 10; repeat++)
+            ExpectSameAsSerial(evaluator, program, inputs);
+    }
+}
+
+// Random programs on the different number of threads.
+TEST(ParallelEvaluatorTest, Random)
+{
+    const Op operations[] = {Op::add, Op::sub, Op::mul, Op::div, Op::power, Op::neg, Op::inv, Op::sqrt,
+                             Op::square, Op::exp, Op::log, Op::sin, Op::cos, Op::atan,
+                             Op::duplicate, Op::swap, Op::rotate_pop, Op::rotate_push, Op::enter, Op::pi};
+    const unsigned int kinds = sizeof(operations) / sizeof(operations[0]);
+    const double inputs[4] = {0.5, 1.25, -2, 3};
+
+    rpn_engine::Xoshiro256 random(7);
+    for (unsigned int threads = 1; threads <= 4; threads++)
+    {
+        rpn_engine::WorkStealingPool pool(threads);
+        rpn_engine::ParallelEvaluator<double> evaluator(pool);
+        evaluator.SetThreshold(0);
+        for (int trial = 0; trial < 20; trial++)
+        {
+            std::vector<Op> program;
+            for (int step = 0; step < 200; step++)
+            {
+                unsigned int r = random.Next() % (kinds + 2);
+                if (r < kinds)
+                    program.push_back(operations[r]);
+                else
+                    program.push_back(static_cast<Op>(static_cast<unsigned int>(Op::num_1) + random.Next() % 9));
+            }
+            ASSERT_TRUE(evaluator.Load(program.data(), program.size()));
+            ExpectSameAsSerial(evaluator, program, inputs);
+        }
+    }
+}
+
+TEST(ParallelEvaluatorTest, Load)
+{
+    rpn_engine::WorkStealingPool pool(2);
+    rpn_engine::ParallelEvaluator<double> evaluator(pool);
+
+    // Not straight line.
+    std::vector<Op> program = Parse("label 1 go_to 1");
+    EXPECT_FALSE(evaluator.Load(program.data(), program.size()));
+    EXPECT_EQ(evaluator.GetErrorPosition(), 0u);
+    EXPECT_EQ(evaluator.GetTaskCount(), 0u);
+
+    // The empty program keeps the stack.
+    rpn_engine::StackStrategy<double> s(4);
+    s.Push(1);
+    s.Push(2);
+    evaluator.Run(s);
+    EXPECT_EQ(s.Get(0), 2);
+    EXPECT_EQ(s.Get(1), 1);
+
+    // A chain is one task.
+    program = Parse("sin cos 2 add");
+    ASSERT_TRUE(evaluator.Load(program.data(), program.size()));
+    EXPECT_EQ(evaluator.GetTaskCount(), 1u);
+    evaluator.Run(s);
+    EXPECT_EQ(s.Get(0), std::cos(std::sin(2.0)) + 2);
+    EXPECT_EQ(s.Get(1), 1);
+
+    // Y used twice. The second user starts a new task.
+    program = Parse("duplicate sin swap cos add");
+    ASSERT_TRUE(evaluator.Load(program.data(), program.size()));
+    EXPECT_EQ(evaluator.GetTaskCount(), 3u);
+
+    EXPECT_EQ(rpn_engine::ParallelEvaluator<double>::EstimateCost(Op::add), 1);
+    EXPECT_EQ(rpn_engine::ParallelEvaluator<Complex>::EstimateCost(Op::add), 4);
+}
@@ -0,0 +1,207 @@
+// Test cases for the polynomial evaluation
+
+#include "gtest/gtest.h"
+#include "rpnengine.hpp"
+#include <cmath>
+#include <complex>
+#include <vector>
+
+using rpn_engine::Op;
+typedef rpn_engine::StackStrategy<double> DoubleStack;
+typedef rpn_engine::StackStrategy<std::complex<double>> ComplexStack;
+
+TEST(PolynomialTest, HornerEstrin)
+{
+    // Taylor series of exp(x)
+    std::vector<double> c;
+    double factorial = 1;
+    for (int i = 0; i < 20; i++)
+    {
+        c.push_back(1.0 / factorial);
+        factorial *= i + 1;
+    }
+
+    for (std::size_t count = 1; count <= c.size(); count++)
+    {
+        double h = rpn_engine::Horner(c.data(), count, 0.5);
+        double e = rpn_engine::Estrin(c.data(), count, 0.5);
+        EXPECT_NEAR(h, e, 1e-15) << "count = " << count;
+    }
+    EXPECT_NEAR(rpn_engine::EvaluatePolynomial(c.data(), c.size(), 0.5), std::exp(0.5), 1e-15);
+
+    // Across several blocks.
+    std::vector<double> ones(100, 1.0);
+    EXPECT_NEAR(rpn_engine::Estrin(ones.data(), ones.size(), 0.9),
+                (1 - std::pow(0.9, 100)) / (1 - 0.9), 1e-12);
+    EXPECT_DOUBLE_EQ(rpn_engine::Estrin(ones.data(), 65, 1.0), 65);
+}
+
+TEST(PolynomialTest, StackOperation)
+{
+    DoubleStack s(8);
+
+    // 2x^2 - 3x + 1 at x = 4
+    s.Push(100); // Below the coefficients
+    s.Push(2);
+    s.Push(-3);
+    s.Push(1);
+    s.Push(4);
+    s.Push(2);
+    s.Operation(Op::polynomial);
+    EXPECT_DOUBLE_EQ(s.Get(0), 21);
+    EXPECT_DOUBLE_EQ(s.Get(1), 100);
+    EXPECT_DOUBLE_EQ(s.Get(7), 0);
+
+    // Undo retrieves the parameters.
+    s.Undo();
+    EXPECT_DOUBLE_EQ(s.Get(0), 2);
+    EXPECT_DOUBLE_EQ(s.Get(1), 4);
+    EXPECT_DOUBLE_EQ(s.Get(4), 2);
+
+    // Degree 0
+    s.Push(7);
+    s.Push(5);
+    s.Push(0);
+    s.Operation(Op::polynomial);
+    EXPECT_DOUBLE_EQ(s.Get(0), 7);
+    EXPECT_DOUBLE_EQ(s.Get(1), 2);
+}
+
+TEST(PolynomialTest, InvalidDegree)
+{
+    DoubleStack s(4);
+
+    // Too many coefficients for the stack
+    s.Push(1);
+    s.Push(2);
+    s.Push(2);
+    s.Operation(Op::polynomial);
+    EXPECT_TRUE(std::isnan(s.Get(0)));
+    EXPECT_NE(s.GetStatus() & rpn_engine::kFpInvalid, 0u);
+
+    // Not an integer
+    s.Push(1);
+    s.Push(0.5);
+    s.Operation(Op::polynomial);
+    EXPECT_TRUE(std::isnan(s.Get(0)));
+
+    // Max degree for the stack of 4.
+    s.Push(3);
+    s.Push(2);
+    s.Push(10);
+    s.Push(1);
+    s.Operation(Op::polynomial);
+    EXPECT_DOUBLE_EQ(s.Get(0), 32);
+}
+
+TEST(PolynomialTest, Complex)
+{
+    ComplexStack s(6);
+    const std::complex<double> j(0, 1);
+
+    // x^2 + 1 at x = j
+    s.Push(1);
+    s.Push(0);
+    s.Push(1);
+    s.Push(j);
+    s.Push(2);
+    s.Operation(Op::polynomial);
+    EXPECT_NEAR(std::abs(s.Get(0)), 0.0, 1e-15);
+
+    // Register range. (1 + j) + 2x at x = j
+    const std::complex<double> c[] = {1.0 + j, 2};
+    s.Push(j);
+    s.Polynomial(c, 2);
+    EXPECT_EQ(s.Get(0), 1.0 + 3.0 * j);
+}
+
+TEST(PolynomialTest, RegisterRange)
+{
+    DoubleStack s(4);
+    std::vector<double> c(30);
+    for (std::size_t i = 0; i < c.size(); i++)
+        c[i] = static_cast<double>(i);
+
+    s.Push(9);
+    s.Push(1);
+    s.Polynomial(c.data(), c.size());
+    EXPECT_DOUBLE_EQ(s.Get(0), 435);
+    EXPECT_DOUBLE_EQ(s.Get(1), 9);
+}
+
+TEST(PolynomialTest, CoefficientRegisters)
+{
+    DoubleStack s(4);
+
+    // 2x^2 - 3x + 1 at x = 4. Store the coefficients, then evaluate.
+    const double c[] = {1, -3, 2};
+    for (int i = 0; i < 3; i++)
+    {
+        s.Push(c[i]);
+        s.Push(i);
+        s.Operation(Op::coefficient_store);
+        EXPECT_DOUBLE_EQ(s.Get(0), c[i]);
+        s.Operation(Op::rotate_pop);
+    }
+    EXPECT_DOUBLE_EQ(s.GetCoefficient(1), -3);
+    s.Push(4);
+    s.Push(2);
+    s.Operation(Op::coefficient_polynomial);
+    EXPECT_DOUBLE_EQ(s.Get(0), 21);
+    s.Undo();
+    EXPECT_DOUBLE_EQ(s.Get(0), 2);
+    EXPECT_DOUBLE_EQ(s.Get(1), 4);
+
+    // The degree is not limited by the stack size.
+    for (unsigned int i = 0; i < rpn_engine::kNumberOfCoefficients; i++)
+        s.SetCoefficient(i, 1);
+    s.Push(1);
+    s.Push(rpn_engine::kNumberOfCoefficients - 1);
+    s.Operation(Op::coefficient_polynomial);
+    EXPECT_DOUBLE_EQ(s.Get(0), rpn_engine::kNumberOfCoefficients);
+
+    // Invalid index and degree.
+    s.Push(5);
+    s.Push(rpn_engine::kNumberOfCoefficients);
+    s.Operation(Op::coefficient_store);
+    EXPECT_TRUE(std::isnan(s.Get(0)));
+    s.Push(1);
+    s.Push(0.5);
+    s.Operation(Op::coefficient_polynomial);
+    EXPECT_TRUE(std::isnan(s.Get(0)));
+    EXPECT_NE(s.GetStatus() & rpn_engine::kFpInvalid, 0u);
+
+    s.ClearCoefficients();
+    EXPECT_DOUBLE_EQ(s.GetCoefficient(0), 0);
+}
+
+TEST(PolynomialTest, CoefficientRegistersByConsole)
+{
+    // x^3 - 2 at x = 3 on the 4 level stack.
+    const Op program[] = {Op::num_2, Op::chs, Op::enter, Op::num_0, Op::coefficient_store,
+                          Op::num_1, Op::enter, Op::num_3, Op::coefficient_store,
+                          Op::num_3, Op::enter, Op::num_3, Op::coefficient_polynomial};
+    rpn_engine::Console c;
+    char text[rpn_engine::kNumberOfDigits + 1];
+
+    for (auto key : program)
+        c.Input(key);
+    c.GetText(text);
+    EXPECT_STREQ(text, " 25000000");
+}
+
+TEST(PolynomialTest, CoefficientRegistersByVirtualMachine)
+{
+    // Same program as the Console.
+    const Op program[] = {Op::num_2, Op::chs, Op::enter, Op::num_0, Op::coefficient_store,
+                          Op::num_1, Op::enter, Op::num_3, Op::coefficient_store,
+                          Op::num_3, Op::enter, Op::num_3, Op::coefficient_polynomial};
+    ComplexStack s(4);
+    rpn_engine::VirtualMachine<std::complex<double>> vm(s);
+
+    ASSERT_TRUE(vm.Load(program, sizeof(program) / sizeof(program[0])));
+    EXPECT_EQ(vm.Run(100), rpn_engine::VirtualMachine<std::complex<double>>::Result::completed);
+    EXPECT_DOUBLE_EQ(s.Get(0).real(), 25);
+    EXPECT_DOUBLE_EQ(s.GetCoefficient(3).real(), 1);
+    EXPECT_DOUBLE_EQ(s.GetCoefficient(1).real(), 0);
+}
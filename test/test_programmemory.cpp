@@ -0,0 +1,239 @@
+// Test cases for the rpn_engine::ProgramMemory class and the playback by rpn_engine::Console
+
+#include "gtest/gtest.h"
+#include "rpnengine.hpp"
+#include <climits>
+#include <cstring>
+#include <type_traits>
+
+using rpn_engine::Op;
+using rpn_engine::ProgramMemory;
+
+TEST(ProgramMemoryTest, Encoding)
+{
+    ProgramMemory p(16);
+
+    EXPECT_EQ(p.GetCapacity(), 32u);
+    EXPECT_EQ(p.GetStepCount(), 0u);
+
+    // Short codes take one nibble.
+    EXPECT_TRUE(p.Append(Op::num_1));
+    EXPECT_TRUE(p.Append(Op::period));
+    EXPECT_TRUE(p.Append(Op::enter));
+    EXPECT_TRUE(p.Append(Op::mul));
+    EXPECT_EQ(p.GetNibbleCount(), 4u);
+
+    // Others take three nibbles.
+    EXPECT_TRUE(p.Append(Op::sqrt));
+    EXPECT_TRUE(p.Append(Op::chs));
+    EXPECT_EQ(p.GetNibbleCount(), 10u);
+    EXPECT_EQ(p.GetStepCount(), 6u);
+
+    unsigned int position = 0;
+    EXPECT_EQ(p.Fetch(position), Op::num_1);
+    EXPECT_EQ(p.Fetch(position), Op::period);
+    EXPECT_EQ(p.Fetch(position), Op::enter);
+    EXPECT_EQ(p.Fetch(position), Op::mul);
+    EXPECT_EQ(p.Fetch(position), Op::sqrt);
+    EXPECT_EQ(position, 7u);
+    EXPECT_EQ(p.Fetch(position), Op::chs);
+    EXPECT_EQ(position, p.GetNibbleCount());
+
+    p.Clear();
+    EXPECT_EQ(p.GetNibbleCount(), 0u);
+    EXPECT_EQ(p.GetStepCount(), 0u);
+}
+
+TEST(ProgramMemoryTest, AllOpcodes)
+{
+    const unsigned int last = static_cast<std::underlying_type<Op>::type>(Op::chs);
+    ProgramMemory p(3 * (last + 1));
+
+    for (unsigned int i = 0; i <= last; i++)
+        EXPECT_TRUE(p.Append(static_cast<Op>(i)));
+
+    unsigned int position = 0;
+    for (unsigned int i = 0; i <= last; i++)
+        EXPECT_EQ(p.Fetch(position), static_cast<Op>(i));
+    EXPECT_EQ(position, p.GetNibbleCount());
+}
+
+TEST(ProgramMemoryTest, Full)
+{
+    ProgramMemory p(2);
+
+    EXPECT_TRUE(p.Append(Op::num_1));
+    EXPECT_TRUE(p.Append(Op::num_2));
+    EXPECT_FALSE(p.Append(Op::sqrt)); // needs 3 nibbles
+    EXPECT_TRUE(p.Append(Op::num_3));
+    EXPECT_TRUE(p.Append(Op::num_4));
+    EXPECT_FALSE(p.Append(Op::num_5));
+    EXPECT_EQ(p.GetStepCount(), 4u);
+}
+
+TEST(ProgramMemoryTest, RecordAndPlay)
+{
+    const Op keys[] = {Op::num_1, Op::period, Op::num_5, Op::enter,
+                       Op::num_2, Op::eex, Op::num_3, Op::chs, Op::mul,
+                       Op::nop, Op::sqrt, Op::num_7, Op::add};
+    rpn_engine::Console recorder, player;
+    ProgramMemory p(64);
+    char expected[12], actual[12];
+
+    recorder.StartRecording(p);
+    EXPECT_TRUE(recorder.GetIsRecording());
+    for (auto key : keys)
+        recorder.Input(key);
+    recorder.StopRecording();
+    EXPECT_FALSE(recorder.GetIsRecording());
+    EXPECT_EQ(p.GetStepCount(), 12u); // nop is not recorded.
+
+    // Same result as the key input.
+    player.Play(p);
+    recorder.GetText(expected);
+    player.GetText(actual);
+    EXPECT_STREQ(actual, expected);
+    EXPECT_EQ(player.GetDecimalPointPosition(), recorder.GetDecimalPointPosition());
+
+    // Not recorded after stop.
+    recorder.Input(Op::num_1);
+    EXPECT_EQ(p.GetStepCount(), 12u);
+}
+
+TEST(ProgramMemoryTest, PlayEditing)
+{
+    rpn_engine::Console c;
+    ProgramMemory p(16), q(16);
+    char text[12];
+
+    // Program ends while editing
+    p.Append(Op::num_2);
+    p.Append(Op::enter);
+    p.Append(Op::num_3);
+    p.Append(Op::period);
+    p.Append(Op::num_5);
+    c.Play(p);
+    c.GetText(text);
+    EXPECT_STREQ(text, " 35      ");
+    EXPECT_EQ(c.GetDecimalPointPosition(), 7);
+
+    // The editing continues in the next program.
+    q.Append(Op::add);
+    c.Play(q);
+    c.GetText(text);
+    EXPECT_STREQ(text, " 55000000");
+    EXPECT_EQ(c.GetDecimalPointPosition(), 7);
+}
+
+TEST(ProgramMemoryTest, SlicedPlay)
+{
+    rpn_engine::Console sliced, whole;
+    ProgramMemory p(256);
+    char expected[12], actual[12];
+    unsigned int played, total;
+
+    // 1 enter 1.1 mul 1.1 mul ...
+    p.Append(Op::num_1);
+    p.Append(Op::enter);
+    for (int i = 0; i < 20; i++)
+    {
+        p.Append(Op::num_1);
+        p.Append(Op::period);
+        p.Append(Op::num_1);
+        p.Append(Op::mul);
+    }
+    whole.Play(p);
+    whole.GetText(expected);
+
+    EXPECT_EQ(sliced.GetPlayState(), rpn_engine::Console::PlayState::idle);
+    sliced.StartPlay(p);
+    EXPECT_EQ(sliced.GetPlayState(), rpn_engine::Console::PlayState::running);
+    sliced.GetPlayProgress(played, total);
+    EXPECT_EQ(played, 0u);
+    EXPECT_EQ(total, 82u);
+
+    // The display is rendered at the end of each slice.
+    EXPECT_EQ(sliced.ResumePlay(6), rpn_engine::Console::PlayState::running);
+    sliced.GetText(actual);
+    EXPECT_STREQ(actual, " 11000000");
+    sliced.GetPlayProgress(played, total);
+    EXPECT_EQ(played, 6u);
+
+    int slices = 1;
+    while (sliced.ResumePlay(7) == rpn_engine::Console::PlayState::running)
+        slices++;
+    EXPECT_EQ(slices, 11); // 6 + 7 * 10 + 6
+    EXPECT_EQ(sliced.GetPlayState(), rpn_engine::Console::PlayState::completed);
+    sliced.GetPlayProgress(played, total);
+    EXPECT_EQ(played, 82u);
+    EXPECT_EQ(total, 82u);
+    sliced.GetText(actual);
+    EXPECT_STREQ(actual, expected);
+    EXPECT_EQ(sliced.GetDecimalPointPosition(), whole.GetDecimalPointPosition());
+
+    // Nothing to do after the completion.
+    EXPECT_EQ(sliced.ResumePlay(7), rpn_engine::Console::PlayState::completed);
+
+    // The time budget stops the slice. At least one step runs.
+    sliced.StartPlay(p);
+    sliced.ResumePlay(UINT_MAX, 1e-12);
+    sliced.GetPlayProgress(played, total);
+    EXPECT_GE(played, 1u);
+    EXPECT_LE(played, rpn_engine::Console::kPlayTimeCheckInterval);
+    while (sliced.ResumePlay(UINT_MAX, 1e-12) == rpn_engine::Console::PlayState::running)
+        ;
+    sliced.GetPlayProgress(played, total);
+    EXPECT_EQ(played, 82u);
+
+    // The step budget 0 runs a step. The time budget too long for the clock is unlimited.
+    sliced.StartPlay(p);
+    EXPECT_EQ(sliced.ResumePlay(0), rpn_engine::Console::PlayState::running);
+    sliced.GetPlayProgress(played, total);
+    EXPECT_EQ(played, 1u);
+    EXPECT_EQ(sliced.ResumePlay(UINT_MAX, 1e300), rpn_engine::Console::PlayState::completed);
+    sliced.GetText(actual);
+    EXPECT_STREQ(actual, expected);
+}
+
+TEST(ProgramMemoryTest, CancelPlay)
+{
+    rpn_engine::Console c;
+    ProgramMemory p(64), recorded(64);
+    char text[12];
+    unsigned int played, total;
+
+    for (int i = 0; i < 10; i++)
+    {
+        p.Append(Op::num_1);
+        p.Append(Op::add);
+    }
+
+    // A key cancels the playback and it is discarded.
+    c.StartRecording(recorded);
+    c.StartPlay(p);
+    c.ResumePlay(4);
+    c.Input(Op::nop); // nop doesn't cancel.
+    EXPECT_EQ(c.GetPlayState(), rpn_engine::Console::PlayState::running);
+    c.Input(Op::num_9);
+    EXPECT_EQ(c.GetPlayState(), rpn_engine::Console::PlayState::cancelled);
+    EXPECT_EQ(c.ResumePlay(4), rpn_engine::Console::PlayState::cancelled);
+    c.GetPlayProgress(played, total);
+    EXPECT_EQ(played, 4u);
+    EXPECT_EQ(total, 20u);
+    c.GetText(text);
+    EXPECT_STREQ(text, " 20000000");
+    EXPECT_EQ(recorded.GetStepCount(), 0u); // Neither the playback nor the cancel key is recorded.
+
+    // The keys work after the cancel.
+    c.Input(Op::num_3);
+    c.Input(Op::add);
+    c.GetText(text);
+    EXPECT_STREQ(text, " 50000000");
+    c.StopRecording();
+
+    c.StartPlay(p);
+    c.CancelPlay();
+    EXPECT_EQ(c.GetPlayState(), rpn_engine::Console::PlayState::cancelled);
+    c.GetText(text);
+    EXPECT_STREQ(text, " 50000000");
+}
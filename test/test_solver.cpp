@@ -0,0 +1,106 @@
+// Test cases for the rpn_engine::RealFunction and rpn_engine::Solver classes
+
+#include "gtest/gtest.h"
+#include "rpnengine.hpp"
+#include "testhelper.hpp"
+#include <cmath>
+#include <string>
+#include <vector>
+
+using rpn_engine::Op;
+typedef rpn_engine::Solver::Status Status;
+
+TEST(RealFunctionTest, Evaluate)
+{
+    rpn_engine::RealFunction f;
+    EXPECT_EQ(f(3), 3); // Empty program.
+
+    // x^2 - r0. The registers are restored for each call.
+    std::vector<Op> program = Parse("square rcl 0 sub 5 sto 0 rotate_pop");
+    ASSERT_TRUE(f.Load(program.data(), program.size()));
+    f.SetRegister(0, 2);
+    EXPECT_EQ(f(3), 7);
+    EXPECT_EQ(f(3), 7);
+
+    // Doesn't finish.
+    program = Parse("label 0 go_to 0");
+    ASSERT_TRUE(f.Load(program.data(), program.size()));
+    EXPECT_TRUE(std::isnan(f(1)));
+
+    program = Parse("go_to 1");
+    EXPECT_FALSE(f.Load(program.data(), program.size()));
+}
+
+TEST(SolverTest, Solve)
+{
+    rpn_engine::WorkStealingPool pool(2);
+    rpn_engine::Solver solver(pool);
+
+    // x^2 - 2
+    std::vector<Op> program = Parse("square 2 sub");
+    ASSERT_TRUE(solver.Load(program.data(), program.size()));
+    double root = 0;
+    EXPECT_EQ(solver.Solve(0, 2, root), Status::converged);
+    EXPECT_NEAR(root, std::sqrt(2.0), 1e-12);
+    EXPECT_LT(solver.GetEvaluationCount(), 15u); // Much faster than bisection.
+    EXPECT_EQ(solver.Solve(2, 0, root), Status::converged);
+    EXPECT_NEAR(root, std::sqrt(2.0), 1e-12);
+    EXPECT_EQ(solver.Solve(2, 3, root), Status::no_sign_change);
+
+    // cos(x) - x r0, with the loop in the subroutine.
+    program = Parse("duplicate go_sub 1 swap rcl 0 mul sub ret "
+                    "label 1 cos ret");
+    ASSERT_TRUE(solver.Load(program.data(), program.size()));
+    solver.SetRegister(0, 1);
+    EXPECT_EQ(solver.Solve(0, 1, root), Status::converged);
+    EXPECT_NEAR(root, 0.7390851332151607, 1e-12);
+
+    // Pole of 1/x
+    program = Parse("inv");
+    ASSERT_TRUE(solver.Load(program.data(), program.size()));
+    EXPECT_EQ(solver.Solve(-1, 2, root), Status::discontinuity);
+
+    // Budget
+    program = Parse("square 2 sub");
+    ASSERT_TRUE(solver.Load(program.data(), program.size()));
+    solver.SetTolerance(0);
+    solver.SetEvaluationBudget(5);
+    EXPECT_EQ(solver.Solve(0, 2, root), Status::evaluation_budget);
+    EXPECT_EQ(solver.GetEvaluationCount(), 5u);
+    solver.SetEvaluationBudget(0);
+    solver.SetTimeBudget(1e-9);
+    EXPECT_EQ(solver.Solve(0, 2, root), Status::time_budget);
+}
+
+TEST(SolverTest, SolveAll)
+{
+    for (unsigned int threads = 1; threads <= 4; threads++)
+    {
+        rpn_engine::WorkStealingPool pool(threads);
+        rpn_engine::Solver solver(pool);
+
+        // sin(x) has the roots at k pi. tan(x) has the poles between them.
+        std::vector<Op> program = Parse("tan");
+        ASSERT_TRUE(solver.Load(program.data(), program.size()));
+        std::vector<double> roots;
+        EXPECT_EQ(solver.SolveAll(-10, 20, 1000, roots), Status::converged);
+        ASSERT_EQ(roots.size(), 10u);
+        for (int k = -3; k <= 6; k++)
+            EXPECT_NEAR(roots[k + 3], k * rpn_engine::pi, 1e-10);
+
+        // Exact zero at the sample. No duplicate.
+        program = Parse("square 1 sub");
+        ASSERT_TRUE(solver.Load(program.data(), program.size()));
+        roots.clear();
+        EXPECT_EQ(solver.SolveAll(2, -2, 4, roots), Status::converged);
+        ASSERT_EQ(roots.size(), 2u);
+        EXPECT_EQ(roots[0], -1);
+        EXPECT_EQ(roots[1], 1);
+
+        // Stop by the budget.
+        roots.clear();
+        solver.SetEvaluationBudget(100);
+        EXPECT_EQ(solver.SolveAll(-2, 2, 1000, roots), Status::evaluation_budget);
+        EXPECT_EQ(solver.GetEvaluationCount(), 100u); // The workers don't overrun the budget.
+    }
+}
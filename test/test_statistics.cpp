@@ -0,0 +1,199 @@
+// Test cases for the rpn_engine::Statistics class and the statistics operations
+
+#include "gtest/gtest.h"
+#include "rpnengine.hpp"
+#include <cmath>
+#include <vector>
+
+using rpn_engine::Op;
+using rpn_engine::Statistics;
+typedef rpn_engine::StackStrategy<double> DoubleStack;
+
+TEST(StatisticsTest, AddRemove)
+{
+    Statistics st;
+    const double data[] = {2, 4, 4, 4, 5, 5, 7, 9};
+
+    for (auto x : data)
+        st.Add(x);
+    EXPECT_EQ(st.Count(), 8u);
+    EXPECT_DOUBLE_EQ(st.MeanX(), 5);
+    EXPECT_DOUBLE_EQ(st.VarianceX(), 32.0 / 7);
+    EXPECT_DOUBLE_EQ(st.SumX(), 40);
+    EXPECT_DOUBLE_EQ(st.SumX2(), 232);
+
+    // Remove the last sample.
+    st.Remove(9);
+    EXPECT_EQ(st.Count(), 7u);
+    EXPECT_DOUBLE_EQ(st.MeanX(), 31.0 / 7);
+    EXPECT_NEAR(st.StandardDeviationX(), std::sqrt((151.0 - 31.0 * 31.0 / 7) / 6), 1e-14);
+
+    st.Clear();
+    EXPECT_EQ(st.Count(), 0u);
+    EXPECT_TRUE(std::isnan(st.MeanX()));
+}
+
+TEST(StatisticsTest, LargeOffset)
+{
+    Statistics st;
+
+    // Naive sum of squares loses all digits in this case.
+    st.Add(1e9 + 4);
+    st.Add(1e9 + 7);
+    st.Add(1e9 + 13);
+    st.Add(1e9 + 16);
+    EXPECT_DOUBLE_EQ(st.MeanX(), 1e9 + 10);
+    EXPECT_DOUBLE_EQ(st.VarianceX(), 30);
+}
+
+TEST(StatisticsTest, Accumulate)
+{
+    Statistics batch, single;
+    std::vector<double> x, y;
+
+    // Over several blocks with the remainder.
+    for (int i = 0; i < 1001; i++)
+    {
+        x.push_back(0.5 * i + 1e6);
+        y.push_back(3.0 * i - 7.0 + ((i % 3) - 1) * 0.25);
+    }
+    batch.Accumulate(x.data(), y.data(), x.size());
+    for (std::size_t i = 0; i < x.size(); i++)
+        single.Add(x[i], y[i]);
+
+    EXPECT_EQ(batch.Count(), single.Count());
+    EXPECT_NEAR(batch.MeanX(), single.MeanX(), 1e-9);
+    EXPECT_NEAR(batch.MeanY(), single.MeanY(), 1e-9);
+    EXPECT_NEAR(batch.VarianceX(), single.VarianceX(), 1e-9);
+    EXPECT_NEAR(batch.VarianceY(), single.VarianceY(), 1e-7);
+    EXPECT_NEAR(batch.Slope(), single.Slope(), 1e-12);
+    EXPECT_NEAR(batch.Correlation(), single.Correlation(), 1e-12);
+
+    // Merge of two halves is the same as the whole.
+    Statistics first, second;
+    first.Accumulate(x.data(), y.data(), 500);
+    second.Accumulate(x.data() + 500, y.data() + 500, x.size() - 500);
+    first.Merge(second);
+    EXPECT_EQ(first.Count(), batch.Count());
+    EXPECT_NEAR(first.VarianceX(), batch.VarianceX(), 1e-9);
+    EXPECT_NEAR(first.Intercept(), batch.Intercept(), 1e-6);
+
+    // Single array version.
+    Statistics xonly;
+    xonly.Accumulate(x.data(), 3);
+    EXPECT_DOUBLE_EQ(xonly.MeanX(), 1e6 + 0.5);
+    EXPECT_DOUBLE_EQ(xonly.MeanY(), 0);
+}
+
+TEST(StatisticsTest, Regression)
+{
+    Statistics st;
+
+    // y = 2x + 1
+    for (int i = 0; i < 10; i++)
+        st.Add(i, 2 * i + 1);
+    EXPECT_DOUBLE_EQ(st.Slope(), 2);
+    EXPECT_DOUBLE_EQ(st.Intercept(), 1);
+    EXPECT_DOUBLE_EQ(st.Correlation(), 1);
+    EXPECT_DOUBLE_EQ(st.SumXY(), 615);
+}
+
+TEST(StatisticsTest, StackOperation)
+{
+    DoubleStack s(4);
+
+    // (x, y) = (1, 10), (2, 20), (3, 60)
+    s.Push(10);
+    s.Push(1);
+    s.Operation(Op::sigma_plus);
+    EXPECT_DOUBLE_EQ(s.Get(0), 1);
+    EXPECT_DOUBLE_EQ(s.Get(1), 10);
+    s.SetX(2);
+    s.Operation(Op::swap);
+    s.SetX(20);
+    s.Operation(Op::swap);
+    s.Operation(Op::sigma_plus);
+    EXPECT_DOUBLE_EQ(s.Get(0), 2);
+    s.SetX(3);
+    s.Operation(Op::swap);
+    s.SetX(60);
+    s.Operation(Op::swap);
+    s.Operation(Op::sigma_plus);
+    EXPECT_DOUBLE_EQ(s.Get(0), 3);
+
+    // Undo restores the stack but not the statistics.
+    s.Undo();
+    EXPECT_DOUBLE_EQ(s.Get(0), 3);
+    EXPECT_EQ(s.GetStatistics().Count(), 3u);
+
+    // Remove the wrong sample.
+    s.Operation(Op::sigma_minus);
+    EXPECT_DOUBLE_EQ(s.Get(0), 2);
+    s.SetX(3);
+    s.Operation(Op::swap);
+    s.SetX(30);
+    s.Operation(Op::swap);
+    s.Operation(Op::sigma_plus);
+
+    s.Operation(Op::mean);
+    EXPECT_DOUBLE_EQ(s.Get(0), 2);
+    EXPECT_DOUBLE_EQ(s.Get(1), 20);
+    s.Operation(Op::standard_deviation);
+    EXPECT_DOUBLE_EQ(s.Get(0), 1);
+    EXPECT_DOUBLE_EQ(s.Get(1), 10);
+
+    // Batch ingest doesn't touch the stack.
+    const double xs[] = {4, 5};
+    const double ys[] = {40, 50};
+    s.Accumulate(xs, ys, 2);
+    EXPECT_EQ(s.GetStatistics().Count(), 5u);
+    EXPECT_DOUBLE_EQ(s.Get(0), 1);
+    EXPECT_DOUBLE_EQ(s.GetStatistics().Slope(), 10);
+
+    s.Operation(Op::sigma_clear);
+    EXPECT_EQ(s.GetStatistics().Count(), 0u);
+    EXPECT_DOUBLE_EQ(s.Get(0), 1);
+}
+
+TEST(StatisticsTest, ComplexStack)
+{
+    rpn_engine::StackStrategy<std::complex<double>> s(4);
+
+    // Real parts are used.
+    s.Push(std::complex<double>(5, 1));
+    s.Push(std::complex<double>(2, 3));
+    s.Operation(Op::sigma_plus);
+    EXPECT_DOUBLE_EQ(s.GetStatistics().MeanX(), 2);
+    EXPECT_DOUBLE_EQ(s.GetStatistics().MeanY(), 5);
+    EXPECT_EQ(s.Get(0), std::complex<double>(1, 0));
+}
+
+TEST(StatisticsTest, Console)
+{
+    rpn_engine::Console c;
+    char display_text[12];
+
+    c.Input(Op::num_1);
+    c.Input(Op::enter);
+    c.Input(Op::num_2);
+    c.Input(Op::sigma_plus);
+    c.GetText(display_text);
+    EXPECT_STREQ(display_text, " 10000000");
+
+    // Number of samples is overwritten by the next entry.
+    c.Input(Op::num_3);
+    c.Input(Op::enter);
+    c.Input(Op::num_4);
+    c.Input(Op::sigma_plus);
+    c.GetText(display_text);
+    EXPECT_STREQ(display_text, " 20000000");
+
+    // mean x = 3
+    c.Input(Op::mean);
+    c.GetText(display_text);
+    EXPECT_STREQ(display_text, " 30000000");
+    // mean y = 2
+    c.Input(Op::swap);
+    c.GetText(display_text);
+    EXPECT_STREQ(display_text, " 20000000");
+}
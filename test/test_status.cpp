@@ -0,0 +1,143 @@
+// Test cases for the sticky floating point status of the rpn_engine::StackStrategy class
+
+#include "gtest/gtest.h"
+#include "rpnengine.hpp"
+#include <cmath>
+#include <limits>
+
+using rpn_engine::Op;
+typedef rpn_engine::StackStrategy<double> DoubleStack;
+typedef rpn_engine::StackStrategy<std::complex<double>> ComplexStack;
+
+TEST(StatusTest, Initial)
+{
+    DoubleStack s(4);
+
+    EXPECT_EQ(s.GetStatus(), 0u);
+    EXPECT_EQ(s.GetOperationCount(), 0u);
+
+    s.Push(2);
+    s.Push(3);
+    s.Operation(Op::add);
+    s.Operation(Op::sqrt);
+    EXPECT_EQ(s.GetStatus(), 0u);
+    EXPECT_EQ(s.GetOperationCount(), 2u);
+}
+
+TEST(StatusTest, DivideByZero)
+{
+    DoubleStack s(4);
+
+    s.Push(1);
+    s.Push(0);
+    s.Operation(Op::div);
+    EXPECT_EQ(s.GetStatus(), rpn_engine::kFpDivideByZero);
+    EXPECT_EQ(s.GetFirstStatusIndex(), 0u);
+
+    // log(0) is also a division by zero.
+    s.ClearStatus();
+    s.Push(0);
+    s.Operation(Op::log);
+    EXPECT_EQ(s.GetStatus(), rpn_engine::kFpDivideByZero);
+
+    // 0/0 is invalid, too.
+    s.ClearStatus();
+    s.Push(0);
+    s.Push(0);
+    s.Operation(Op::div);
+    EXPECT_EQ(s.GetStatus(), rpn_engine::kFpDivideByZero | rpn_engine::kFpInvalid);
+}
+
+TEST(StatusTest, Sticky)
+{
+    DoubleStack s(4);
+
+    s.Push(2);
+    s.Operation(Op::sqrt);
+    s.Push(-1);
+    s.Operation(Op::sqrt); // NaN at the second operation.
+    s.Pop();
+    EXPECT_EQ(s.GetStatus(), rpn_engine::kFpInvalid);
+
+    // Overflow
+    s.Push(1000);
+    s.Operation(Op::exp);
+    EXPECT_TRUE(std::isinf(s.Get(0)));
+    EXPECT_EQ(s.GetStatus(), rpn_engine::kFpInvalid | rpn_engine::kFpOverflow);
+    EXPECT_EQ(s.GetFirstStatusIndex(), 1u);
+    EXPECT_EQ(s.GetOperationCount(), 3u);
+
+    // Propagated infinity doesn't raise the overflow.
+    s.ClearStatus();
+    s.Push(1);
+    s.Operation(Op::add);
+    EXPECT_EQ(s.GetStatus(), 0u);
+
+    // inf - inf is invalid
+    s.Operation(Op::duplicate);
+    s.Operation(Op::sub);
+    EXPECT_EQ(s.GetStatus(), rpn_engine::kFpInvalid);
+    EXPECT_EQ(s.GetFirstStatusIndex(), 2u);
+
+    // Undo doesn't clear the status.
+    s.Undo();
+    EXPECT_EQ(s.GetStatus(), rpn_engine::kFpInvalid);
+}
+
+TEST(StatusTest, Underflow)
+{
+    DoubleStack s(4);
+
+    s.Push(std::numeric_limits<double>::min());
+    s.Push(16);
+    s.Operation(Op::div);
+    EXPECT_EQ(s.GetStatus(), rpn_engine::kFpUnderflow);
+}
+
+TEST(StatusTest, InexactBitwise)
+{
+    ComplexStack s(4);
+
+    s.Push(6);
+    s.Push(3);
+    s.Operation(Op::bit_and);
+    EXPECT_EQ(s.GetStatus(), 0u);
+
+    s.Push(1.5);
+    s.Operation(Op::bit_or);
+    EXPECT_EQ(s.GetStatus(), rpn_engine::kFpInexactBitwise);
+
+    s.ClearStatus();
+    s.Push(std::complex<double>(1, 1));
+    s.Operation(Op::bit_not);
+    EXPECT_EQ(s.GetStatus(), rpn_engine::kFpInexactBitwise);
+
+    s.ClearStatus();
+    s.Push(1e10);
+    s.Operation(Op::bit_neg);
+    EXPECT_EQ(s.GetStatus(), rpn_engine::kFpInexactBitwise);
+}
+
+TEST(StatusTest, Snapshot)
+{
+    ComplexStack s(4);
+
+    auto clean = s.TakeSnapshot();
+    s.Push(0);
+    s.Operation(Op::inv);
+    EXPECT_NE(s.GetStatus() & rpn_engine::kFpDivideByZero, 0u);
+
+    s.RestoreSnapshot(clean);
+    EXPECT_EQ(s.GetStatus(), 0u);
+    EXPECT_EQ(s.GetOperationCount(), 0u);
+}
+
+TEST(StatusTest, Matrix)
+{
+    rpn_engine::StackStrategy<rpn_engine::MatrixElement> s(4);
+    const double a[] = {1, 0};
+
+    s.Push(rpn_engine::MatrixElement::Vector(2, a));
+    s.Operation(Op::log);
+    EXPECT_EQ(s.GetStatus(), rpn_engine::kFpOverflow);
+}
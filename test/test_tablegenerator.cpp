@@ -0,0 +1,153 @@
+// Test cases for the rpn_engine::TableGenerator class
+
+#include "gtest/gtest.h"
+#include "rpnengine.hpp"
+#include "testhelper.hpp"
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+using rpn_engine::Op;
+typedef rpn_engine::TableGenerator::Row Row;
+
+// The rows are given in order and same as the RealFunction, regardless of the number of threads.
+TEST(TableGeneratorTest, Range)
+{
+    const char *programs[] = {
+        "square rcl 0 mul sin 2 add", // Vectorized.
+        "duplicate 0 x_lt_y neg",     // Not straight line.
+    };
+    const std::size_t count = rpn_engine::TableGenerator::kChunkSize * 20 + 123;
+
+    for (auto text : programs)
+    {
+        std::vector<Op> program = Parse(text);
+        rpn_engine::RealFunction scalar;
+        ASSERT_TRUE(scalar.Load(program.data(), program.size()));
+        scalar.SetRegister(0, 0.25);
+
+        for (unsigned int threads = 1; threads <= 4; threads++)
+        {
+            rpn_engine::WorkStealingPool pool(threads);
+            rpn_engine::TableGenerator table(pool);
+            ASSERT_TRUE(table.Load(program.data(), program.size()));
+            table.SetRegister(0, 0.25);
+
+            std::vector<Row> rows;
+            std::size_t calls = 0;
+            table.Generate(-10, 10, count, [&](const Row r[], std::size_t n)
+                           { rows.insert(rows.end(), r, r + n); calls++; });
+            ASSERT_EQ(rows.size(), count) << text;
+            EXPECT_EQ(calls, 21u);
+            EXPECT_EQ(rows.front().x, -10);
+            EXPECT_EQ(rows.back().x, 10);
+            for (std::size_t i = 0; i < count; i++)
+            {
+                EXPECT_EQ(rows[i].x, -10 + 20.0 * i / (count - 1));
+                ASSERT_TRUE(IsSame(rows[i].y, scalar(rows[i].x))) << text << " at " << i;
+                ASSERT_STREQ(rows[i].text, "");
+            }
+        }
+    }
+}
+
+TEST(TableGeneratorTest, List)
+{
+    std::vector<Op> program = Parse("inv");
+    rpn_engine::WorkStealingPool pool(2);
+    rpn_engine::TableGenerator table(pool);
+    ASSERT_TRUE(table.Load(program.data(), program.size()));
+
+    const double x[] = {4, 0.5, -2, 0};
+    std::vector<Row> rows;
+    table.Generate(x, 4, [&](const Row r[], std::size_t n)
+                   { rows.insert(rows.end(), r, r + n); });
+    ASSERT_EQ(rows.size(), 4u);
+    EXPECT_EQ(rows[0].y, 0.25);
+    EXPECT_EQ(rows[1].y, 2);
+    EXPECT_EQ(rows[2].y, -0.5);
+    EXPECT_TRUE(std::isinf(rows[3].y));
+
+    // Empty table.
+    rows.clear();
+    table.Generate(x, 0, [&](const Row r[], std::size_t n)
+                   { rows.insert(rows.end(), r, r + n); });
+    table.Generate(0, 1, 0, [&](const Row r[], std::size_t n)
+                   { rows.insert(rows.end(), r, r + n); });
+    EXPECT_TRUE(rows.empty());
+
+    // Single row is the start.
+    table.Generate(2, 3, 1, [&](const Row r[], std::size_t n)
+                   { rows.insert(rows.end(), r, r + n); });
+    ASSERT_EQ(rows.size(), 1u);
+    EXPECT_EQ(rows[0].x, 2);
+}
+
+// The text is same as the Console.
+TEST(TableGeneratorTest, Display)
+{
+    std::vector<Op> program = Parse("3 mul");
+    rpn_engine::WorkStealingPool pool(2);
+    rpn_engine::TableGenerator table(pool);
+    ASSERT_TRUE(table.Load(program.data(), program.size()));
+
+    const double x[] = {1.5, -2e-3, 1e20, 0.1, 12345678};
+    const rpn_engine::DisplayMode modes[] = {rpn_engine::DisplayMode::fixed, rpn_engine::DisplayMode::scientific, rpn_engine::DisplayMode::engineering};
+    for (auto mode : modes)
+    {
+        table.SetDisplay(true, mode);
+        std::vector<Row> rows;
+        table.Generate(x, 5, [&](const Row r[], std::size_t n)
+                       { rows.insert(rows.end(), r, r + n); });
+        ASSERT_EQ(rows.size(), 5u);
+        for (std::size_t i = 0; i < 5; i++)
+        {
+            char text[rpn_engine::kNumberOfDigits + 1];
+            int32_t decimal_point_position;
+            rpn_engine::Console::RenderText(rows[i].y, mode, false, text, decimal_point_position);
+            EXPECT_STREQ(rows[i].text, text);
+            EXPECT_EQ(rows[i].decimal_point_position, decimal_point_position);
+        }
+    }
+
+    // Same as the GetText() of the Console.
+    rpn_engine::Console console;
+    console.Input(Op::num_1);
+    console.Input(Op::period);
+    console.Input(Op::num_5);
+    console.Input(Op::enter);
+    console.Input(Op::num_3);
+    console.Input(Op::mul);
+    char text[rpn_engine::kNumberOfDigits + 1];
+    console.GetText(text);
+    table.SetDisplay(true);
+    std::vector<Row> rows;
+    table.Generate(x, 1, [&](const Row r[], std::size_t n)
+                   { rows.insert(rows.end(), r, r + n); });
+    EXPECT_STREQ(rows[0].text, text);
+    EXPECT_EQ(rows[0].decimal_point_position, console.GetDecimalPointPosition());
+}
+
+TEST(TableGeneratorTest, FileSink)
+{
+    std::vector<Op> program = Parse("2 mul");
+    rpn_engine::WorkStealingPool pool(2);
+    rpn_engine::TableGenerator table(pool);
+    ASSERT_TRUE(table.Load(program.data(), program.size()));
+
+    std::FILE *file = std::tmpfile();
+    ASSERT_NE(file, nullptr);
+    table.Generate(0, 1, 3, rpn_engine::TableGenerator::MakeFileSink(file));
+    table.SetDisplay(true);
+    const double x[] = {1.25};
+    table.Generate(x, 1, rpn_engine::TableGenerator::MakeFileSink(file));
+
+    std::rewind(file);
+    char buffer[256];
+    std::size_t length = std::fread(buffer, 1, sizeof(buffer) - 1, file);
+    buffer[length] = '\0';
+    std::fclose(file);
+    EXPECT_STREQ(buffer, "0,0\n0.5,1\n1,2\n1.25,2.5, 2.5000000\n");
+}
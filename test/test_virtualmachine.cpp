@@ -0,0 +1,263 @@
+// Test cases for the rpn_engine::VirtualMachine class
+
+#include "gtest/gtest.h"
+#include "rpnengine.hpp"
+#include <cmath>
+#include <cstdio>
+#include <string>
+
+using rpn_engine::Op;
+typedef rpn_engine::StackStrategy<double> DoubleStack;
+typedef rpn_engine::VirtualMachine<double> DoubleVm;
+
+TEST(VirtualMachineTest, StraightLine)
+{
+    DoubleStack s(4);
+    DoubleVm vm(s);
+
+    // 1.5 enter 2 eex 3 chs * sqrt
+    const Op program[] = {Op::num_1, Op::period, Op::num_5, Op::enter,
+                          Op::num_2, Op::eex, Op::num_3, Op::chs, Op::mul, Op::sqrt};
+    ASSERT_TRUE(vm.Load(program, sizeof(program) / sizeof(program[0])));
+    EXPECT_EQ(vm.GetProgramSize(), 5u);
+    EXPECT_EQ(vm.Run(100), DoubleVm::Result::completed);
+    EXPECT_EQ(vm.GetExecutedCount(), 5u);
+    EXPECT_DOUBLE_EQ(s.Get(0), std::sqrt(1.5 * 2e-3));
+    // The number after enter overwrites the duplicated X.
+    EXPECT_DOUBLE_EQ(s.Get(1), 0);
+}
+
+TEST(VirtualMachineTest, SameAsConsole)
+{
+    const Op program[] = {Op::clx, Op::num_2, Op::enter, Op::pi, Op::mul,
+                          Op::num_7, Op::add,
+                          Op::num_3, Op::sigma_plus, Op::num_4, Op::sub,
+                          Op::num_6, Op::chs, Op::div};
+    const std::size_t length = sizeof(program) / sizeof(program[0]);
+    rpn_engine::Console c;
+    rpn_engine::StackStrategy<std::complex<double>> s(4);
+    rpn_engine::VirtualMachine<std::complex<double>> vm(s);
+    char expected[rpn_engine::kDepthOfStack][rpn_engine::kNumberOfDigits + 1];
+    int32_t expected_point[rpn_engine::kDepthOfStack];
+
+    for (auto key : program)
+        c.Input(key);
+    c.GetStackText(rpn_engine::kDepthOfStack, expected, expected_point);
+
+    ASSERT_TRUE(vm.Load(program, length));
+    vm.Run(100);
+
+    // pi replaces the duplicated X. The number after sigma_plus overwrites the count.
+    EXPECT_NEAR(s.Get(0).real(), (2 * rpn_engine::pi + 7 - 4) / -6.0, 1e-12);
+    EXPECT_NEAR(s.Get(1).real(), 0, 1e-12);
+    EXPECT_EQ(s.GetStatistics().Count(), 1u);
+    EXPECT_DOUBLE_EQ(s.GetStatistics().MeanX(), 3);
+    EXPECT_STREQ(expected[0], "-15471976");
+    EXPECT_STREQ(expected[1], " 00000000");
+}
+
+TEST(VirtualMachineTest, Loop)
+{
+    DoubleStack s(4);
+    DoubleVm vm(s);
+
+    // Factorial of 5 by the registers.
+    const Op program[] = {
+        Op::num_5, Op::sto, Op::num_0,
+        Op::num_1, Op::sto, Op::num_1,
+        Op::label, Op::num_a,
+        Op::rcl, Op::num_1, Op::rcl, Op::num_0, Op::mul, Op::sto, Op::num_1,
+        Op::rcl, Op::num_0, Op::num_1, Op::sub, Op::sto, Op::num_0,
+        Op::num_0, Op::x_lt_y, Op::go_to, Op::num_a,
+        Op::rcl, Op::num_1};
+    ASSERT_TRUE(vm.Load(program, sizeof(program) / sizeof(program[0])));
+    EXPECT_EQ(vm.Run(1000), DoubleVm::Result::completed);
+    EXPECT_DOUBLE_EQ(s.Get(0), 120);
+    EXPECT_DOUBLE_EQ(vm.GetRegister(1), 120);
+    EXPECT_DOUBLE_EQ(vm.GetRegister(0), 0);
+}
+
+TEST(VirtualMachineTest, Convergence)
+{
+    DoubleStack s(4);
+    DoubleVm vm(s);
+
+    // Newton iteration of sqrt(2) until x doesn't change.
+    // r0 : x
+    const Op program[] = {
+        Op::num_1, Op::sto, Op::num_0,
+        Op::label, Op::num_0,
+        Op::num_2, Op::rcl, Op::num_0, Op::div, Op::rcl, Op::num_0, Op::add,
+        Op::num_2, Op::div,             // x' = (2/x + x) / 2
+        Op::rcl, Op::num_0, Op::swap,   // Y = x, X = x'
+        Op::sto, Op::num_0,
+        Op::x_eq_y, Op::ret,            // converged
+        Op::go_to, Op::num_0};
+    ASSERT_TRUE(vm.Load(program, sizeof(program) / sizeof(program[0])));
+    EXPECT_EQ(vm.Run(10000), DoubleVm::Result::completed);
+    EXPECT_DOUBLE_EQ(s.Get(0), std::sqrt(2.0));
+}
+
+TEST(VirtualMachineTest, Subroutine)
+{
+    DoubleStack s(4);
+    DoubleVm vm(s);
+
+    // square twice by subroutine
+    const Op program[] = {
+        Op::num_3, Op::go_sub, Op::num_1, Op::go_sub, Op::num_1, Op::ret,
+        Op::label, Op::num_1, Op::square, Op::ret};
+    ASSERT_TRUE(vm.Load(program, sizeof(program) / sizeof(program[0])));
+    EXPECT_EQ(vm.Run(100), DoubleVm::Result::completed);
+    EXPECT_DOUBLE_EQ(s.Get(0), 81);
+
+    // Endless recursion
+    const Op recursion[] = {Op::label, Op::num_2, Op::go_sub, Op::num_2};
+    ASSERT_TRUE(vm.Load(recursion, 4));
+    EXPECT_EQ(vm.Run(100), DoubleVm::Result::return_stack_overflow);
+    EXPECT_EQ(vm.GetExecutedCount(), rpn_engine::kVmReturnStackDepth + 1);
+}
+
+TEST(VirtualMachineTest, Budget)
+{
+    DoubleStack s(4);
+    DoubleVm vm(s);
+
+    // Count up forever
+    const Op program[] = {Op::num_0, Op::label, Op::num_0, Op::num_1, Op::add, Op::go_to, Op::num_0};
+    ASSERT_TRUE(vm.Load(program, sizeof(program) / sizeof(program[0])));
+    EXPECT_EQ(vm.Run(31), DoubleVm::Result::budget_exhausted);
+    EXPECT_EQ(vm.GetExecutedCount(), 31u);
+    EXPECT_DOUBLE_EQ(s.Get(0), 10);
+
+    // Continue
+    EXPECT_EQ(vm.Run(30), DoubleVm::Result::budget_exhausted);
+    EXPECT_DOUBLE_EQ(s.Get(0), 20);
+
+    // Cancel. The next Run() starts from the top and keeps the stack.
+    vm.Reset();
+    EXPECT_EQ(vm.Run(1), DoubleVm::Result::budget_exhausted);
+    EXPECT_DOUBLE_EQ(s.Get(0), 0);
+    EXPECT_DOUBLE_EQ(s.Get(1), 20);
+}
+
+TEST(VirtualMachineTest, LoadError)
+{
+    DoubleStack s(4);
+    DoubleVm vm(s);
+
+    const Op missing_operand[] = {Op::num_1, Op::sto};
+    EXPECT_FALSE(vm.Load(missing_operand, 2));
+    EXPECT_EQ(vm.GetProgramSize(), 0u);
+
+    const Op undefined_label[] = {Op::go_to, Op::num_3};
+    EXPECT_FALSE(vm.Load(undefined_label, 2));
+
+    const Op duplicated_label[] = {Op::label, Op::num_3, Op::label, Op::num_3};
+    EXPECT_FALSE(vm.Load(duplicated_label, 4));
+
+    const Op hex_digit[] = {Op::num_1, Op::num_a};
+    EXPECT_FALSE(vm.Load(hex_digit, 2));
+
+    const Op bad_operand[] = {Op::rcl, Op::add};
+    EXPECT_FALSE(vm.Load(bad_operand, 2));
+}
+
+TEST(VirtualMachineTest, ProgramMemory)
+{
+    rpn_engine::Console c;
+    rpn_engine::ProgramMemory p(32);
+    rpn_engine::StackStrategy<std::complex<double>> s(4);
+    rpn_engine::VirtualMachine<std::complex<double>> vm(s);
+
+    // Record at the console. Program opcodes are ignored by the console.
+    c.StartRecording(p);
+    c.Input(Op::num_4);
+    c.Input(Op::enter);
+    c.Input(Op::label);
+    c.Input(Op::num_1);
+    c.Input(Op::x_le_y);
+    c.Input(Op::add);
+    c.StopRecording();
+
+    ASSERT_TRUE(vm.Load(p));
+    EXPECT_EQ(vm.Run(100), rpn_engine::VirtualMachine<std::complex<double>>::Result::completed);
+    EXPECT_EQ(s.Get(0), std::complex<double>(8, 0));
+}
+
+TEST(VirtualMachineTest, Undo)
+{
+    DoubleStack s(4);
+    DoubleVm vm(s);
+
+    s.Push(5);
+    const Op program[] = {Op::num_2, Op::mul, Op::num_3, Op::add};
+    ASSERT_TRUE(vm.Load(program, 4));
+    vm.Run(100);
+    EXPECT_DOUBLE_EQ(s.Get(0), 13);
+
+    // The whole run is undone.
+    s.Undo();
+    EXPECT_DOUBLE_EQ(s.Get(0), 5);
+}
+
+#ifdef RPN_ENGINE_PROFILE
+TEST(VirtualMachineTest, Profile)
+{
+    DoubleStack s(4);
+    DoubleVm vm(s);
+
+    // 3 label 1 1 sub 0 x_lt_y go_to 1 : The loop runs twice. The second sub gets 0 - 1.
+    const Op program[] = {Op::num_3, Op::label, Op::num_1, Op::num_1, Op::sub,
+                          Op::num_0, Op::x_lt_y, Op::go_to, Op::num_1, Op::nop};
+    const std::size_t length = sizeof(program) / sizeof(program[0]);
+    ASSERT_TRUE(vm.Load(program, length));
+    ASSERT_EQ(vm.GetProgramSize(), 6u);
+    for (auto &counter : vm.GetProfile())
+        EXPECT_EQ(counter.count, 0u);
+
+    // The steps map to the program.
+    const std::size_t begins[] = {0, 3, 4, 5, 6, 7};
+    const std::size_t ends[] = {1, 4, 5, 6, 7, 9};
+    for (std::size_t step = 0; step < 6; step++)
+    {
+        std::size_t begin, end;
+        vm.GetStepRange(step, begin, end);
+        EXPECT_EQ(begin, begins[step]);
+        EXPECT_EQ(end, ends[step]);
+    }
+
+    // Counted over Run()s.
+    EXPECT_EQ(vm.Run(4), DoubleVm::Result::budget_exhausted);
+    EXPECT_EQ(vm.Run(100), DoubleVm::Result::completed);
+    const unsigned long counts[] = {1, 2, 2, 2, 2, 1};
+    for (std::size_t step = 0; step < 6; step++)
+    {
+        EXPECT_EQ(vm.GetProfile()[step].count, counts[step]) << step;
+        EXPECT_GT(vm.GetProfile()[step].time.count(), 0);
+    }
+
+    std::FILE *file = std::tmpfile();
+    ASSERT_NE(file, nullptr);
+    vm.WriteFlatProfile(file);
+    vm.WriteAnnotatedListing(file, program, length);
+    std::rewind(file);
+    std::string text;
+    char buffer[256];
+    while (std::fgets(buffer, sizeof(buffer), file) != nullptr)
+        text += buffer;
+    std::fclose(file);
+
+    // Flat profile sums the numbers.
+    EXPECT_NE(text.find("           5  "), std::string::npos) << text;
+    EXPECT_NE(text.find("  number\n"), std::string::npos) << text;
+    EXPECT_NE(text.find("  x_lt_y\n"), std::string::npos) << text;
+    // The label and nop are listed without the record.
+    EXPECT_NE(text.find(" label num_1\n"), std::string::npos) << text;
+    EXPECT_NE(text.find(" go_to num_1\n"), std::string::npos) << text;
+    EXPECT_NE(text.find(" nop\n"), std::string::npos) << text;
+
+    vm.ClearProfile();
+    EXPECT_EQ(vm.GetProfile()[1].count, 0u);
+}
+#endif
@@ -0,0 +1,184 @@
+// Test cases for the rpn_engine::WireFormat class
+
+#include "gtest/gtest.h"
+#include "rpnengine.hpp"
+#include <type_traits>
+#include <vector>
+
+using rpn_engine::Op;
+using rpn_engine::WireFormat;
+
+static const unsigned int kOpCount = static_cast<std::underlying_type<Op>::type>(Op::chs) + 1;
+
+// Encode and decode. Then return the encoded size.
+static std::size_t RoundTrip(const std::vector<Op> &program)
+{
+    std::vector<uint8_t> data;
+    std::vector<Op> decoded;
+    WireFormat::Encode(program.data(), program.size(), data);
+    EXPECT_TRUE(WireFormat::Decode(data.data(), data.size(), decoded));
+    EXPECT_EQ(decoded, program);
+    return data.size();
+}
+
+TEST(WireFormatTest, Size)
+{
+    // Version and count only.
+    EXPECT_EQ(RoundTrip({}), 2u);
+
+    // A nibble for the short codes. The odd nibble is padded.
+    EXPECT_EQ(RoundTrip({Op::num_1, Op::period, Op::num_5, Op::enter, Op::num_2, Op::mul}), 2u + 3u);
+    EXPECT_EQ(RoundTrip({Op::num_1, Op::add, Op::num_2}), 2u + 2u);
+
+    // Three nibbles for the others.
+    EXPECT_EQ(RoundTrip({Op::sqrt, Op::num_1}), 2u + 2u);
+    EXPECT_EQ(RoundTrip({Op::sin, Op::cos}), 2u + 3u);
+
+    // Repetition. 3 nibbles of del, 3 nibbles of the repeat and 2 nibbles of the count 39.
+    EXPECT_EQ(RoundTrip(std::vector<Op>(40, Op::del)), 2u + 4u);
+    // Short repetition is not shorter.
+    EXPECT_EQ(RoundTrip(std::vector<Op>(4, Op::num_0)), 2u + 2u);
+    EXPECT_EQ(RoundTrip(std::vector<Op>(100000, Op::num_0)), 4u + 5u);
+
+    // The count is a varint.
+    EXPECT_EQ(RoundTrip(std::vector<Op>(128, Op::num_0)), 3u + 4u);
+}
+
+TEST(WireFormatTest, AllOpcodes)
+{
+    std::vector<Op> program;
+    for (unsigned int i = 0; i < kOpCount; i++)
+        program.push_back(static_cast<Op>(i));
+    RoundTrip(program);
+
+    // Each opcode repeated.
+    program.clear();
+    for (unsigned int i = 0; i < kOpCount; i++)
+        program.insert(program.end(), i % 20 + 1, static_cast<Op>(i));
+    RoundTrip(program);
+}
+
+TEST(WireFormatTest, Random)
+{
+    rpn_engine::Xoshiro256 random(3);
+    for (int trial = 0; trial < 200; trial++)
+    {
+        // Mostly short codes to exercise the fast path at the various alignments.
+        std::vector<Op> program(random.Next() % 500);
+        for (auto &opcode : program)
+        {
+            uint64_t r = random.Next();
+            if (r % 8 == 0)
+                opcode = static_cast<Op>((r >> 8) % kOpCount);
+            else
+                opcode = static_cast<Op>(static_cast<unsigned int>(Op::num_0) + (r >> 8) % 10);
+        }
+        RoundTrip(program);
+    }
+}
+
+TEST(WireFormatTest, Broken)
+{
+    std::vector<uint8_t> data;
+    std::vector<Op> program = {Op::num_1, Op::num_2, Op::sqrt};
+    std::vector<Op> decoded;
+    WireFormat::Encode(program.data(), program.size(), data); // 01 03 21 XF X
+
+    // Truncated.
+    for (std::size_t size = 0; size < data.size(); size++)
+        EXPECT_FALSE(WireFormat::Decode(data.data(), size, decoded)) << size;
+
+    // Extra byte.
+    std::vector<uint8_t> extra = data;
+    extra.push_back(0);
+    EXPECT_FALSE(WireFormat::Decode(extra.data(), extra.size(), decoded));
+    EXPECT_TRUE(decoded.empty());
+
+    // Nonzero padding.
+    std::vector<Op> odd = {Op::num_1};
+    WireFormat::Encode(odd.data(), odd.size(), data);
+    EXPECT_TRUE(WireFormat::Decode(data.data(), data.size(), decoded));
+    data[2] |= 0x20;
+    EXPECT_FALSE(WireFormat::Decode(data.data(), data.size(), decoded));
+
+    // Unknown opcode.
+    const uint8_t unknown[] = {1, 1, 0xEF, 0x0E};
+    EXPECT_FALSE(WireFormat::Decode(unknown, sizeof(unknown), decoded));
+
+    // Repetition without the previous opcode, and beyond the count.
+    const uint8_t first_repeat[] = {1, 2, 0xFF, 0x1F};
+    EXPECT_FALSE(WireFormat::Decode(first_repeat, sizeof(first_repeat), decoded));
+    const uint8_t too_many[] = {1, 3, 0xF1, 0xFF, 0x03};
+    EXPECT_FALSE(WireFormat::Decode(too_many, sizeof(too_many), decoded));
+    const uint8_t just[] = {1, 3, 0xF1, 0xFF, 0x02};
+    EXPECT_TRUE(WireFormat::Decode(just, sizeof(just), decoded));
+    EXPECT_EQ(decoded, std::vector<Op>(3, Op::num_1));
+
+    // Huge count with short data.
+    const uint8_t huge[] = {1, 0xFF, 0xFF, 0xFF, 0xFF, 0x0F, 0x21};
+    EXPECT_FALSE(WireFormat::Decode(huge, sizeof(huge), decoded));
+}
+
+// The encoded bytes don't change by the reordering of the Op enum.
+TEST(WireFormatTest, PinnedBytes)
+{
+    std::vector<uint8_t> data;
+    std::vector<Op> decoded;
+
+    // Version, count and the nibbles 1 2 F A 0 of sqrt.
+    const std::vector<Op> sqrt = {Op::num_1, Op::num_2, Op::sqrt};
+    WireFormat::Encode(sqrt.data(), sqrt.size(), data);
+    EXPECT_EQ(data, (std::vector<uint8_t>{0x01, 0x03, 0x21, 0xAF, 0x00}));
+
+    // The first and the last code of the first table, the appended codes and a repetition.
+    const std::vector<Op> program = {Op::duplicate, Op::chs, Op::coefficient_store, Op::coefficient_polynomial,
+                                     Op::sin, Op::sin, Op::sin, Op::sin, Op::sin};
+    WireFormat::Encode(program.data(), program.size(), data);
+    EXPECT_EQ(data, (std::vector<uint8_t>{0x01, 0x09, 0x0F, 0xF0, 0x55, 0x6F, 0xF5, 0x57, 0x2F, 0xF1, 0xFF, 0x04}));
+    EXPECT_TRUE(WireFormat::Decode(data.data(), data.size(), decoded));
+    EXPECT_EQ(decoded, program);
+
+    // Unknown version.
+    data[0] = 2;
+    EXPECT_FALSE(WireFormat::Decode(data.data(), data.size(), decoded));
+    EXPECT_TRUE(decoded.empty());
+    data[0] = 0;
+    EXPECT_FALSE(WireFormat::Decode(data.data(), data.size(), decoded));
+}
+
+// The mutated data is rejected or decoded to a program which survives the round trip.
+// The buffer is reused to catch the write beyond the decoded size.
+TEST(WireFormatTest, MalformedFuzz)
+{
+    rpn_engine::Xoshiro256 random(7);
+    std::vector<uint8_t> data;
+    std::vector<Op> decoded;
+    for (int trial = 0; trial < 20000; trial++)
+    {
+        // Short codes, escapes and repetitions.
+        std::vector<Op> program(random.Next() % 80);
+        for (auto &opcode : program)
+        {
+            uint64_t r = random.Next();
+            if (r % 4 == 0)
+                opcode = static_cast<Op>((r >> 8) % kOpCount);
+            else
+                opcode = static_cast<Op>(static_cast<unsigned int>(Op::num_0) + (r >> 8) % 4);
+        }
+        WireFormat::Encode(program.data(), program.size(), data);
+
+        // Flip the bits, truncate or append.
+        const uint64_t r = random.Next();
+        for (unsigned int k = 0; k < r % 4 && !data.empty(); k++)
+            data[random.Next() % data.size()] ^= static_cast<uint8_t>(1 << (random.Next() % 8));
+        if ((r >> 8) % 4 == 0 && !data.empty())
+            data.resize(random.Next() % data.size());
+        if ((r >> 8) % 4 == 1)
+            data.push_back(static_cast<uint8_t>(random.Next()));
+
+        if (WireFormat::Decode(data.data(), data.size(), decoded))
+            RoundTrip(decoded);
+        else
+            EXPECT_TRUE(decoded.empty());
+    }
+}
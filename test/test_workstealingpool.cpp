@@ -0,0 +1,58 @@
+// Test cases for the rpn_engine::WorkStealingPool class
+
+#include "gtest/gtest.h"
+#include "rpnengine.hpp"
+#include <atomic>
+#include <vector>
+
+// Spawn a binary tree of tasks.
+static void Tree(rpn_engine::WorkStealingPool &pool, unsigned int worker, int depth, std::atomic<int> &leaves)
+{
+    if (depth == 0)
+    {
+        leaves++;
+        return;
+    }
+    pool.Spawn(worker, [&pool, depth, &leaves](unsigned int w)
+               { Tree(pool, w, depth - 1, leaves); });
+    Tree(pool, worker, depth - 1, leaves);
+}
+
+TEST(WorkStealingPoolTest, Run)
+{
+    for (unsigned int threads = 1; threads <= 4; threads++)
+    {
+        rpn_engine::WorkStealingPool pool(threads);
+        EXPECT_EQ(pool.GetThreadCount(), threads);
+
+        // Run() waits for all spawned tasks. The pool can be reused.
+        for (int repeat = 0; repeat < 10; repeat++)
+        {
+            std::atomic<int> leaves(0);
+            pool.Run([&](unsigned int worker)
+                     {
+                         EXPECT_EQ(worker, 0u);
+                         Tree(pool, worker, 10, leaves); });
+            EXPECT_EQ(leaves, 1024);
+        }
+    }
+}
+
+TEST(WorkStealingPoolTest, Worker)
+{
+    rpn_engine::WorkStealingPool pool(3);
+    std::vector<int> counts(pool.GetThreadCount(), 0);
+
+    // Each task gets the id of the worker running it. The counts are not shared.
+    pool.Run([&](unsigned int worker)
+             {
+                 for (int i = 0; i < 1000; i++)
+                     pool.Spawn(worker, [&](unsigned int w)
+                                { counts[w]++; }); });
+    int total = 0;
+    for (auto count : counts)
+        total += count;
+    EXPECT_EQ(total, 1000);
+
+    EXPECT_GT(rpn_engine::WorkStealingPool().GetThreadCount(), 0u);
+}
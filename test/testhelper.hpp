@@ -0,0 +1,29 @@
+#pragma once
+// Helper functions shared by the test cases of the evaluators
+
+#include "gtest/gtest.h"
+#include "rpnengine.hpp"
+#include <cmath>
+#include <complex>
+#include <string>
+#include <vector>
+
+// Parse the program text.
+inline std::vector<rpn_engine::Op> Parse(const std::string &text)
+{
+    std::vector<rpn_engine::Op> program;
+    unsigned int line = 0;
+    EXPECT_TRUE(rpn_engine::ParseProgramText(text.c_str(), program, line)) << text;
+    return program;
+}
+
+// Same value with the same sign, or both NaN. So, 0 and -0 are different.
+inline bool IsSame(double a, double b)
+{
+    return (a == b && std::signbit(a) == std::signbit(b)) || (std::isnan(a) && std::isnan(b));
+}
+
+inline bool IsSame(const std::complex<double> &a, const std::complex<double> &b)
+{
+    return IsSame(a.real(), b.real()) && IsSame(a.imag(), b.imag());
+}
@@ -0,0 +1,83 @@
+/**
+ * @file rpnc.cpp
+ * @author Seiichi "Suikan" Horie
+ * @brief Command line driver of the AotCompiler.
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2026
+ *
+ * @details
+ * Usage :
+ * @code
+ * rpnc [--complex] name program.rpn output.cpp output.hpp
+ * @endcode
+ * The program.rpn is the text form of the program. See ParseProgramText().
+ * The function "name" is generated to output.cpp and declared in output.hpp.
+ */
+#include "aotcompiler.hpp"
+#include "opcode.hpp"
+#include "programtext.hpp"
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <string>
+
+static bool WriteFile(const char *path, const std::string &text)
+{
+    std::ofstream file(path);
+    file << text;
+    return static_cast<bool>(file);
+}
+
+int main(int argc, char *argv[])
+{
+    int arg = 1;
+    rpn_engine::AotCompiler::ElementType type = rpn_engine::AotCompiler::ElementType::real;
+    if (arg < argc && std::strcmp(argv[arg], "--complex") == 0)
+    {
+        type = rpn_engine::AotCompiler::ElementType::complex;
+        arg++;
+    }
+    if (argc - arg != 4)
+    {
+        std::fprintf(stderr, "usage : rpnc [--complex] name program.rpn output.cpp output.hpp\n");
+        return 1;
+    }
+    const char *name = argv[arg];
+    const char *input = argv[arg + 1];
+
+    std::ifstream file(input);
+    if (!file)
+    {
+        std::fprintf(stderr, "%s : cannot open\n", input);
+        return 1;
+    }
+    std::stringstream text;
+    text << file.rdbuf();
+
+    std::vector<rpn_engine::Op> program;
+    unsigned int line;
+    if (!rpn_engine::ParseProgramText(text.str().c_str(), program, line))
+    {
+        std::fprintf(stderr, "%s:%u : unknown token\n", input, line);
+        return 1;
+    }
+
+    rpn_engine::AotCompiler compiler;
+    if (!compiler.Compile(program.data(), program.size()))
+    {
+        std::fprintf(stderr, "%s : %s is not supported by the compiler\n",
+                     input, rpn_engine::GetOpName(program[compiler.GetErrorPosition()]));
+        return 1;
+    }
+
+    if (!WriteFile(argv[arg + 2], compiler.GenerateSource(name, type)) ||
+        !WriteFile(argv[arg + 3], compiler.GenerateHeader(name, type)))
+    {
+        std::fprintf(stderr, "%s : cannot write the output\n", name);
+        return 1;
+    }
+    return 0;
+}
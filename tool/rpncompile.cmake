@@ -0,0 +1,38 @@
+# Helper to compile an Op program to a C++ function at the build time.
+#
+# rpn_compile_function(<target> <name> <program> [COMPLEX])
+#   target  : Target to add the generated function.
+#   name    : Name of the generated function. Also used as the file name.
+#   program : Program text file. See ParseProgramText() in src/programtext.hpp.
+#   COMPLEX : Generate std::complex<double> function instead of double.
+#
+# The function is generated as <name>.cpp and <name>.hpp in the rpn_generated
+# sub-directory of the current binary directory. The target can include <name>.hpp.
+
+# Cached to be visible from the function called in the other directories.
+set(RPN_ENGINE_SOURCE_DIR "${CMAKE_CURRENT_LIST_DIR}/../src" CACHE INTERNAL "Source directory of the rpn_engine")
+
+function(rpn_compile_function TARGET NAME PROGRAM)
+    cmake_parse_arguments(ARG "COMPLEX" "" "" ${ARGN})
+
+    set(OUTPUT_DIR "${CMAKE_CURRENT_BINARY_DIR}/rpn_generated")
+    set(OUTPUT_SOURCE "${OUTPUT_DIR}/${NAME}.cpp")
+    set(OUTPUT_HEADER "${OUTPUT_DIR}/${NAME}.hpp")
+    get_filename_component(PROGRAM_PATH "${PROGRAM}" ABSOLUTE)
+
+    set(TYPE_OPTION)
+    if(ARG_COMPLEX)
+        set(TYPE_OPTION "--complex")
+    endif()
+
+    file(MAKE_DIRECTORY "${OUTPUT_DIR}")
+    add_custom_command(
+        OUTPUT "${OUTPUT_SOURCE}" "${OUTPUT_HEADER}"
+        COMMAND rpnc ${TYPE_OPTION} "${NAME}" "${PROGRAM_PATH}" "${OUTPUT_SOURCE}" "${OUTPUT_HEADER}"
+        DEPENDS rpnc "${PROGRAM_PATH}"
+        COMMENT "Compiling ${PROGRAM} to ${NAME}()"
+        VERBATIM)
+
+    target_sources(${TARGET} PRIVATE "${OUTPUT_SOURCE}" "${OUTPUT_HEADER}")
+    target_include_directories(${TARGET} PRIVATE "${OUTPUT_DIR}" "${RPN_ENGINE_SOURCE_DIR}")
+endfunction()
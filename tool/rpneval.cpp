@@ -0,0 +1,888 @@
+/**
+ * @file rpneval.cpp
+ * @author Seiichi "Suikan" Horie
+ * @brief Command line evaluator of a program over the columns of a data file.
+ * @version 0.1
+ * @date 2026-10-18
+ *
+ * @copyright Copyright (c) 2026
+ *
+ * @details
+ * Usage :
+ * @code
+ * rpneval [--binary columns] [--threads n] (-p program.rpn | -e expression) input output
+ * @endcode
+ * The input is a CSV file by default. The first line is the header if it has a field which
+ * is not a number. With --binary, the input is the raw double of the host byte order, column
+ * after column. The number of the rows is the file size divided by the size of a column.
+ *
+ * The columns of a row are pushed to the stack in order. So, the last column is X. The program
+ * is given by the text form ( See ParseProgramText() ) or by the infix expression. In the
+ * expression, a column is the variable of its header name, or c0, c1, ... without the header.
+ *
+ * The output is the raw double of X after the program, one for each row. Both files are
+ * mapped to the memory. The binary columns are given to the BatchFunction from the mapped
+ * input and the results are written to the mapped output directly. The throughput is
+ * reported to the stderr.
+ *
+ * Streaming mode :
+ * @code
+ * rpneval --stream [--columns n] [--frame samples] [--deadline ms] (-p program.rpn | -e expression)
+ * @endcode
+ * The samples are read from the stdin and the results are written to the stdout. A sample is
+ * the interleaved doubles of the columns ( 1 by default ), like I and Q. The samples are
+ * evaluated in the frames ( 1024 samples by default ). A frame is evaluated when it is full, or
+ * when the deadline ( 10 ms by default ) from its first byte is passed. So, the latency of a slow
+ * stream is bounded. The stdin and the stdout are read and written by the threads with two
+ * buffers for each. If the stdout is slow, the stdin is not read. The latency percentiles from
+ * the read to the write of the frames are reported to the stderr at the end.
+ *
+ * SIGINT or SIGTERM stops the reading. The frames already read are evaluated and written, and
+ * the percentiles are reported. The second signal terminates at once.
+ */
+#include "batchfunction.hpp"
+#include "infixcompiler.hpp"
+#include "opcode.hpp"
+#include "programtext.hpp"
+#include "workstealingpool.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <csignal>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <fcntl.h>
+#include <fstream>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <poll.h>
+#include <sstream>
+#include <string>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+// Rows evaluated by a task.
+static const std::size_t kChunkRows = 64 * rpn_engine::BatchFunction::kBlockSize;
+// Approximate bytes of the CSV parsed by a task.
+static const std::size_t kRangeBytes = 1 << 20;
+// The register of sto is given by a digit key.
+static const unsigned int kMaxVariableColumns = 10;
+
+// A file mapped to the memory. Unmapped and closed by the destructor.
+struct MappedFile
+{
+    int fd;
+    void *data;
+    std::size_t size;
+
+    MappedFile() : fd(-1), data(MAP_FAILED), size(0) {}
+    ~MappedFile()
+    {
+        if (data != MAP_FAILED)
+            munmap(data, size);
+        if (fd >= 0)
+            close(fd);
+    }
+};
+
+static bool MapInput(const char *path, MappedFile &file)
+{
+    file.fd = open(path, O_RDONLY);
+    struct stat status;
+    if (file.fd < 0 || fstat(file.fd, &status) != 0)
+        return false;
+    file.size = static_cast<std::size_t>(status.st_size);
+    if (file.size == 0)
+        return true;
+    file.data = mmap(nullptr, file.size, PROT_READ, MAP_PRIVATE, file.fd, 0);
+    if (file.data == MAP_FAILED)
+        return false;
+    madvise(file.data, file.size, MADV_SEQUENTIAL);
+    return true;
+}
+
+static bool MapOutput(const char *path, std::size_t size, MappedFile &file)
+{
+    file.fd = open(path, O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (file.fd < 0)
+        return false;
+    file.size = size;
+    if (size == 0)
+        return true;
+    // Allocate the blocks now. A write to the mapping can't report the full disk.
+    // Only the file system without the allocation falls back to the sparse file.
+    int error = posix_fallocate(file.fd, 0, static_cast<off_t>(size));
+    if (error == EOPNOTSUPP || error == EINVAL)
+        error = ftruncate(file.fd, static_cast<off_t>(size));
+    if (error == 0)
+        file.data = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, file.fd, 0);
+    if (error != 0 || file.data == MAP_FAILED)
+    {
+        // Don't leave the unwritten output.
+        unlink(path);
+        return false;
+    }
+    return true;
+}
+
+// Parse a decimal number. The exact cases are calculated by one multiplication or division
+// of the exact double ( Clinger's fast path ). The others are given to the strtod().
+static bool ParseDecimal(const char *begin, const char *end, double &value)
+{
+    static const double kPowerOf10[] = {1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10,
+                                        1e11, 1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20,
+                                        1e21, 1e22};
+    const char *p = begin;
+    bool is_negative = false;
+    if (p < end && (*p == '+' || *p == '-'))
+        is_negative = *p++ == '-';
+
+    uint64_t mantissa = 0;
+    int digits = 0; // Significant digits in the mantissa.
+    int exponent = 0;
+    bool has_digit = false;
+    bool is_truncated = false;
+    for (bool is_fraction = false; p < end; p++)
+    {
+        if (*p == '.' && !is_fraction)
+        {
+            is_fraction = true;
+            continue;
+        }
+        unsigned int digit = static_cast<unsigned char>(*p) - '0';
+        if (digit > 9)
+            break;
+        has_digit = true;
+        if (digits < 19)
+        {
+            mantissa = mantissa * 10 + digit;
+            if (mantissa != 0)
+                digits++;
+            if (is_fraction)
+                exponent--;
+        }
+        else
+        {
+            is_truncated = is_truncated || digit != 0;
+            if (!is_fraction)
+                exponent++;
+        }
+    }
+    if (has_digit && p < end && (*p == 'e' || *p == 'E'))
+    {
+        p++;
+        bool is_negative_exponent = false;
+        if (p < end && (*p == '+' || *p == '-'))
+            is_negative_exponent = *p++ == '-';
+        if (p == end || static_cast<unsigned int>(static_cast<unsigned char>(*p) - '0') > 9)
+            return false;
+        int e = 0;
+        for (; p < end && static_cast<unsigned int>(static_cast<unsigned char>(*p) - '0') <= 9; p++)
+            if (e < 100000)
+                e = e * 10 + (*p - '0');
+        exponent += is_negative_exponent ? -e : e;
+    }
+    if (!has_digit || p != end)
+    {
+        // nan, inf, hexadecimal and so on.
+        std::string text(begin, end);
+        char *stop;
+        value = std::strtod(text.c_str(), &stop);
+        return !text.empty() && *stop == '\0';
+    }
+
+    if (is_truncated || mantissa > (uint64_t(1) << 53) || exponent < -22 || exponent > 22)
+    {
+        std::string text(begin, end);
+        value = std::strtod(text.c_str(), nullptr);
+        return true;
+    }
+    value = static_cast<double>(mantissa);
+    value = exponent < 0 ? value / kPowerOf10[-exponent] : value * kPowerOf10[exponent];
+    if (is_negative)
+        value = -value;
+    return true;
+}
+
+// Parse a field of CSV and move p to the delimiter ( comma, new line or end ).
+static bool ParseField(const char *&p, const char *end, double &value)
+{
+    while (p < end && (*p == ' ' || *p == '\t'))
+        p++;
+    const char *begin = p;
+    while (p < end && *p != ',' && *p != '\n')
+        p++;
+    const char *last = p;
+    while (last > begin && (last[-1] == ' ' || last[-1] == '\t' || last[-1] == '\r'))
+        last--;
+    if (!ParseDecimal(begin, last, value))
+    {
+        value = std::numeric_limits<double>::quiet_NaN();
+        return false;
+    }
+    return true;
+}
+
+// Parse a line to the row of the columns. The missing fields are NaN. Return the next line.
+static const char *ParseLine(const char *p, const char *end, std::vector<std::vector<double>> &columns, std::size_t row)
+{
+    std::size_t column = 0;
+    while (true)
+    {
+        double value;
+        ParseField(p, end, value);
+        if (column < columns.size())
+            columns[column][row] = value;
+        column++;
+        if (p == end || *p == '\n')
+            break;
+        p++; // Comma.
+    }
+    for (; column < columns.size(); column++)
+        columns[column][row] = std::numeric_limits<double>::quiet_NaN();
+    return p == end ? p : p + 1;
+}
+
+// Split the first line of CSV to the fields. Return true if all fields are numbers.
+static bool SplitHeader(const char *p, const char *end, std::vector<std::string> &fields)
+{
+    bool is_number = true;
+    while (true)
+    {
+        const char *begin = p;
+        double value;
+        is_number = ParseField(p, end, value) && is_number;
+        std::string field(begin, p);
+        field.erase(0, field.find_first_not_of(" \t"));
+        field.erase(field.find_last_not_of(" \t\r") + 1);
+        fields.push_back(field);
+        if (p == end || *p == '\n')
+            return is_number;
+        p++;
+    }
+}
+
+static bool ReadProgram(const char *path, std::vector<rpn_engine::Op> &program)
+{
+    std::ifstream file(path);
+    if (!file)
+    {
+        std::fprintf(stderr, "%s : cannot open\n", path);
+        return false;
+    }
+    std::stringstream text;
+    text << file.rdbuf();
+
+    unsigned int line;
+    if (!rpn_engine::ParseProgramText(text.str().c_str(), program, line))
+    {
+        std::fprintf(stderr, "%s:%u : unknown token\n", path, line);
+        return false;
+    }
+    return true;
+}
+
+// Compile the expression of the column variables. Each column is stored to its register
+// before the expression. So, the rcl of the variable is the input of the stack.
+static bool CompileExpression(const char *expression, const std::vector<std::string> &names,
+                              std::vector<rpn_engine::Op> &program, unsigned int &stack_size)
+{
+    static const rpn_engine::Op kDigits[] = {rpn_engine::Op::num_0, rpn_engine::Op::num_1, rpn_engine::Op::num_2,
+                                             rpn_engine::Op::num_3, rpn_engine::Op::num_4, rpn_engine::Op::num_5,
+                                             rpn_engine::Op::num_6, rpn_engine::Op::num_7, rpn_engine::Op::num_8,
+                                             rpn_engine::Op::num_9};
+    const unsigned int count = static_cast<unsigned int>(names.size());
+    if (count > kMaxVariableColumns)
+    {
+        std::fprintf(stderr, "the expression takes up to %u columns\n", kMaxVariableColumns);
+        return false;
+    }
+
+    rpn_engine::InfixCompiler compiler(stack_size);
+    for (unsigned int i = 0; i < count; i++)
+        if (!compiler.DefineVariable(names[i], i))
+        {
+            std::fprintf(stderr, "column name \"%s\" is duplicated\n", names[i].c_str());
+            return false;
+        }
+    // Occupy the other registers by the names which are not the identifier. Then, an unknown
+    // variable is too_many_variables rather than a register of zero.
+    for (unsigned int i = count; i < rpn_engine::kNumberOfVmRegisters; i++)
+        compiler.DefineVariable("#" + std::to_string(i), i);
+
+    // X is the last column.
+    for (unsigned int i = count; i-- > 0;)
+    {
+        program.push_back(rpn_engine::Op::sto);
+        program.push_back(kDigits[i]);
+        program.push_back(rpn_engine::Op::rotate_pop);
+    }
+
+    rpn_engine::InfixCompiler::Status status = compiler.Compile(expression, program);
+    switch (status)
+    {
+    case rpn_engine::InfixCompiler::Status::ok:
+        return true;
+    case rpn_engine::InfixCompiler::Status::stack_overflow:
+        stack_size = compiler.GetRequiredDepth();
+        return true;
+    case rpn_engine::InfixCompiler::Status::too_many_variables:
+        std::fprintf(stderr, "%s\n%*s^ unknown variable\n", expression, static_cast<int>(compiler.GetErrorPosition()), "");
+        return false;
+    default:
+        std::fprintf(stderr, "%s\n%*s^ syntax error\n", expression, static_cast<int>(compiler.GetErrorPosition()), "");
+        return false;
+    }
+}
+
+// One BatchFunction and the parse buffer for each worker.
+struct Worker
+{
+    rpn_engine::BatchFunction function;
+    std::vector<std::vector<double>> columns;
+    std::vector<const double *> inputs; // Stack order. 0 is X.
+
+    Worker(unsigned int stack_size, std::size_t column_count, bool has_buffer) : function(stack_size),
+                                                                                  columns(has_buffer ? column_count : 0, std::vector<double>(kChunkRows)),
+                                                                                  inputs(column_count)
+    {
+    }
+};
+
+static void EvaluateBinary(rpn_engine::WorkStealingPool &pool, std::vector<std::unique_ptr<Worker>> &workers,
+                           const double *input, std::size_t column_count, std::size_t rows, double *output)
+{
+    pool.Run([&](unsigned int worker)
+             {
+                 for (std::size_t first = 0; first < rows; first += kChunkRows)
+                     pool.Spawn(worker, [&, first](unsigned int w)
+                                {
+                                    Worker &self = *workers[w];
+                                    for (std::size_t k = 0; k < column_count; k++)
+                                        self.inputs[column_count - 1 - k] = input + k * rows + first;
+                                    const std::size_t count = std::min(kChunkRows, rows - first);
+                                    self.function.Evaluate(self.inputs.data(), static_cast<unsigned int>(column_count),
+                                                           output + first, count);
+                                }); });
+}
+
+// Count the rows of the CSV ranges, then parse and evaluate each range at its row offset.
+static std::size_t EvaluateCsv(rpn_engine::WorkStealingPool &pool, std::vector<std::unique_ptr<Worker>> &workers,
+                               const char *body, const char *end, const char *output_path, MappedFile &output)
+{
+    // The ranges start at the head of a line.
+    const std::size_t size = static_cast<std::size_t>(end - body);
+    const std::size_t range_count = std::max<std::size_t>(4 * pool.GetThreadCount(), size / kRangeBytes + 1);
+    std::vector<const char *> bounds(range_count + 1, end);
+    bounds[0] = body;
+    for (std::size_t i = 1; i < range_count; i++)
+    {
+        const char *p = std::max(bounds[i - 1], body + size / range_count * i);
+        if (p > body && p < end && p[-1] != '\n')
+        {
+            p = static_cast<const char *>(std::memchr(p, '\n', static_cast<std::size_t>(end - p)));
+            p = p ? p + 1 : end;
+        }
+        bounds[i] = p;
+    }
+
+    std::vector<std::size_t> offsets(range_count + 1, 0);
+    pool.Run([&](unsigned int worker)
+             {
+                 for (std::size_t i = 0; i < range_count; i++)
+                     pool.Spawn(worker, [&, i](unsigned int)
+                                {
+                                    std::size_t count = 0;
+                                    for (const char *p = bounds[i]; p < bounds[i + 1]; count++)
+                                    {
+                                        p = static_cast<const char *>(std::memchr(p, '\n', static_cast<std::size_t>(bounds[i + 1] - p)));
+                                        p = p ? p + 1 : bounds[i + 1];
+                                    }
+                                    offsets[i + 1] = count;
+                                }); });
+    for (std::size_t i = 0; i < range_count; i++)
+        offsets[i + 1] += offsets[i];
+    const std::size_t rows = offsets[range_count];
+
+    if (!MapOutput(output_path, rows * sizeof(double), output))
+    {
+        std::fprintf(stderr, "%s : cannot write the output\n", output_path);
+        return SIZE_MAX;
+    }
+    double *results = static_cast<double *>(output.data);
+
+    pool.Run([&](unsigned int worker)
+             {
+                 for (std::size_t i = 0; i < range_count; i++)
+                     pool.Spawn(worker, [&, i](unsigned int w)
+                                {
+                                    Worker &self = *workers[w];
+                                    const std::size_t column_count = self.columns.size();
+                                    for (std::size_t k = 0; k < column_count; k++)
+                                        self.inputs[column_count - 1 - k] = self.columns[k].data();
+
+                                    std::size_t row = offsets[i];
+                                    const char *p = bounds[i];
+                                    while (p < bounds[i + 1])
+                                    {
+                                        std::size_t count = 0;
+                                        for (; count < kChunkRows && p < bounds[i + 1]; count++)
+                                            p = ParseLine(p, bounds[i + 1], self.columns, count);
+                                        self.function.Evaluate(self.inputs.data(), static_cast<unsigned int>(column_count),
+                                                               results + row, count);
+                                        row += count;
+                                    }
+                                }); });
+    return rows;
+}
+
+// Samples of a stream.
+struct Frame
+{
+    std::vector<double> data;
+    std::size_t samples;
+    std::chrono::steady_clock::time_point arrival; // First byte of the frame is read.
+    bool is_short;                                 // Given by the deadline before full.
+};
+
+// Queue of the frames between the threads. Push() waits while full and Pop() waits while
+// empty. So, a slow consumer stops the producer. Close() releases all waiting threads.
+class FrameQueue
+{
+public:
+    explicit FrameQueue(std::size_t capacity) : capacity_(capacity), is_closed_(false) {}
+
+    bool Push(Frame *frame)
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        not_full_.wait(lock, [this]
+                       { return is_closed_ || frames_.size() < capacity_; });
+        if (is_closed_)
+            return false;
+        frames_.push_back(frame);
+        not_empty_.notify_one();
+        return true;
+    }
+
+    // Return false if closed and empty.
+    bool Pop(Frame *&frame)
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        not_empty_.wait(lock, [this]
+                        { return is_closed_ || !frames_.empty(); });
+        if (frames_.empty())
+            return false;
+        frame = frames_.front();
+        frames_.pop_front();
+        not_full_.notify_one();
+        return true;
+    }
+
+    void Close()
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        is_closed_ = true;
+        not_empty_.notify_all();
+        not_full_.notify_all();
+    }
+
+private:
+    const std::size_t capacity_;
+    std::deque<Frame *> frames_;
+    bool is_closed_;
+    std::mutex mutex_;
+    std::condition_variable not_empty_;
+    std::condition_variable not_full_;
+};
+
+// Histogram of the latency in the buckets of 1/8 octave. The memory is bounded for an endless stream.
+class LatencyHistogram
+{
+public:
+    LatencyHistogram() : counts_(kBucketCount, 0), total_(0), max_(0) {}
+
+    void Add(std::chrono::steady_clock::duration latency)
+    {
+        const double ns = static_cast<double>(std::chrono::duration_cast<std::chrono::nanoseconds>(latency).count());
+        const int bucket = ns < 1 ? 0 : static_cast<int>(std::log2(ns) * kBucketsPerOctave) + 1;
+        counts_[std::min(bucket, kBucketCount - 1)]++;
+        total_++;
+        max_ = std::max(max_, ns);
+    }
+
+    // Upper bound of the bucket of the ratio in microseconds.
+    double GetPercentile(double ratio) const
+    {
+        const uint64_t rank = static_cast<uint64_t>(std::ceil(ratio * total_));
+        uint64_t count = 0;
+        for (int i = 0; i < kBucketCount; i++)
+        {
+            count += counts_[i];
+            if (count >= rank && count > 0)
+                return std::min(max_, std::exp2(static_cast<double>(i) / kBucketsPerOctave)) * 1e-3;
+        }
+        return max_ * 1e-3;
+    }
+
+    double GetMax() const { return max_ * 1e-3; }
+
+private:
+    static const int kBucketsPerOctave = 8;
+    static const int kBucketCount = 64 * kBucketsPerOctave;
+    std::vector<uint64_t> counts_;
+    uint64_t total_;
+    double max_; // ns.
+};
+
+// Set by SIGINT and SIGTERM. Only the lock free atomic is safe in the signal handler.
+static_assert(ATOMIC_BOOL_LOCK_FREE == 2, "The signal handler needs the lock free bool");
+static std::atomic<bool> is_interrupted(false);
+
+static void Interrupt(int signal_number)
+{
+    is_interrupted = true;
+    std::signal(signal_number, SIG_DFL); // The next one terminates.
+}
+
+// Read a frame from the stdin. The frame is given when it is full, or when the deadline from
+// its first byte is passed with at least one sample. The bytes of an incomplete sample are kept
+// in the carry for the next frame. Return false at the end of the input, the stop or the interrupt.
+static bool ReadFrame(Frame &frame, std::size_t sample_bytes, std::chrono::milliseconds deadline,
+                      std::vector<char> &carry, const std::atomic<bool> &is_stopping)
+{
+    char *buffer = reinterpret_cast<char *>(frame.data.data());
+    const std::size_t capacity = frame.data.size() * sizeof(double);
+    std::size_t bytes = carry.size();
+    std::copy(carry.begin(), carry.end(), buffer);
+    frame.arrival = std::chrono::steady_clock::now();
+    frame.is_short = false;
+
+    bool is_end = false;
+    while (bytes < capacity && !is_stopping && !is_interrupted)
+    {
+        // Wait until the deadline if a sample can be given. Otherwise, wake up periodically
+        // to see the stop. The time is rounded up not to poll busily before the deadline.
+        int timeout = 100;
+        if (bytes >= sample_bytes)
+        {
+            auto rest = std::chrono::duration_cast<std::chrono::microseconds>(frame.arrival + deadline - std::chrono::steady_clock::now());
+            timeout = static_cast<int>(std::max<long long>(0, (rest.count() + 999) / 1000));
+        }
+        struct pollfd request = {STDIN_FILENO, POLLIN, 0};
+        int ready = poll(&request, 1, timeout);
+        if (ready < 0 && errno != EINTR)
+        {
+            is_end = true;
+            break;
+        }
+        if (ready <= 0)
+        {
+            if (bytes >= sample_bytes && std::chrono::steady_clock::now() >= frame.arrival + deadline)
+            {
+                frame.is_short = true;
+                break;
+            }
+            continue;
+        }
+
+        ssize_t length = read(STDIN_FILENO, buffer + bytes, capacity - bytes);
+        if (length < 0 && errno == EINTR)
+            continue;
+        if (length <= 0)
+        {
+            is_end = true;
+            break;
+        }
+        if (bytes == 0)
+            frame.arrival = std::chrono::steady_clock::now();
+        bytes += static_cast<std::size_t>(length);
+    }
+
+    frame.samples = bytes / sample_bytes;
+    carry.assign(buffer + frame.samples * sample_bytes, buffer + bytes);
+    return !is_end && !is_stopping && !is_interrupted;
+}
+
+static bool WriteAll(const char *data, std::size_t size)
+{
+    while (size > 0)
+    {
+        ssize_t length = write(STDOUT_FILENO, data, size);
+        if (length < 0 && errno == EINTR)
+            continue;
+        if (length <= 0)
+            return false;
+        data += length;
+        size -= static_cast<std::size_t>(length);
+    }
+    return true;
+}
+
+// Filter the samples from the stdin to the stdout. The reader and the writer threads do the
+// I/O while this thread evaluates. Each direction has two frames : one is filled while the
+// other is processed.
+static int RunStream(rpn_engine::BatchFunction &function, unsigned int column_count, std::size_t frame_samples,
+                     std::chrono::milliseconds deadline)
+{
+    const std::size_t kBuffers = 2;
+    std::vector<Frame> frames(2 * kBuffers);
+    FrameQueue free_inputs(kBuffers), full_inputs(kBuffers), free_outputs(kBuffers), full_outputs(kBuffers);
+    for (std::size_t i = 0; i < kBuffers; i++)
+    {
+        frames[i].data.resize(frame_samples * column_count);
+        free_inputs.Push(&frames[i]);
+        frames[kBuffers + i].data.resize(frame_samples);
+        free_outputs.Push(&frames[kBuffers + i]);
+    }
+    std::atomic<bool> is_stopping(false);
+    auto stop = [&]
+    {
+        is_stopping = true;
+        free_inputs.Close();
+        full_inputs.Close();
+        free_outputs.Close();
+        full_outputs.Close();
+    };
+
+    std::size_t carry_bytes = 0;
+    std::thread reader([&]
+                       {
+                           std::vector<char> carry;
+                           Frame *frame;
+                           bool is_more = true;
+                           while (is_more && free_inputs.Pop(frame))
+                           {
+                               is_more = ReadFrame(*frame, column_count * sizeof(double), deadline, carry, is_stopping);
+                               if (frame->samples == 0 ? !free_inputs.Push(frame) : !full_inputs.Push(frame))
+                                   break;
+                           }
+                           carry_bytes = carry.size();
+                           full_inputs.Close(); });
+
+    LatencyHistogram latency;
+    std::size_t frame_count = 0, sample_count = 0, short_count = 0;
+    bool is_broken = false;
+    std::thread writer([&]
+                       {
+                           Frame *frame;
+                           while (full_outputs.Pop(frame))
+                           {
+                               if (!WriteAll(reinterpret_cast<const char *>(frame->data.data()), frame->samples * sizeof(double)))
+                               {
+                                   is_broken = true;
+                                   stop();
+                                   break;
+                               }
+                               latency.Add(std::chrono::steady_clock::now() - frame->arrival);
+                               frame_count++;
+                               sample_count += frame->samples;
+                               short_count += frame->is_short;
+                               if (!free_outputs.Push(frame))
+                                   break;
+                           } });
+
+    std::vector<std::vector<double>> columns(column_count > 1 ? column_count : 0, std::vector<double>(frame_samples));
+    std::vector<const double *> inputs(column_count);
+    for (unsigned int k = 0; k < columns.size(); k++)
+        inputs[column_count - 1 - k] = columns[k].data();
+    Frame *input;
+    Frame *output;
+    while (full_inputs.Pop(input) && free_outputs.Pop(output))
+    {
+        const std::size_t count = input->samples;
+        if (column_count == 1)
+            function.Evaluate(input->data.data(), output->data.data(), count);
+        else
+        {
+            // The samples are interleaved. The columns are made here.
+            for (std::size_t i = 0; i < count; i++)
+                for (unsigned int k = 0; k < column_count; k++)
+                    columns[k][i] = input->data[i * column_count + k];
+            function.Evaluate(inputs.data(), column_count, output->data.data(), count);
+        }
+        output->samples = count;
+        output->arrival = input->arrival;
+        output->is_short = input->is_short;
+        if (!free_inputs.Push(input) || !full_outputs.Push(output))
+            break;
+    }
+    full_outputs.Close();
+    writer.join();
+    stop();
+    reader.join();
+
+    if (is_broken)
+        std::fprintf(stderr, "cannot write the output\n");
+    if (is_interrupted)
+        std::fprintf(stderr, "interrupted\n");
+    if (carry_bytes != 0)
+        std::fprintf(stderr, "%zu bytes of an incomplete sample are discarded\n", carry_bytes);
+    std::fprintf(stderr, "%zu frames, %zu samples, %zu short frames\n", frame_count, sample_count, short_count);
+    std::fprintf(stderr, "latency us : p50 %.1f, p90 %.1f, p99 %.1f, p99.9 %.1f, max %.1f\n",
+                 latency.GetPercentile(0.5), latency.GetPercentile(0.9), latency.GetPercentile(0.99),
+                 latency.GetPercentile(0.999), latency.GetMax());
+    return is_broken ? 1 : 0;
+}
+
+int main(int argc, char *argv[])
+{
+    const char *kUsage = "usage : rpneval [--binary columns] [--threads n] (-p program.rpn | -e expression) input output\n"
+                         "        rpneval --stream [--columns n] [--frame samples] [--deadline ms] (-p program.rpn | -e expression)\n";
+    const char *program_path = nullptr;
+    const char *expression = nullptr;
+    std::size_t binary_columns = 0;
+    unsigned int threads = 0;
+    bool is_stream = false;
+    unsigned int stream_columns = 1;
+    std::size_t frame_samples = rpn_engine::BatchFunction::kBlockSize;
+    int deadline = 10;
+    int arg = 1;
+    for (; arg < argc && argv[arg][0] == '-'; arg += 2)
+    {
+        if (std::strcmp(argv[arg], "--stream") == 0)
+        {
+            is_stream = true;
+            arg--;
+            continue;
+        }
+        if (arg + 1 >= argc)
+            break;
+        if (std::strcmp(argv[arg], "-p") == 0)
+            program_path = argv[arg + 1];
+        else if (std::strcmp(argv[arg], "-e") == 0)
+            expression = argv[arg + 1];
+        else if (std::strcmp(argv[arg], "--binary") == 0 && std::atoi(argv[arg + 1]) > 0)
+            binary_columns = static_cast<std::size_t>(std::atoi(argv[arg + 1]));
+        else if (std::strcmp(argv[arg], "--threads") == 0 && std::atoi(argv[arg + 1]) > 0)
+            threads = static_cast<unsigned int>(std::atoi(argv[arg + 1]));
+        else if (std::strcmp(argv[arg], "--columns") == 0 && std::atoi(argv[arg + 1]) > 0)
+            stream_columns = static_cast<unsigned int>(std::atoi(argv[arg + 1]));
+        else if (std::strcmp(argv[arg], "--frame") == 0 && std::atoi(argv[arg + 1]) > 0)
+            frame_samples = static_cast<std::size_t>(std::atoi(argv[arg + 1]));
+        else if (std::strcmp(argv[arg], "--deadline") == 0 && std::atoi(argv[arg + 1]) > 0)
+            deadline = std::atoi(argv[arg + 1]);
+        else
+            break;
+    }
+    if (argc - arg != (is_stream ? 0 : 2) || (program_path == nullptr) == (expression == nullptr))
+    {
+        std::fprintf(stderr, "%s", kUsage);
+        return 1;
+    }
+
+    if (is_stream)
+    {
+        std::vector<std::string> names;
+        for (unsigned int i = 0; i < stream_columns; i++)
+            names.push_back("c" + std::to_string(i));
+        unsigned int stack_size = std::max(4u, stream_columns);
+        std::vector<rpn_engine::Op> program;
+        if (program_path ? !ReadProgram(program_path, program) : !CompileExpression(expression, names, program, stack_size))
+            return 1;
+        rpn_engine::BatchFunction function(stack_size);
+        if (!function.Load(program.data(), program.size()))
+        {
+            std::fprintf(stderr, "the program has error\n");
+            return 1;
+        }
+        // A closed stdout is reported by the write(). The interrupt ends the input.
+        std::signal(SIGPIPE, SIG_IGN);
+        std::signal(SIGINT, Interrupt);
+        std::signal(SIGTERM, Interrupt);
+        return RunStream(function, stream_columns, frame_samples, std::chrono::milliseconds(deadline));
+    }
+
+    const char *input_path = argv[arg];
+    const char *output_path = argv[arg + 1];
+
+    MappedFile input;
+    if (!MapInput(input_path, input))
+    {
+        std::fprintf(stderr, "%s : cannot open\n", input_path);
+        return 1;
+    }
+    const char *text = static_cast<const char *>(input.data);
+    const char *body = text;
+    const char *end = text + input.size;
+
+    // Columns and their names.
+    std::vector<std::string> names;
+    if (binary_columns != 0)
+    {
+        if (input.size % (binary_columns * sizeof(double)) != 0)
+        {
+            std::fprintf(stderr, "%s : the size is not a multiple of %zu columns\n", input_path, binary_columns);
+            return 1;
+        }
+        for (std::size_t i = 0; i < binary_columns; i++)
+            names.push_back("c" + std::to_string(i));
+    }
+    else if (input.size != 0)
+    {
+        std::vector<std::string> fields;
+        const bool is_data = SplitHeader(text, end, fields);
+        for (std::size_t i = 0; i < fields.size(); i++)
+            names.push_back(is_data ? "c" + std::to_string(i) : fields[i]);
+        if (!is_data)
+        {
+            body = static_cast<const char *>(std::memchr(text, '\n', input.size));
+            body = body ? body + 1 : end;
+        }
+    }
+    const std::size_t column_count = names.size();
+
+    // The stack holds all columns.
+    unsigned int stack_size = std::max(4u, static_cast<unsigned int>(column_count));
+    std::vector<rpn_engine::Op> program;
+    if (program_path ? !ReadProgram(program_path, program) : !CompileExpression(expression, names, program, stack_size))
+        return 1;
+
+    rpn_engine::WorkStealingPool pool(threads);
+    std::vector<std::unique_ptr<Worker>> workers;
+    for (unsigned int i = 0; i < pool.GetThreadCount(); i++)
+    {
+        workers.emplace_back(new Worker(stack_size, column_count, binary_columns == 0));
+        if (!workers.back()->function.Load(program.data(), program.size()))
+        {
+            std::fprintf(stderr, "the program has error\n");
+            return 1;
+        }
+    }
+
+    const auto start = std::chrono::steady_clock::now();
+    MappedFile output;
+    std::size_t rows;
+    if (binary_columns != 0)
+    {
+        rows = input.size / (binary_columns * sizeof(double));
+        if (!MapOutput(output_path, rows * sizeof(double), output))
+        {
+            std::fprintf(stderr, "%s : cannot write the output\n", output_path);
+            return 1;
+        }
+        if (rows != 0)
+            EvaluateBinary(pool, workers, static_cast<const double *>(input.data), binary_columns, rows,
+                           static_cast<double *>(output.data));
+    }
+    else
+    {
+        rows = EvaluateCsv(pool, workers, body, end, output_path, output);
+        if (rows == SIZE_MAX)
+            return 1;
+    }
+    const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    std::fprintf(stderr, "%zu rows, %.3f s, %.3g rows/s, %.3f GB/s\n",
+                 rows, seconds, rows / seconds, input.size / seconds * 1e-9);
+    return 0;
+}
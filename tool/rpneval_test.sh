@@ -0,0 +1,40 @@
+#!/bin/sh
+# Test of the rpneval tool. The first argument is the path of the rpneval.
+set -u
+rpneval="$1"
+work=$(mktemp -d)
+trap 'rm -rf "$work"' EXIT
+
+fail()
+{
+    echo "FAIL : $1"
+    cat "$work/stderr"
+    exit 1
+}
+
+# SIGINT in the streaming mode drains the frames, then reports the latency.
+cat /dev/zero | "$rpneval" --stream -e "c0+1" > "$work/stdout" 2> "$work/stderr" &
+pid=$!
+sleep 1
+kill -INT "$pid"
+wait "$pid"
+status=$?
+[ "$status" -eq 0 ] || fail "SIGINT : exit status $status"
+grep -q "^interrupted" "$work/stderr" || fail "SIGINT : not reported"
+grep -q "^latency us : p50" "$work/stderr" || fail "SIGINT : no percentiles"
+# All the evaluated samples are written. Each result is 1.0.
+samples=$(sed -n 's/^[0-9]* frames, \([0-9]*\) samples.*/\1/p' "$work/stderr")
+[ "$samples" -gt 0 ] || fail "SIGINT : no sample"
+[ "$(wc -c < "$work/stdout")" -eq $((samples * 8)) ] || fail "SIGINT : output is not flushed"
+
+# SIGTERM too.
+cat /dev/zero | "$rpneval" --stream -e "c0*2" > /dev/null 2> "$work/stderr" &
+pid=$!
+sleep 1
+kill -TERM "$pid"
+wait "$pid"
+status=$?
+[ "$status" -eq 0 ] || fail "SIGTERM : exit status $status"
+grep -q "^latency us : p50" "$work/stderr" || fail "SIGTERM : no percentiles"
+
+echo "PASS"